@@ -0,0 +1,176 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <sycomore/epg/Discrete.h>
+#include <sycomore/epg/robin_hood.h>
+#include <sycomore/Species.h>
+#include <sycomore/sycomore.h>
+#include <sycomore/units.h>
+
+// Compare the merge-based shift of epg::Discrete with the previous
+// implementation, based on a hash map from orders to locations, on models of
+// 10^3 to 10^6 orders.
+
+using sycomore::Complex;
+
+struct States
+{
+    std::vector<long long> orders;
+    std::vector<Complex> F, F_star, Z;
+};
+
+// Previous implementation of Discrete::shift, for a single-pool model.
+void hash_shift(States & states, long long delta_k, States & cache)
+{
+    auto const size = states.orders.size();
+    
+    robin_hood::unordered_flat_map<long long, std::size_t> locations;
+    locations.reserve(3*size);
+    cache.orders.resize(3*size);
+    for(auto * population: {&cache.F, &cache.F_star, &cache.Z})
+    {
+        population->resize(3*size);
+        std::memset(
+            reinterpret_cast<void*>(population->data()), 0,
+            population->size()*sizeof(Complex));
+    }
+    cache.orders[0] = 0;
+    locations[0] = 0;
+    
+    auto const location = [&](long long order) {
+        auto const location = locations.size();
+        auto const insert_result = locations.try_emplace(order, location);
+        if(insert_result.second)
+        {
+            cache.orders[location] = order;
+        }
+        return insert_result.first->second;
+    };
+    
+    for(std::size_t i=0; i != size; ++i)
+    {
+        auto const k = states.orders[i];
+        
+        auto state = states.Z[i];
+        if(state != 0.)
+        {
+            cache.Z[location(k)] = state;
+        }
+        
+        state = states.F[i];
+        if(state != 0.)
+        {
+            auto k_F = k+delta_k;
+            auto destination = &cache.F;
+            if(k_F < 0)
+            {
+                k_F *= -1;
+                destination = &cache.F_star;
+                state = std::conj(state);
+            }
+            (*destination)[location(k_F)] = state;
+        }
+        
+        state = states.F_star[i];
+        if(i != 0 && state != 0.)
+        {
+            auto k_F_star = k-delta_k;
+            auto destination = &cache.F_star;
+            if(k_F_star < 0)
+            {
+                k_F_star *= -1;
+                destination = &cache.F;
+                state = std::conj(state);
+            }
+            (*destination)[location(k_F_star)] = state;
+        }
+    }
+    
+    cache.orders.resize(locations.size());
+    cache.F.resize(locations.size());
+    cache.F_star.resize(locations.size());
+    cache.Z.resize(locations.size());
+    std::swap(cache.orders, states.orders);
+    std::swap(cache.F, states.F);
+    std::swap(cache.F_star, states.F_star);
+    std::swap(cache.Z, states.Z);
+}
+
+template<typename Function>
+double measure(Function function, int repetitions)
+{
+    auto const begin = std::chrono::steady_clock::now();
+    for(int i=0; i<repetitions; ++i)
+    {
+        function();
+    }
+    auto const end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(end-begin).count()/repetitions;
+}
+
+int main()
+{
+    using namespace sycomore::units;
+    
+    sycomore::Species const species(1000*ms, 100*ms);
+    auto const bin_width = 1*rad/m;
+    auto const duration = 1*ms;
+    // Gradient yielding a shift of one bin.
+    auto const unit_gradient = bin_width/(sycomore::gamma*duration);
+    
+    // Gradients with increasing powers of 2 create all orders in [0, 2^n).
+    sycomore::epg::Discrete model(species, {0,0,1}, bin_width);
+    int power = 1;
+    
+    std::cout << "orders,hash_s,merge_s,speedup\n";
+    for(std::size_t orders: {1000, 10000, 100000, 1000000})
+    {
+        while(model.size() < orders)
+        {
+            model.apply_pulse(40*deg, 10*deg);
+            model.shift(duration, power*unit_gradient);
+            power *= 2;
+        }
+        
+        int const repetitions = std::max<int>(2, 10000000/model.size());
+        
+        States states;
+        auto const model_orders = model.orders();
+        auto const model_states = model.states();
+        for(std::size_t i=0; i<model.size(); ++i)
+        {
+            states.orders.push_back(
+                std::lround(model_orders[i].magnitude/bin_width.magnitude));
+            states.F.push_back(model_states(i, 0));
+            states.F_star.push_back(model_states(i, 1));
+            states.Z.push_back(model_states(i, 2));
+        }
+        States cache;
+        auto const hash_time = measure(
+            [&]() {
+                hash_shift(states, 3, cache);
+                hash_shift(states, -3, cache);
+            },
+            repetitions);
+        
+        auto merge = model;
+        auto const merge_time = measure(
+            [&]() {
+                merge.shift(duration, 3*unit_gradient);
+                merge.shift(duration, -3*unit_gradient);
+            },
+            repetitions);
+        
+        std::cout
+            << model.size() << ","
+            << hash_time << "," << merge_time << ","
+            << hash_time/merge_time << "\n";
+    }
+    
+    return 0;
+}
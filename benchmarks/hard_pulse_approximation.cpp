@@ -0,0 +1,75 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+#include <sycomore/HardPulseApproximation.h>
+#include <sycomore/Pulse.h>
+#include <sycomore/sycomore.h>
+#include <sycomore/units.h>
+
+// Compare the creation of hard pulse approximations from callback envelopes
+// and from envelopes sampled with SIMD instructions, on supports of 64 to
+// 4096 points.
+
+template<typename Function>
+double measure(Function function, int repetitions)
+{
+    auto const begin = std::chrono::steady_clock::now();
+    for(int i=0; i<repetitions; ++i)
+    {
+        function();
+    }
+    auto const end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(end-begin).count()/repetitions;
+}
+
+int main()
+{
+    using namespace sycomore::units;
+    
+    sycomore::Pulse const model(40*deg, 10*deg);
+    auto const duration = 1*ms;
+    auto const t0 = duration/4;
+    
+    std::cout << "envelope,points,callback_s,sampled_s,speedup\n";
+    for(std::size_t points: {64, 256, 1024, 4096})
+    {
+        auto const support = sycomore::linspace(duration, points);
+        int const repetitions = std::max<int>(10, 10000000/points);
+        
+        auto const run = [&](
+            char const * name,
+            sycomore::HardPulseApproximation::Envelope const & callback,
+            sycomore::HardPulseApproximation::SampledEnvelope const & sampled)
+        {
+            auto const callback_time = measure(
+                [&]() {
+                    sycomore::HardPulseApproximation(model, support, callback);
+                },
+                repetitions);
+            auto const sampled_time = measure(
+                [&]() {
+                    sycomore::HardPulseApproximation(model, support, sampled);
+                },
+                repetitions);
+            std::cout
+                << name << "," << points << ","
+                << callback_time << "," << sampled_time << ","
+                << callback_time/sampled_time << "\n";
+        };
+        
+        run(
+            "sinc",
+            sycomore::sinc_envelope(t0), sycomore::sinc_sampled_envelope(t0));
+        run(
+            "hann_sinc",
+            sycomore::hann_sinc_envelope(t0, 2),
+            sycomore::hann_sinc_sampled_envelope(t0, 2));
+        run(
+            "hamming_sinc",
+            sycomore::hamming_sinc_envelope(t0, 2),
+            sycomore::hamming_sinc_sampled_envelope(t0, 2));
+    }
+    
+    return 0;
+}
@@ -0,0 +1,121 @@
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <xtensor/xtensor.hpp>
+
+#include <sycomore/isochromat/Model.h>
+#include <sycomore/isochromat/simd_api.h>
+#include <sycomore/simd.h>
+#include <sycomore/sycomore.h>
+#include <sycomore/units.h>
+
+// Apply spatially-varying time intervals and RF pulses to models of 10^4 to
+// 10^6 isochromats, with each instruction set supported by the CPU and with 1
+// or all hardware threads: pre-built operator ("apply"), operator built at
+// each step ("build_apply"), and transform computed on the fly ("lazy").
+
+#if XSIMD_VERSION_MAJOR >= 8
+#define SYCOMORE_INSTRUCTION_SET(name) name::version()
+#else
+#define SYCOMORE_INSTRUCTION_SET(name) name
+#endif
+
+template<typename Function>
+double measure(Function function, int repetitions)
+{
+    auto const begin = std::chrono::steady_clock::now();
+    for(int i=0; i<repetitions; ++i)
+    {
+        function();
+    }
+    auto const end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(end-begin).count()/repetitions;
+}
+
+int main()
+{
+    using namespace sycomore::units;
+    namespace simd_api = sycomore::isochromat::simd_api;
+    
+    std::vector<std::pair<std::string, unsigned>> const instruction_sets{
+        {"scalar", 0},
+        {"sse2", SYCOMORE_INSTRUCTION_SET(sycomore::XSIMD_X86_SSE2_VERSION)},
+        {"avx", SYCOMORE_INSTRUCTION_SET(sycomore::XSIMD_X86_AVX_VERSION)},
+        {"avx2", SYCOMORE_INSTRUCTION_SET(sycomore::XSIMD_X86_AVX2_VERSION)},
+        {
+            "avx512",
+            SYCOMORE_INSTRUCTION_SET(sycomore::XSIMD_X86_AVX512_VERSION)}};
+    auto const supported = static_cast<unsigned>(
+        sycomore::simd::instruction_set());
+    
+    std::cout << "isochromats,method,instruction_set,threads,time_s\n";
+    for(std::size_t size: {10000, 100000, 1000000})
+    {
+        sycomore::TensorQ<2> positions(
+            sycomore::TensorQ<2>::shape_type{size, 3});
+        std::fill(positions.begin(), positions.end(), 0*m);
+        sycomore::TensorQ<1> angles(sycomore::TensorQ<1>::shape_type{size});
+        sycomore::TensorQ<1> phases(sycomore::TensorQ<1>::shape_type{size});
+        for(std::size_t n=0; n<size; ++n)
+        {
+            positions.unchecked(n, 2) = (1e-6*n)*m;
+            angles[n] = (1e-5*n)*rad;
+            phases[n] = (2e-5*n)*rad;
+        }
+        
+        sycomore::isochromat::Model model(
+            1000*ms, 100*ms, {0., 0., 1.}, positions);
+        sycomore::TensorQ<1> const gradient{0*T/m, 0*T/m, 10*mT/m};
+        auto const operator_ = model.build_time_interval(
+            1*ms, 0*Hz, gradient);
+        
+        std::vector<std::pair<std::string, std::function<void()>>> const
+        methods{
+            {"apply", [&]() { model.apply(operator_); }},
+            {
+                "build_apply",
+                [&]() {
+                    model.apply(
+                        model.build_time_interval(1*ms, 0*Hz, gradient)); }},
+            {
+                "lazy",
+                [&]() { model.apply_time_interval(1*ms, 0*Hz, gradient); }},
+            {
+                "pulse_build_apply",
+                [&]() { model.apply(model.build_pulse(angles, phases)); }},
+            {
+                "pulse_lazy",
+                [&]() { model.apply_pulse(angles, phases); }}};
+        
+        int const repetitions = std::max<int>(10, 100000000/size/100);
+        for(auto const & method: methods)
+        {
+            for(unsigned int threads: {1U, 0U})
+            {
+                model.set_threads(threads);
+                for(auto const & instruction_set: instruction_sets)
+                {
+                    if(instruction_set.second > supported)
+                    {
+                        continue;
+                    }
+                    simd_api::set_api(instruction_set.second);
+                    auto const time = measure(method.second, repetitions);
+                    std::cout
+                        << size << "," << method.first << ","
+                        << instruction_set.first << "," << model.threads()
+                        << "," << time << "\n";
+                }
+            }
+        }
+    }
+    
+    simd_api::set_default_api();
+    
+    return 0;
+}
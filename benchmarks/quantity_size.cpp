@@ -0,0 +1,111 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+#include <xtensor/xtensor.hpp>
+
+#include <sycomore/Dimensions.h>
+#include <sycomore/epg/Discrete.h>
+#include <sycomore/isochromat/Model.h>
+#include <sycomore/Quantity.h>
+#include <sycomore/Species.h>
+#include <sycomore/sycomore.h>
+#include <sycomore/units.h>
+
+// Memory footprint and run time of the code paths creating arrays of
+// quantities, epg::Discrete::orders and the constructor of isochromat::Model,
+// on 10^3 to 10^6 elements. The footprint is compared to the one of the
+// previous representation of dimensions, with seven double exponents.
+
+template<typename Function>
+double measure(Function function, int repetitions)
+{
+    auto const begin = std::chrono::steady_clock::now();
+    for(int i=0; i<repetitions; ++i)
+    {
+        function();
+    }
+    auto const end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(end-begin).count()/repetitions;
+}
+
+int main()
+{
+    using namespace sycomore::units;
+    
+    // Magnitude and seven double exponents
+    std::size_t const unpacked_size = 8*sizeof(double);
+    
+    std::cout
+        << "# sizeof(Dimensions)=" << sizeof(sycomore::Dimensions)
+        << ", sizeof(Quantity)=" << sizeof(sycomore::Quantity)
+        << " (previously " << unpacked_size << ")\n";
+    std::cout << "path,elements,bytes,previous_bytes,time_s\n";
+    
+    auto const report = [&](
+        char const * path, std::size_t elements, std::size_t quantities,
+        double time)
+    {
+        std::cout
+            << path << "," << elements << ","
+            << quantities*sizeof(sycomore::Quantity) << ","
+            << quantities*unpacked_size << "," << time << "\n";
+    };
+    
+    sycomore::Species const species(1000*ms, 100*ms);
+    auto const bin_width = 1*rad/m;
+    auto const duration = 1*ms;
+    // Gradient yielding a shift of one bin.
+    auto const unit_gradient = bin_width/(sycomore::gamma*duration);
+    
+    // Gradients with increasing powers of 2 create all orders in [0, 2^n).
+    sycomore::epg::Discrete discrete(species, {0,0,1}, bin_width);
+    int power = 1;
+    
+    for(std::size_t size: {1000, 10000, 100000, 1000000})
+    {
+        int const repetitions = std::max<int>(2, 10000000/size);
+        
+        while(discrete.size() < size)
+        {
+            discrete.apply_pulse(40*deg, 10*deg);
+            discrete.shift(duration, power*unit_gradient);
+            power *= 2;
+        }
+        auto const orders_time = measure(
+            [&]() { discrete.orders(); }, repetitions);
+        report(
+            "discrete_orders", discrete.size(), discrete.size(), orders_time);
+        
+        sycomore::TensorQ<2> positions(
+            sycomore::TensorQ<2>::shape_type{size, 3});
+        std::fill(positions.begin(), positions.end(), 0*m);
+        sycomore::TensorQ<1> T1(sycomore::TensorQ<1>::shape_type{size});
+        std::fill(T1.begin(), T1.end(), 1000*ms);
+        sycomore::TensorQ<1> T2(sycomore::TensorQ<1>::shape_type{size});
+        std::fill(T2.begin(), T2.end(), 100*ms);
+        sycomore::TensorR<2> M0(sycomore::TensorR<2>::shape_type{size, 3});
+        std::fill(M0.begin(), M0.end(), 0.);
+        for(std::size_t n=0; n<size; ++n)
+        {
+            positions.unchecked(n, 2) = (1e-6*n)*m;
+            M0.unchecked(n, 2) = 1;
+        }
+        
+        auto const constant_time = measure(
+            [&]() {
+                sycomore::isochromat::Model(
+                    1000*ms, 100*ms, {0., 0., 1.}, positions);
+            },
+            repetitions);
+        report("isochromat_constant", size, positions.size(), constant_time);
+        
+        auto const varying_time = measure(
+            [&]() { sycomore::isochromat::Model(T1, T2, M0, positions); },
+            repetitions);
+        report(
+            "isochromat_varying", size, positions.size()+2*size, varying_time);
+    }
+    
+    return 0;
+}
@@ -0,0 +1,72 @@
+#include <chrono>
+#include <iostream>
+
+#include <sycomore/epg/Regular.h>
+#include <sycomore/Species.h>
+#include <sycomore/units.h>
+
+// Compare a shift by n unit gradients with n consecutive unit shifts, on a
+// model with a large number of states.
+
+template<typename Function>
+double measure(Function function, int repetitions)
+{
+    auto const begin = std::chrono::steady_clock::now();
+    for(int i=0; i<repetitions; ++i)
+    {
+        function();
+    }
+    auto const end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(end-begin).count()/repetitions;
+}
+
+int main()
+{
+    using namespace sycomore::units;
+    
+    sycomore::Species const species(1000*ms, 100*ms);
+    auto const unit_dephasing = 1*mT/m*ms;
+    auto const duration = 1*ms;
+    int const repetitions = 20;
+    
+    std::cout << "states,multiple,unit_steps_s,multi_step_s,speedup\n";
+    for(int states: {100, 1000, 10000})
+    {
+        sycomore::epg::Regular initial(
+            species, {0,0,1}, states, unit_dephasing);
+        initial.apply_pulse(90*deg);
+        initial.shift(duration, (states-1)*1*mT/m);
+        
+        for(int multiple: {2, 10, 100})
+        {
+            auto unit_steps = initial;
+            auto const unit_steps_time = measure(
+                [&]() {
+                    for(int i=0; i<multiple; ++i)
+                    {
+                        unit_steps.shift(duration, 1*mT/m);
+                    }
+                    for(int i=0; i<multiple; ++i)
+                    {
+                        unit_steps.shift(duration, -1*mT/m);
+                    }
+                },
+                repetitions);
+            
+            auto multi_step = initial;
+            auto const multi_step_time = measure(
+                [&]() {
+                    multi_step.shift(duration, multiple*1*mT/m);
+                    multi_step.shift(duration, -multiple*1*mT/m);
+                },
+                repetitions);
+            
+            std::cout
+                << states << "," << multiple << ","
+                << unit_steps_time << "," << multi_step_time << ","
+                << unit_steps_time/multi_step_time << "\n";
+        }
+    }
+    
+    return 0;
+}
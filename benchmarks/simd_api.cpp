@@ -0,0 +1,230 @@
+#include <algorithm>
+#include <chrono>
+#include <complex>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sycomore/Buffer.h>
+#include <sycomore/epg/Model.h>
+#include <sycomore/epg/operators.h>
+#include <sycomore/epg/simd_api.h>
+#include <sycomore/simd.h>
+#include <sycomore/Species.h>
+#include <sycomore/sycomore.h>
+#include <sycomore/units.h>
+
+// Run each kernel of the SIMD API with each instruction set supported by the
+// CPU, on models of 10^3 and 10^5 states.
+
+#if XSIMD_VERSION_MAJOR >= 8
+#define SYCOMORE_INSTRUCTION_SET(name) name::version()
+#else
+#define SYCOMORE_INSTRUCTION_SET(name) name
+#endif
+
+template<typename Function>
+double measure(Function function, int repetitions)
+{
+    auto const begin = std::chrono::steady_clock::now();
+    for(int i=0; i<repetitions; ++i)
+    {
+        function();
+    }
+    auto const end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(end-begin).count()/repetitions;
+}
+
+// Fill all orders with non-zero states of unit magnitude.
+void fill(sycomore::epg::Model & model)
+{
+    for(std::size_t pool=0; pool<model.pools; ++pool)
+    {
+        for(std::size_t i=0; i<model.F[pool].size(); ++i)
+        {
+            auto const state = std::polar(1., 0.1*i);
+            model.F[pool][i] = state;
+            model.F_star[pool][i] = std::conj(state);
+            model.Z[pool][i] = state.real();
+        }
+    }
+}
+
+int main()
+{
+    using namespace sycomore::units;
+    namespace simd_api = sycomore::epg::simd_api;
+    using sycomore::Complex;
+    using sycomore::Real;
+    
+    std::vector<std::pair<std::string, unsigned>> const instruction_sets{
+        {"scalar", 0},
+        {"sse2", SYCOMORE_INSTRUCTION_SET(sycomore::XSIMD_X86_SSE2_VERSION)},
+        {"avx", SYCOMORE_INSTRUCTION_SET(sycomore::XSIMD_X86_AVX_VERSION)},
+        {"avx2", SYCOMORE_INSTRUCTION_SET(sycomore::XSIMD_X86_AVX2_VERSION)},
+        {
+            "avx512",
+            SYCOMORE_INSTRUCTION_SET(sycomore::XSIMD_X86_AVX512_VERSION)}};
+    auto const supported = static_cast<unsigned>(
+        sycomore::simd::instruction_set());
+    
+    sycomore::Species const species(1000*ms, 100*ms, 1*um*um/ms, 10*Hz);
+    auto const T = sycomore::epg::operators::pulse_single_pool(0.5, 0.25);
+    std::array<Complex, 18> T_exchange;
+    std::copy(T.begin(), T.end(), T_exchange.begin());
+    std::copy(T.begin(), T.end(), T_exchange.begin()+9);
+    
+    // Close to identity, so that repeated applications do not reach the
+    // denormal range.
+    std::pair<Real, Real> const E{0.99999, 0.9999};
+    std::pair<Complex, Complex> const phi{
+        std::polar(1., 0.01), std::polar(1., -0.01)};
+    Real const delta_k=1, tau=1e-3, D=1e-12, v=1e-3;
+    
+    std::cout << "kernel,instruction_set,states,time_s\n";
+    for(std::size_t states: {1000, 100000})
+    {
+        sycomore::epg::Model model(species, {0,0,1}, states);
+        fill(model);
+        sycomore::epg::Model exchange(
+            species, species, {0,0,0.8}, {0,0,0.2}, 10*Hz, 0*Hz, states);
+        fill(exchange);
+        
+        std::vector<Real> k(states), magnitude(states);
+        for(std::size_t i=0; i<states; ++i)
+        {
+            k[i] = i*delta_k;
+        }
+        
+        // Batch of 64 models, with states/64 orders, in the interleaved and
+        // in the planar layouts, and in single precision.
+        std::size_t const stride = 64;
+        auto const batch_states = states/stride;
+        sycomore::Buffer<Real> B1(stride), delta_omega(stride);
+        std::fill(B1.begin(), B1.end(), 1.);
+        std::fill(delta_omega.begin(), delta_omega.end(), 10.);
+        sycomore::Buffer<Complex> F(states), F_star(states), Z(states);
+        for(std::size_t i=0; i<states; ++i)
+        {
+            F[i] = std::polar(1., 0.1*i);
+            F_star[i] = std::conj(F[i]);
+            Z[i] = F[i].real();
+        }
+        auto const F_r = reinterpret_cast<Real*>(F.data());
+        auto const F_star_r = reinterpret_cast<Real*>(F_star.data());
+        auto const Z_r = reinterpret_cast<Real*>(Z.data());
+        sycomore::Buffer<float> F_f(2*states), F_star_f(2*states),
+            Z_f(2*states);
+        for(std::size_t i=0; i<2*states; ++i)
+        {
+            F_f[i] = F_r[i];
+            F_star_f[i] = F_star_r[i];
+            Z_f[i] = Z_r[i];
+        }
+        
+        std::vector<std::pair<std::string, std::function<void()>>> const
+        kernels{
+            {
+                "apply_pulse_single_pool",
+                [&]() {
+                    simd_api::apply_pulse_single_pool(T, model, states); }},
+            {
+                "apply_pulse_exchange",
+                [&]() {
+                    simd_api::apply_pulse_exchange(
+                        T_exchange, exchange, states); }},
+            {
+                "relaxation_single_pool",
+                [&]() {
+                    simd_api::relaxation_single_pool(E, model, states); }},
+            {
+                "diffusion",
+                [&]() {
+                    simd_api::diffusion(
+                        delta_k, tau, D, k.data(),
+                        model.F[0], model.F_star[0], model.Z[0],
+                        model.F_offset, model.F_star_offset, states); }},
+            {
+                "off_resonance",
+                [&]() {
+                    simd_api::off_resonance(
+                        phi, model.F[0], model.F_star[0],
+                        model.F_offset, model.F_star_offset, states); }},
+            {
+                "bulk_motion",
+                [&]() {
+                    simd_api::bulk_motion(
+                        delta_k, v, tau, k.data(), model, states); }},
+            {
+                "time_interval",
+                [&]() {
+                    simd_api::time_interval(
+                        E, delta_k, tau, D, v, phi, k.data(),
+                        model.F[0], model.F_star[0], model.Z[0],
+                        model.F_offset, model.F_star_offset, states); }},
+            {
+                "cull_magnitude",
+                [&]() {
+                    simd_api::cull_magnitude(
+                        model, states, magnitude.data()); }},
+            {
+                "apply_pulse_batch",
+                [&]() {
+                    simd_api::apply_pulse_batch(
+                        0.5, 0.25, B1.data(), F.data(), F_star.data(),
+                        Z.data(), batch_states, stride); }},
+            {
+                "apply_pulse_batch_planar",
+                [&]() {
+                    simd_api::apply_pulse_batch_planar(
+                        0.5, 0.25, B1.data(), F_r, F_star_r, Z_r,
+                        batch_states, stride); }},
+            {
+                "apply_pulse_batch_planar_float",
+                [&]() {
+                    simd_api::apply_pulse_batch_planar_float(
+                        0.5, 0.25, B1.data(), F_f.data(), F_star_f.data(),
+                        Z_f.data(), batch_states, stride); }},
+            {
+                "off_resonance_batch",
+                [&]() {
+                    simd_api::off_resonance_batch(
+                        1e-3, 0, delta_omega.data(), F.data(), F_star.data(),
+                        batch_states, stride); }},
+            {
+                "off_resonance_batch_planar",
+                [&]() {
+                    simd_api::off_resonance_batch_planar(
+                        1e-3, 0, delta_omega.data(), F_r, F_star_r,
+                        batch_states, stride); }},
+            {
+                "off_resonance_batch_planar_float",
+                [&]() {
+                    simd_api::off_resonance_batch_planar_float(
+                        1e-3, 0, delta_omega.data(), F_f.data(),
+                        F_star_f.data(), batch_states, stride); }}};
+        
+        int const repetitions = std::max<int>(10, 1000000/states);
+        for(auto const & kernel: kernels)
+        {
+            for(auto const & instruction_set: instruction_sets)
+            {
+                if(instruction_set.second > supported)
+                {
+                    continue;
+                }
+                simd_api::set_api(instruction_set.second);
+                auto const time = measure(kernel.second, repetitions);
+                std::cout
+                    << kernel.first << "," << instruction_set.first << ","
+                    << states << "," << time << "\n";
+            }
+        }
+    }
+    
+    simd_api::set_default_api();
+    
+    return 0;
+}
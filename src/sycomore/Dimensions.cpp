@@ -1,11 +1,86 @@
 #include "Dimensions.h"
 
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
 #include <ostream>
+#include <stdexcept>
 #include <string>
 
 namespace sycomore
 {
 
+static_assert(sizeof(Dimensions) == 8, "Dimensions must be packed in 8 bytes");
+static_assert(
+    offsetof(Dimensions, luminous_intensity) == 6,
+    "Exponents must be contiguous");
+
+Dimensions::Exponent
+::Exponent(double value)
+: _numerator(Exponent::_checked(value*Exponent::denominator))
+{
+    // Nothing else.
+}
+
+Dimensions::Exponent
+::operator double() const
+{
+    return static_cast<double>(this->_numerator)/Exponent::denominator;
+}
+
+Dimensions::Exponent &
+Dimensions::Exponent
+::operator+=(Exponent const & other)
+{
+    this->_numerator = Exponent::_checked(
+        this->_numerator+other._numerator);
+    return *this;
+}
+
+Dimensions::Exponent &
+Dimensions::Exponent
+::operator-=(Exponent const & other)
+{
+    this->_numerator = Exponent::_checked(
+        this->_numerator-other._numerator);
+    return *this;
+}
+
+Dimensions::Exponent &
+Dimensions::Exponent
+::operator*=(double scalar)
+{
+    this->_numerator = Exponent::_checked(this->_numerator*scalar);
+    return *this;
+}
+
+Dimensions::Exponent &
+Dimensions::Exponent
+::operator/=(double scalar)
+{
+    this->_numerator = Exponent::_checked(this->_numerator/scalar);
+    return *this;
+}
+
+std::int8_t
+Dimensions::Exponent
+::_checked(double numerator)
+{
+    auto const rounded = std::round(numerator);
+    if(
+        std::abs(numerator-rounded) > 1e-9
+        || rounded < std::numeric_limits<std::int8_t>::min()
+        || rounded > std::numeric_limits<std::int8_t>::max())
+    {
+        throw std::runtime_error(
+            "Cannot represent exponent "
+            + std::to_string(numerator/Exponent::denominator));
+    }
+    return static_cast<std::int8_t>(rounded);
+}
+
 Dimensions
 ::Dimensions(
     double length, double mass, double time, double electric_current,
@@ -23,14 +98,7 @@ bool
 Dimensions
 ::operator==(Dimensions const & other) const
 {
-    return (
-        this->length == other.length
-        && this->mass == other.mass
-        && this->time == other.time
-        && this->electric_current == other.electric_current
-        && this->thermodynamic_temperature == other.thermodynamic_temperature
-        && this->amount_of_substance == other.amount_of_substance
-        && this->luminous_intensity == other.luminous_intensity);
+    return this->_packed() == other._packed();
 }
 
 Dimensions &
@@ -70,6 +138,17 @@ Dimensions
     return !this->operator==(other);
 }
 
+std::uint64_t
+Dimensions
+::_packed() const
+{
+    // The eighth byte is padding, with an unspecified value: only copy the
+    // exponents.
+    std::uint64_t packed = 0;
+    std::memcpy(&packed, &this->length, 7);
+    return packed;
+}
+
 Dimensions operator*(Dimensions l, Dimensions const & r)
 {
     l *= r;
@@ -1,6 +1,7 @@
 #ifndef _bad9a44e_bb0e_403b_be26_3ca5d92c4d4a
 #define _bad9a44e_bb0e_403b_be26_3ca5d92c4d4a
 
+#include <cstdint>
 #include <ostream>
 
 #include "sycomore/sycomore_api.h"
@@ -8,17 +9,52 @@
 namespace sycomore
 {
 
-/// @brief Physical dimensions of a quantity
-class Dimensions
+/**
+ * @brief Physical dimensions of a quantity
+ *
+ * The seven exponents are packed in 8 bytes, so that a Quantity is only twice
+ * as large as its magnitude, and that dimensions are compared as a single
+ * integer.
+ */
+class alignas(8) Dimensions
 {
 public:
-    double length;
-    double mass;
-    double time;
-    double electric_current;
-    double thermodynamic_temperature;
-    double amount_of_substance;
-    double luminous_intensity;
+    /**
+     * @brief Rational exponent of a base dimension, stored in a signed byte as
+     * a multiple of 1/denominator: integers in [-21, 21], halves and thirds
+     * are exact. Other values throw an exception.
+     *
+     * Exponents convert implicitly to and from double, and support compound
+     * assignment. Unlike the previous double members, they cannot be bound
+     * to a double reference or to a pointer to a double member.
+     */
+    class Exponent
+    {
+    public:
+        static int const denominator = 6;
+        
+        Exponent(double value=0);
+        
+        operator double() const;
+        
+        Exponent & operator+=(Exponent const & other);
+        Exponent & operator-=(Exponent const & other);
+        Exponent & operator*=(double scalar);
+        Exponent & operator/=(double scalar);
+    
+    private:
+        std::int8_t _numerator;
+        
+        static std::int8_t _checked(double numerator);
+    };
+    
+    Exponent length;
+    Exponent mass;
+    Exponent time;
+    Exponent electric_current;
+    Exponent thermodynamic_temperature;
+    Exponent amount_of_substance;
+    Exponent luminous_intensity;
 
     Dimensions(
         double length=0, double mass=0, double time=0, double electric_current=0,
@@ -30,6 +66,10 @@ public:
 
     Dimensions & operator*=(Dimensions const & other);
     Dimensions & operator/=(Dimensions const & other);
+
+private:
+    /// @brief Return the seven exponents as a single integer.
+    std::uint64_t _packed() const;
 };
 
 /// @addtogroup DimensionsOperators
@@ -1,11 +1,16 @@
 #include "HardPulseApproximation.h"
 
+#include <algorithm>
+#include <cstddef>
 #include <functional>
+#include <numeric>
 #include <string>
 #include <vector>
 
 #include "sycomore/Pulse.h"
 #include "sycomore/Quantity.h"
+#include "sycomore/simd_api.h"
+#include "sycomore/sycomore.h"
 #include "sycomore/units.h"
 
 namespace sycomore
@@ -16,20 +21,25 @@ HardPulseApproximation
     Pulse const & model, std::vector<Quantity> const & support,
     Envelope const & envelope)
 {
-    std::vector<Quantity> angles(support.size());
-    std::transform(support.begin(), support.end(), angles.begin(), envelope);
-    auto const sum = std::accumulate(angles.begin(), angles.end(), 0.*units::rad);
+    std::vector<Real> values(support.size());
     std::transform(
-        angles.begin(), angles.end(), angles.begin(),
-        [&](Quantity x) { return x*model.angle() / sum; });
-
-    for(auto && angle: angles)
-    {
-        this->_pulses.emplace_back(angle, model.phase());
-    }
+        support.begin(), support.end(), values.begin(),
+        [&](Quantity const & t) { return envelope(t).magnitude; });
+    this->_set_pulses(model, support, values);
+}
 
-    auto const pulse_duration = support.back()-support.front();
-    this->_duration = pulse_duration/(support.size()-1);
+HardPulseApproximation
+::HardPulseApproximation(
+    Pulse const & model, std::vector<Quantity> const & support,
+    SampledEnvelope const & envelope)
+{
+    std::vector<Real> times(support.size());
+    std::transform(
+        support.begin(), support.end(), times.begin(),
+        [](Quantity const & t) { return t.magnitude; });
+    std::vector<Real> values(support.size());
+    envelope(times.data(), times.size(), values.data());
+    this->_set_pulses(model, support, values);
 }
 
 std::vector<Pulse> const &
@@ -63,16 +73,34 @@ HardPulseApproximation
     }
 }
 
+void
+HardPulseApproximation
+::_set_pulses(
+    Pulse const & model, std::vector<Quantity> const & support,
+    std::vector<Real> const & envelope)
+{
+    auto const sum = std::accumulate(envelope.begin(), envelope.end(), 0.);
+    
+    this->_pulses.reserve(envelope.size());
+    for(auto && value: envelope)
+    {
+        this->_pulses.emplace_back(value*model.angle()/sum, model.phase());
+    }
+    
+    auto const pulse_duration = support.back()-support.front();
+    this->_duration = pulse_duration/(support.size()-1);
+}
+
 HardPulseApproximation::Envelope
 apodized_sinc_envelope(Quantity const & t0_, unsigned int N, Real alpha)
 {
     return [=](Quantity const t_) {
-        auto const t0 = t0_.magnitude;
+        // Scalar version of the sampled envelope, also defined at t=0.
         auto const t = t_.magnitude;
-        return 
-            t0
-            *((1-alpha)+alpha*std::cos(M_PI*t/(N*t0)))
-            *std::sin(M_PI*t/t0)/(M_PI*t);
+        Real value;
+        simd_api::apodized_sinc_w<Real>(
+            t0_.magnitude, N, alpha, &t, &value, 0, 1, 1);
+        return value;
     };
 }
 
@@ -90,10 +118,37 @@ hamming_sinc_envelope(Quantity const & t0, unsigned int N)
 
 HardPulseApproximation::Envelope sinc_envelope(Quantity const & t0)
 {
-    return [&](Quantity const x) {
+    return [=](Quantity const x) {
         double const x_scaled = M_PI*x/t0;
         return x_scaled==0?1:std::sin(x_scaled)/(x_scaled);
     };
 }
 
+HardPulseApproximation::SampledEnvelope
+apodized_sinc_sampled_envelope(Quantity const & t0, unsigned int N, Real alpha)
+{
+    auto const t0_s = t0.magnitude;
+    return [=](Real const * times, std::size_t size, Real * values) {
+        simd_api::apodized_sinc(t0_s, N, alpha, times, values, 0, size);
+    };
+}
+
+HardPulseApproximation::SampledEnvelope
+hann_sinc_sampled_envelope(Quantity const & t0, unsigned int N)
+{
+    return apodized_sinc_sampled_envelope(t0, N, 0.5);
+}
+
+HardPulseApproximation::SampledEnvelope
+hamming_sinc_sampled_envelope(Quantity const & t0, unsigned int N)
+{
+    return apodized_sinc_sampled_envelope(t0, N, 0.46);
+}
+
+HardPulseApproximation::SampledEnvelope
+sinc_sampled_envelope(Quantity const & t0)
+{
+    return apodized_sinc_sampled_envelope(t0, 1, 0);
+}
+
 }
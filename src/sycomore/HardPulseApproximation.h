@@ -1,12 +1,14 @@
 #ifndef _ea452652_2d33_45ed_9feb_960f1d861041
 #define _ea452652_2d33_45ed_9feb_960f1d861041
 
+#include <cstddef>
 #include <functional>
 #include <string>
 #include <vector>
 
 #include "sycomore/Pulse.h"
 #include "sycomore/Quantity.h"
+#include "sycomore/sycomore.h"
 #include "sycomore/units.h"
 
 namespace sycomore
@@ -19,6 +21,13 @@ public:
     /// @brief Normalized envelope of the pulse as a function of time
     using Envelope = std::function<Quantity(Quantity const &)>;
     
+    /**
+     * @brief Normalized envelope of the pulse, sampled at once on an array
+     * of times (in s): the envelope at times[i] is stored in values[i]
+     */
+    using SampledEnvelope = std::function<
+        void(Real const * times, std::size_t size, Real * values)>;
+    
     /**
      * @brief Create a shaped pulse with a flip angle equivalent to given
      * hard pulse
@@ -27,6 +36,14 @@ public:
         Pulse const & model, std::vector<Quantity> const & support,
         Envelope const & envelope);
     
+    /**
+     * @brief Create a shaped pulse with a flip angle equivalent to given
+     * hard pulse, sampling the envelope on the whole support at once
+     */
+    HardPulseApproximation(
+        Pulse const & model, std::vector<Quantity> const & support,
+        SampledEnvelope const & envelope);
+    
     /// @brief Return the hard pulses approximating the shaped pulse
     std::vector<Pulse> const & pulses() const;
     
@@ -42,6 +59,11 @@ public:
 private:
     std::vector<Pulse> _pulses;
     Quantity _duration;
+    
+    /// @brief Create the hard pulses from the envelope sampled on the support
+    void _set_pulses(
+        Pulse const & model, std::vector<Quantity> const & support,
+        std::vector<Real> const & envelope);
 };
 
 /// @addtogroup HardPulseApproximationEnvelopes
@@ -59,6 +81,19 @@ HardPulseApproximation::Envelope hamming_sinc_envelope(
 /// @brief Create a sinc envelope
 HardPulseApproximation::Envelope sinc_envelope(Quantity const & t0);
 
+/// @brief Create an apodized sinc envelope, sampled with SIMD
+HardPulseApproximation::SampledEnvelope apodized_sinc_sampled_envelope(
+    Quantity const & t0, unsigned int N, Real alpha);
+/// @brief Create an Hann-apodized sinc envelope, sampled with SIMD
+HardPulseApproximation::SampledEnvelope hann_sinc_sampled_envelope(
+    Quantity const & t0, unsigned int N);
+/// @brief Create an Hamming-apodized sinc envelope, sampled with SIMD
+HardPulseApproximation::SampledEnvelope hamming_sinc_sampled_envelope(
+    Quantity const & t0, unsigned int N);
+/// @brief Create a sinc envelope, sampled with SIMD
+HardPulseApproximation::SampledEnvelope sinc_sampled_envelope(
+    Quantity const & t0);
+
 /// @}
 
 }
@@ -0,0 +1,92 @@
+#ifndef _7b7d6e40_fa94_4891_bb5d_5c8cff4fceb9
+#define _7b7d6e40_fa94_4891_bb5d_5c8cff4fceb9
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace sycomore
+{
+
+/**
+ * @brief Cache of values computed from a key, evicting the least recently
+ * used value when full.
+ *
+ * The number of lookups which found a value (hits) and of lookups which had
+ * to compute it (misses) are counted.
+ */
+template<typename Key, typename Value, typename Hash=std::hash<Key>>
+class LRUCache
+{
+public:
+    using Self = LRUCache<Key, Value, Hash>;
+    using key_type = Key;
+    using value_type = Value;
+    
+    /// @brief Create an empty cache of given capacity (at least 1).
+    LRUCache(std::size_t capacity=64);
+    
+    /// @brief Copy constructor.
+    LRUCache(Self const & other);
+    
+    /// @brief Default move constructor.
+    LRUCache(Self && other) = default;
+    
+    /// @brief Copy assignment.
+    Self & operator=(Self const & other);
+    
+    /// @brief Default move assignment.
+    Self & operator=(Self && other) = default;
+    
+    /// @brief Default destructor.
+    ~LRUCache() = default;
+    
+    /// @brief Maximum number of values in the cache.
+    std::size_t capacity() const;
+    
+    /// @brief Set the maximum number of values, evict values if needed.
+    void set_capacity(std::size_t capacity);
+    
+    /// @brief Number of values in the cache.
+    std::size_t size() const;
+    
+    /// @brief Number of lookups which found their value in the cache.
+    std::size_t hits() const;
+    
+    /// @brief Number of lookups which computed their value.
+    std::size_t misses() const;
+    
+    /// @brief Remove all values and reset the counters.
+    void clear();
+    
+    /**
+     * @brief Return the value associated with key, calling compute() if it is
+     * not in the cache. The reference is valid until the next call.
+     */
+    template<typename Function>
+    Value const & get(Key const & key, Function compute);
+
+private:
+    using Items = std::list<std::pair<Key, Value>>;
+    
+    std::size_t _capacity;
+    std::size_t _hits;
+    std::size_t _misses;
+    
+    /// @brief Values, from the most recently used to the least recently used.
+    Items _items;
+    
+    /// @brief Location of each key in the list of values.
+    std::unordered_map<Key, typename Items::iterator, Hash> _index;
+    
+    void _evict(std::size_t size);
+    void _rebuild_index();
+};
+
+}
+
+#include "LRUCache.txx"
+
+#endif // _7b7d6e40_fa94_4891_bb5d_5c8cff4fceb9
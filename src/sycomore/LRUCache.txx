@@ -0,0 +1,154 @@
+#ifndef _15cbfc38_1af0_4310_b0fb_74e902491e52
+#define _15cbfc38_1af0_4310_b0fb_74e902491e52
+
+#include "LRUCache.h"
+
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+
+namespace sycomore
+{
+
+template<typename Key, typename Value, typename Hash>
+LRUCache<Key, Value, Hash>
+::LRUCache(std::size_t capacity)
+: _capacity(0), _hits(0), _misses(0)
+{
+    this->set_capacity(capacity);
+}
+
+template<typename Key, typename Value, typename Hash>
+LRUCache<Key, Value, Hash>
+::LRUCache(Self const & other)
+: _capacity(other._capacity), _hits(other._hits), _misses(other._misses),
+    _items(other._items)
+{
+    this->_rebuild_index();
+}
+
+template<typename Key, typename Value, typename Hash>
+LRUCache<Key, Value, Hash> &
+LRUCache<Key, Value, Hash>
+::operator=(Self const & other)
+{
+    if(this != &other)
+    {
+        this->_capacity = other._capacity;
+        this->_hits = other._hits;
+        this->_misses = other._misses;
+        this->_items = other._items;
+        this->_rebuild_index();
+    }
+    return *this;
+}
+
+template<typename Key, typename Value, typename Hash>
+std::size_t
+LRUCache<Key, Value, Hash>
+::capacity() const
+{
+    return this->_capacity;
+}
+
+template<typename Key, typename Value, typename Hash>
+void
+LRUCache<Key, Value, Hash>
+::set_capacity(std::size_t capacity)
+{
+    if(capacity == 0)
+    {
+        throw std::runtime_error("Cache capacity must be at least 1");
+    }
+    this->_capacity = capacity;
+    this->_evict(capacity);
+}
+
+template<typename Key, typename Value, typename Hash>
+std::size_t
+LRUCache<Key, Value, Hash>
+::size() const
+{
+    return this->_items.size();
+}
+
+template<typename Key, typename Value, typename Hash>
+std::size_t
+LRUCache<Key, Value, Hash>
+::hits() const
+{
+    return this->_hits;
+}
+
+template<typename Key, typename Value, typename Hash>
+std::size_t
+LRUCache<Key, Value, Hash>
+::misses() const
+{
+    return this->_misses;
+}
+
+template<typename Key, typename Value, typename Hash>
+void
+LRUCache<Key, Value, Hash>
+::clear()
+{
+    this->_items.clear();
+    this->_index.clear();
+    this->_hits = 0;
+    this->_misses = 0;
+}
+
+template<typename Key, typename Value, typename Hash>
+template<typename Function>
+Value const &
+LRUCache<Key, Value, Hash>
+::get(Key const & key, Function compute)
+{
+    auto const location = this->_index.find(key);
+    if(location != this->_index.end())
+    {
+        ++this->_hits;
+        // Move the item to the front, this does not invalidate iterators.
+        this->_items.splice(
+            this->_items.begin(), this->_items, location->second);
+        return location->second->second;
+    }
+    
+    ++this->_misses;
+    
+    // Compute before evicting, so that the cache is unchanged if it throws.
+    auto value = compute();
+    this->_evict(this->_capacity-1);
+    this->_items.emplace_front(key, std::move(value));
+    this->_index.emplace(key, this->_items.begin());
+    return this->_items.front().second;
+}
+
+template<typename Key, typename Value, typename Hash>
+void
+LRUCache<Key, Value, Hash>
+::_evict(std::size_t size)
+{
+    while(this->_items.size() > size)
+    {
+        this->_index.erase(this->_items.back().first);
+        this->_items.pop_back();
+    }
+}
+
+template<typename Key, typename Value, typename Hash>
+void
+LRUCache<Key, Value, Hash>
+::_rebuild_index()
+{
+    this->_index.clear();
+    for(auto it=this->_items.begin(); it!=this->_items.end(); ++it)
+    {
+        this->_index.emplace(it->first, it);
+    }
+}
+
+}
+
+#endif // _15cbfc38_1af0_4310_b0fb_74e902491e52
@@ -0,0 +1,110 @@
+#include "Sequence.h"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "sycomore/Pulse.h"
+#include "sycomore/Quantity.h"
+#include "sycomore/TimeInterval.h"
+
+namespace sycomore
+{
+
+Sequence &
+Sequence
+::pulse(Quantity const & angle, Quantity const & phase)
+{
+    Step step;
+    step.kind = Step::Pulse;
+    step.pulse = sycomore::Pulse(angle, phase);
+    this->_steps.push_back(step);
+    
+    return *this;
+}
+
+Sequence &
+Sequence
+::time_interval(sycomore::TimeInterval const & interval)
+{
+    Step step;
+    step.kind = Step::TimeInterval;
+    step.interval = interval;
+    this->_steps.push_back(step);
+    
+    return *this;
+}
+
+Sequence &
+Sequence
+::time_interval(Quantity const & duration, Quantity const & gradient)
+{
+    return this->time_interval(sycomore::TimeInterval(duration, gradient));
+}
+
+Sequence &
+Sequence
+::echo()
+{
+    Step step;
+    step.kind = Step::Echo;
+    this->_steps.push_back(step);
+    
+    return *this;
+}
+
+Sequence &
+Sequence
+::loop(std::size_t repetitions, Sequence const & body)
+{
+    Step step;
+    step.kind = Step::Loop;
+    step.repetitions = repetitions;
+    // Copy the body, so that later modifications of the argument do not
+    // modify this sequence.
+    step.body = std::make_shared<Sequence const>(body);
+    this->_steps.push_back(step);
+    
+    return *this;
+}
+
+std::vector<Sequence::Step> const &
+Sequence
+::steps() const
+{
+    return this->_steps;
+}
+
+std::size_t
+Sequence
+::size() const
+{
+    std::size_t size = 0;
+    for(auto && step: this->_steps)
+    {
+        size +=
+            (step.kind == Step::Loop) ? step.repetitions*step.body->size() : 1;
+    }
+    return size;
+}
+
+std::size_t
+Sequence
+::echoes() const
+{
+    std::size_t echoes = 0;
+    for(auto && step: this->_steps)
+    {
+        if(step.kind == Step::Echo)
+        {
+            ++echoes;
+        }
+        else if(step.kind == Step::Loop)
+        {
+            echoes += step.repetitions*step.body->echoes();
+        }
+    }
+    return echoes;
+}
+
+}
@@ -0,0 +1,82 @@
+#ifndef _8259a74a_41de_4c67_9ff0_e378dff50341
+#define _8259a74a_41de_4c67_9ff0_e378dff50341
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "sycomore/Pulse.h"
+#include "sycomore/Quantity.h"
+#include "sycomore/TimeInterval.h"
+#include "sycomore/units.h"
+
+namespace sycomore
+{
+
+/**
+ * @brief Sequence of RF pulses, time intervals and echo readouts, which may be
+ * repeated in loops.
+ *
+ * The sequence does not depend on the simulation model: it is compiled for a
+ * model before being run (see epg::Program).
+ */
+class Sequence
+{
+public:
+    /// @brief Element of a sequence.
+    class Step
+    {
+    public:
+        /// @brief Kind of the step
+        enum Kind { Pulse, TimeInterval, Echo, Loop };
+        
+        /// @brief Kind of the step
+        Kind kind;
+        
+        /// @brief RF pulse of Pulse steps
+        sycomore::Pulse pulse{0*units::rad};
+        
+        /// @brief Time interval of TimeInterval steps
+        sycomore::TimeInterval interval;
+        
+        /// @brief Number of repetitions of Loop steps
+        std::size_t repetitions=0;
+        
+        /// @brief Repeated sequence of Loop steps
+        std::shared_ptr<Sequence const> body;
+    };
+    
+    /// @brief Append an RF hard pulse, return the sequence.
+    Sequence & pulse(
+        Quantity const & angle, Quantity const & phase=0*units::rad);
+    
+    /// @brief Append a time interval, return the sequence.
+    Sequence & time_interval(sycomore::TimeInterval const & interval);
+    
+    /// @brief Append a time interval, return the sequence.
+    Sequence & time_interval(
+        Quantity const & duration,
+        Quantity const & gradient=0*units::T/units::m);
+    
+    /// @brief Append the readout of the echo signal, return the sequence.
+    Sequence & echo();
+    
+    /// @brief Append a repeated sequence, return the sequence.
+    Sequence & loop(std::size_t repetitions, Sequence const & body);
+    
+    /// @brief Return the steps of the sequence.
+    std::vector<Step> const & steps() const;
+    
+    /// @brief Return the number of steps, loops being unrolled.
+    std::size_t size() const;
+    
+    /// @brief Return the number of echo readouts, loops being unrolled.
+    std::size_t echoes() const;
+
+private:
+    std::vector<Step> _steps;
+};
+
+}
+
+#endif // _8259a74a_41de_4c67_9ff0_e378dff50341
@@ -0,0 +1,235 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace sycomore
+{
+
+thread_local bool ThreadPool::_running_task = false;
+
+ThreadPool
+::ThreadPool(unsigned int size)
+: _generation(0), _stop(false), _pending(0)
+{
+    if(size == 0)
+    {
+        size = ThreadPool::_default_size();
+    }
+    
+    for(unsigned int i=0; i<size; ++i)
+    {
+        this->_queues.emplace_back(new Queue());
+    }
+    
+    // Worker 0 is the thread calling parallel_for.
+    for(unsigned int i=1; i<size; ++i)
+    {
+        this->_threads.emplace_back(&ThreadPool::_worker, this, i);
+    }
+}
+
+ThreadPool
+::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        this->_stop = true;
+    }
+    this->_start.notify_all();
+    for(auto && thread: this->_threads)
+    {
+        thread.join();
+    }
+}
+
+ThreadPool &
+ThreadPool
+::shared(unsigned int size)
+{
+    if(size == 0)
+    {
+        size = ThreadPool::_default_size();
+    }
+    
+    static std::mutex mutex;
+    static std::map<unsigned int, std::unique_ptr<ThreadPool>> pools;
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    auto & pool = pools[size];
+    if(!pool)
+    {
+        pool.reset(new ThreadPool(size));
+    }
+    return *pool;
+}
+
+unsigned int
+ThreadPool
+::size() const
+{
+    return this->_queues.size();
+}
+
+void
+ThreadPool
+::parallel_for(std::size_t size, Function const & function, std::size_t grain)
+{
+    if(size == 0)
+    {
+        return;
+    }
+    
+    if(ThreadPool::_running_task)
+    {
+        // Nested loop: the workers may all be busy with the enclosing loop,
+        // and _call_mutex may be held by the caller of the enclosing loop.
+        for(std::size_t i=0; i<size; ++i)
+        {
+            function(i);
+        }
+        return;
+    }
+    
+    std::lock_guard<std::mutex> call_lock(this->_call_mutex);
+    
+    if(grain == 0)
+    {
+        // Several tasks per worker, so that stealing can balance the load.
+        grain = std::max<std::size_t>(1, size/(8*this->size()));
+    }
+    
+    auto const tasks_count = (size+grain-1)/grain;
+    this->_pending = tasks_count;
+    this->_exception = nullptr;
+    
+    for(std::size_t task=0; task<tasks_count; ++task)
+    {
+        auto & queue = *this->_queues[task % this->size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(
+            {&function, task*grain, std::min(size, (task+1)*grain)});
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        ++this->_generation;
+    }
+    this->_start.notify_all();
+    
+    this->_run(0);
+    
+    {
+        std::unique_lock<std::mutex> lock(this->_mutex);
+        this->_done.wait(lock, [&]() { return this->_pending == 0; });
+    }
+    
+    if(this->_exception)
+    {
+        std::rethrow_exception(this->_exception);
+    }
+}
+
+void
+ThreadPool
+::_worker(unsigned int index)
+{
+    std::size_t generation = 0;
+    while(true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(this->_mutex);
+            this->_start.wait(
+                lock, [&]() {
+                    return this->_stop || this->_generation != generation; });
+            if(this->_stop)
+            {
+                return;
+            }
+            generation = this->_generation;
+        }
+        
+        this->_run(index);
+    }
+}
+
+void
+ThreadPool
+::_run(unsigned int index)
+{
+    // All tasks are queued before the workers start: once no task can be
+    // found, the worker is done for this loop.
+    Task task;
+    while(this->_pop(index, task))
+    {
+        ThreadPool::_running_task = true;
+        try
+        {
+            for(auto i=task.begin; i<task.end; ++i)
+            {
+                (*task.function)(i);
+            }
+        }
+        catch(...)
+        {
+            std::lock_guard<std::mutex> lock(this->_mutex);
+            if(!this->_exception)
+            {
+                this->_exception = std::current_exception();
+            }
+        }
+        ThreadPool::_running_task = false;
+        
+        if(--this->_pending == 0)
+        {
+            std::lock_guard<std::mutex> lock(this->_mutex);
+            this->_done.notify_all();
+        }
+    }
+}
+
+unsigned int
+ThreadPool
+::_default_size()
+{
+    return std::max(1U, std::thread::hardware_concurrency());
+}
+
+bool
+ThreadPool
+::_pop(unsigned int index, Task & task)
+{
+    // Own tasks are taken from the back ...
+    {
+        auto & queue = *this->_queues[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if(!queue.tasks.empty())
+        {
+            task = queue.tasks.back();
+            queue.tasks.pop_back();
+            return true;
+        }
+    }
+    
+    // ... and stolen tasks from the front.
+    for(unsigned int offset=1; offset<this->size(); ++offset)
+    {
+        auto & queue = *this->_queues[(index+offset) % this->size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if(!queue.tasks.empty())
+        {
+            task = queue.tasks.front();
+            queue.tasks.pop_front();
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+}
@@ -0,0 +1,111 @@
+#ifndef _f1b92c78_d244_47d0_adef_2db8b6c88fdb
+#define _f1b92c78_d244_47d0_adef_2db8b6c88fdb
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sycomore
+{
+
+/**
+ * @brief Pool of threads running independent tasks, with work stealing.
+ *
+ * Each worker has its own queue of tasks, which it consumes from the back; a
+ * worker with an empty queue steals tasks from the front of the queues of
+ * other workers. The thread calling parallel_for is one of the workers.
+ *
+ * A parallel_for called from a task of any pool runs inline in the calling
+ * worker, so that nested parallel loops do not deadlock.
+ */
+class ThreadPool
+{
+public:
+    /// @brief Function called for each index of a parallel loop.
+    using Function = std::function<void(std::size_t)>;
+    
+    /**
+     * @brief Create a pool with given number of workers, including the calling
+     * thread. If 0, use the number of hardware threads.
+     */
+    ThreadPool(unsigned int size=0);
+    
+    ThreadPool(ThreadPool const &) = delete;
+    ThreadPool(ThreadPool &&) = delete;
+    ThreadPool & operator=(ThreadPool const &) = delete;
+    ThreadPool & operator=(ThreadPool &&) = delete;
+    
+    /// @brief Wait for the workers to finish, and join them.
+    ~ThreadPool();
+    
+    /**
+     * @brief Return a long-lived pool with given number of workers, created
+     * on first use and shared by all callers. If 0, use the number of
+     * hardware threads.
+     */
+    static ThreadPool & shared(unsigned int size=0);
+    
+    /// @brief Return the number of workers, including the calling thread.
+    unsigned int size() const;
+    
+    /**
+     * @brief Call function for each index in [0, size), in parallel, and
+     * return when all calls are done. Indices are grouped in tasks of grain
+     * size (automatically computed if 0). The first exception thrown by
+     * function is re-thrown in the calling thread. If called from a task, the
+     * loop runs sequentially in the calling thread.
+     */
+    void parallel_for(
+        std::size_t size, Function const & function, std::size_t grain=0);
+
+private:
+    struct Task
+    {
+        Function const * function;
+        std::size_t begin;
+        std::size_t end;
+    };
+    
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+    
+    std::vector<std::thread> _threads;
+    std::vector<std::unique_ptr<Queue>> _queues;
+    
+    /// @brief Serialize concurrent calls to parallel_for.
+    std::mutex _call_mutex;
+    
+    std::mutex _mutex;
+    std::condition_variable _start;
+    std::condition_variable _done;
+    std::size_t _generation;
+    bool _stop;
+    
+    /// @brief Number of tasks not yet completed in the current loop.
+    std::atomic<std::size_t> _pending;
+    
+    std::exception_ptr _exception;
+    
+    /// @brief Whether the current thread is running a task of any pool.
+    static thread_local bool _running_task;
+    
+    void _worker(unsigned int index);
+    void _run(unsigned int index);
+    bool _pop(unsigned int index, Task & task);
+    
+    static unsigned int _default_size();
+};
+
+}
+
+#endif // _f1b92c78_d244_47d0_adef_2db8b6c88fdb
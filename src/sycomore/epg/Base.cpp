@@ -1,13 +1,16 @@
 #include "Base.h"
 
 #include <cmath>
+#include <functional>
 #include <stdexcept>
+#include <utility>
 
 #include <xtensor/xview.hpp>
 
 #include "sycomore/epg/Model.h"
 #include "sycomore/epg/operators.h"
 #include "sycomore/epg/simd_api.h"
+#include "sycomore/HardPulseApproximation.h"
 #include "sycomore/Species.h"
 #include "sycomore/sycomore.h"
 #include "sycomore/units.h"
@@ -141,8 +144,10 @@ Base
     ArrayC result(ArrayC::shape_type{this->_model.pools, 3});
     for(std::size_t pool=0; pool < this->_model.pools; ++pool)
     {
-        result.unchecked(pool, 0) = this->_model.F[pool][order];
-        result.unchecked(pool, 1) = this->_model.F_star[pool][order];
+        result.unchecked(pool, 0) = 
+            this->_model.F[pool][this->_model.F_index(order)];
+        result.unchecked(pool, 1) = 
+            this->_model.F_star[pool][this->_model.F_star_index(order)];
         result.unchecked(pool, 2) = this->_model.Z[pool][order];
     }
     
@@ -158,10 +163,13 @@ Base
     ArrayC result(ArrayC::shape_type{this->size(), this->_model.pools, 3});
     for(std::size_t order=0; order<this->size(); ++order)
     {
+        auto const F_index = this->_model.F_index(order);
+        auto const F_star_index = this->_model.F_star_index(order);
         for(std::size_t pool=0; pool < this->_model.pools; ++pool)
         {
-            result.unchecked(order, pool, 0) = this->_model.F[pool][order];
-            result.unchecked(order, pool, 1) = this->_model.F_star[pool][order];
+            result.unchecked(order, pool, 0) = this->_model.F[pool][F_index];
+            result.unchecked(order, pool, 1) = 
+                this->_model.F_star[pool][F_star_index];
             result.unchecked(order, pool, 2) = this->_model.Z[pool][order];
         }
     }
@@ -169,6 +177,28 @@ Base
     return this->_model.pools > 1 ? result : xt::view(result, xt::all(), 0UL);
 }
 
+Base::StatesView
+Base
+::F_view(std::size_t pool)
+{
+    return this->_view(this->_model.F, this->_model.F_offset, pool);
+}
+
+Base::StatesView
+Base
+::F_star_view(std::size_t pool)
+{
+    return this->_view(
+        this->_model.F_star, this->_model.F_star_offset, pool);
+}
+
+Base::StatesView
+Base
+::Z_view(std::size_t pool)
+{
+    return this->_view(this->_model.Z, 0, pool);
+}
+
 Quantity
 Base
 ::elapsed() const
@@ -180,7 +210,7 @@ Complex const &
 Base
 ::echo(std::size_t pool) const
 {
-    return this->_model.F[pool][0];
+    return this->_model.F[pool][this->_model.F_offset];
 }
 
 void
@@ -189,13 +219,15 @@ Base
 {
     if(this->_model.kind == Model::SinglePool)
     {
-        auto const T = operators::pulse_single_pool(
-            angle.magnitude, phase.magnitude);
+        auto const & T = OperatorCache::memoize(
+            this->_operator_cache.pulse_single_pool,
+            operators::pulse_single_pool, angle.magnitude, phase.magnitude);
         simd_api::apply_pulse_single_pool(T, this->_model, this->size());
     }
     else if(this->_model.kind == Model::Exchange)
     {
-        auto const T = operators::pulse_exchange(
+        auto const & T = OperatorCache::memoize(
+            this->_operator_cache.pulse_exchange, operators::pulse_exchange,
             angle.magnitude, phase.magnitude,
             angle.magnitude, phase.magnitude);
         simd_api::apply_pulse_exchange(T, this->_model, this->size());
@@ -217,7 +249,8 @@ Base
         throw std::runtime_error("Invalid model");
     }
     
-    auto const T = operators::pulse_exchange(
+    auto const & T = OperatorCache::memoize(
+        this->_operator_cache.pulse_exchange, operators::pulse_exchange,
         angle_a.magnitude, phase_a.magnitude,
         angle_b.magnitude, phase_b.magnitude);
     simd_api::apply_pulse_exchange(T, this->_model, this->size());
@@ -233,7 +266,9 @@ Base
         throw std::runtime_error("Invalid model");
     }
     
-    auto const T = operators::pulse_magnetization_transfer(
+    auto const & T = OperatorCache::memoize(
+        this->_operator_cache.pulse_magnetization_transfer,
+        operators::pulse_magnetization_transfer,
         angle_a.magnitude, phase_a.magnitude, saturation);
     simd_api::apply_pulse_magnetization_transfer(T, this->_model, this->size());
 }
@@ -249,14 +284,18 @@ Base
         {
             return;
         }
-        auto const E = operators::relaxation_single_pool(
+        auto const & E = OperatorCache::memoize(
+            this->_operator_cache.relaxation_single_pool,
+            operators::relaxation_single_pool,
             species.R1().magnitude, species.R2().magnitude, duration.magnitude);
         simd_api::relaxation_single_pool(E, this->_model, this->size());
         this->_model.Z[0][0] += this->_model.M0[0]*(1.-E.first);
     }
     else if(this->_model.kind == Model::Exchange)
     {
-        auto const E = operators::relaxation_exchange(
+        auto const & E = OperatorCache::memoize(
+            this->_operator_cache.relaxation_exchange,
+            operators::relaxation_exchange,
             this->_model.species[0].R1().magnitude,
             this->_model.species[0].R2().magnitude,
             this->_model.species[1].R1().magnitude,
@@ -265,28 +304,20 @@ Base
             this->_model.delta_b.magnitude,
             this->_model.M0[0], this->_model.M0[1],
             duration.magnitude);
-        simd_api::relaxation_exchange(
-            std::get<0>(E), std::get<1>(E), this->_model, this->size());
-        
-        auto const & recovery = std::get<2>(E);
-        this->_model.Z[0][0] += recovery[0];
-        this->_model.Z[1][0] += recovery[1];
+        this->_relaxation_exchange(E);
     }
     else if(this->_model.kind == Model::MagnetizationTransfer)
     {
-        auto const E = operators::relaxation_magnetization_transfer(
+        auto const & E = OperatorCache::memoize(
+            this->_operator_cache.relaxation_magnetization_transfer,
+            operators::relaxation_magnetization_transfer,
             this->_model.species[0].R1().magnitude,
             this->_model.species[0].R2().magnitude,
             this->_model.species[1].R1().magnitude,
             this->_model.k[0].magnitude, this->_model.k[1].magnitude,
             this->_model.M0[0], this->_model.M0[1],
             duration.magnitude);
-        simd_api::relaxation_magnetization_transfer(
-            std::get<0>(E), std::get<1>(E), this->_model, this->size());
-        
-        auto const & recovery = std::get<2>(E);
-        this->_model.Z[0][0] += recovery[0];
-        this->_model.Z[1][0] += recovery[1];
+        this->_relaxation_magnetization_transfer(E);
     }
     else
     {
@@ -307,14 +338,313 @@ Base
                 + this->_model.species[pool].delta_omega().magnitude);
         if(angle != 0)
         {
-            auto const Omega = operators::phase_accumulation(angle);
+            auto const & Omega = OperatorCache::memoize(
+                this->_operator_cache.phase_accumulation,
+                operators::phase_accumulation, angle);
             simd_api::off_resonance(
                 Omega, this->_model.F[pool], this->_model.F_star[pool],
+                this->_model.F_offset, this->_model.F_star_offset,
                 this->size());
         }
     }
 }
 
+Base::TimeIntervalOperators
+Base
+::_time_interval_operators(Real duration)
+{
+    TimeIntervalOperators result;
+    result.duration = duration;
+    
+    // The relaxation of exchange and MT models couples the pools, it cannot be
+    // applied separately on each population.
+    result.E = {1, 1};
+    if(this->_model.kind == Model::SinglePool)
+    {
+        auto const & species = this->_model.species[0];
+        result.E = OperatorCache::memoize(
+            this->_operator_cache.relaxation_single_pool,
+            operators::relaxation_single_pool,
+            species.R1().magnitude, species.R2().magnitude, duration);
+    }
+    else if(this->_model.kind == Model::Exchange)
+    {
+        result.E_exchange = OperatorCache::memoize(
+            this->_operator_cache.relaxation_exchange,
+            operators::relaxation_exchange,
+            this->_model.species[0].R1().magnitude,
+            this->_model.species[0].R2().magnitude,
+            this->_model.species[1].R1().magnitude,
+            this->_model.species[1].R2().magnitude,
+            this->_model.k[0].magnitude, this->_model.k[1].magnitude,
+            this->_model.delta_b.magnitude,
+            this->_model.M0[0], this->_model.M0[1],
+            duration);
+    }
+    else if(this->_model.kind == Model::MagnetizationTransfer)
+    {
+        result.E_magnetization_transfer = OperatorCache::memoize(
+            this->_operator_cache.relaxation_magnetization_transfer,
+            operators::relaxation_magnetization_transfer,
+            this->_model.species[0].R1().magnitude,
+            this->_model.species[0].R2().magnitude,
+            this->_model.species[1].R1().magnitude,
+            this->_model.k[0].magnitude, this->_model.k[1].magnitude,
+            this->_model.M0[0], this->_model.M0[1],
+            duration);
+    }
+    else
+    {
+        throw std::runtime_error("Invalid model");
+    }
+    
+    for(std::size_t pool=0; pool<this->_model.pools; ++pool)
+    {
+        auto const & species = this->_model.species[pool];
+        result.angle[pool] =
+            duration * 2*M_PI
+            * (this->delta_omega.magnitude + species.delta_omega().magnitude);
+        result.phi[pool] =
+            (result.angle[pool] != 0)
+            ? OperatorCache::memoize(
+                this->_operator_cache.phase_accumulation,
+                operators::phase_accumulation, result.angle[pool])
+            : operators::phase_accumulation(0);
+    }
+    
+    return result;
+}
+
+void
+Base
+::_time_interval(
+    Quantity const & duration, Real delta_k, Real const * k, Real velocity)
+{
+    this->_time_interval(
+        this->_time_interval_operators(duration.magnitude), delta_k, k,
+        velocity);
+}
+
+void
+Base
+::_time_interval(
+    TimeIntervalOperators const & operators, Real delta_k, Real const * k,
+    Real velocity)
+{
+    auto const & tau = operators.duration;
+    auto const & E = operators.E;
+    
+    if(this->_model.kind == Model::Exchange)
+    {
+        this->_relaxation_exchange(operators.E_exchange);
+    }
+    else if(this->_model.kind == Model::MagnetizationTransfer)
+    {
+        this->_relaxation_magnetization_transfer(
+            operators.E_magnetization_transfer);
+    }
+    
+    for(std::size_t pool=0; pool<this->_model.pools; ++pool)
+    {
+        auto const & species = this->_model.species[pool];
+        
+        auto const angle = operators.angle[pool];
+        auto const D = species.D().unchecked(0, 0).magnitude;
+        auto const k_pool = (D != 0 || velocity != 0) ? k : nullptr;
+        if(E.first == 1 && E.second == 1 && angle == 0 && k_pool == nullptr)
+        {
+            continue;
+        }
+        
+        simd_api::time_interval(
+            E, delta_k, tau, D, velocity, operators.phi[pool], k_pool,
+            this->_model.F[pool], this->_model.F_star[pool],
+            this->_model.Z[pool],
+            this->_model.F_offset, this->_model.F_star_offset, this->size());
+    }
+    
+    if(this->_model.kind == Model::SinglePool)
+    {
+        this->_model.Z[0][0] += this->_model.M0[0]*(1.-E.first);
+    }
+}
+
+void
+Base
+::_apply_shaped_pulse(
+    HardPulseApproximation const & pulse,
+    std::function<void(TimeIntervalOperators const &)> const & time_interval,
+    bool shared_operators)
+{
+    // The saturation of the bound pool depends on the shape of the pulse, not
+    // only on its hard pulses.
+    if(
+        this->_model.kind != Model::SinglePool
+        && this->_model.kind != Model::Exchange)
+    {
+        throw std::runtime_error("Invalid model");
+    }
+    
+    TimeIntervalOperators operators{};
+    if(shared_operators)
+    {
+        operators = this->_time_interval_operators(pulse.duration().magnitude);
+    }
+    
+    // The hard pulses have different angles: their operators are computed
+    // directly, so that they do not evict the operators of the rest of the
+    // sequence from the cache.
+    for(auto && hard_pulse: pulse.pulses())
+    {
+        auto const angle = hard_pulse.angle().magnitude;
+        auto const phase = hard_pulse.phase().magnitude;
+        if(this->_model.kind == Model::SinglePool)
+        {
+            simd_api::apply_pulse_single_pool(
+                operators::pulse_single_pool(angle, phase), this->_model,
+                this->size());
+        }
+        else
+        {
+            simd_api::apply_pulse_exchange(
+                operators::pulse_exchange(angle, phase, angle, phase),
+                this->_model, this->size());
+        }
+        
+        time_interval(operators);
+    }
+}
+
+void
+Base
+::_relaxation_exchange(
+    std::tuple<
+            std::array<Complex, 8>, std::array<Real, 4>, std::array<Real, 2>
+        > const & E)
+{
+    simd_api::relaxation_exchange(
+        std::get<0>(E), std::get<1>(E), this->_model, this->size());
+    
+    auto const & recovery = std::get<2>(E);
+    this->_model.Z[0][0] += recovery[0];
+    this->_model.Z[1][0] += recovery[1];
+}
+
+void
+Base
+::_relaxation_magnetization_transfer(
+    std::tuple<Real, std::array<Real, 4>, std::array<Real, 2>> const & E)
+{
+    simd_api::relaxation_magnetization_transfer(
+        std::get<0>(E), std::get<1>(E), this->_model, this->size());
+    
+    auto const & recovery = std::get<2>(E);
+    this->_model.Z[0][0] += recovery[0];
+    this->_model.Z[1][0] += recovery[1];
+}
+
+std::size_t
+Base
+::operator_cache_hits() const
+{
+    return this->_operator_cache.hits();
+}
+
+std::size_t
+Base
+::operator_cache_misses() const
+{
+    return this->_operator_cache.misses();
+}
+
+std::size_t
+Base
+::operator_cache_capacity() const
+{
+    // All caches have the same capacity.
+    return this->_operator_cache.pulse_single_pool.capacity();
+}
+
+void
+Base
+::set_operator_cache_capacity(std::size_t capacity)
+{
+    this->_operator_cache.set_capacity(capacity);
+}
+
+Base::StatesView
+Base
+::_view(
+    std::vector<Model::Population> const & population,
+    std::size_t const & offset, std::size_t pool)
+{
+    if(pool >= this->_model.pools)
+    {
+        throw std::runtime_error("Invalid pool");
+    }
+    
+    auto const size = this->size();
+    
+    // Only states wrapping around the end of the storage require a contiguous
+    // copy. Linearizing resets the offset.
+    if(offset+size > population[pool].size())
+    {
+        this->_model.linearize();
+    }
+    
+    return xt::adapt(
+        static_cast<Complex const *>(population[pool].data()+offset), size,
+        xt::no_ownership(), std::array<std::size_t, 1>{size});
+}
+
+std::size_t
+Base::OperatorCache
+::hits() const
+{
+    return
+        this->pulse_single_pool.hits() + this->pulse_exchange.hits()
+        + this->pulse_magnetization_transfer.hits()
+        + this->relaxation_single_pool.hits()
+        + this->relaxation_exchange.hits()
+        + this->relaxation_magnetization_transfer.hits()
+        + this->phase_accumulation.hits();
+}
+
+std::size_t
+Base::OperatorCache
+::misses() const
+{
+    return
+        this->pulse_single_pool.misses() + this->pulse_exchange.misses()
+        + this->pulse_magnetization_transfer.misses()
+        + this->relaxation_single_pool.misses()
+        + this->relaxation_exchange.misses()
+        + this->relaxation_magnetization_transfer.misses()
+        + this->phase_accumulation.misses();
+}
+
+void
+Base::OperatorCache
+::set_capacity(std::size_t capacity)
+{
+    this->pulse_single_pool.set_capacity(capacity);
+    this->pulse_exchange.set_capacity(capacity);
+    this->pulse_magnetization_transfer.set_capacity(capacity);
+    this->relaxation_single_pool.set_capacity(capacity);
+    this->relaxation_exchange.set_capacity(capacity);
+    this->relaxation_magnetization_transfer.set_capacity(capacity);
+    this->phase_accumulation.set_capacity(capacity);
+}
+
+template<typename C, typename Function, typename ... Args>
+typename C::value_type const &
+Base::OperatorCache
+::memoize(C & cache, Function function, Args ... args)
+{
+    return cache.get({args...}, [&]() { return function(args...); });
+}
+
+
 }
 
 }
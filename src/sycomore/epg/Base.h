@@ -1,8 +1,20 @@
 #ifndef _d635f223_7e0b_4f80_ab43_c03b499864f2
 #define _d635f223_7e0b_4f80_ab43_c03b499864f2
 
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <xtensor/xadapt.hpp>
+
 #include "sycomore/Array.h"
 #include "sycomore/epg/Model.h"
+#include "sycomore/HardPulseApproximation.h"
+#include "sycomore/hash.h"
+#include "sycomore/LRUCache.h"
 #include "sycomore/Species.h"
 #include "sycomore/sycomore.h"
 #include "sycomore/units.h"
@@ -23,6 +35,12 @@ public:
     /// @brief Threshold used to cull states with low population
     Real threshold=0;
     
+    /// @brief Read-only view of the states of a population.
+    using StatesView = decltype(
+        xt::adapt(
+            std::declval<Complex const *>(), std::size_t(), xt::no_ownership(),
+            std::declval<std::array<std::size_t, 1>>()));
+    
     /// @brief Create a single-pool model
     Base(
         Species const & species, Vector3R const & initial_magnetization,
@@ -104,6 +122,23 @@ public:
      */
     ArrayC states() const;
     
+    /**
+     * @brief Return a view of the F states of a pool, ordered as the orders
+     * of the model.
+     *
+     * The view is valid until the next call to a non-const member function.
+     * It shares the memory of the model unless the states of a circular
+     * population wrap around the end of its storage: the populations are then
+     * linearized first, in O(capacity).
+     */
+    StatesView F_view(std::size_t pool=0);
+    
+    /// @brief Return a view of the F* states of a pool, see F_view.
+    StatesView F_star_view(std::size_t pool=0);
+    
+    /// @brief Return a view of the Z states of a pool, see F_view.
+    StatesView Z_view(std::size_t pool=0);
+    
     /// @brief Return the elapsed time.
     Quantity elapsed() const;
     
@@ -131,12 +166,139 @@ public:
      */
     void off_resonance(Quantity const & duration);
     
+    /// @brief Return the number of operators found in the operator cache.
+    std::size_t operator_cache_hits() const;
+    
+    /// @brief Return the number of operators computed by the operator cache.
+    std::size_t operator_cache_misses() const;
+    
+    /// @brief Return the number of operators of each kind kept in the cache.
+    std::size_t operator_cache_capacity() const;
+    
+    /// @brief Set the number of operators of each kind kept in the cache.
+    void set_operator_cache_capacity(std::size_t capacity);
+    
 protected:
     /// @brief EPG model
     Model _model;
     
     /// @brief Elapsed time, in s
     Real _elapsed;
+    
+    /// @brief Operators of a time interval, which do not depend on the states.
+    class TimeIntervalOperators
+    {
+    public:
+        /// @brief Duration, in s
+        Real duration;
+        
+        /// @brief Relaxation of a single-pool model
+        std::pair<Real, Real> E;
+        
+        /// @brief Relaxation of an exchange model
+        std::tuple<
+                std::array<Complex, 8>, std::array<Real, 4>,
+                std::array<Real, 2>
+            > E_exchange;
+        
+        /// @brief Relaxation of a magnetization transfer model
+        std::tuple<Real, std::array<Real, 4>, std::array<Real, 2>>
+            E_magnetization_transfer;
+        
+        /// @brief Off-resonance angle and operator of each pool
+        std::array<Real, 2> angle;
+        std::array<std::pair<Complex, Complex>, 2> phi;
+    };
+    
+    /// @brief Return the operators of a time interval of given duration (s).
+    TimeIntervalOperators _time_interval_operators(Real duration);
+    
+    /**
+     * @brief Apply the relaxation, diffusion, bulk motion, and off-resonance
+     * operators in a single pass over the states. Diffusion and bulk motion
+     * are skipped if the dephasing of the states, k, is null.
+     */
+    void _time_interval(
+        Quantity const & duration, Real delta_k, Real const * k,
+        Real velocity);
+    
+    /// @brief Apply the operators of a time interval, see above.
+    void _time_interval(
+        TimeIntervalOperators const & operators, Real delta_k, Real const * k,
+        Real velocity);
+    
+    /**
+     * @brief Apply the hard pulses of a shaped pulse, each one followed by a
+     * call to time_interval. If shared_operators is true, the operators of
+     * the time interval are computed once and shared by all hard pulses;
+     * otherwise, time_interval receives empty operators.
+     *
+     * Magnetization transfer models are rejected before any modification.
+     */
+    void _apply_shaped_pulse(
+        HardPulseApproximation const & pulse,
+        std::function<void(TimeIntervalOperators const &)> const &
+            time_interval,
+        bool shared_operators=true);
+    
+    /// @brief Apply the relaxation operator of an exchange model.
+    void _relaxation_exchange(
+        std::tuple<
+                std::array<Complex, 8>, std::array<Real, 4>,
+                std::array<Real, 2>
+            > const & E);
+    
+    /// @brief Apply the relaxation operator of a magnetization transfer model.
+    void _relaxation_magnetization_transfer(
+        std::tuple<Real, std::array<Real, 4>, std::array<Real, 2>> const & E);
+    
+    /**
+     * @brief Pulse, relaxation, and off-resonance operators, keyed on all
+     * their parameters: repeated sequence blocks skip their computation.
+     */
+    class OperatorCache
+    {
+    public:
+        template<std::size_t N, typename T>
+        using Cache = LRUCache<std::array<Real, N>, T, ArrayHash<Real, N>>;
+        
+        Cache<2, std::array<Complex, 9>> pulse_single_pool;
+        Cache<4, std::array<Complex, 18>> pulse_exchange;
+        Cache<3, std::array<Complex, 10>> pulse_magnetization_transfer;
+        
+        Cache<3, std::pair<Real, Real>> relaxation_single_pool;
+        Cache<
+                10,
+                std::tuple<
+                    std::array<Complex, 8>, std::array<Real, 4>,
+                    std::array<Real, 2>>
+            > relaxation_exchange;
+        Cache<
+                8,
+                std::tuple<Real, std::array<Real, 4>, std::array<Real, 2>>
+            > relaxation_magnetization_transfer;
+        
+        Cache<1, std::pair<Complex, Complex>> phase_accumulation;
+        
+        std::size_t hits() const;
+        std::size_t misses() const;
+        void set_capacity(std::size_t capacity);
+        
+        /// @brief Return function(args...), computed only if not in cache.
+        template<typename C, typename Function, typename ... Args>
+        static typename C::value_type const & memoize(
+            C & cache, Function function, Args ... args);
+    };
+    
+    OperatorCache _operator_cache;
+    
+    /**
+     * @brief Return a view of the size() states of a population, stored from
+     * the given offset.
+     */
+    StatesView _view(
+        std::vector<Model::Population> const & population,
+        std::size_t const & offset, std::size_t pool);
 };
 
 }
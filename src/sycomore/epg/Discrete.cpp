@@ -3,7 +3,7 @@
 #include <algorithm>
 #include <cmath>
 #include <complex>
-#include <cstring>
+#include <limits>
 #include <vector>
 
 #include <xsimd/xsimd.hpp>
@@ -12,8 +12,8 @@
 #include "sycomore/Array.h"
 #include "sycomore/epg/Base.h"
 #include "sycomore/epg/operators.h"
-#include "sycomore/epg/robin_hood.h"
 #include "sycomore/epg/simd_api.h"
+#include "sycomore/HardPulseApproximation.h"
 #include "sycomore/Quantity.h"
 #include "sycomore/Species.h"
 #include "sycomore/TimeInterval.h"
@@ -81,8 +81,9 @@ Discrete
 {
     std::size_t const k = std::lround(double(order/this->_bin_width));
 
-    auto const it = std::find(this->_orders.begin(), this->_orders.end(), k);
-    if(it == this->_orders.end())
+    auto const it = std::lower_bound(
+        this->_orders.begin(), this->_orders.end(), k);
+    if(it == this->_orders.end() || *it != k)
     {
         std::ostringstream message;
         message << "No such order: " << order;
@@ -98,89 +99,9 @@ Discrete
 ::apply_time_interval(
     Quantity const & duration, Quantity const & gradient)
 {
-    if(duration.magnitude == 0)
-    {
-        return;
-    }
-    
-    this->relaxation(duration);
-    this->diffusion(duration, gradient);
-    this->bulk_motion(duration, gradient);
-    this->shift(duration, gradient);
-    this->off_resonance(duration);
-    
-    this->_elapsed += duration.magnitude;
-    
-    if(this->threshold > 0)
-    {
-        auto const threshold_squared = std::pow(this->threshold, 2);
-        
-        // NOTE: calling pow(abs(this->_model.F[p][i]), 2) is rather
-        // expensive. Since we don't care about abs(this->_model.F[p][i]),
-        // we just need the sum of squares of real part and imaginary part.
-        static std::array<double *, 2> F{nullptr, nullptr};
-        static std::array<double *, 2> F_star{nullptr, nullptr};
-        static std::array<double *, 2> Z{nullptr, nullptr};
-        F[0] = reinterpret_cast<double*>(this->_model.F[0].data());
-        F_star[0] = reinterpret_cast<double*>(this->_model.F_star[0].data());
-        Z[0] = reinterpret_cast<double*>(this->_model.Z[0].data());
-        if(this->_model.pools==2)
-        {
-            F[1] = reinterpret_cast<double*>(this->_model.F[1].data());
-            F_star[1] = reinterpret_cast<double*>(this->_model.F_star[1].data());
-            Z[1] = reinterpret_cast<double*>(this->_model.Z[1].data());
-        }
-        
-        // Always include the zero order (implicit since we start at 1),
-        // include other order if population is above threshold.
-        std::size_t destination=1;
-        for(std::size_t source=1, end=this->size(); source != end; ++source)
-        {
-            // Indices of real and imaginary part in Real-F, F_star, Z
-            std::size_t const r = 2*source;
-            std::size_t const i = 2*source+1;
-                
-            Real max_magnitude_squared = 0.;
-            for(std::size_t pool=0; pool<this->_model.pools; ++pool)
-            {
-                
-                auto const magnitude_squared = 
-                    F[pool][r]*F[pool][r] + F[pool][i]*F[pool][i]
-                    + F_star[pool][r]*F_star[pool][r] + F_star[pool][i]*F_star[pool][i]
-                    + Z[pool][r]*Z[pool][r] + Z[pool][i]*Z[pool][i];
-                max_magnitude_squared = std::max(
-                    max_magnitude_squared, magnitude_squared);
-            }
-            
-            if(max_magnitude_squared >= threshold_squared)
-            {
-                if(source != destination)
-                {
-                    this->_orders[destination] = this->_orders[source];
-                    for(std::size_t pool=0; pool<this->_model.pools; ++pool)
-                    {
-                        this->_model.F[pool][destination] =
-                            this->_model.F[pool][source];
-                        this->_model.F_star[pool][destination] =
-                            this->_model.F_star[pool][source];
-                        this->_model.Z[pool][destination] =
-                            this->_model.Z[pool][source];
-                    }
-                }
-                ++destination;
-            }
-        }
-        
-        this->_orders.resize(destination);
-        for(std::size_t pool=0; pool<this->_model.pools; ++pool)
-        {
-            this->_model.F[pool].resize(destination);
-            this->_model.F_star[pool].resize(destination);
-            this->_model.Z[pool].resize(destination);
-                
-            // No need to update the iterator pointing to the echo magnetization.
-        }
-    }
+    this->_apply_time_interval(
+        duration, gradient,
+        this->_time_interval_operators(duration.magnitude));
 }
 
 void
@@ -191,6 +112,19 @@ Discrete
         interval.duration(), interval.gradient_amplitude()[0]);
 }
 
+void
+Discrete
+::apply_shaped_pulse(
+    HardPulseApproximation const & pulse, Quantity const & gradient)
+{
+    this->_apply_shaped_pulse(
+        pulse,
+        [&](TimeIntervalOperators const & operators) {
+            this->_apply_time_interval(
+                pulse.duration(), gradient, operators);
+        });
+}
+
 void
 Discrete
 ::shift(Quantity const & duration, Quantity const & gradient)
@@ -208,63 +142,88 @@ Discrete
     
     this->_cache.update_shift(this->size());
     
-    for(std::size_t i=0, end=this->size(); i != end; ++i)
+    // The orders are positive and sorted. The new orders are the merge of four
+    // sorted sequences, where s=|Δk|:
+    // - k for the Z states,
+    // - k+s for the states moving away from the echo (F if Δk>0, F* else),
+    // - k-s for the other states if k ≥ s,
+    // - s-k for the other states if 0 < k < s: they cross the echo, change
+    //   half space, and are conjugated.
+    // The F* state at echo is a duplicate of the F state, and is skipped.
+    auto const & orders = this->_orders;
+    std::size_t const size = orders.size();
+    long long const steps = std::abs(delta_k);
+    
+    auto & up = (delta_k > 0) ? this->_model.F : this->_model.F_star;
+    auto & down = (delta_k > 0) ? this->_model.F_star : this->_model.F;
+    auto & new_up = (delta_k > 0) ? this->_cache.F : this->_cache.F_star;
+    auto & new_down = (delta_k > 0) ? this->_cache.F_star : this->_cache.F;
+    
+    // States in [1, crossing_end) cross the echo, in decreasing new order.
+    std::size_t const crossing_end = 
+        std::lower_bound(orders.begin(), orders.end(), steps)-orders.begin();
+    
+    std::size_t i_Z=0, i_up=0, i_down=crossing_end, i_crossing=crossing_end;
+    
+    auto constexpr none = std::numeric_limits<long long>::max();
+    std::size_t destination=0;
+    while(i_Z != size || i_up != size || i_down != size || i_crossing > 1)
     {
-        auto const k = this->_orders[i];
+        auto const k_Z = (i_Z != size) ? orders[i_Z] : none;
+        auto const k_up = (i_up != size) ? orders[i_up]+steps : none;
+        auto const k_down = (i_down != size) ? orders[i_down]-steps : none;
+        auto const k_crossing = 
+            (i_crossing > 1) ? steps-orders[i_crossing-1] : none;
+        auto const k = std::min({k_Z, k_up, k_down, k_crossing});
         
+        // Always keep the echo, keep other orders if they are populated.
+        bool populated = (k == 0);
         for(std::size_t pool=0; pool<this->_model.pools; ++pool)
         {
-            auto state = this->_model.Z[pool][i];
-            if(state != 0.)
-            {
-                this->_cache.Z[pool][this->_cache.location(k)] = state;
-            }
+            Complex const Z = (k == k_Z) ? this->_model.Z[pool][i_Z] : 0.;
             
-            state = this->_model.F[pool][i];
-            if(state != 0.)
+            // Crossing states and states moving away from the echo never
+            // share an order: the former are below s, the latter above.
+            Complex state_up = 0.;
+            if(k == k_up)
             {
-                auto k_F = k+delta_k;
-                
-                // Depending on whether the new order changed half space,
-                // conjugate the state and store it in F* instead of F.
-                auto destination = &this->_cache.F[pool];
-                if(k_F < 0)
-                {
-                    k_F *= -1;
-                    destination = &this->_cache.F_star[pool];
-                    state = std::conj(state);
-                }
-                (*destination)[this->_cache.location(k_F)] = state;
+                state_up = 
+                    (i_up == 0 && delta_k < 0)
+                    ? std::conj(this->_model.F[pool][0]) : up[pool][i_up];
             }
-            
-            // WARNING: F* state at echo is a duplicate of F state.
-            state = this->_model.F_star[pool][i];
-            if(i != 0 && state != 0.)
+            else if(k == k_crossing)
             {
-                // The F* order corresponding to F order k+Δk is -(-k+Δk),
-                // i.e. k-Δk
-                auto k_F_star = k-delta_k;
-                
-                // Same as above.
-                auto destination = &this->_cache.F_star[pool];
-                if(k_F_star < 0)
-                {
-                    k_F_star *= -1;
-                    destination = &this->_cache.F[pool];
-                    state = std::conj(state);
-                }
-                (*destination)[this->_cache.location(k_F_star)] = state;
+                state_up = std::conj(down[pool][i_crossing-1]);
             }
+            
+            Complex const state_down = 
+                (k == k_down) ? down[pool][i_down] : 0.;
+            
+            this->_cache.Z[pool][destination] = Z;
+            new_up[pool][destination] = state_up;
+            new_down[pool][destination] = state_down;
+            
+            populated = 
+                populated || Z != 0. || state_up != 0. || state_down != 0.;
         }
+        
+        i_Z += (k == k_Z);
+        i_up += (k == k_up);
+        i_down += (k == k_down);
+        i_crossing -= (k == k_crossing);
+        
+        // Unpopulated orders are overwritten by the next one.
+        this->_cache.orders[destination] = k;
+        destination += populated;
     }
     
     // Update the current orders and states with the new ones.
-    this->_cache.orders.resize(this->_cache.locations.size());
+    this->_cache.orders.resize(destination);
     for(std::size_t pool=0; pool<this->_model.pools; ++pool)
     {
-        this->_cache.F[pool].resize(this->_cache.locations.size());
-        this->_cache.F_star[pool].resize(this->_cache.locations.size());
-        this->_cache.Z[pool].resize(this->_cache.locations.size());
+        this->_cache.F[pool].resize(destination);
+        this->_cache.F_star[pool].resize(destination);
+        this->_cache.Z[pool].resize(destination);
     }
         
     // Use swap and not move since we keep the temporary variables between
@@ -326,7 +285,7 @@ Discrete
         simd_api::diffusion(
             delta_k, tau, D, this->_cache.k.data(),
             this->_model.F[pool], this->_model.F_star[pool], this->_model.Z[pool],
-            this->size());
+            this->_model.F_offset, this->_model.F_star_offset, this->size());
     }
 }
 
@@ -363,6 +322,49 @@ Discrete
     return this->_bin_width;
 }
 
+void
+Discrete
+::_apply_time_interval(
+    Quantity const & duration, Quantity const & gradient,
+    TimeIntervalOperators const & operators)
+{
+    if(duration.magnitude == 0)
+    {
+        return;
+    }
+    
+    // Relaxation, diffusion, bulk motion and off-resonance are applied in a
+    // single pass before the shift, as in Regular::apply_time_interval.
+    auto const delta_k =
+        sycomore::gamma.magnitude * duration.magnitude * gradient.magnitude;
+    Real const * k = nullptr;
+    if(
+        delta_k != 0 && (
+            this->velocity.magnitude != 0
+            || std::any_of(
+                this->_model.species.begin(), this->_model.species.end(),
+                [](Species const & s) {
+                    return s.D().unchecked(0, 0).magnitude != 0; })))
+    {
+        this->_cache.update_diffusion(
+            this->size(), this->_orders, this->_bin_width.magnitude);
+        k = this->_cache.k.data();
+    }
+    this->_time_interval(operators, delta_k, k, this->velocity.magnitude);
+    this->shift(duration, gradient);
+    
+    this->_elapsed += duration.magnitude;
+    
+    if(this->threshold > 0)
+    {
+        this->_cache.magnitude.resize(this->size());
+        auto const size = simd_api::cull(
+            this->threshold, this->_model, this->_orders.data(), 1,
+            this->size(), this->_cache.magnitude.data());
+        this->_orders.resize(size);
+    }
+}
+
 Discrete::Cache
 ::Cache(std::size_t pools)
 : orders(0), F(pools), F_star(pools), Z(pools)
@@ -374,43 +376,15 @@ void
 Discrete::Cache
 ::update_shift(std::size_t size)
 {
-    // New (i.e. shifted) orders. We will have at most 3*N_states new states
+    // New (i.e. shifted) orders. We will have at most 3*N_states new states.
+    // All new states are written by the shift: no need to clear them.
     this->orders.resize(3*size);
-    this->locations.clear();
-    this->locations.reserve(3*size);
-    
-    // Make sure k=0 is in the first position.
-    this->orders[0] = 0;
-    this->locations[0] = 0;
-    
-    // Same for F states.
-    for(auto & F: this->F)
-    {
-        F.resize(3*size);
-        // NOTE memset is slightly faster than std::fill, but requires that
-        // Complex has a trivial representation.
-        static_assert(
-            std::is_trivially_copyable<Complex>::value, 
-            "Complex cannot be used with memset");
-        std::memset(
-            reinterpret_cast<void*>(F.data()), 0, F.size()*sizeof(Complex));
-    }
-    
-    // Same for F* states.
-    for(auto & F_star: this->F_star)
-    {
-        F_star.resize(3*size);
-        std::memset(
-            reinterpret_cast<void*>(F_star.data()), 0,
-            F_star.size()*sizeof(Complex));
-    }
-    
-    // Same for Z states.
-    for(auto & Z: this->Z)
+    for(auto * populations: {&this->F, &this->F_star, &this->Z})
     {
-        Z.resize(3*size);
-        std::memset(
-            reinterpret_cast<void*>(Z.data()), 0, Z.size()*sizeof(Complex));
+        for(auto & population: *populations)
+        {
+            population.resize(3*size);
+        }
     }
 }
 
@@ -425,19 +399,6 @@ Discrete::Cache
     }
 }
 
-std::size_t
-Discrete::Cache
-::location(long long order) 
-{
-    auto const location = this->locations.size();
-    auto const insert_result = this->locations.try_emplace(order, location);
-    if(insert_result.second)
-    {
-        this->orders[location] = order;
-    }
-    return insert_result.first->second;
-}
-
 }
 
 }
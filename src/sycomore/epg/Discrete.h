@@ -8,7 +8,7 @@
 #include "sycomore/Array.h"
 #include "sycomore/Buffer.h"
 #include "sycomore/epg/Base.h"
-#include "sycomore/epg/robin_hood.h"
+#include "sycomore/HardPulseApproximation.h"
 #include "sycomore/Quantity.h"
 #include "sycomore/Species.h"
 #include "sycomore/sycomore.h"
@@ -93,6 +93,14 @@ public:
      */
     void apply_time_interval(TimeInterval const & interval);
 
+    /**
+     * @brief Apply a shaped pulse: each of its hard pulses is followed by a
+     * time interval of the hard pulse duration, with given gradient.
+     */
+    void apply_shaped_pulse(
+        HardPulseApproximation const & pulse,
+        Quantity const & gradient=0*units::T/units::m);
+    
     /**
      * @brief Apply a gradient; in discrete EPG, this shifts all orders by
      * specified value.
@@ -117,28 +125,35 @@ public:
 private:
     using Orders = Buffer<long long>;
     Quantity _bin_width;
+    
+    /// @brief Apply a time interval with pre-computed operators.
+    void _apply_time_interval(
+        Quantity const & duration, Quantity const & gradient,
+        TimeIntervalOperators const & operators);
+    
+    /// @brief Orders of the states, positive and sorted.
     Orders _orders;
     
     // Data kept to avoid expansive re-allocation of memory.
     class Cache
     {
     public:
-        // Shift-related data.
-        // Mapping between a normalized (i.e. folded) order and its location in
-        // the states vectors.
-        robin_hood::unordered_flat_map<long long, std::size_t> locations;
+        // Shift-related data: new orders and states.
         Orders orders;
         std::vector<Model::Population> F, F_star, Z;
         
         // Diffusion-related data.
         Buffer<Real> k;
         
+        // Threshold-related data: squared magnitude of each order. This is
+        // per-instance so that independent models may run concurrently.
+        Buffer<Real> magnitude;
+        
         Cache(std::size_t pools);
         
         void update_shift(std::size_t size);
         void update_diffusion(
             std::size_t size, Orders const & orders, Real bin_width);
-        std::size_t location(long long order);
     };
     
     Cache _cache;
@@ -16,6 +16,7 @@
 #include "sycomore/epg/robin_hood.h"
 #include "sycomore/epg/operators.h"
 #include "sycomore/epg/simd_api.h"
+#include "sycomore/HardPulseApproximation.h"
 #include "sycomore/Quantity.h"
 #include "sycomore/Species.h"
 #include "sycomore/TimeInterval.h"
@@ -130,53 +131,11 @@ Discrete3D
     
     if(this->threshold > 0)
     {
-        auto const threshold_squared = std::pow(this->threshold, 2);
-        
-        // Always include the zero order (implicit since we start at 1),
-        // include other order if population is above threshold.
-        std::size_t destination=1;
-        for(std::size_t source=1, end=this->size(); source != end; ++source)
-        {
-            Real max_magnitude_squared = 0.;
-            for(std::size_t pool=0; pool<this->_model.pools; ++pool)
-            {
-                using std::pow; using std::abs;
-                auto const magnitude_squared = 
-                    pow(abs(this->_model.F[pool][source]), 2)
-                    +pow(abs(this->_model.F_star[pool][source]), 2)
-                    +pow(abs(this->_model.Z[pool][source]), 2);
-                max_magnitude_squared = std::max(
-                    max_magnitude_squared, magnitude_squared);
-            }
-            
-            if(max_magnitude_squared >= threshold_squared)
-            {
-                if(source != destination)
-                {
-                    this->_orders[destination] = this->_orders[source];
-                    for(std::size_t pool=0; pool<this->_model.pools; ++pool)
-                    {
-                        this->_model.F[pool][destination] =
-                            this->_model.F[pool][source];
-                        this->_model.F_star[pool][destination] =
-                            this->_model.F_star[pool][source];
-                        this->_model.Z[pool][destination] =
-                            this->_model.Z[pool][source];
-                    }
-                }
-                ++destination;
-            }
-        }
-
-        this->_orders.resize(destination);
-        for(std::size_t pool=0; pool<this->_model.pools; ++pool)
-        {
-            this->_model.F[pool].resize(destination);
-            this->_model.F_star[pool].resize(destination);
-            this->_model.Z[pool].resize(destination);
-                
-            // No need to update the iterator pointing to the echo magnetization.
-        }
+        this->_cache.magnitude.resize(this->size());
+        auto const size = simd_api::cull(
+            this->threshold, this->_model, this->_orders.data(), 3,
+            this->size(), this->_cache.magnitude.data());
+        this->_orders.resize(3*size);
     }
 }
 
@@ -188,6 +147,21 @@ Discrete3D
         interval.duration(), interval.gradient_amplitude()[0]);
 }
 
+void
+Discrete3D
+::apply_shaped_pulse(
+    HardPulseApproximation const & pulse, Vector3Q const & gradient)
+{
+    // The time interval of Discrete3D does not use the shared operators: do
+    // not compute them.
+    this->_apply_shaped_pulse(
+        pulse,
+        [&](TimeIntervalOperators const &) {
+            this->apply_time_interval(pulse.duration(), gradient);
+        },
+        false);
+}
+
 void
 Discrete3D
 ::shift(Quantity const & duration, Vector3Q const & gradient)
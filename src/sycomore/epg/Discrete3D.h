@@ -11,6 +11,7 @@
 #include "sycomore/Buffer.h"
 #include "sycomore/epg/Base.h"
 #include "sycomore/epg/robin_hood.h"
+#include "sycomore/HardPulseApproximation.h"
 #include "sycomore/Quantity.h"
 #include "sycomore/Species.h"
 #include "sycomore/sycomore.h"
@@ -105,6 +106,15 @@ public:
     /// @brief Apply a time interval, i.e. relaxation, diffusion, and gradient.
     void apply_time_interval(TimeInterval const & interval);
 
+    /**
+     * @brief Apply a shaped pulse: each of its hard pulses is followed by a
+     * time interval of the hard pulse duration, with given gradient.
+     */
+    void apply_shaped_pulse(
+        HardPulseApproximation const & pulse,
+        Vector3Q const & gradient={
+            0*units::T/units::m,0*units::T/units::m,0*units::T/units::m});
+    
     /**
      * @brief Apply a gradient; in discrete EPG, this shifts all orders by
      * specified value.
@@ -146,6 +156,9 @@ private:
         RealVector b_T_plus_D;
         RealVector b_T_minus_D;
         
+        // Threshold-related data: squared magnitude of each order.
+        RealVector magnitude;
+        
         Cache(std::size_t pools);
         
         void update_shift(std::size_t size);
@@ -1,5 +1,6 @@
 #include "Model.h"
 
+#include <algorithm>
 #include <stdexcept>
 #include <vector>
 #include <utility>
@@ -22,7 +23,7 @@ Model
     Species const & species, Vector3R const & M0, std::size_t initial_size)
 : kind(SinglePool), pools(1),
     species({species}), M0(pools), k(0), delta_b(0*units::Hz),
-    F(pools), F_star(pools), Z(pools)
+    F(pools), F_star(pools), Z(pools), F_offset(0), F_star_offset(0)
 {
     this->_initialize(M0, initial_size);
 }
@@ -35,7 +36,7 @@ Model
     std::size_t initial_size)
 : kind(Exchange), pools(2),
     species({species_a, species_b}), M0(pools), k(pools), delta_b(delta_b),
-    F(pools), F_star(pools), Z(pools)
+    F(pools), F_star(pools), Z(pools), F_offset(0), F_star_offset(0)
 {
     this->_initialize(M0_a, M0_b, initial_size);
     this->k = {
@@ -51,7 +52,7 @@ Model
 : kind(MagnetizationTransfer), pools(2),
     species({species_a, Species(R1_b_or_T1_b, 1*units::ns)}),
     M0(pools), k(pools), delta_b(0*units::Hz),
-    F(pools), F_star(pools), Z(pools)
+    F(pools), F_star(pools), Z(pools), F_offset(0), F_star_offset(0)
 {
     this->_initialize(M0_a, M0_b, initial_size);
     this->k = {
@@ -74,6 +75,8 @@ Model
     this->F = other.F;
     this->F_star = other.F_star;
     this->Z = other.Z;
+    this->F_offset = other.F_offset;
+    this->F_star_offset = other.F_star_offset;
     
     return *this;
 }
@@ -94,10 +97,44 @@ Model
     this->F = std::move(other.F);
     this->F_star = std::move(other.F_star);
     this->Z = std::move(other.Z);
+    this->F_offset = other.F_offset;
+    this->F_star_offset = other.F_star_offset;
     
     return *this;
 }
 
+std::size_t
+Model
+::F_index(std::size_t order) const
+{
+    return (this->F_offset+order) % this->F[0].size();
+}
+
+std::size_t
+Model
+::F_star_index(std::size_t order) const
+{
+    return (this->F_star_offset+order) % this->F_star[0].size();
+}
+
+void
+Model
+::linearize()
+{
+    for(std::size_t pool=0; pool<this->pools; ++pool)
+    {
+        auto & F = this->F[pool];
+        std::rotate(F.begin(), F.begin()+this->F_offset, F.end());
+        
+        auto & F_star = this->F_star[pool];
+        std::rotate(
+            F_star.begin(), F_star.begin()+this->F_star_offset, F_star.end());
+    }
+    
+    this->F_offset = 0;
+    this->F_star_offset = 0;
+}
+
 void
 Model
 ::_initialize(Vector3R const & M0, std::size_t initial_size)
@@ -52,6 +52,14 @@ public:
     /// @brief EPG Z states for each pool
     std::vector<Population> Z;
     
+    /**
+     * @brief Position of the order 0 in the F and F* populations of all pools.
+     *
+     * When non-zero, the populations are circular: the state of order k is
+     * stored at position (offset+k) modulo the population size.
+     */
+    std::size_t F_offset, F_star_offset;
+    
     /// @brief Create a single-pool model.
     Model(
         Species const & species, Vector3R const & M0,
@@ -80,6 +88,20 @@ public:
     /// @brief Default move assignment
     Model & operator=(Model && other);
     
+    /// @brief Position of the F state of given order in the populations.
+    std::size_t F_index(std::size_t order) const;
+    
+    /// @brief Position of the F* state of given order in the populations.
+    std::size_t F_star_index(std::size_t order) const;
+    
+    /**
+     * @brief Store the order 0 at the start of the F and F* populations.
+     *
+     * This rotates the populations, in O(capacity), if they have an offset,
+     * and does nothing otherwise.
+     */
+    void linearize();
+    
 private:
     void _initialize(Vector3R const & M0, std::size_t initial_size);
     void _initialize(
@@ -0,0 +1,914 @@
+#include "Program.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+#include "sycomore/epg/Model.h"
+#include "sycomore/epg/operators.h"
+#include "sycomore/epg/Regular.h"
+#include "sycomore/epg/simd_api.h"
+#include "sycomore/Sequence.h"
+#include "sycomore/Species.h"
+#include "sycomore/sycomore.h"
+
+namespace sycomore
+{
+
+namespace epg
+{
+
+Program
+::Program(Sequence const & sequence, Regular & model)
+: _kind(model.kind()), _unit_dephasing(model.unit_dephasing().magnitude),
+    _velocity(model.velocity.magnitude),
+    _fingerprint(Program::_compute_fingerprint(model)), _echoes(0)
+{
+    this->_instructions.reserve(sequence.size());
+    this->_compile(sequence, model);
+}
+
+std::size_t
+Program
+::size() const
+{
+    return this->_instructions.size();
+}
+
+std::size_t
+Program
+::echoes() const
+{
+    return this->_echoes;
+}
+
+std::vector<Complex>
+Program
+::run(Regular & model) const
+{
+    std::vector<Complex> echoes(this->_echoes);
+    this->run(model, echoes.data());
+    return echoes;
+}
+
+void
+Program
+::run(Regular & model, Complex * echoes) const
+{
+    this->_check(model);
+    
+    for(auto && instruction: this->_instructions)
+    {
+        this->_execute(instruction, model, echoes);
+    }
+}
+
+std::vector<Complex>
+Program
+::run(
+    Regular & model, std::vector<Parameter> const & parameters,
+    std::vector<Complex> & jacobian) const
+{
+    this->_check(model);
+    if(this->_kind != Model::SinglePool)
+    {
+        throw std::runtime_error("Invalid model");
+    }
+    
+    auto & x = model._model;
+    auto const M0 = x.M0[0];
+    
+    // Derivatives of the states, with the same layout as the model. The
+    // operators are affine: their derivatives are propagated without the
+    // recovery term.
+    std::vector<Regular> tangents(parameters.size(), model);
+    for(auto && tangent: tangents)
+    {
+        tangent._model.M0[0] = 0;
+        for(auto * population: {
+            &tangent._model.F[0], &tangent._model.F_star[0],
+            &tangent._model.Z[0]})
+        {
+            std::fill(population->begin(), population->end(), 0);
+        }
+    }
+    
+    // Derivative of the pulse applied to the states, shared by all B1
+    // tangents of a pulse. Its storage grows with the model and is reused.
+    auto const has_B1 =
+        std::find(parameters.begin(), parameters.end(), B1) != parameters.end();
+    Model dP_x = x;
+    
+    // Add factor(order, population)*x to a tangent, for the populations of
+    // the model (0: F, 1: F*, 2: Z). Only used when the factor depends on the
+    // order: constant factors use simd_api::add_scaled_single_pool.
+    auto const add = [&](Model & t, Model const & x, auto factor) {
+        for(std::size_t order=0; order<model.size(); ++order)
+        {
+            auto const F_index = x.F_index(order);
+            auto const F_star_index = x.F_star_index(order);
+            t.F[0][F_index] += factor(order, 0)*x.F[0][F_index];
+            t.F_star[0][F_star_index] +=
+                factor(order, 1)*x.F_star[0][F_star_index];
+            t.Z[0][order] += factor(order, 2)*x.Z[0][order];
+        }
+    };
+    
+    std::vector<Complex> echoes;
+    echoes.reserve(this->_echoes);
+    jacobian.clear();
+    jacobian.reserve(this->_echoes*parameters.size());
+    for(auto && instruction: this->_instructions)
+    {
+        if(instruction.kind == Instruction::Pulse)
+        {
+            // d(Px) = P dx + (dP) x
+            auto const & P = this->_pulses_single_pool[instruction.index];
+            if(has_B1)
+            {
+                // d/dB1 P(B1*angle) = angle*P'(angle), at B1=1
+                auto dP = this->_pulses_single_pool_angle[instruction.index];
+                auto const angle = this->_angles_single_pool[instruction.index];
+                for(auto && item: dP)
+                {
+                    item *= angle;
+                }
+                
+                dP_x.F[0] = x.F[0];
+                dP_x.F_star[0] = x.F_star[0];
+                dP_x.Z[0] = x.Z[0];
+                dP_x.F_offset = x.F_offset;
+                dP_x.F_star_offset = x.F_star_offset;
+                simd_api::apply_pulse_single_pool(dP, dP_x, model.size());
+            }
+            for(std::size_t p=0; p<parameters.size(); ++p)
+            {
+                auto & tangent = tangents[p];
+                simd_api::apply_pulse_single_pool(
+                    P, tangent._model, tangent.size());
+                if(parameters[p] == B1)
+                {
+                    simd_api::add_scaled_single_pool(
+                        {1., 1., 1.}, dP_x, tangent._model, model.size());
+                }
+            }
+            simd_api::apply_pulse_single_pool(P, x, model.size());
+        }
+        else if(instruction.kind == Instruction::TimeInterval)
+        {
+            auto const & interval = this->_time_intervals[instruction.index];
+            auto const & tau = interval.operators.duration;
+            
+            // The time interval operator is diagonal: its derivative is
+            // E'(x) = E(g*x) where g is the derivative of the logarithm of
+            // its diagonal.
+            for(std::size_t p=0; p<parameters.size(); ++p)
+            {
+                auto & t = tangents[p]._model;
+                if(parameters[p] == R1)
+                {
+                    simd_api::add_scaled_single_pool(
+                        {0., 0., -tau}, x, t, model.size());
+                }
+                else if(parameters[p] == R2)
+                {
+                    simd_api::add_scaled_single_pool(
+                        {-tau, -tau, 0.}, x, t, model.size());
+                }
+                else if(parameters[p] == D && interval.delta_k != 0)
+                {
+                    if(this->_unit_dephasing == 0)
+                    {
+                        throw std::runtime_error(
+                            "Cannot compute diffusion without unit dephasing");
+                    }
+                    
+                    // Opposite of the b-values of the diffusion operator
+                    auto const & delta_k = interval.delta_k;
+                    add(t, x, [&](std::size_t order, std::size_t population) {
+                        auto const k = order*interval.unit_k;
+                        if(population == 2)
+                        {
+                            return -tau*k*k;
+                        }
+                        auto const k_T = (population == 0 ? k : -k)+delta_k/2;
+                        return -tau*(k_T*k_T + delta_k*delta_k/12); });
+                }
+            }
+            
+            Real const * k = nullptr;
+            if(interval.update_k)
+            {
+                model._cache.update_diffusion(model.size(), interval.unit_k);
+                k = model._cache.k.data();
+            }
+            model._time_interval(
+                interval.operators, interval.delta_k, k, this->_velocity);
+            for(std::size_t p=0; p<parameters.size(); ++p)
+            {
+                auto & tangent = tangents[p];
+                tangent._time_interval(
+                    interval.operators, interval.delta_k, k, this->_velocity);
+                if(parameters[p] == R1)
+                {
+                    // Derivative of the recovery
+                    tangent._model.Z[0][0] +=
+                        M0*tau*interval.operators.E.first;
+                }
+            }
+            
+            model._shift(interval.steps);
+            model._elapsed += tau;
+            model._cull();
+            for(auto && tangent: tangents)
+            {
+                tangent._shift(interval.steps);
+                tangent._states_count = model._states_count;
+            }
+        }
+        else
+        {
+            echoes.push_back(model.echo());
+            for(auto && tangent: tangents)
+            {
+                jacobian.push_back(tangent.echo());
+            }
+        }
+    }
+    
+    return echoes;
+}
+
+std::vector<Complex>
+Program
+::gradient(
+    Regular & model, EchoesGradient const & echoes_gradient,
+    std::vector<Real> & angles, std::vector<Real> & phases,
+    std::size_t checkpoint_interval) const
+{
+    this->_check(model);
+    if(this->_kind != Model::SinglePool)
+    {
+        throw std::runtime_error("Invalid model");
+    }
+    
+    auto const size = this->_instructions.size();
+    if(checkpoint_interval == 0)
+    {
+        checkpoint_interval = std::max<std::size_t>(
+            1, std::lround(std::sqrt(size)));
+    }
+    
+    // Forward sweep
+    std::vector<Regular> checkpoints;
+    checkpoints.reserve(1+size/checkpoint_interval);
+    std::vector<Complex> echoes(this->_echoes);
+    auto * echo = echoes.data();
+    for(std::size_t i=0; i<size; ++i)
+    {
+        if(i % checkpoint_interval == 0)
+        {
+            checkpoints.push_back(model);
+        }
+        this->_execute(this->_instructions[i], model, echo);
+    }
+    
+    auto const gradient = echoes_gradient(echoes);
+    if(gradient.size() != echoes.size())
+    {
+        throw std::runtime_error(
+            "Gradient must contain one value per echo");
+    }
+    
+    // Adjoint states, in linear storage and without recovery.
+    Regular adjoint(model);
+    adjoint.circular_storage = false;
+    adjoint._model.linearize();
+    adjoint._model.M0[0] = 0;
+    for(auto * population: {
+        &adjoint._model.F[0], &adjoint._model.F_star[0], &adjoint._model.Z[0]})
+    {
+        std::fill(population->begin(), population->end(), 0);
+    }
+    auto & lambda = adjoint._model;
+    
+    auto pulse = std::count_if(
+        this->_instructions.begin(), this->_instructions.end(),
+        [](Instruction const & x) { return x.kind == Instruction::Pulse; });
+    angles.resize(pulse);
+    phases.resize(pulse);
+    auto echo_index = echoes.size();
+    
+    // Backward sweep, re-computing the states from the checkpoints.
+    std::vector<Regular> states;
+    states.reserve(checkpoint_interval);
+    Complex * ignored = nullptr;
+    for(std::size_t checkpoint=checkpoints.size(); checkpoint>0; --checkpoint)
+    {
+        auto const begin = (checkpoint-1)*checkpoint_interval;
+        auto const end = std::min(size, begin+checkpoint_interval);
+        
+        // States before each instruction of the segment. Since the echoes
+        // are already known, their instructions are skipped.
+        states.clear();
+        states.push_back(std::move(checkpoints[checkpoint-1]));
+        for(std::size_t i=begin; i+1<end; ++i)
+        {
+            // No re-allocation: the reference to the last state stays valid.
+            states.push_back(states.back());
+            if(this->_instructions[i].kind != Instruction::Echo)
+            {
+                this->_execute(this->_instructions[i], states.back(), ignored);
+            }
+        }
+        
+        for(std::size_t i=end; i>begin; --i)
+        {
+            auto const & instruction = this->_instructions[i-1];
+            auto const & x = states[i-1-begin];
+            if(instruction.kind == Instruction::Echo)
+            {
+                --echo_index;
+                lambda.F[0][0] += gradient[echo_index];
+            }
+            else if(instruction.kind == Instruction::Pulse)
+            {
+                // df/dp = <lambda, (dP/dp) x>, then lambda = P^H lambda
+                --pulse;
+                auto const & dP_angle =
+                    this->_pulses_single_pool_angle[instruction.index];
+                auto const & dP_phase =
+                    this->_pulses_single_pool_phase[instruction.index];
+                Real angle = 0, phase = 0;
+                for(std::size_t order=0; order<x.size(); ++order)
+                {
+                    std::array<Complex, 3> const v{
+                        x._model.F[0][x._model.F_index(order)],
+                        x._model.F_star[0][x._model.F_star_index(order)],
+                        x._model.Z[0][order]};
+                    std::array<Complex, 3> const l{
+                        lambda.F[0][order], lambda.F_star[0][order],
+                        lambda.Z[0][order]};
+                    for(std::size_t r=0; r<3; ++r)
+                    {
+                        Complex angle_r = 0, phase_r = 0;
+                        for(std::size_t c=0; c<3; ++c)
+                        {
+                            angle_r += dP_angle[3*r+c]*v[c];
+                            phase_r += dP_phase[3*r+c]*v[c];
+                        }
+                        angle += (std::conj(l[r])*angle_r).real();
+                        phase += (std::conj(l[r])*phase_r).real();
+                    }
+                }
+                angles[pulse] = angle;
+                phases[pulse] = phase;
+                
+                auto const & P = this->_pulses_single_pool[instruction.index];
+                std::array<Complex, 9> P_H;
+                for(std::size_t r=0; r<3; ++r)
+                {
+                    for(std::size_t c=0; c<3; ++c)
+                    {
+                        P_H[3*r+c] = std::conj(P[3*c+r]);
+                    }
+                }
+                simd_api::apply_pulse_single_pool(P_H, lambda, adjoint.size());
+            }
+            else
+            {
+                this->_adjoint_time_interval(
+                    this->_time_intervals[instruction.index], x, adjoint);
+            }
+        }
+    }
+    
+    return echoes;
+}
+
+std::vector<Complex>
+Program
+::steady_state(
+    Regular & model, Real tolerance, std::size_t max_size) const
+{
+    // The solver modifies the states and the threshold of the model: restore
+    // them if it fails.
+    auto const original = model;
+    try
+    {
+        return this->_steady_state(model, tolerance, max_size);
+    }
+    catch(...)
+    {
+        model = original;
+        throw;
+    }
+}
+
+std::vector<Complex>
+Program
+::_steady_state(
+    Regular & model, Real tolerance, std::size_t max_size) const
+{
+    // Number of reals per order, and maximum displacement of a state during
+    // the block: the block is an affine map whose linear part is banded in
+    // the order-major layout of the states.
+    std::size_t const width = 2*3*model._model.pools;
+    std::size_t reach = 0;
+    for(auto && instruction: this->_instructions)
+    {
+        if(instruction.kind == Instruction::TimeInterval)
+        {
+            reach += std::abs(this->_time_intervals[instruction.index].steps);
+        }
+    }
+    std::size_t const bandwidth = width*(reach+1)-1;
+    
+    auto const elapsed = model._elapsed;
+    auto const threshold = model.threshold;
+    
+    std::vector<Complex> x, f, echoes(this->_echoes);
+    auto size = std::max<std::size_t>(model.size(), 2*reach+1);
+    while(size <= max_size)
+    {
+        // Image of the states by the block, truncated to size orders.
+        // Culling would make the block non-linear: disable it until the
+        // fixed point is checked.
+        model.threshold = 0;
+        auto const block = [&](std::vector<Complex> const & states) {
+            Program::_unpack(states, model);
+            this->run(model, echoes.data());
+            Program::_pack(model, size, f);
+            return reinterpret_cast<Real const *>(f.data());
+        };
+        
+        // Constant part of the block, b = block(0).
+        std::size_t const n = width*size;
+        std::vector<Complex> states(n/2, 0);
+        model._elapsed = elapsed;
+        auto const constant = block(states);
+        std::vector<Real> b(constant, constant+n);
+        auto const duration = model._elapsed - elapsed;
+        
+        // Build I-A in LAPACK band storage, with room for the fill-in of the
+        // pivoting. Columns whose orders are more than 2*reach apart have
+        // disjoint images: probe them together.
+        std::size_t const rows = 3*bandwidth+1;
+        std::vector<Real> AB(rows*n, 0);
+        std::size_t const period = width*(2*reach+1);
+        for(std::size_t first=0; first<std::min(period, n); ++first)
+        {
+            std::fill(states.begin(), states.end(), 0);
+            auto * probe = reinterpret_cast<Real *>(states.data());
+            for(std::size_t j=first; j<n; j+=period)
+            {
+                probe[j] = 1;
+            }
+            auto const image = block(states);
+            for(std::size_t j=first; j<n; j+=period)
+            {
+                // Images of other probes may be in the band: only use the
+                // orders reachable from this one.
+                auto const order = j/width;
+                auto const begin = width*((order > reach) ? order-reach : 0);
+                auto const end = std::min(n, width*(order+reach+1));
+                for(std::size_t i=begin; i<end; ++i)
+                {
+                    AB[2*bandwidth+i-j+j*rows] =
+                        (i == j ? 1 : 0) - (image[i]-b[i]);
+                }
+            }
+        }
+        
+        // Fixed point: (I-A) x = b
+        Program::_solve_banded(AB, n, bandwidth, b.data());
+        
+        // Check the fixed point on the model without truncation.
+        x.resize(n/2);
+        std::copy(
+            b.begin(), b.end(), reinterpret_cast<Real *>(x.data()));
+        Program::_unpack(x, model);
+        this->run(model, echoes.data());
+        Program::_pack(model, std::max(size, model.size()), f);
+        x.resize(f.size(), 0);
+        Real residual = 0;
+        for(std::size_t i=0; i<f.size(); ++i)
+        {
+            residual += std::norm(f[i]-x[i]);
+        }
+        
+        model.threshold = threshold;
+        model._cull();
+        model._elapsed = elapsed + duration;
+        if(std::sqrt(residual) <= tolerance)
+        {
+            return echoes;
+        }
+        
+        // States of high order are not negligible: extend the truncation.
+        size *= 2;
+    }
+    
+    throw std::runtime_error("Steady state was not reached");
+}
+
+void
+Program
+::_check(Regular const & model) const
+{
+    if(Program::_compute_fingerprint(model) != this->_fingerprint)
+    {
+        throw std::runtime_error("Program was compiled for another model");
+    }
+}
+
+std::vector<Real>
+Program
+::_compute_fingerprint(Regular const & model)
+{
+    auto const & m = model._model;
+    
+    // Kind and number of pools, then the parameters of the shifts, of the
+    // bulk motion and of the off-resonance.
+    std::vector<Real> fingerprint{
+        Real(m.kind), Real(m.pools),
+        model.unit_dephasing().magnitude, model.gradient_tolerance(),
+        model.velocity.magnitude, model.delta_omega.magnitude};
+    
+    // Relaxation, diffusion and off-resonance of each pool
+    for(auto && species: m.species)
+    {
+        fingerprint.push_back(species.R1().magnitude);
+        fingerprint.push_back(species.R2().magnitude);
+        fingerprint.push_back(species.delta_omega().magnitude);
+        for(auto && D: species.D())
+        {
+            fingerprint.push_back(D.magnitude);
+        }
+    }
+    
+    // The relaxation of multi-pool models depends on the exchange.
+    if(m.kind != Model::SinglePool)
+    {
+        for(auto && k: m.k)
+        {
+            fingerprint.push_back(k.magnitude);
+        }
+        fingerprint.push_back(m.delta_b.magnitude);
+        fingerprint.insert(fingerprint.end(), m.M0.begin(), m.M0.end());
+    }
+    
+    return fingerprint;
+}
+
+void
+Program
+::_execute(
+    Instruction const & instruction, Regular & model,
+    Complex * & echoes) const
+{
+    if(instruction.kind == Instruction::Pulse)
+    {
+        if(this->_kind == Model::SinglePool)
+        {
+            simd_api::apply_pulse_single_pool(
+                this->_pulses_single_pool[instruction.index],
+                model._model, model.size());
+        }
+        else
+        {
+            simd_api::apply_pulse_exchange(
+                this->_pulses_exchange[instruction.index],
+                model._model, model.size());
+        }
+    }
+    else if(instruction.kind == Instruction::TimeInterval)
+    {
+        auto const & interval = this->_time_intervals[instruction.index];
+        
+        Real const * k = nullptr;
+        if(interval.update_k)
+        {
+            model._cache.update_diffusion(model.size(), interval.unit_k);
+            k = model._cache.k.data();
+        }
+        model._time_interval(
+            interval.operators, interval.delta_k, k, this->_velocity);
+        model._shift(interval.steps);
+        model._elapsed += interval.operators.duration;
+        model._cull();
+    }
+    else
+    {
+        *echoes = model.echo();
+        ++echoes;
+    }
+}
+
+void
+Program
+::_adjoint_time_interval(
+    Interval const & interval, Regular const & states, Regular & adjoint) const
+{
+    auto & lambda = adjoint._model;
+    
+    // Culled states do not contribute: their adjoint is 0.
+    std::size_t const steps = std::abs(interval.steps);
+    std::size_t const shifted_size = states.size()+steps;
+    adjoint._reserve(shifted_size);
+    for(auto * population: {&lambda.F[0], &lambda.F_star[0], &lambda.Z[0]})
+    {
+        std::fill(
+            population->begin()+adjoint.size(),
+            population->begin()+shifted_size, 0);
+    }
+    
+    // Adjoint of the shift: F(k) -> F(k+n) and F*(k+n) -> F*(k) are reversed,
+    // and the F*(n-k) folded to conj(F(k)) for k<n are unfolded. For a
+    // negative shift, F and F* are swapped.
+    if(steps != 0)
+    {
+        auto & F = (interval.steps > 0) ? lambda.F[0] : lambda.F_star[0];
+        auto & F_star = (interval.steps > 0) ? lambda.F_star[0] : lambda.F[0];
+        std::vector<Complex> folded(F.begin(), F.begin()+steps);
+        
+        std::copy(
+            F.begin()+steps, F.begin()+shifted_size, F.begin());
+        std::copy_backward(
+            F_star.begin(), F_star.begin()+states.size(),
+            F_star.begin()+shifted_size);
+        std::fill(F_star.begin(), F_star.begin()+steps, 0);
+        for(std::size_t k=0; k<steps; ++k)
+        {
+            if(steps-k < states.size())
+            {
+                F_star[steps-k] += std::conj(folded[k]);
+            }
+        }
+        for(auto * population: {&F, &F_star})
+        {
+            std::fill(
+                population->begin()+states.size(),
+                population->begin()+shifted_size, 0);
+        }
+    }
+    adjoint._states_count = states.size();
+    
+    // Adjoint of the diagonal operator: conjugate factors. The bulk motion
+    // factors are conjugated by an opposite velocity.
+    auto operators = interval.operators;
+    for(auto && phi: operators.phi)
+    {
+        phi.first = std::conj(phi.first);
+        phi.second = std::conj(phi.second);
+    }
+    Real const * k = nullptr;
+    if(interval.update_k)
+    {
+        adjoint._cache.update_diffusion(adjoint.size(), interval.unit_k);
+        k = adjoint._cache.k.data();
+    }
+    adjoint._time_interval(operators, interval.delta_k, k, -this->_velocity);
+}
+
+void
+Program
+::_compile(Sequence const & sequence, Regular & model)
+{
+    for(auto && step: sequence.steps())
+    {
+        if(step.kind == Sequence::Step::Pulse)
+        {
+            auto const angle = step.pulse.angle().magnitude;
+            auto const phase = step.pulse.phase().magnitude;
+            if(this->_kind == Model::SinglePool)
+            {
+                this->_instructions.push_back(
+                    {Instruction::Pulse, this->_pulses_single_pool.size()});
+                this->_pulses_single_pool.push_back(
+                    operators::pulse_single_pool(angle, phase));
+                this->_angles_single_pool.push_back(angle);
+                this->_pulses_single_pool_angle.push_back(
+                    operators::pulse_single_pool_derivative(angle, phase));
+                this->_pulses_single_pool_phase.push_back(
+                    operators::pulse_single_pool_phase_derivative(
+                        angle, phase));
+            }
+            else if(this->_kind == Model::Exchange)
+            {
+                this->_instructions.push_back(
+                    {Instruction::Pulse, this->_pulses_exchange.size()});
+                this->_pulses_exchange.push_back(
+                    operators::pulse_exchange(angle, phase, angle, phase));
+            }
+            else
+            {
+                throw std::runtime_error("Invalid model");
+            }
+        }
+        else if(step.kind == Sequence::Step::TimeInterval)
+        {
+            auto const & duration = step.interval.duration();
+            auto const & gradient = step.interval.gradient_amplitude()[0];
+            
+            // Same operators as in Regular::apply_time_interval
+            Interval interval;
+            interval.operators = model._time_interval_operators(
+                duration.magnitude);
+            interval.delta_k =
+                sycomore::gamma.magnitude * duration.magnitude
+                * gradient.magnitude;
+            
+            auto const diffusion = std::any_of(
+                model._model.species.begin(), model._model.species.end(),
+                [](Species const & s) {
+                    return s.D().unchecked(0, 0).magnitude != 0; });
+            interval.update_k =
+                interval.delta_k != 0
+                && (diffusion || this->_velocity != 0);
+            if(interval.update_k)
+            {
+                // Check that the diffusion operator can be applied.
+                model._update_k(interval.delta_k, diffusion);
+            }
+            interval.unit_k =
+                (this->_unit_dephasing != 0)
+                ? this->_unit_dephasing : interval.delta_k;
+            
+            interval.steps = 0;
+            if(duration.magnitude != 0 && gradient.magnitude != 0)
+            {
+                interval.steps =
+                    (this->_unit_dephasing != 0)
+                    ? model._steps(duration, gradient) : 1;
+            }
+            
+            this->_instructions.push_back(
+                {Instruction::TimeInterval, this->_time_intervals.size()});
+            this->_time_intervals.push_back(interval);
+        }
+        else if(step.kind == Sequence::Step::Echo)
+        {
+            this->_instructions.push_back({Instruction::Echo, 0});
+            ++this->_echoes;
+        }
+        else
+        {
+            // Compile the body once, then repeat its instructions.
+            auto const begin = this->_instructions.size();
+            auto const echoes = this->_echoes;
+            if(step.repetitions > 0)
+            {
+                this->_compile(*step.body, model);
+            }
+            auto const end = this->_instructions.size();
+            for(std::size_t i=1; i<step.repetitions; ++i)
+            {
+                for(std::size_t j=begin; j<end; ++j)
+                {
+                    auto const instruction = this->_instructions[j];
+                    this->_instructions.push_back(instruction);
+                }
+            }
+            this->_echoes =
+                echoes + step.repetitions*(this->_echoes-echoes);
+        }
+    }
+}
+
+void
+Program
+::_pack(Regular & model, std::size_t size, std::vector<Complex> & states)
+{
+    auto & m = model._model;
+    m.linearize();
+    
+    auto const pools = m.pools;
+    states.assign(3*pools*size, 0);
+    for(std::size_t order=0; order<std::min(size, model.size()); ++order)
+    {
+        for(std::size_t pool=0; pool<pools; ++pool)
+        {
+            auto const i = 3*(order*pools+pool);
+            states[i+0] = m.F[pool][order];
+            states[i+1] = m.F_star[pool][order];
+            states[i+2] = m.Z[pool][order];
+        }
+    }
+}
+
+void
+Program
+::_unpack(std::vector<Complex> const & states, Regular & model)
+{
+    auto & m = model._model;
+    auto const pools = m.pools;
+    auto const size = states.size()/(3*pools);
+    
+    model._reserve(size);
+    m.linearize();
+    for(std::size_t pool=0; pool<pools; ++pool)
+    {
+        for(std::size_t order=0; order<size; ++order)
+        {
+            auto const i = 3*(order*pools+pool);
+            m.F[pool][order] = states[i+0];
+            m.F_star[pool][order] = states[i+1];
+            m.Z[pool][order] = states[i+2];
+        }
+        
+        // Clear the previous states of higher order, so that they do not
+        // re-appear in a subsequent shift.
+        for(auto * population: {&m.F[pool], &m.F_star[pool], &m.Z[pool]})
+        {
+            std::fill(population->begin()+size, population->end(), 0);
+        }
+    }
+    model._states_count = size;
+}
+
+void
+Program
+::_solve_banded(
+    std::vector<Real> & AB, std::size_t size, std::size_t bandwidth, Real * b)
+{
+    // Gaussian elimination with partial pivoting, as in LAPACK's dgbtf2 and
+    // dgbtrs: element (i, j) is stored at AB[2*bandwidth+i-j+j*rows]. Pivoting
+    // extends the upper bandwidth of U to 2*bandwidth.
+    std::size_t const rows = 3*bandwidth+1;
+    std::size_t const diagonal = 2*bandwidth;
+    auto const at = [&](std::size_t i, std::size_t j) -> Real & {
+        return AB[diagonal+i-j+j*rows]; };
+    
+    std::vector<std::size_t> pivots(size);
+    for(std::size_t j=0; j<size; ++j)
+    {
+        auto const lower = std::min(bandwidth, size-1-j);
+        auto const upper = std::min(diagonal, size-1-j);
+        
+        std::size_t pivot = j;
+        for(std::size_t i=j+1; i<=j+lower; ++i)
+        {
+            if(std::abs(at(i, j)) > std::abs(at(pivot, j)))
+            {
+                pivot = i;
+            }
+        }
+        if(at(pivot, j) == 0)
+        {
+            throw std::runtime_error("Steady state is not unique");
+        }
+        pivots[j] = pivot;
+        if(pivot != j)
+        {
+            for(std::size_t k=j; k<=j+upper; ++k)
+            {
+                std::swap(at(j, k), at(pivot, k));
+            }
+        }
+        
+        for(std::size_t i=j+1; i<=j+lower; ++i)
+        {
+            at(i, j) /= at(j, j);
+        }
+        for(std::size_t k=j+1; k<=j+upper; ++k)
+        {
+            auto const u = at(j, k);
+            if(u == 0)
+            {
+                continue;
+            }
+            for(std::size_t i=j+1; i<=j+lower; ++i)
+            {
+                at(i, k) -= at(i, j)*u;
+            }
+        }
+    }
+    
+    // Solve L y = P b, then U x = y.
+    for(std::size_t j=0; j<size; ++j)
+    {
+        std::swap(b[j], b[pivots[j]]);
+        auto const lower = std::min(bandwidth, size-1-j);
+        for(std::size_t i=j+1; i<=j+lower; ++i)
+        {
+            b[i] -= at(i, j)*b[j];
+        }
+    }
+    for(std::size_t j=size; j>0; --j)
+    {
+        auto const k = j-1;
+        b[k] /= at(k, k);
+        auto const begin = (k > diagonal) ? k-diagonal : 0;
+        for(std::size_t i=begin; i<k; ++i)
+        {
+            b[i] -= at(i, k)*b[k];
+        }
+    }
+}
+
+}
+
+}
@@ -0,0 +1,215 @@
+#ifndef _03a1fe0e_33ef_4003_a5ec_242888a28a67
+#define _03a1fe0e_33ef_4003_a5ec_242888a28a67
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#include "sycomore/epg/Model.h"
+#include "sycomore/epg/Regular.h"
+#include "sycomore/Sequence.h"
+#include "sycomore/sycomore.h"
+
+namespace sycomore
+{
+
+namespace epg
+{
+
+/**
+ * @brief Sequence compiled for a regular EPG model.
+ *
+ * The pulse and time interval operators and the shifts are computed once,
+ * from the species, frequency offset, velocity and unit dephasing of the
+ * model: running the program does not check units nor compute operators.
+ * Running a program on a model whose parameters differ from the compilation
+ * model throws an exception.
+ */
+class Program
+{
+public:
+    /// @brief Parameters of the derivatives of the echoes
+    enum Parameter {
+        /// @brief Longitudinal relaxation rate of the species
+        R1,
+        /// @brief Transversal relaxation rate of the species
+        R2,
+        /// @brief Relative scale of the flip angle of all pulses, at 1
+        B1,
+        /// @brief Diffusion coefficient of the species
+        D
+    };
+    
+    /**
+     * @brief Compile a sequence for a regular model. The operator cache of
+     * the model is used, the states of the model are not modified.
+     */
+    Program(Sequence const & sequence, Regular & model);
+    
+    /// @brief Return the number of instructions, loops being unrolled.
+    std::size_t size() const;
+    
+    /// @brief Return the number of echoes read by the program.
+    std::size_t echoes() const;
+    
+    /**
+     * @brief Run the program on a model with the same parameters as the
+     * compilation model, return the echo of the first pool at each readout.
+     */
+    std::vector<Complex> run(Regular & model) const;
+    
+    /// @brief Run the program, storing echoes() values in given array.
+    void run(Regular & model, Complex * echoes) const;
+    
+    /**
+     * @brief Run the program on a single-pool model, return the echoes and
+     * store their derivatives with respect to the parameters in jacobian.
+     *
+     * The derivatives of the states are propagated alongside the states
+     * (forward mode), using the same operators. The derivative of echo i with
+     * respect to parameter j is stored at jacobian[i*parameters.size()+j].
+     */
+    std::vector<Complex> run(
+        Regular & model, std::vector<Parameter> const & parameters,
+        std::vector<Complex> & jacobian) const;
+    
+    /// @brief Derivatives of a real function of the echoes w.r.t. the echoes
+    using EchoesGradient =
+        std::function<std::vector<Complex>(std::vector<Complex> const &)>;
+    
+    /**
+     * @brief Run the program on a single-pool model, return the echoes and
+     * store the gradient of a real function of the echoes with respect to
+     * the angle and the phase of each pulse, in execution order.
+     *
+     * The gradient of the function with respect to the echoes is given by
+     * echoes_gradient, as df/d(real part) + i df/d(imaginary part). The
+     * gradient with respect to the pulses is computed in reverse mode: the
+     * states of the model are stored every checkpoint_interval instructions
+     * (by default, the square root of the program size) during the forward
+     * sweep, and are re-computed from these checkpoints during the backward
+     * sweep.
+     */
+    std::vector<Complex> gradient(
+        Regular & model, EchoesGradient const & echoes_gradient,
+        std::vector<Real> & angles, std::vector<Real> & phases,
+        std::size_t checkpoint_interval=0) const;
+    
+    /**
+     * @brief Run the program as a repeated block until the model reaches its
+     * steady state, return the echoes of the last repetition.
+     *
+     * Instead of running all the repetitions, the block is expressed as an
+     * affine map on the states truncated to a number of orders, and its fixed
+     * point is solved directly. The linear part of the map is banded, since
+     * the shifts of a block only move the states by a bounded number of
+     * orders. The truncation is extended until the change of the states over
+     * a block is below tolerance; throw an exception if this requires more
+     * than max_size orders.
+     */
+    std::vector<Complex> steady_state(
+        Regular & model, Real tolerance=1e-9,
+        std::size_t max_size=10000) const;
+
+private:
+    class Instruction
+    {
+    public:
+        enum Kind { Pulse, TimeInterval, Echo };
+        
+        Kind kind;
+        
+        /// @brief Location of the operators in the pulses or time intervals
+        std::size_t index;
+    };
+    
+    class Interval
+    {
+    public:
+        Regular::TimeIntervalOperators operators;
+        
+        /// @brief Dephasing of the time interval, in rad/m
+        Real delta_k;
+        
+        /// @brief Whether the dephasing of the states must be computed
+        bool update_k;
+        
+        /// @brief Dephasing between consecutive orders, in rad/m
+        Real unit_k;
+        
+        /// @brief Number of orders of the shift
+        int steps;
+    };
+    
+    Model::Kind _kind;
+    Real _unit_dephasing;
+    Real _velocity;
+    
+    /// @brief Parameters of the compilation model used by the operators
+    std::vector<Real> _fingerprint;
+    
+    std::vector<Instruction> _instructions;
+    std::vector<std::array<Complex, 9>> _pulses_single_pool;
+    /// @brief Flip angle of single-pool pulses
+    std::vector<Real> _angles_single_pool;
+    /// @brief Derivatives of single-pool pulses w.r.t. the flip angle
+    std::vector<std::array<Complex, 9>> _pulses_single_pool_angle;
+    /// @brief Derivatives of single-pool pulses w.r.t. the phase
+    std::vector<std::array<Complex, 9>> _pulses_single_pool_phase;
+    std::vector<std::array<Complex, 18>> _pulses_exchange;
+    std::vector<Interval> _time_intervals;
+    std::size_t _echoes;
+    
+    /// @brief Check that the model matches the compilation model.
+    void _check(Regular const & model) const;
+    
+    /**
+     * @brief Return the parameters of a model which are used to compute the
+     * operators of a program.
+     */
+    static std::vector<Real> _compute_fingerprint(Regular const & model);
+    
+    /// @brief Run one instruction, store the echo and move to the next one.
+    void _execute(
+        Instruction const & instruction, Regular & model,
+        Complex * & echoes) const;
+    
+    /**
+     * @brief Apply the adjoint of a time interval to the adjoint states, given
+     * the states before the time interval.
+     */
+    void _adjoint_time_interval(
+        Interval const & interval, Regular const & states,
+        Regular & adjoint) const;
+    
+    void _compile(Sequence const & sequence, Regular & model);
+    
+    /// @brief Solve the steady state, leaving the model modified on failure.
+    std::vector<Complex> _steady_state(
+        Regular & model, Real tolerance, std::size_t max_size) const;
+    
+    /**
+     * @brief Store the states of all pools in an array, order-major, padded
+     * with zeros to given number of orders.
+     */
+    static void _pack(
+        Regular & model, std::size_t size, std::vector<Complex> & states);
+    
+    /// @brief Set the states of a model from an order-major array.
+    static void _unpack(std::vector<Complex> const & states, Regular & model);
+    
+    /**
+     * @brief Solve a banded linear system in place, with equal lower and
+     * upper bandwidths, in LAPACK band storage.
+     */
+    static void _solve_banded(
+        std::vector<Real> & AB, std::size_t size, std::size_t bandwidth,
+        Real * b);
+};
+
+}
+
+}
+
+#endif // _03a1fe0e_33ef_4003_a5ec_242888a28a67
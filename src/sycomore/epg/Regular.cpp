@@ -1,6 +1,8 @@
 #include "Regular.h"
 
+#include <algorithm>
 #include <cmath>
+#include <cstring>
 
 #include <xsimd/xsimd.hpp>
 
@@ -9,6 +11,7 @@
 #include "sycomore/epg/Base.h"
 #include "sycomore/epg/operators.h"
 #include "sycomore/epg/simd_api.h"
+#include "sycomore/HardPulseApproximation.h"
 #include "sycomore/Quantity.h"
 #include "sycomore/Species.h"
 #include "sycomore/sycomore.h"
@@ -122,58 +125,9 @@ void
 Regular
 ::apply_time_interval(Quantity const & duration, Quantity const & gradient)
 {
-    // Note that since E does not depend on k, the E and S operators commute
-    // and that E and D(k) also commute as they are diagonal matrices. The
-    // only effect will be the relative order of D and S.
-    // Since the diffusion operator relies on the "start" state k_1, we need
-    // to apply the gradient operator after the diffusion operator. Otherwise
-    // states would be dephased by D(k+Δk, Δk) instead of D(k, Δk)
-    
-    this->relaxation(duration);
-    this->diffusion(duration, gradient);
-    this->bulk_motion(duration, gradient);
-    if(duration.magnitude != 0 && gradient.magnitude != 0)
-    {
-        if(this->_unit_dephasing.magnitude != 0)
-        {
-            this->shift(duration, gradient);
-        }
-        else
-        {
-            this->shift();
-        }
-    }
-    this->off_resonance(duration);
-    
-    this->_elapsed += duration.magnitude;
-    
-    // Remove low-populated states with high order.
-    auto const threshold_squared = std::pow(this->threshold, 2);
-    
-    bool done = false;
-    while(this->_states_count > 1 && !done)
-    {
-        Real max_magnitude_squared = 0.;
-        for(std::size_t pool=0; pool<this->_model.pools; ++pool)
-        {
-            using std::pow; using std::abs;
-            auto const magnitude_squared = 
-                pow(abs(this->_model.F[pool][this->_states_count-1]), 2)
-                +pow(abs(this->_model.F_star[pool][this->_states_count-1]), 2)
-                +pow(abs(this->_model.Z[pool][this->_states_count-1]), 2);
-            max_magnitude_squared = std::max(
-                max_magnitude_squared, magnitude_squared);
-        }
-        
-        if(max_magnitude_squared > threshold_squared)
-        {
-            done = true;
-        }
-        else
-        {
-            --this->_states_count;
-        }
-    }
+    this->_apply_time_interval(
+        duration, gradient,
+        this->_time_interval_operators(duration.magnitude));
 }
 
 void
@@ -184,6 +138,33 @@ Regular
         interval.duration(), interval.gradient_amplitude()[0]);
 }
 
+void
+Regular
+::apply_shaped_pulse(
+    HardPulseApproximation const & pulse, Quantity const & gradient)
+{
+    // The states are shifted after each hard pulse: use the circular storage,
+    // where shifts do not move the states. A later linear shift linearizes
+    // the states once.
+    auto const circular_storage = this->circular_storage;
+    this->circular_storage = true;
+    try
+    {
+        this->_apply_shaped_pulse(
+            pulse,
+            [&](TimeIntervalOperators const & operators) {
+                this->_apply_time_interval(
+                    pulse.duration(), gradient, operators);
+            });
+    }
+    catch(...)
+    {
+        this->circular_storage = circular_storage;
+        throw;
+    }
+    this->circular_storage = circular_storage;
+}
+
 void
 Regular
 ::shift()
@@ -195,21 +176,7 @@ void
 Regular
 ::shift(Quantity const & duration, Quantity const & gradient)
 {
-    auto const dephasing = sycomore::gamma*duration*gradient;
-    auto const epsilon = 
-        this->_gradient_tolerance*this->_unit_dephasing.magnitude;
-    auto const remainder = std::remainder(
-        dephasing.magnitude, this->_unit_dephasing.magnitude);
-    
-    if(std::abs(remainder) >= epsilon)
-    {
-        throw std::runtime_error(
-            "Dephasing is not a integer multiple of unit dephasing");
-    }
-    
-    int n = std::lround(dephasing/this->_unit_dephasing);
-    
-    this->_shift(n);
+    this->_shift(this->_steps(duration, gradient));
 }
 
 void
@@ -231,23 +198,9 @@ Regular
         return;
     }
     
-    auto const unit_dephasing = this->_unit_dephasing.magnitude;
-    if(unit_dephasing == 0)
-    {
-        throw std::runtime_error(
-            "Cannot compute diffusion without unit dephasing");
-    }
-    
-    auto const remainder = std::remainder(dephasing, unit_dephasing);
-    if(std::abs(remainder) >= this->_gradient_tolerance*unit_dephasing)
-    {
-        throw std::runtime_error(
-            "Gradient is not a interger multiple of unit gradient");
-    }
-    
     auto const delta_k = dephasing;
     
-    this->_cache.update_diffusion(this->size(), unit_dephasing);
+    this->_update_k(delta_k, true);
     
     auto const & tau = duration.magnitude;
     
@@ -262,7 +215,7 @@ Regular
         simd_api::diffusion(
             delta_k, tau, D, this->_cache.k.data(),
             this->_model.F[pool], this->_model.F_star[pool], this->_model.Z[pool],
-            this->size());
+            this->_model.F_offset, this->_model.F_star_offset, this->size());
     }
 }
 
@@ -282,15 +235,11 @@ Regular
         return;
     }
     
-    Buffer<Real> k(this->size());
-    for(std::size_t i=0; i<k.size(); ++i)
-    {
-        k[i] = delta_k*i;
-    }
+    this->_update_k(delta_k, false);
     
     simd_api::bulk_motion(
-        delta_k, this->velocity.magnitude, duration.magnitude, k.data(),
-        this->_model, this->size());
+        delta_k, this->velocity.magnitude, duration.magnitude,
+        this->_cache.k.data(), this->_model, this->size());
 }
 
 Quantity const &
@@ -307,66 +256,262 @@ Regular
     return this->_gradient_tolerance;
 }
 
+void
+Regular
+::_apply_time_interval(
+    Quantity const & duration, Quantity const & gradient,
+    TimeIntervalOperators const & operators)
+{
+    // Note that since E does not depend on k, the E and S operators commute
+    // and that E and D(k) also commute as they are diagonal matrices. The
+    // only effect will be the relative order of D and S.
+    // Since the diffusion operator relies on the "start" state k_1, we need
+    // to apply the gradient operator after the diffusion operator. Otherwise
+    // states would be dephased by D(k+Δk, Δk) instead of D(k, Δk)
+    // The off-resonance operator does not depend on k either, and commutes
+    // with S: all operators but S are applied in a single pass.
+    
+    auto const delta_k =
+        sycomore::gamma.magnitude * duration.magnitude * gradient.magnitude;
+    Real const * k = nullptr;
+    if(delta_k != 0)
+    {
+        auto const diffusion = std::any_of(
+            this->_model.species.begin(), this->_model.species.end(),
+            [](Species const & s) { return s.D().unchecked(0, 0).magnitude != 0; });
+        if(diffusion || this->velocity.magnitude != 0)
+        {
+            this->_update_k(delta_k, diffusion);
+            k = this->_cache.k.data();
+        }
+    }
+    this->_time_interval(operators, delta_k, k, this->velocity.magnitude);
+    
+    if(duration.magnitude != 0 && gradient.magnitude != 0)
+    {
+        if(this->_unit_dephasing.magnitude != 0)
+        {
+            this->shift(duration, gradient);
+        }
+        else
+        {
+            this->shift();
+        }
+    }
+    
+    this->_elapsed += duration.magnitude;
+    
+    this->_cull();
+}
+
+int
+Regular
+::_steps(Quantity const & duration, Quantity const & gradient) const
+{
+    auto const dephasing = sycomore::gamma*duration*gradient;
+    auto const epsilon = 
+        this->_gradient_tolerance*this->_unit_dephasing.magnitude;
+    auto const remainder = std::remainder(
+        dephasing.magnitude, this->_unit_dephasing.magnitude);
+    
+    if(std::abs(remainder) >= epsilon)
+    {
+        throw std::runtime_error(
+            "Dephasing is not a integer multiple of unit dephasing");
+    }
+    
+    return std::lround(dephasing/this->_unit_dephasing);
+}
+
 void
 Regular
 ::_shift(int n)
 {
-    if(std::abs(n)>1)
+    if(n == 0)
+    {
+        return;
+    }
+    
+    std::size_t const size = this->size();
+    std::size_t const steps = std::abs(n);
+    
+    this->_reserve(size+steps);
+    
+    if(this->circular_storage)
+    {
+        this->_circular_shift(n);
+        return;
+    }
+    
+    // Storage may have been circular in a previous shift
+    this->_model.linearize();
+    
+    for(std::size_t pool=0; pool<this->_model.pools; ++pool)
+    {
+        // A positive shift moves F states right and F* states left, a
+        // negative shift does the opposite.
+        auto & F = (n > 0) ? this->_model.F[pool] : this->_model.F_star[pool];
+        auto & F_star = 
+            (n > 0) ? this->_model.F_star[pool] : this->_model.F[pool];
+        
+        // Shift F states right
+        std::memmove(F.data()+steps, F.data(), size*sizeof(Complex));
+        
+        // Fold the lowest F* states (k=-1 to -n) to the lowest F states (k=n-1
+        // to 0). Since states beyond size are not stored, they are zero.
+        for(std::size_t k=0; k<steps; ++k)
+        {
+            F[k] = (steps-k < size) ? std::conj(F_star[steps-k]) : 0;
+        }
+        
+        // Shift remaining F* states left, and clear the new high orders.
+        std::size_t const kept = (size > steps) ? size-steps : 0;
+        std::memmove(F_star.data(), F_star.data()+steps, kept*sizeof(Complex));
+        std::fill(F_star.begin()+kept, F_star.begin()+size+steps, 0);
+    }
+    
+    this->_states_count += steps;
+}
+
+void
+Regular
+::_circular_shift(int n)
+{
+    std::size_t const size = this->size();
+    std::size_t const steps = std::abs(n);
+    std::size_t const capacity = this->_model.F[0].size();
+    
+    // Same algorithm as the linear shift, but only the folded states and the
+    // new high orders are written: other states are moved by updating the
+    // offsets.
+    auto & F_offset = 
+        (n > 0) ? this->_model.F_offset : this->_model.F_star_offset;
+    auto & F_star_offset = 
+        (n > 0) ? this->_model.F_star_offset : this->_model.F_offset;
+    
+    for(std::size_t pool=0; pool<this->_model.pools; ++pool)
     {
-        for(int i=0; i<std::abs(n); ++i)
+        auto & F = (n > 0) ? this->_model.F[pool] : this->_model.F_star[pool];
+        auto & F_star = 
+            (n > 0) ? this->_model.F_star[pool] : this->_model.F[pool];
+        
+        // New F states of order k < n, stored before the current order 0.
+        // Since capacity >= size+steps, these do not overlap the current F
+        // states.
+        for(std::size_t k=0; k<steps; ++k)
         {
-            this->_shift(n>0?+1:-1);
+            auto const destination = (F_offset+capacity-steps+k) % capacity;
+            F[destination] = 
+                (steps-k < size) 
+                ? std::conj(F_star[(F_star_offset+steps-k) % capacity]) : 0;
         }
+        
+        // Clear the new high orders of F*, i.e. new orders [kept, size+steps),
+        // stored at old orders [kept+steps, size+2*steps). Since 
+        // capacity >= size+steps, these only overlap the discarded F* states
+        // of old order less than steps.
+        std::size_t const kept = (size > steps) ? size-steps : 0;
+        for(std::size_t k=kept; k<size+steps; ++k)
+        {
+            F_star[(F_star_offset+steps+k) % capacity] = 0;
+        }
+    }
+    
+    F_offset = (F_offset+capacity-steps) % capacity;
+    F_star_offset = (F_star_offset+steps) % capacity;
+    
+    this->_states_count += steps;
+}
+
+void
+Regular
+::_reserve(std::size_t size)
+{
+    auto const capacity = this->_model.F[0].size();
+    if(size <= capacity)
+    {
+        return;
     }
-    else if(n==1 || n==-1)
+    
+    // Re-allocation does not preserve the circular layout.
+    this->_model.linearize();
+    
+    std::size_t new_capacity = std::max<std::size_t>(1, capacity);
+    while(new_capacity < size)
     {
-        auto const size = this->size();
+        new_capacity *= 2;
+    }
+    
+    for(std::size_t pool=0; pool<this->_model.pools; ++pool)
+    {
+        this->_model.F[pool].resize(new_capacity, 0);
+        this->_model.F_star[pool].resize(new_capacity, 0);
+        this->_model.Z[pool].resize(new_capacity, 0);
+    }
+}
+
+void
+Regular
+::_cull()
+{
+    // Remove low-populated states with high order.
+    auto const threshold_squared = std::pow(this->threshold, 2);
+    
+    bool done = false;
+    while(this->_states_count > 1 && !done)
+    {
+        Real max_magnitude_squared = 0.;
         for(std::size_t pool=0; pool<this->_model.pools; ++pool)
         {
-            auto & F = this->_model.F[pool];
-            auto & F_star = this->_model.F_star[pool];
-            auto & Z = this->_model.Z[pool];
-            if(size >= F.size())
-            {
-                F.resize(F.size()*2, 0);
-                F_star.resize(F_star.size()*2, 0);
-                Z.resize(Z.size()*2, 0);
-            }
-            
-            if(n == +1)
-            {
-                // Shift positive F states right
-                std::copy_backward(F.begin(), F.begin()+size, F.begin()+size+1);
-                
-                // Shift negative F* states left
-                std::copy(
-                    F_star.begin()+1, F_star.begin()+size+1, F_star.begin());
-                
-                // Update extremal states: F_{+0} using F*_{-0}, F*_{-max+1}=0
-                F[0] = std::conj(F_star[0]);
-                F_star[size] = 0;
-            }
-            else
-            {
-                // Shift negative F* states right
-                std::copy_backward(
-                    F_star.begin(), F_star.begin()+size, F_star.begin()+size+1);
-                
-                // Shift positive F states left
-                std::copy(F.begin()+1, F.begin()+size+1, F.begin());
-                
-                // Update extremal states: F*_{-0} using F_{+0}, F_{max+1}=0
-                F_star[0] = std::conj(F[0]);
-                F[size] = 0;
-            }
+            using std::pow; using std::abs;
+            auto const order = this->_states_count-1;
+            auto const magnitude_squared = 
+                pow(abs(this->_model.F[pool][this->_model.F_index(order)]), 2)
+                +pow(
+                    abs(
+                        this->_model.F_star[pool][
+                            this->_model.F_star_index(order)]),
+                    2)
+                +pow(abs(this->_model.Z[pool][order]), 2);
+            max_magnitude_squared = std::max(
+                max_magnitude_squared, magnitude_squared);
         }
         
-        ++this->_states_count;
+        if(max_magnitude_squared > threshold_squared)
+        {
+            done = true;
+        }
+        else
+        {
+            --this->_states_count;
+        }
     }
-    else
-    { 
-        // n==0, nothing to do.
+}
+
+void
+Regular
+::_update_k(Real delta_k, bool diffusion)
+{
+    auto const unit_dephasing = this->_unit_dephasing.magnitude;
+    if(diffusion)
+    {
+        if(unit_dephasing == 0)
+        {
+            throw std::runtime_error(
+                "Cannot compute diffusion without unit dephasing");
+        }
+        
+        auto const remainder = std::remainder(delta_k, unit_dephasing);
+        if(std::abs(remainder) >= this->_gradient_tolerance*unit_dephasing)
+        {
+            throw std::runtime_error(
+                "Gradient is not a interger multiple of unit gradient");
+        }
     }
+    
+    // Without unit dephasing, each time interval shifts by one order.
+    this->_cache.update_diffusion(
+        this->size(), (unit_dephasing != 0) ? unit_dephasing : delta_k);
 }
 
 void
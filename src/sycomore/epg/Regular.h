@@ -6,6 +6,7 @@
 #include "sycomore/Array.h"
 #include "sycomore/Buffer.h"
 #include "sycomore/epg/Base.h"
+#include "sycomore/HardPulseApproximation.h"
 #include "sycomore/Quantity.h"
 #include "sycomore/Species.h"
 #include "sycomore/sycomore.h"
@@ -34,6 +35,12 @@ public:
     /// @brief Bulk velocity
     Quantity velocity=0*units::m/units::s;
     
+    /**
+     * @brief Store the F and F* states in circular buffers, so that a shift
+     * only moves the position of the order 0 instead of all the states.
+     */
+    bool circular_storage=false;
+    
     /// @brief Create a single-pool model
     Regular(
         Species const & species, 
@@ -96,6 +103,14 @@ public:
      */
     void apply_time_interval(TimeInterval const & interval);
 
+    /**
+     * @brief Apply a shaped pulse: each of its hard pulses is followed by a
+     * time interval of the hard pulse duration, with given gradient.
+     */
+    void apply_shaped_pulse(
+        HardPulseApproximation const & pulse,
+        Quantity const & gradient=0*units::T/units::m);
+    
     /// @brief Apply a unit gradient; in regular EPG, this shifts all orders by 1.
     void shift();
     
@@ -125,6 +140,8 @@ public:
     double gradient_tolerance() const;
     
 private:
+    friend class Program;
+    
     std::size_t _states_count;
     
     /// @brief Unit dephasing, in rad/m.
@@ -136,9 +153,32 @@ private:
      */
     double _gradient_tolerance;
     
+    /// @brief Return the number of unit steps of a gradient.
+    int _steps(Quantity const & duration, Quantity const & gradient) const;
+    
     /// @brief Shift all orders by given number of steps (may be negative).
     void _shift(int n);
     
+    /// @brief Shift all orders in circular storage.
+    void _circular_shift(int n);
+    
+    /// @brief Make sure the populations can store given number of states.
+    void _reserve(std::size_t size);
+    
+    /**
+     * @brief Update the dephasing of each state, after checking that the
+     * diffusion operator can be applied if requested.
+     */
+    void _update_k(Real delta_k, bool diffusion);
+    
+    /// @brief Remove low-populated states with high order.
+    void _cull();
+    
+    /// @brief Apply a time interval with pre-computed operators.
+    void _apply_time_interval(
+        Quantity const & duration, Quantity const & gradient,
+        TimeIntervalOperators const & operators);
+    
     // Data kept to avoid expansive re-allocation of memory.
     class Cache
     {
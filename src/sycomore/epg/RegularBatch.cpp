@@ -0,0 +1,601 @@
+#include "RegularBatch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "sycomore/Array.h"
+#include "sycomore/Buffer.h"
+#include "sycomore/epg/simd_api.h"
+#include "sycomore/Quantity.h"
+#include "sycomore/Species.h"
+#include "sycomore/sycomore.h"
+#include "sycomore/TimeInterval.h"
+#include "sycomore/units.h"
+
+namespace sycomore
+{
+
+namespace epg
+{
+
+RegularBatch
+::RegularBatch(
+    std::vector<Species> const & species,
+    Vector3R const & initial_magnetization, unsigned int initial_size,
+    Quantity const & unit_dephasing, double gradient_tolerance,
+    Layout layout, Precision precision)
+: _species(species), _layout(layout), _precision(precision), _states_count(1),
+    _elapsed(0), _unit_dephasing(unit_dephasing),
+    _gradient_tolerance(gradient_tolerance)
+{
+    if(this->_species.empty())
+    {
+        throw std::runtime_error("Batch must contain at least one model");
+    }
+    if(this->_precision == Single && this->_layout != Planar)
+    {
+        throw std::runtime_error("Single precision requires the planar layout");
+    }
+    
+    if(this->_unit_dephasing.dimensions != GradientDephasing)
+    {
+        this->_unit_dephasing *= sycomore::gamma;
+    }
+    
+    // Pad the number of models to the widest batch (8 complex numbers or 16
+    // floats for AVX-512) so that all rows are aligned and processed without
+    // tail. A single-precision row of 2*stride floats spans stride/2 complex
+    // elements of the state buffers.
+    auto const models = this->_species.size();
+    if(this->_precision == Single)
+    {
+        this->_stride = 16*((models+15)/16);
+        this->_row = this->_stride/2;
+    }
+    else
+    {
+        this->_stride = 8*((models+7)/8);
+        this->_row = this->_stride;
+    }
+    
+    for(auto * buffer: {
+        &this->_R1, &this->_R2, &this->_D, &this->_delta_omega, &this->_M0,
+        &this->_B1})
+    {
+        buffer->resize(this->_stride, 0);
+    }
+    for(std::size_t m=0; m<models; ++m)
+    {
+        auto const & item = this->_species[m];
+        this->_R1[m] = item.R1().magnitude;
+        this->_R2[m] = item.R2().magnitude;
+        this->_D[m] = item.D().unchecked(0, 0).magnitude;
+        this->_delta_omega[m] = item.delta_omega().magnitude;
+        this->_M0[m] = initial_magnetization[2];
+        this->_B1[m] = 1;
+    }
+    
+    auto const size = std::max(1U, initial_size)*this->_row;
+    for(auto * population: {&this->_F, &this->_F_star, &this->_Z})
+    {
+        population->resize(size, 0);
+    }
+    
+    auto const & M = initial_magnetization;
+    auto const M_plus = Complex(M[0], M[1]);
+    auto const M_minus = Complex(M[0], -M[1]);
+    for(std::size_t m=0; m<models; ++m)
+    {
+        this->_set(this->_F, 0, m, M_plus);
+        this->_set(this->_F_star, 0, m, M_minus);
+        this->_set(this->_Z, 0, m, M[2]);
+    }
+}
+
+std::size_t
+RegularBatch
+::models() const
+{
+    return this->_species.size();
+}
+
+std::size_t
+RegularBatch
+::size() const
+{
+    return this->_states_count;
+}
+
+RegularBatch::Layout
+RegularBatch
+::layout() const
+{
+    return this->_layout;
+}
+
+RegularBatch::Precision
+RegularBatch
+::precision() const
+{
+    return this->_precision;
+}
+
+Species const &
+RegularBatch
+::species(std::size_t model) const
+{
+    return this->_species[model];
+}
+
+Real
+RegularBatch
+::B1(std::size_t model) const
+{
+    return this->_B1[model];
+}
+
+void
+RegularBatch
+::set_B1(std::vector<Real> const & B1)
+{
+    if(B1.size() != this->models())
+    {
+        throw std::runtime_error("B1 must contain one value per model");
+    }
+    std::copy(B1.begin(), B1.end(), this->_B1.begin());
+}
+
+TensorQ<1>
+RegularBatch
+::orders() const
+{
+    TensorQ<1> result(TensorQ<1>::shape_type{this->size()});
+    auto const factor =
+        (this->_unit_dephasing.magnitude != 0)
+        ? this->_unit_dephasing : Quantity(1.);
+    for(std::size_t i=0; i<result.size(); ++i)
+    {
+        result[i] = i * factor;
+    }
+    return result;
+}
+
+ArrayC
+RegularBatch
+::states(std::size_t model) const
+{
+    if(model >= this->models())
+    {
+        throw std::runtime_error("Invalid model");
+    }
+    
+    ArrayC result(ArrayC::shape_type{this->size(), 3});
+    for(std::size_t order=0; order<this->size(); ++order)
+    {
+        result.unchecked(order, 0) = this->_get(this->_F, order, model);
+        result.unchecked(order, 1) = this->_get(this->_F_star, order, model);
+        result.unchecked(order, 2) = this->_get(this->_Z, order, model);
+    }
+    
+    return result;
+}
+
+TensorC<1>
+RegularBatch
+::echo() const
+{
+    TensorC<1> result(TensorC<1>::shape_type{this->models()});
+    for(std::size_t m=0; m<this->models(); ++m)
+    {
+        result[m] = this->_get(this->_F, 0, m);
+    }
+    return result;
+}
+
+Quantity
+RegularBatch
+::elapsed() const
+{
+    return this->_elapsed*sycomore::units::s;
+}
+
+void
+RegularBatch
+::apply_pulse(Quantity const & angle, Quantity const & phase)
+{
+    if(this->_precision == Single)
+    {
+        simd_api::apply_pulse_batch_planar_float(
+            angle.magnitude, phase.magnitude, this->_B1.data(),
+            reinterpret_cast<float*>(this->_F.data()),
+            reinterpret_cast<float*>(this->_F_star.data()),
+            reinterpret_cast<float*>(this->_Z.data()),
+            this->size(), this->_stride);
+    }
+    else if(this->_layout == Planar)
+    {
+        simd_api::apply_pulse_batch_planar(
+            angle.magnitude, phase.magnitude, this->_B1.data(),
+            reinterpret_cast<Real*>(this->_F.data()),
+            reinterpret_cast<Real*>(this->_F_star.data()),
+            reinterpret_cast<Real*>(this->_Z.data()),
+            this->size(), this->_stride);
+    }
+    else
+    {
+        simd_api::apply_pulse_batch(
+            angle.magnitude, phase.magnitude, this->_B1.data(),
+            this->_F.data(), this->_F_star.data(), this->_Z.data(),
+            this->size(), this->_stride);
+    }
+}
+
+void
+RegularBatch
+::apply_time_interval(Quantity const & duration, Quantity const & gradient)
+{
+    // Same order of operators as in Regular::apply_time_interval
+    this->relaxation(duration);
+    this->diffusion(duration, gradient);
+    if(duration.magnitude != 0 && gradient.magnitude != 0)
+    {
+        if(this->_unit_dephasing.magnitude != 0)
+        {
+            this->shift(duration, gradient);
+        }
+        else
+        {
+            this->shift();
+        }
+    }
+    this->off_resonance(duration);
+    
+    this->_elapsed += duration.magnitude;
+    
+    // Remove high-order states which are low-populated in all models.
+    auto const threshold_squared = std::pow(this->threshold, 2);
+    
+    bool done = false;
+    while(this->_states_count > 1 && !done)
+    {
+        auto const begin = (this->_states_count-1)*this->_row;
+        auto const order = this->_states_count-1;
+        for(std::size_t m=0; m<this->models() && !done; ++m)
+        {
+            using std::norm;
+            auto const magnitude_squared =
+                norm(this->_get(this->_F, order, m))
+                + norm(this->_get(this->_F_star, order, m))
+                + norm(this->_get(this->_Z, order, m));
+            done = (magnitude_squared > threshold_squared);
+        }
+        
+        if(!done)
+        {
+            // Clear the culled states so that they do not re-appear in a
+            // subsequent shift.
+            for(auto * population: {&this->_F, &this->_F_star, &this->_Z})
+            {
+                std::fill(
+                    population->begin()+begin,
+                    population->begin()+begin+this->_row, 0);
+            }
+            --this->_states_count;
+        }
+    }
+}
+
+void
+RegularBatch
+::apply_time_interval(TimeInterval const & interval)
+{
+    this->apply_time_interval(
+        interval.duration(), interval.gradient_amplitude()[0]);
+}
+
+void
+RegularBatch
+::shift()
+{
+    this->_shift(1);
+}
+
+void
+RegularBatch
+::shift(Quantity const & duration, Quantity const & gradient)
+{
+    auto const dephasing = sycomore::gamma*duration*gradient;
+    auto const epsilon =
+        this->_gradient_tolerance*this->_unit_dephasing.magnitude;
+    auto const remainder = std::remainder(
+        dephasing.magnitude, this->_unit_dephasing.magnitude);
+    
+    if(std::abs(remainder) >= epsilon)
+    {
+        throw std::runtime_error(
+            "Dephasing is not a integer multiple of unit dephasing");
+    }
+    
+    int n = std::lround(dephasing/this->_unit_dephasing);
+    
+    this->_shift(n);
+}
+
+void
+RegularBatch
+::relaxation(Quantity const & duration)
+{
+    if(this->_precision == Single)
+    {
+        simd_api::relaxation_batch_planar_float(
+            this->_R1.data(), this->_R2.data(), this->_M0.data(),
+            duration.magnitude,
+            reinterpret_cast<float*>(this->_F.data()),
+            reinterpret_cast<float*>(this->_F_star.data()),
+            reinterpret_cast<float*>(this->_Z.data()),
+            this->size(), this->_stride);
+    }
+    else if(this->_layout == Planar)
+    {
+        simd_api::relaxation_batch_planar(
+            this->_R1.data(), this->_R2.data(), this->_M0.data(),
+            duration.magnitude,
+            reinterpret_cast<Real*>(this->_F.data()),
+            reinterpret_cast<Real*>(this->_F_star.data()),
+            reinterpret_cast<Real*>(this->_Z.data()),
+            this->size(), this->_stride);
+    }
+    else
+    {
+        simd_api::relaxation_batch(
+            this->_R1.data(), this->_R2.data(), this->_M0.data(),
+            duration.magnitude,
+            this->_F.data(), this->_F_star.data(), this->_Z.data(),
+            this->size(), this->_stride);
+    }
+}
+
+void
+RegularBatch
+::diffusion(Quantity const & duration, Quantity const & gradient)
+{
+    if(
+        std::all_of(
+            this->_D.begin(), this->_D.end(), [](Real D) { return D == 0; }))
+    {
+        return;
+    }
+    
+    auto const dephasing =
+        sycomore::gamma.magnitude * duration.magnitude * gradient.magnitude;
+    if(dephasing == 0)
+    {
+        return;
+    }
+    
+    auto const unit_dephasing = this->_unit_dephasing.magnitude;
+    if(unit_dephasing == 0)
+    {
+        throw std::runtime_error(
+            "Cannot compute diffusion without unit dephasing");
+    }
+    
+    auto const remainder = std::remainder(dephasing, unit_dephasing);
+    if(std::abs(remainder) >= this->_gradient_tolerance*unit_dephasing)
+    {
+        throw std::runtime_error(
+            "Gradient is not a interger multiple of unit gradient");
+    }
+    
+    this->_cache.update_diffusion(this->size(), unit_dephasing);
+    
+    if(this->_precision == Single)
+    {
+        simd_api::diffusion_batch_planar_float(
+            dephasing, duration.magnitude, this->_D.data(),
+            this->_cache.k.data(),
+            reinterpret_cast<float*>(this->_F.data()),
+            reinterpret_cast<float*>(this->_F_star.data()),
+            reinterpret_cast<float*>(this->_Z.data()),
+            this->size(), this->_stride);
+    }
+    else if(this->_layout == Planar)
+    {
+        simd_api::diffusion_batch_planar(
+            dephasing, duration.magnitude, this->_D.data(),
+            this->_cache.k.data(),
+            reinterpret_cast<Real*>(this->_F.data()),
+            reinterpret_cast<Real*>(this->_F_star.data()),
+            reinterpret_cast<Real*>(this->_Z.data()),
+            this->size(), this->_stride);
+    }
+    else
+    {
+        simd_api::diffusion_batch(
+            dephasing, duration.magnitude, this->_D.data(),
+            this->_cache.k.data(),
+            this->_F.data(), this->_F_star.data(), this->_Z.data(),
+            this->size(), this->_stride);
+    }
+}
+
+void
+RegularBatch
+::off_resonance(Quantity const & duration)
+{
+    if(
+        this->delta_omega.magnitude == 0
+        && std::all_of(
+            this->_delta_omega.begin(), this->_delta_omega.end(),
+            [](Real x) { return x == 0; }))
+    {
+        return;
+    }
+    
+    if(this->_precision == Single)
+    {
+        simd_api::off_resonance_batch_planar_float(
+            duration.magnitude, this->delta_omega.magnitude,
+            this->_delta_omega.data(),
+            reinterpret_cast<float*>(this->_F.data()),
+            reinterpret_cast<float*>(this->_F_star.data()),
+            this->size(), this->_stride);
+    }
+    else if(this->_layout == Planar)
+    {
+        simd_api::off_resonance_batch_planar(
+            duration.magnitude, this->delta_omega.magnitude,
+            this->_delta_omega.data(),
+            reinterpret_cast<Real*>(this->_F.data()),
+            reinterpret_cast<Real*>(this->_F_star.data()),
+            this->size(), this->_stride);
+    }
+    else
+    {
+        simd_api::off_resonance_batch(
+            duration.magnitude, this->delta_omega.magnitude,
+            this->_delta_omega.data(), this->_F.data(), this->_F_star.data(),
+            this->size(), this->_stride);
+    }
+}
+
+Quantity const &
+RegularBatch
+::unit_dephasing() const
+{
+    return this->_unit_dephasing;
+}
+
+double
+RegularBatch
+::gradient_tolerance() const
+{
+    return this->_gradient_tolerance;
+}
+
+void
+RegularBatch
+::_shift(int n)
+{
+    if(n == 0)
+    {
+        return;
+    }
+    
+    std::size_t const size = this->size();
+    std::size_t const steps = std::abs(n);
+    auto const row = this->_row;
+    
+    // Make room for the new states in one re-allocation
+    if((size+steps)*row > this->_F.size())
+    {
+        auto capacity = this->_F.size();
+        while(capacity < (size+steps)*row)
+        {
+            capacity *= 2;
+        }
+        this->_F.resize(capacity, 0);
+        this->_F_star.resize(capacity, 0);
+        this->_Z.resize(capacity, 0);
+    }
+    
+    // Each order is a contiguous row of models: shifting the orders of all
+    // models is a move of rows. A positive shift moves F states right and F*
+    // states left, a negative shift does the opposite.
+    auto const row_bytes = row*sizeof(Complex);
+    auto & F = (n > 0) ? this->_F : this->_F_star;
+    auto & F_star = (n > 0) ? this->_F_star : this->_F;
+    
+    // Shift F states right
+    std::memmove(F.data()+steps*row, F.data(), size*row_bytes);
+    
+    // Fold the lowest F* states (k=-1 to -n) to the lowest F states (k=n-1
+    // to 0). Since states beyond size are not stored, they are zero. Rows
+    // are moved as raw memory in all layouts and precisions, only the folded
+    // states depend on them.
+    for(std::size_t k=0; k<steps; ++k)
+    {
+        for(std::size_t m=0; m<this->_stride; ++m)
+        {
+            Complex state = 0;
+            if(steps-k < size)
+            {
+                state = std::conj(this->_get(F_star, steps-k, m));
+            }
+            this->_set(F, k, m, state);
+        }
+    }
+    
+    // Shift remaining F* states left, and clear the new high orders.
+    std::size_t const kept = (size > steps) ? size-steps : 0;
+    std::memmove(F_star.data(), F_star.data()+steps*row, kept*row_bytes);
+    std::fill(F_star.begin()+kept*row, F_star.begin()+(size+steps)*row, 0);
+    
+    this->_states_count += steps;
+}
+
+Complex
+RegularBatch
+::_get(
+    Buffer<Complex> const & population, std::size_t order,
+    std::size_t model) const
+{
+    auto const real = 2*order*this->_stride+model;
+    if(this->_precision == Single)
+    {
+        auto const data = reinterpret_cast<float const *>(population.data());
+        return {data[real], data[real+this->_stride]};
+    }
+    else if(this->_layout == Planar)
+    {
+        auto const data = reinterpret_cast<Real const *>(population.data());
+        return {data[real], data[real+this->_stride]};
+    }
+    else
+    {
+        return population[order*this->_stride+model];
+    }
+}
+
+void
+RegularBatch
+::_set(
+    Buffer<Complex> & population, std::size_t order, std::size_t model,
+    Complex const & value)
+{
+    auto const real = 2*order*this->_stride+model;
+    if(this->_precision == Single)
+    {
+        auto const data = reinterpret_cast<float *>(population.data());
+        data[real] = value.real();
+        data[real+this->_stride] = value.imag();
+    }
+    else if(this->_layout == Planar)
+    {
+        auto const data = reinterpret_cast<Real *>(population.data());
+        data[real] = value.real();
+        data[real+this->_stride] = value.imag();
+    }
+    else
+    {
+        population[order*this->_stride+model] = value;
+    }
+}
+
+void
+RegularBatch::Cache
+::update_diffusion(std::size_t size, Real unit_dephasing)
+{
+    this->k.resize(size);
+    for(std::size_t order=0; order != size; ++order)
+    {
+        this->k[order] = order*unit_dephasing;
+    }
+}
+
+}
+
+}
@@ -0,0 +1,234 @@
+#ifndef _2e3c1b9a_53f0_4a8e_9d57_46b6f0a1c2d4
+#define _2e3c1b9a_53f0_4a8e_9d57_46b6f0a1c2d4
+
+#include <vector>
+
+#include "sycomore/Array.h"
+#include "sycomore/Buffer.h"
+#include "sycomore/Quantity.h"
+#include "sycomore/Species.h"
+#include "sycomore/sycomore.h"
+#include "sycomore/TimeInterval.h"
+#include "sycomore/units.h"
+
+namespace sycomore
+{
+
+namespace epg
+{
+
+/**
+ * @brief Batch of single-pool regular EPG models, sharing the same sequence
+ * but with different species and B1 scaling.
+ *
+ * The states of all models are stored order-major (structure of arrays), so
+ * that the operators are vectorized across models rather than across orders.
+ * This is efficient for dictionary simulations, where many models are
+ * simulated with few states.
+ */
+class RegularBatch
+{
+public:
+    /// @brief Order of the model, as gradient area
+    using Order = Quantity;
+    
+    /**
+     * @brief Memory layout of the complex states.
+     *
+     * In the interleaved layout, the real and imaginary parts of a state are
+     * contiguous. In the planar layout, the states of each order are stored
+     * as the real parts of all models followed by their imaginary parts, so
+     * that complex products are computed on real vectors.
+     */
+    enum Layout { Interleaved, Planar };
+    
+    /**
+     * @brief Precision of the states.
+     *
+     * Single-precision states halve the memory footprint and double the
+     * number of models processed by each SIMD instruction, at the cost of a
+     * relative error around 1e-6. The per-model parameters and the
+     * accessors remain in double precision. Single precision requires the
+     * planar layout.
+     */
+    enum Precision { Double, Single };
+    
+    /// @brief Frequency offset of the simulator
+    Quantity delta_omega=0*units::Hz;
+    
+    /// @brief Threshold used to cull states with low population in all models
+    Real threshold=0;
+    
+    /// @brief Create a batch of single-pool models
+    RegularBatch(
+        std::vector<Species> const & species,
+        Vector3R const & initial_magnetization={0,0,1},
+        unsigned int initial_size=100,
+        Quantity const & unit_dephasing=0*units::rad/units::m,
+        double gradient_tolerance=1e-5, Layout layout=Interleaved,
+        Precision precision=Double);
+    
+    /// @brief Default copy constructor
+    RegularBatch(RegularBatch const &) = default;
+    /// @brief Default move constructor
+    RegularBatch(RegularBatch &&) = default;
+    /// @brief Default copy assignment
+    RegularBatch & operator=(RegularBatch const &) = default;
+    /// @brief Default move assignment
+    RegularBatch & operator=(RegularBatch &&) = default;
+    /// @brief Default destructor
+    ~RegularBatch() = default;
+    
+    /// @brief Return the number of models in the batch.
+    std::size_t models() const;
+    
+    /// @brief Return the number of states of each model.
+    std::size_t size() const;
+    
+    /// @brief Return the memory layout of the states.
+    Layout layout() const;
+    
+    /// @brief Return the precision of the states.
+    Precision precision() const;
+    
+    /// @brief Return the species of one of the models
+    Species const & species(std::size_t model) const;
+    
+    /// @brief Return the relative B1 of one of the models
+    Real B1(std::size_t model) const;
+    
+    /// @brief Set the relative B1 of all models
+    void set_B1(std::vector<Real> const & B1);
+    
+    /// @brief Return the orders of the models.
+    TensorQ<1> orders() const;
+    
+    /**
+     * @brief Return all states of a model, as \f$\tilde{F}\f$,
+     * \f$\tilde{F}^*\f$, and \f$\tilde{Z}\f$ for each order.
+     */
+    ArrayC states(std::size_t model) const;
+    
+    /// @brief Return the echo signal, i.e. \f$F_0\f$, of each model
+    TensorC<1> echo() const;
+    
+    /// @brief Return the elapsed time.
+    Quantity elapsed() const;
+    
+    /// @brief Apply an RF hard pulse, scaled by the B1 of each model.
+    void apply_pulse(Quantity const & angle, Quantity const & phase=0*units::rad);
+    
+    /**
+     * @brief Apply a time interval, i.e. relaxation, diffusion, gradient, and
+     * off-resonance effects.
+     */
+    void apply_time_interval(
+        Quantity const & duration,
+        Quantity const & gradient=0*units::T/units::m);
+    
+    /**
+     * @brief Apply a time interval, i.e. relaxation, diffusion, gradient, and
+     * off-resonance effects.
+     */
+    void apply_time_interval(TimeInterval const & interval);
+    
+    /// @brief Apply a unit gradient; in regular EPG, this shifts all orders by 1.
+    void shift();
+    
+    /**
+     * @brief Apply an arbitrary gradient; in regular EPG, this shifts all
+     * orders by an integer number corresponding to a multiple of the unit
+     * gradient.
+     */
+    void shift(Quantity const & duration, Quantity const & gradient);
+    
+    /// @brief Simulate the relaxation during given duration.
+    void relaxation(Quantity const & duration);
+    
+    /**
+     * @brief Simulate diffusion during given duration with given gradient
+     * amplitude.
+     */
+    void diffusion(Quantity const & duration, Quantity const & gradient);
+    
+    /**
+     * @brief Simulate field- and species-related off-resonance effects during
+     * given duration with given frequency offset.
+     */
+    void off_resonance(Quantity const & duration);
+    
+    /// @brief Return the unit dephasing
+    Quantity const & unit_dephasing() const;
+    
+    /// @brief Return the gradient tolerance
+    double gradient_tolerance() const;
+
+private:
+    std::vector<Species> _species;
+    
+    /// @brief Number of models, padded to a multiple of the widest SIMD batch
+    std::size_t _stride;
+    
+    // Per-model parameters, padded to the stride with inert models.
+    Buffer<Real> _R1, _R2, _D, _delta_omega, _M0, _B1;
+    
+    Layout _layout;
+    Precision _precision;
+    
+    /// @brief Number of elements of the state buffers used by each order
+    std::size_t _row;
+    
+    /**
+     * @brief States of all models. In the interleaved layout, the state i of
+     * model m is at i*stride+m. In the planar layout, the same memory is
+     * used as real numbers (float or double, depending on the precision):
+     * its real part is at 2*i*stride+m and its imaginary part at
+     * (2*i+1)*stride+m.
+     */
+    Buffer<Complex> _F, _F_star, _Z;
+    
+    std::size_t _states_count;
+    
+    /// @brief Elapsed time, in s
+    Real _elapsed;
+    
+    /// @brief Unit dephasing, in rad/m.
+    Quantity _unit_dephasing;
+    
+    /**
+     * @brief Tolerance used when checking that a prescribed gradient dephasing
+     * is close enough to a multiple of the unit gradient.
+     */
+    double _gradient_tolerance;
+    
+    /// @brief Return a state of a model, in any layout.
+    Complex _get(
+        Buffer<Complex> const & population, std::size_t order,
+        std::size_t model) const;
+    
+    /// @brief Set a state of a model, in any layout.
+    void _set(
+        Buffer<Complex> & population, std::size_t order, std::size_t model,
+        Complex const & value);
+    
+    /// @brief Shift all orders by given number of steps (may be negative).
+    void _shift(int n);
+    
+    // Data kept to avoid expansive re-allocation of memory.
+    class Cache
+    {
+    public:
+        // Diffusion-related data.
+        Buffer<Real> k;
+        
+        void update_diffusion(std::size_t size, Real unit_dephasing);
+    };
+    
+    Cache _cache;
+};
+
+}
+
+}
+
+#endif // _2e3c1b9a_53f0_4a8e_9d57_46b6f0a1c2d4
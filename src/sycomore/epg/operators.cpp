@@ -30,6 +30,38 @@ std::array<Complex, 9> pulse_single_pool(Real angle, Real phase)
     return { PULSE_MATRIX(angle, phase) };
 }
 
+std::array<Complex, 9> pulse_single_pool_derivative(Real angle, Real phase)
+{
+    using std::cos; using std::exp; using std::sin;
+    constexpr Complex const i{0,1};
+
+    auto const & a = angle;
+    auto const & p = phase;
+    return {
+        -sin(a)/2.,               exp(2.*i*p)*sin(a)/2., -i*exp( i*p)*cos(a),
+        exp(-2.*i*p)*sin(a)/2.,   -sin(a)/2.,            i*exp(-i*p)*cos(a),
+        -i/2.*exp(-i*p)*cos(a),   i/2.*exp(i*p)*cos(a),  -sin(a)
+    };
+}
+
+std::array<Complex, 9>
+pulse_single_pool_phase_derivative(Real angle, Real phase)
+{
+    using std::exp; using std::pow; using std::sin;
+    constexpr Complex const i{0,1};
+
+    auto const & a = angle;
+    auto const & p = phase;
+    return {
+        0.,                              2.*i*exp(2.*i*p)*pow(sin(a/2), 2),
+            exp(i*p)*sin(a),
+        -2.*i*exp(-2.*i*p)*pow(sin(a/2), 2), 0.,
+            exp(-i*p)*sin(a),
+        -exp(-i*p)*sin(a)/2.,            -exp(i*p)*sin(a)/2.,
+            0.
+    };
+}
+
 std::array<Complex, 18>
 pulse_exchange(Real angle_a, Real phase_a, Real angle_b, Real phase_b)
 {
@@ -25,6 +25,19 @@ namespace operators
  */
 std::array<Complex, 9> pulse_single_pool(Real angle, Real phase);
 
+/**
+ * @brief Return the row-wise derivative of the single-pool EPG pulse operator
+ * with respect to the flip angle.
+ */
+std::array<Complex, 9> pulse_single_pool_derivative(Real angle, Real phase);
+
+/**
+ * @brief Return the row-wise derivative of the single-pool EPG pulse operator
+ * with respect to the phase.
+ */
+std::array<Complex, 9>
+pulse_single_pool_phase_derivative(Real angle, Real phase);
+
 /**
  * @brief Return the row-wise matrix corresponding to the two-pools exchange EPG
  * pulse operator.
@@ -24,10 +24,17 @@ void
 apply_pulse_single_pool_d<unsupported>(
     std::array<Complex, 9> const & T, Model & model, std::size_t states_count)
 {
-    apply_pulse_single_pool_w<Complex>(
-        T,
-        model.F[0].data(), model.F_star[0].data(), model.Z[0].data(),
-        0, states_count, 1);
+    for_each_segment(
+        model, states_count,
+        [&](
+            std::size_t order, std::size_t F_index, std::size_t F_star_index,
+            std::size_t count)
+        {
+            apply_pulse_single_pool_w<Complex>(
+                T,
+                model.F[0].data()+F_index, model.F_star[0].data()+F_star_index,
+                model.Z[0].data()+order, 0, count, 1);
+        });
 }
 
 template<>
@@ -35,11 +42,20 @@ void
 apply_pulse_exchange_d<unsupported>(
     std::array<Complex, 18> const & T, Model & model, std::size_t states_count)
 {
-    apply_pulse_exchange_w<Complex>(
-        T,
-        model.F[0].data(), model.F_star[0].data(), model.Z[0].data(),
-        model.F[1].data(), model.F_star[1].data(), model.Z[1].data(),
-        0, states_count, 1);
+    for_each_segment(
+        model, states_count,
+        [&](
+            std::size_t order, std::size_t F_index, std::size_t F_star_index,
+            std::size_t count)
+        {
+            apply_pulse_exchange_w<Complex>(
+                T,
+                model.F[0].data()+F_index, model.F_star[0].data()+F_star_index,
+                model.Z[0].data()+order,
+                model.F[1].data()+F_index, model.F_star[1].data()+F_star_index,
+                model.Z[1].data()+order,
+                0, count, 1);
+        });
 }
 
 template<>
@@ -47,10 +63,18 @@ void
 apply_pulse_magnetization_transfer_d<unsupported>(
     std::array<Complex, 10> const & T, Model & model, std::size_t states_count)
 {
-    apply_pulse_magnetization_transfer_w<Complex>(
-        T,
-        model.F[0].data(), model.F_star[0].data(), model.Z[0].data(),
-        model.Z[1].data(), 0, states_count, 1);
+    for_each_segment(
+        model, states_count,
+        [&](
+            std::size_t order, std::size_t F_index, std::size_t F_star_index,
+            std::size_t count)
+        {
+            apply_pulse_magnetization_transfer_w<Complex>(
+                T,
+                model.F[0].data()+F_index, model.F_star[0].data()+F_star_index,
+                model.Z[0].data()+order, model.Z[1].data()+order,
+                0, count, 1);
+        });
 }
 
 /*******************************************************************************
@@ -62,10 +86,17 @@ void
 relaxation_single_pool_d<unsupported>(
     std::pair<Real, Real> const & E, Model & model, std::size_t states_count)
 {
-    relaxation_single_pool_w<Complex>(
-        E,
-        model.F[0].data(), model.F_star[0].data(), model.Z[0].data(),
-        0, states_count, 1);
+    for_each_segment(
+        model, states_count,
+        [&](
+            std::size_t order, std::size_t F_index, std::size_t F_star_index,
+            std::size_t count)
+        {
+            relaxation_single_pool_w<Complex>(
+                E,
+                model.F[0].data()+F_index, model.F_star[0].data()+F_star_index,
+                model.Z[0].data()+order, 0, count, 1);
+        });
 }
 
 template<>
@@ -74,11 +105,20 @@ relaxation_exchange_d<unsupported>(
     std::array<Complex, 8> const & Xi_T, std::array<Real, 4> const & Xi_L,
     Model & model, std::size_t states_count)
 {
-    relaxation_exchange_w<Complex>(
-        Xi_T, Xi_L,
-        model.F[0].data(), model.F_star[0].data(), model.Z[0].data(),
-        model.F[1].data(), model.F_star[1].data(), model.Z[1].data(),
-        0, states_count, 1);
+    for_each_segment(
+        model, states_count,
+        [&](
+            std::size_t order, std::size_t F_index, std::size_t F_star_index,
+            std::size_t count)
+        {
+            relaxation_exchange_w<Complex>(
+                Xi_T, Xi_L,
+                model.F[0].data()+F_index, model.F_star[0].data()+F_star_index,
+                model.Z[0].data()+order,
+                model.F[1].data()+F_index, model.F_star[1].data()+F_star_index,
+                model.Z[1].data()+order,
+                0, count, 1);
+        });
 }
 
 template<>
@@ -86,11 +126,20 @@ void relaxation_magnetization_transfer_d<unsupported>(
     Real const & Xi_T, std::array<Real, 4> const & Xi_L,
     Model & model, std::size_t states_count)
 {
-    relaxation_magnetization_transfer_w<Complex>(
-        Xi_T, Xi_L,
-        model.F[0].data(), model.F_star[0].data(), model.Z[0].data(),
-        model.F[1].data(), model.F_star[1].data(), model.Z[1].data(),
-        0, states_count, 1);
+    for_each_segment(
+        model, states_count,
+        [&](
+            std::size_t order, std::size_t F_index, std::size_t F_star_index,
+            std::size_t count)
+        {
+            relaxation_magnetization_transfer_w<Complex>(
+                Xi_T, Xi_L,
+                model.F[0].data()+F_index, model.F_star[0].data()+F_star_index,
+                model.Z[0].data()+order,
+                model.F[1].data()+F_index, model.F_star[1].data()+F_star_index,
+                model.Z[1].data()+order,
+                0, count, 1);
+        });
 }
 
 /*******************************************************************************
@@ -102,11 +151,20 @@ void
 diffusion_d<unsupported>(
     Real delta_k, Real tau, Real D, Real const * k,
     Model::Population & F, Model::Population & F_star, Model::Population & Z,
+    std::size_t F_offset, std::size_t F_star_offset,
     std::size_t states_count)
 {
-    diffusion_w<Real, Complex>(
-        delta_k, tau, D, k, F.data(), F_star.data(), Z.data(),
-        0, states_count, 1);
+    for_each_segment(
+        F.size(), F_offset, F_star_offset, states_count,
+        [&](
+            std::size_t order, std::size_t F_index, std::size_t F_star_index,
+            std::size_t count)
+        {
+            diffusion_w<Real, Complex>(
+                delta_k, tau, D, k+order,
+                F.data()+F_index, F_star.data()+F_star_index, Z.data()+order,
+                0, count, 1);
+        });
 }
 
 /*******************************************************************************
@@ -146,9 +204,19 @@ void
 off_resonance_d<unsupported>(
     std::pair<Complex, Complex> const & phi,
     Model::Population & F, Model::Population & F_star,
+    std::size_t F_offset, std::size_t F_star_offset,
     std::size_t states_count)
 {
-    off_resonance_w<Complex>(phi, F.data(), F_star.data(), 0, states_count, 1);
+    for_each_segment(
+        F.size(), F_offset, F_star_offset, states_count,
+        [&](
+            std::size_t, std::size_t F_index, std::size_t F_star_index,
+            std::size_t count)
+        {
+            off_resonance_w<Complex>(
+                phi, F.data()+F_index, F_star.data()+F_star_index,
+                0, count, 1);
+        });
 }
 
 /*******************************************************************************
@@ -163,15 +231,245 @@ bulk_motion_d<unsupported>(
 {
     for(std::size_t pool=0; pool<model.F.size(); ++pool)
     {
-        auto F = model.F[pool].data();
-        auto F_star = model.F_star[pool].data();
-        auto Z = model.Z[pool].data();
-        
-        bulk_motion_w<Real, Complex>(
-            delta_k, v, tau, k, F, F_star, Z, 0, states_count, 1);
+        for_each_segment(
+            model, states_count,
+            [&](
+                std::size_t order, std::size_t F_index,
+                std::size_t F_star_index, std::size_t count)
+            {
+                bulk_motion_w<Real, Complex>(
+                    delta_k, v, tau, k+order,
+                    model.F[pool].data()+F_index,
+                    model.F_star[pool].data()+F_star_index,
+                    model.Z[pool].data()+order,
+                    0, count, 1);
+            });
     }
 }
 
+/*******************************************************************************
+ *                           Time interval operator                            *
+ ******************************************************************************/
+
+template<>
+void
+time_interval_d<unsupported>(
+    std::pair<Real, Real> const & E, Real delta_k, Real tau, Real D, Real v,
+    std::pair<Complex, Complex> const & phi, Real const * k,
+    Model::Population & F, Model::Population & F_star, Model::Population & Z,
+    std::size_t F_offset, std::size_t F_star_offset,
+    std::size_t states_count)
+{
+    for_each_segment(
+        F.size(), F_offset, F_star_offset, states_count,
+        [&](
+            std::size_t order, std::size_t F_index, std::size_t F_star_index,
+            std::size_t count)
+        {
+            time_interval_w<Real, Complex>(
+                E, delta_k, tau, D, v, phi, (k != nullptr) ? k+order : nullptr,
+                F.data()+F_index, F_star.data()+F_star_index, Z.data()+order,
+                0, count, 1);
+        });
+}
+
+/*******************************************************************************
+ *                                Accumulation                                 *
+ ******************************************************************************/
+
+template<>
+void
+add_scaled_single_pool_d<unsupported>(
+    std::array<Real, 3> const & factors, Model const & source,
+    Model & destination, std::size_t states_count)
+{
+    for_each_segment(
+        source, states_count,
+        [&](
+            std::size_t order, std::size_t F_index, std::size_t F_star_index,
+            std::size_t count)
+        {
+            add_scaled_single_pool_w<Complex>(
+                factors,
+                source.F[0].data()+F_index,
+                source.F_star[0].data()+F_star_index,
+                source.Z[0].data()+order,
+                destination.F[0].data()+F_index,
+                destination.F_star[0].data()+F_star_index,
+                destination.Z[0].data()+order, 0, count, 1);
+        });
+}
+
+/*******************************************************************************
+ *                               Threshold culling                             *
+ ******************************************************************************/
+
+template<>
+void
+cull_magnitude_d<unsupported>(
+    Model const & model, std::size_t states_count, Real * magnitude)
+{
+    for(std::size_t pool=0; pool<model.pools; ++pool)
+    {
+        for_each_segment(
+            model, states_count,
+            [&](
+                std::size_t order, std::size_t F_index,
+                std::size_t F_star_index, std::size_t count)
+            {
+                cull_magnitude_w<Real, Complex>(
+                    model.F[pool].data()+F_index,
+                    model.F_star[pool].data()+F_star_index,
+                    model.Z[pool].data()+order, magnitude+order, pool==0,
+                    0, count, 1);
+            });
+    }
+}
+
+/*******************************************************************************
+ *                               Batched models                                *
+ ******************************************************************************/
+
+template<>
+void
+apply_pulse_batch_d<unsupported>(
+    Real angle, Real phase, Real const * B1,
+    Complex * F, Complex * F_star, Complex * Z,
+    std::size_t states_count, std::size_t stride)
+{
+    apply_pulse_batch_w<Real, Complex>(
+        angle, phase, B1, F, F_star, Z, states_count, stride, 0, stride, 1);
+}
+
+template<>
+void
+relaxation_batch_d<unsupported>(
+    Real const * R1, Real const * R2, Real const * M0, Real duration,
+    Complex * F, Complex * F_star, Complex * Z,
+    std::size_t states_count, std::size_t stride)
+{
+    relaxation_batch_w<Real, Complex>(
+        R1, R2, M0, duration, F, F_star, Z, states_count, stride, 0, stride, 1);
+}
+
+template<>
+void
+diffusion_batch_d<unsupported>(
+    Real delta_k, Real tau, Real const * D, Real const * k_array,
+    Complex * F, Complex * F_star, Complex * Z,
+    std::size_t states_count, std::size_t stride)
+{
+    diffusion_batch_w<Real, Complex>(
+        delta_k, tau, D, k_array, F, F_star, Z, states_count, stride,
+        0, stride, 1);
+}
+
+template<>
+void
+off_resonance_batch_d<unsupported>(
+    Real duration, Real delta_omega, Real const * species_delta_omega,
+    Complex * F, Complex * F_star,
+    std::size_t states_count, std::size_t stride)
+{
+    off_resonance_batch_w<Real, Complex>(
+        duration, delta_omega, species_delta_omega, F, F_star,
+        states_count, stride, 0, stride, 1);
+}
+
+template<>
+void
+apply_pulse_batch_planar_d<unsupported>(
+    Real angle, Real phase, Real const * B1,
+    Real * F, Real * F_star, Real * Z,
+    std::size_t states_count, std::size_t stride)
+{
+    apply_pulse_batch_planar_w<Real>(
+        angle, phase, B1, F, F_star, Z, states_count, stride, 0, stride, 1);
+}
+
+template<>
+void
+apply_pulse_batch_planar_float_d<unsupported>(
+    Real angle, Real phase, Real const * B1,
+    float * F, float * F_star, float * Z,
+    std::size_t states_count, std::size_t stride)
+{
+    apply_pulse_batch_planar_w<float>(
+        angle, phase, B1, F, F_star, Z, states_count, stride, 0, stride, 1);
+}
+
+template<>
+void
+relaxation_batch_planar_d<unsupported>(
+    Real const * R1, Real const * R2, Real const * M0, Real duration,
+    Real * F, Real * F_star, Real * Z,
+    std::size_t states_count, std::size_t stride)
+{
+    relaxation_batch_planar_w<Real>(
+        R1, R2, M0, duration, F, F_star, Z, states_count, stride,
+        0, stride, 1);
+}
+
+template<>
+void
+relaxation_batch_planar_float_d<unsupported>(
+    Real const * R1, Real const * R2, Real const * M0, Real duration,
+    float * F, float * F_star, float * Z,
+    std::size_t states_count, std::size_t stride)
+{
+    relaxation_batch_planar_w<float>(
+        R1, R2, M0, duration, F, F_star, Z, states_count, stride,
+        0, stride, 1);
+}
+
+template<>
+void
+diffusion_batch_planar_d<unsupported>(
+    Real delta_k, Real tau, Real const * D, Real const * k_array,
+    Real * F, Real * F_star, Real * Z,
+    std::size_t states_count, std::size_t stride)
+{
+    diffusion_batch_planar_w<Real>(
+        delta_k, tau, D, k_array, F, F_star, Z, states_count, stride,
+        0, stride, 1);
+}
+
+template<>
+void
+diffusion_batch_planar_float_d<unsupported>(
+    Real delta_k, Real tau, Real const * D, Real const * k_array,
+    float * F, float * F_star, float * Z,
+    std::size_t states_count, std::size_t stride)
+{
+    diffusion_batch_planar_w<float>(
+        delta_k, tau, D, k_array, F, F_star, Z, states_count, stride,
+        0, stride, 1);
+}
+
+template<>
+void
+off_resonance_batch_planar_d<unsupported>(
+    Real duration, Real delta_omega, Real const * species_delta_omega,
+    Real * F, Real * F_star,
+    std::size_t states_count, std::size_t stride)
+{
+    off_resonance_batch_planar_w<Real>(
+        duration, delta_omega, species_delta_omega, F, F_star,
+        states_count, stride, 0, stride, 1);
+}
+
+template<>
+void
+off_resonance_batch_planar_float_d<unsupported>(
+    Real duration, Real delta_omega, Real const * species_delta_omega,
+    float * F, float * F_star,
+    std::size_t states_count, std::size_t stride)
+{
+    off_resonance_batch_planar_w<float>(
+        duration, delta_omega, species_delta_omega, F, F_star,
+        states_count, stride, 0, stride, 1);
+}
+
 /*******************************************************************************
  *                          Function table and set-up                          *
  ******************************************************************************/
@@ -191,6 +489,30 @@ decltype(&diffusion_3d_b_d<unsupported>) diffusion_3d_b = nullptr;
 decltype(&diffusion_3d_d<unsupported>) diffusion_3d = nullptr;
 decltype(&off_resonance_d<unsupported>) off_resonance = nullptr;
 decltype(&bulk_motion_d<unsupported>) bulk_motion = nullptr;
+decltype(&time_interval_d<unsupported>) time_interval = nullptr;
+decltype(&add_scaled_single_pool_d<unsupported>)
+    add_scaled_single_pool = nullptr;
+decltype(&cull_magnitude_d<unsupported>) cull_magnitude = nullptr;
+decltype(&apply_pulse_batch_d<unsupported>) apply_pulse_batch = nullptr;
+decltype(&relaxation_batch_d<unsupported>) relaxation_batch = nullptr;
+decltype(&diffusion_batch_d<unsupported>) diffusion_batch = nullptr;
+decltype(&off_resonance_batch_d<unsupported>) off_resonance_batch = nullptr;
+decltype(&apply_pulse_batch_planar_d<unsupported>)
+    apply_pulse_batch_planar = nullptr;
+decltype(&relaxation_batch_planar_d<unsupported>)
+    relaxation_batch_planar = nullptr;
+decltype(&diffusion_batch_planar_d<unsupported>)
+    diffusion_batch_planar = nullptr;
+decltype(&off_resonance_batch_planar_d<unsupported>)
+    off_resonance_batch_planar = nullptr;
+decltype(&apply_pulse_batch_planar_float_d<unsupported>)
+    apply_pulse_batch_planar_float = nullptr;
+decltype(&relaxation_batch_planar_float_d<unsupported>)
+    relaxation_batch_planar_float = nullptr;
+decltype(&diffusion_batch_planar_float_d<unsupported>)
+    diffusion_batch_planar_float = nullptr;
+decltype(&off_resonance_batch_planar_float_d<unsupported>)
+    off_resonance_batch_planar_float = nullptr;
 
 void set_api(unsigned instruction_set)
 {
@@ -205,6 +527,21 @@ void set_api(unsigned instruction_set)
     SYCOMORE_SET_API_FUNCTION(diffusion_3d)
     SYCOMORE_SET_API_FUNCTION(off_resonance)
     SYCOMORE_SET_API_FUNCTION(bulk_motion)
+    SYCOMORE_SET_API_FUNCTION(time_interval)
+    SYCOMORE_SET_API_FUNCTION(add_scaled_single_pool)
+    SYCOMORE_SET_API_FUNCTION(cull_magnitude)
+    SYCOMORE_SET_API_FUNCTION(apply_pulse_batch)
+    SYCOMORE_SET_API_FUNCTION(relaxation_batch)
+    SYCOMORE_SET_API_FUNCTION(diffusion_batch)
+    SYCOMORE_SET_API_FUNCTION(off_resonance_batch)
+    SYCOMORE_SET_API_FUNCTION(apply_pulse_batch_planar)
+    SYCOMORE_SET_API_FUNCTION(relaxation_batch_planar)
+    SYCOMORE_SET_API_FUNCTION(diffusion_batch_planar)
+    SYCOMORE_SET_API_FUNCTION(off_resonance_batch_planar)
+    SYCOMORE_SET_API_FUNCTION(apply_pulse_batch_planar_float)
+    SYCOMORE_SET_API_FUNCTION(relaxation_batch_planar_float)
+    SYCOMORE_SET_API_FUNCTION(diffusion_batch_planar_float)
+    SYCOMORE_SET_API_FUNCTION(off_resonance_batch_planar_float)
 }
 
 bool set_default_api()
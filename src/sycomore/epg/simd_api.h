@@ -1,6 +1,7 @@
 #ifndef _d3b9de75_d62d_4445_b032_a08F985a5d10
 #define _d3b9de75_d62d_4445_b032_a08F985a5d10
 
+#include <initializer_list>
 #include <utility>
 #include <vector>
 
@@ -17,21 +18,37 @@ namespace epg
 namespace simd_api
 {
 
-#define SYCOMORE_DEFINE_SIMD_DISPATCHER_FUNCTION(return_, name, parameters) \
-    template<INSTRUCTION_SET_TYPE InstructionSet> return_ name parameters; \
-    template<> return_ name<unsupported> parameters; \
-    extern template return_ name<XSIMD_X86_SSE2_VERSION> parameters; \
-    extern template return_ name<XSIMD_X86_AVX_VERSION> parameters; \
-    extern template return_ name<XSIMD_X86_AVX512_VERSION> parameters;
-
 // Functions with a _w suffix are worker functions, functions with a _d suffix
 // are dispatcher functions.
 
+/*******************************************************************************
+ *                               Circular storage                              *
+ ******************************************************************************/
+
+/**
+ * @brief Call function(order, F_index, F_star_index, count) on each segment of
+ * [0, states_count) where the F and F* populations, which may be circular, are
+ * contiguous. There are at most three such segments.
+ */
+template<typename Function>
+void for_each_segment(
+    std::size_t capacity, std::size_t F_offset, std::size_t F_star_offset,
+    std::size_t states_count, Function function);
+
+/// @brief Call for_each_segment with the populations of a model.
+template<typename Function>
+void for_each_segment(
+    Model const & model, std::size_t states_count, Function function);
+
+/// @brief Test whether all pointers are aligned for given instruction set.
+template<INSTRUCTION_SET_TYPE InstructionSet>
+bool is_aligned(std::initializer_list<void const *> pointers);
+
 /*******************************************************************************
  *                                Pulse operators                              *
  ******************************************************************************/
 
-template<typename ValueType>
+template<typename ValueType, bool Aligned=true>
 void apply_pulse_single_pool_w(
     std::array<Complex, 9> const & T,
     Complex * F, Complex * F_star, Complex * Z,
@@ -41,7 +58,7 @@ SYCOMORE_DEFINE_SIMD_DISPATCHER_FUNCTION(
     void, apply_pulse_single_pool_d, 
     (std::array<Complex, 9> const & T, Model & model, std::size_t states_count))
 
-template<typename ValueType>
+template<typename ValueType, bool Aligned=true>
 void apply_pulse_exchange_w(
     std::array<Complex, 18> const & T,
     Complex * F_a, Complex * F_star_a, Complex * Z_a,
@@ -52,7 +69,7 @@ SYCOMORE_DEFINE_SIMD_DISPATCHER_FUNCTION(
     void, apply_pulse_exchange_d, 
     (std::array<Complex, 18> const & T, Model & model, std::size_t states_count))
 
-template<typename ValueType>
+template<typename ValueType, bool Aligned=true>
 void apply_pulse_magnetization_transfer_w(
     std::array<Complex, 10> const & T,
     Complex * F, Complex * F_star, Complex * Z_a, Complex * Z_b,
@@ -66,7 +83,7 @@ SYCOMORE_DEFINE_SIMD_DISPATCHER_FUNCTION(
  *                             Relaxation operators                            *
  ******************************************************************************/
 
-template<typename ValueType>
+template<typename ValueType, bool Aligned=true>
 void relaxation_single_pool_w(
     std::pair<Real, Real> const & E,
     Complex * F, Complex * F_star, Complex * Z,
@@ -76,7 +93,7 @@ SYCOMORE_DEFINE_SIMD_DISPATCHER_FUNCTION(
     void, relaxation_single_pool_d, 
     (std::pair<Real, Real> const & E, Model & model, std::size_t states_count))
 
-template<typename ValueType>
+template<typename ValueType, bool Aligned=true>
 void relaxation_exchange_w(
     std::array<Complex, 8> const & Xi_T, std::array<Real, 4> const & Xi_L,
     Complex * F_a, Complex * F_star_a, Complex * Z_a,
@@ -89,7 +106,7 @@ SYCOMORE_DEFINE_SIMD_DISPATCHER_FUNCTION(
         std::array<Complex, 8> const & Xi_T, std::array<Real, 4> const & Xi_L,
         Model & model, std::size_t states_count))
 
-template<typename ValueType>
+template<typename ValueType, bool Aligned=true>
 void relaxation_magnetization_transfer_w(
     Real const & Xi_T, std::array<Real, 4> const & Xi_L,
     Complex * F_a, Complex * F_star_a, Complex * Z_a,
@@ -106,7 +123,8 @@ SYCOMORE_DEFINE_SIMD_DISPATCHER_FUNCTION(
  *                             Diffusion operator                              *
  ******************************************************************************/
 
-template<typename RealType, typename ComplexType>
+template<
+    typename RealType, typename ComplexType, bool Aligned=true>
 void diffusion_w(
     Real delta_k, Real tau, Real D, Real const * k_array,
     Complex * F, Complex * F_star, Complex * Z,
@@ -117,6 +135,7 @@ SYCOMORE_DEFINE_SIMD_DISPATCHER_FUNCTION(
     (
         Real delta_k, Real tau, Real D, Real const * k_array, 
         Model::Population & F, Model::Population & F_star, Model::Population & Z,
+        std::size_t F_offset, std::size_t F_star_offset,
         std::size_t states_count))
 
 /*******************************************************************************
@@ -155,7 +174,7 @@ SYCOMORE_DEFINE_SIMD_DISPATCHER_FUNCTION(
  *                           Off-resonance operator                            *
  ******************************************************************************/
 
-template<typename ValueType>
+template<typename ValueType, bool Aligned=true>
 void off_resonance_w(
     std::pair<Complex, Complex> const & phi,
     Complex * F, Complex * F_star,
@@ -166,13 +185,15 @@ SYCOMORE_DEFINE_SIMD_DISPATCHER_FUNCTION(
     (
         std::pair<Complex, Complex> const & phi, 
         Model::Population & F, Model::Population & F_star,
+        std::size_t F_offset, std::size_t F_star_offset,
         std::size_t states_count))
 
 /*******************************************************************************
  *                            Bulk motion operator                             *
  ******************************************************************************/
 
-template<typename RealType, typename ComplexType>
+template<
+    typename RealType, typename ComplexType, bool Aligned=true>
 void bulk_motion_w(
     Real delta_k, Real v, Real tau, Real const * k_array,
     Complex * F, Complex * F_star, Complex * Z,
@@ -184,6 +205,237 @@ SYCOMORE_DEFINE_SIMD_DISPATCHER_FUNCTION(
         Real delta_k, Real v, Real tau, Real const * k_array, Model & model,
         std::size_t states_count))
 
+/*******************************************************************************
+ *                           Time interval operator                            *
+ ******************************************************************************/
+
+// Relaxation (single pool), diffusion, bulk motion and off-resonance are all
+// diagonal in the order: they are applied in a single pass over a population.
+// If k_array is null, neither diffusion nor bulk motion are applied.
+
+template<
+    typename RealType, typename ComplexType, bool Aligned=true>
+void time_interval_w(
+    std::pair<Real, Real> const & E, Real delta_k, Real tau, Real D, Real v,
+    std::pair<Complex, Complex> const & phi, Real const * k_array,
+    Complex * F, Complex * F_star, Complex * Z,
+    std::size_t begin, std::size_t end, std::size_t step);
+
+SYCOMORE_DEFINE_SIMD_DISPATCHER_FUNCTION(
+    void, time_interval_d,
+    (
+        std::pair<Real, Real> const & E, Real delta_k, Real tau, Real D, Real v,
+        std::pair<Complex, Complex> const & phi, Real const * k_array,
+        Model::Population & F, Model::Population & F_star, Model::Population & Z,
+        std::size_t F_offset, std::size_t F_star_offset,
+        std::size_t states_count))
+
+/*******************************************************************************
+ *                                Accumulation                                 *
+ ******************************************************************************/
+
+// Add the states of a model, scaled by one factor for each of F, F* and Z, to
+// the states of another model with the same storage layout.
+
+template<typename ValueType, bool Aligned=true>
+void add_scaled_single_pool_w(
+    std::array<Real, 3> const & factors,
+    Complex const * F, Complex const * F_star, Complex const * Z,
+    Complex * F_out, Complex * F_star_out, Complex * Z_out,
+    std::size_t start, std::size_t end, std::size_t step);
+
+SYCOMORE_DEFINE_SIMD_DISPATCHER_FUNCTION(
+    void, add_scaled_single_pool_d,
+    (
+        std::array<Real, 3> const & factors, Model const & source,
+        Model & destination, std::size_t states_count))
+
+/*******************************************************************************
+ *                               Threshold culling                             *
+ ******************************************************************************/
+
+// Culling is split in two passes: the squared magnitude of each order, i.e. the
+// maximum of |F|^2+|F*|^2+|Z|^2 over all pools, is computed in vector
+// registers, then the orders above the threshold are compacted.
+
+template<
+    typename RealType, typename ComplexType, bool Aligned=true>
+void cull_magnitude_w(
+    Complex const * F, Complex const * F_star, Complex const * Z,
+    Real * magnitude, bool first_pool,
+    std::size_t begin, std::size_t end, std::size_t step);
+
+SYCOMORE_DEFINE_SIMD_DISPATCHER_FUNCTION(
+    void, cull_magnitude_d,
+    (Model const & model, std::size_t states_count, Real * magnitude))
+
+/**
+ * @brief Remove the orders whose squared magnitude is below the squared
+ * threshold, keeping the order 0, and resize the populations of the model.
+ * Each order contains order_width elements of the orders array, and magnitude
+ * must have room for states_count elements. Return the number of kept orders.
+ */
+template<typename Order>
+std::size_t cull(
+    Real threshold, Model & model, Order * orders, std::size_t order_width,
+    std::size_t states_count, Real * magnitude);
+
+/*******************************************************************************
+ *                               Batched models                                *
+ ******************************************************************************/
+
+// In batched models, the states are stored order-major: the state of order i
+// of model m is located at i*stride+m. Workers iterate over models, and
+// dispatchers process all orders.
+
+template<typename RealType, typename ComplexType>
+void apply_pulse_batch_w(
+    Real angle, Real phase, Real const * B1,
+    Complex * F, Complex * F_star, Complex * Z,
+    std::size_t states_count, std::size_t stride,
+    std::size_t begin, std::size_t end, std::size_t step);
+
+SYCOMORE_DEFINE_SIMD_DISPATCHER_FUNCTION(
+    void, apply_pulse_batch_d,
+    (
+        Real angle, Real phase, Real const * B1,
+        Complex * F, Complex * F_star, Complex * Z,
+        std::size_t states_count, std::size_t stride))
+
+template<typename RealType, typename ComplexType>
+void relaxation_batch_w(
+    Real const * R1, Real const * R2, Real const * M0, Real duration,
+    Complex * F, Complex * F_star, Complex * Z,
+    std::size_t states_count, std::size_t stride,
+    std::size_t begin, std::size_t end, std::size_t step);
+
+SYCOMORE_DEFINE_SIMD_DISPATCHER_FUNCTION(
+    void, relaxation_batch_d,
+    (
+        Real const * R1, Real const * R2, Real const * M0, Real duration,
+        Complex * F, Complex * F_star, Complex * Z,
+        std::size_t states_count, std::size_t stride))
+
+template<typename RealType, typename ComplexType>
+void diffusion_batch_w(
+    Real delta_k, Real tau, Real const * D, Real const * k_array,
+    Complex * F, Complex * F_star, Complex * Z,
+    std::size_t states_count, std::size_t stride,
+    std::size_t begin, std::size_t end, std::size_t step);
+
+SYCOMORE_DEFINE_SIMD_DISPATCHER_FUNCTION(
+    void, diffusion_batch_d,
+    (
+        Real delta_k, Real tau, Real const * D, Real const * k_array,
+        Complex * F, Complex * F_star, Complex * Z,
+        std::size_t states_count, std::size_t stride))
+
+template<typename RealType, typename ComplexType>
+void off_resonance_batch_w(
+    Real duration, Real delta_omega, Real const * species_delta_omega,
+    Complex * F, Complex * F_star,
+    std::size_t states_count, std::size_t stride,
+    std::size_t begin, std::size_t end, std::size_t step);
+
+SYCOMORE_DEFINE_SIMD_DISPATCHER_FUNCTION(
+    void, off_resonance_batch_d,
+    (
+        Real duration, Real delta_omega, Real const * species_delta_omega,
+        Complex * F, Complex * F_star,
+        std::size_t states_count, std::size_t stride))
+
+// In the planar layout, the row of order i contains the real parts of the
+// states of all models, followed by their imaginary parts: the real part of
+// the state of order i of model m is located at 2*i*stride+m, and its
+// imaginary part at (2*i+1)*stride+m. Complex products are then computed on
+// real vectors, without shuffling real and imaginary parts. The _float
+// variants store the states in single precision, doubling the number of models
+// per vector; the per-model parameters remain in double precision.
+
+template<typename RealType, typename Scalar>
+void apply_pulse_batch_planar_w(
+    Real angle, Real phase, Real const * B1,
+    Scalar * F, Scalar * F_star, Scalar * Z,
+    std::size_t states_count, std::size_t stride,
+    std::size_t begin, std::size_t end, std::size_t step);
+
+SYCOMORE_DEFINE_SIMD_DISPATCHER_FUNCTION(
+    void, apply_pulse_batch_planar_d,
+    (
+        Real angle, Real phase, Real const * B1,
+        Real * F, Real * F_star, Real * Z,
+        std::size_t states_count, std::size_t stride))
+
+SYCOMORE_DEFINE_SIMD_DISPATCHER_FUNCTION(
+    void, apply_pulse_batch_planar_float_d,
+    (
+        Real angle, Real phase, Real const * B1,
+        float * F, float * F_star, float * Z,
+        std::size_t states_count, std::size_t stride))
+
+template<typename RealType, typename Scalar>
+void relaxation_batch_planar_w(
+    Real const * R1, Real const * R2, Real const * M0, Real duration,
+    Scalar * F, Scalar * F_star, Scalar * Z,
+    std::size_t states_count, std::size_t stride,
+    std::size_t begin, std::size_t end, std::size_t step);
+
+SYCOMORE_DEFINE_SIMD_DISPATCHER_FUNCTION(
+    void, relaxation_batch_planar_d,
+    (
+        Real const * R1, Real const * R2, Real const * M0, Real duration,
+        Real * F, Real * F_star, Real * Z,
+        std::size_t states_count, std::size_t stride))
+
+SYCOMORE_DEFINE_SIMD_DISPATCHER_FUNCTION(
+    void, relaxation_batch_planar_float_d,
+    (
+        Real const * R1, Real const * R2, Real const * M0, Real duration,
+        float * F, float * F_star, float * Z,
+        std::size_t states_count, std::size_t stride))
+
+template<typename RealType, typename Scalar>
+void diffusion_batch_planar_w(
+    Real delta_k, Real tau, Real const * D, Real const * k_array,
+    Scalar * F, Scalar * F_star, Scalar * Z,
+    std::size_t states_count, std::size_t stride,
+    std::size_t begin, std::size_t end, std::size_t step);
+
+SYCOMORE_DEFINE_SIMD_DISPATCHER_FUNCTION(
+    void, diffusion_batch_planar_d,
+    (
+        Real delta_k, Real tau, Real const * D, Real const * k_array,
+        Real * F, Real * F_star, Real * Z,
+        std::size_t states_count, std::size_t stride))
+
+SYCOMORE_DEFINE_SIMD_DISPATCHER_FUNCTION(
+    void, diffusion_batch_planar_float_d,
+    (
+        Real delta_k, Real tau, Real const * D, Real const * k_array,
+        float * F, float * F_star, float * Z,
+        std::size_t states_count, std::size_t stride))
+
+template<typename RealType, typename Scalar>
+void off_resonance_batch_planar_w(
+    Real duration, Real delta_omega, Real const * species_delta_omega,
+    Scalar * F, Scalar * F_star,
+    std::size_t states_count, std::size_t stride,
+    std::size_t begin, std::size_t end, std::size_t step);
+
+SYCOMORE_DEFINE_SIMD_DISPATCHER_FUNCTION(
+    void, off_resonance_batch_planar_d,
+    (
+        Real duration, Real delta_omega, Real const * species_delta_omega,
+        Real * F, Real * F_star,
+        std::size_t states_count, std::size_t stride))
+
+SYCOMORE_DEFINE_SIMD_DISPATCHER_FUNCTION(
+    void, off_resonance_batch_planar_float_d,
+    (
+        Real duration, Real delta_omega, Real const * species_delta_omega,
+        float * F, float * F_star,
+        std::size_t states_count, std::size_t stride))
+
 /*******************************************************************************
  *                          Function table and set-up                          *
  ******************************************************************************/
@@ -201,6 +453,29 @@ extern decltype(&diffusion_3d_b_d<unsupported>) diffusion_3d_b;
 extern decltype(&diffusion_3d_d<unsupported>) diffusion_3d;
 extern decltype(&off_resonance_d<unsupported>) off_resonance;
 extern decltype(&bulk_motion_d<unsupported>) bulk_motion;
+extern decltype(&time_interval_d<unsupported>) time_interval;
+extern decltype(&add_scaled_single_pool_d<unsupported>)
+    add_scaled_single_pool;
+extern decltype(&cull_magnitude_d<unsupported>) cull_magnitude;
+extern decltype(&apply_pulse_batch_d<unsupported>) apply_pulse_batch;
+extern decltype(&relaxation_batch_d<unsupported>) relaxation_batch;
+extern decltype(&diffusion_batch_d<unsupported>) diffusion_batch;
+extern decltype(&off_resonance_batch_d<unsupported>) off_resonance_batch;
+extern decltype(&apply_pulse_batch_planar_d<unsupported>)
+    apply_pulse_batch_planar;
+extern decltype(&relaxation_batch_planar_d<unsupported>)
+    relaxation_batch_planar;
+extern decltype(&diffusion_batch_planar_d<unsupported>) diffusion_batch_planar;
+extern decltype(&off_resonance_batch_planar_d<unsupported>)
+    off_resonance_batch_planar;
+extern decltype(&apply_pulse_batch_planar_float_d<unsupported>)
+    apply_pulse_batch_planar_float;
+extern decltype(&relaxation_batch_planar_float_d<unsupported>)
+    relaxation_batch_planar_float;
+extern decltype(&diffusion_batch_planar_float_d<unsupported>)
+    diffusion_batch_planar_float;
+extern decltype(&off_resonance_batch_planar_float_d<unsupported>)
+    off_resonance_batch_planar_float;
 
 void set_api(unsigned instruction_set);
 
@@ -3,6 +3,9 @@
 
 #include "simd_api.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <initializer_list>
 #include <utility>
 #include <vector>
 
@@ -20,11 +23,54 @@ namespace epg
 namespace simd_api
 {
     
+/*******************************************************************************
+ *                               Circular storage                              *
+ ******************************************************************************/
+
+template<typename Function>
+void for_each_segment(
+    std::size_t capacity, std::size_t F_offset, std::size_t F_star_offset,
+    std::size_t states_count, Function function)
+{
+    std::size_t order=0;
+    while(order < states_count)
+    {
+        auto const F_index = (F_offset+order) % capacity;
+        auto const F_star_index = (F_star_offset+order) % capacity;
+        auto const count = std::min({
+            states_count-order, capacity-F_index, capacity-F_star_index});
+        function(order, F_index, F_star_index, count);
+        order += count;
+    }
+}
+
+template<typename Function>
+void for_each_segment(
+    Model const & model, std::size_t states_count, Function function)
+{
+    for_each_segment(
+        model.F[0].size(), model.F_offset, model.F_star_offset, states_count,
+        function);
+}
+
+template<INSTRUCTION_SET_TYPE InstructionSet>
+bool is_aligned(std::initializer_list<void const *> pointers)
+{
+    // Alignment of a full register
+    auto const alignment =
+        simd::Batch<Real, InstructionSet>::size*sizeof(Real);
+    return std::all_of(
+        pointers.begin(), pointers.end(),
+        [&](void const * pointer) {
+            return reinterpret_cast<std::uintptr_t>(pointer) % alignment == 0;
+        });
+}
+
 /*******************************************************************************
  *                                Pulse operators                              *
  ******************************************************************************/
 
-template<typename ValueType>
+template<typename ValueType, bool Aligned>
 void apply_pulse_single_pool_w(
     std::array<Complex, 9> const & T,
     Complex * F, Complex * F_star, Complex * Z,
@@ -33,20 +79,20 @@ void apply_pulse_single_pool_w(
     for(std::size_t i=start; i<end; i+=step)
     {
         ValueType F_i, F_star_i, Z_i;
-        sycomore::simd::load_aligned(F+i, F_i);
-        sycomore::simd::load_aligned(F_star+i, F_star_i);
-        sycomore::simd::load_aligned(Z+i, Z_i);
+        sycomore::simd::load<Aligned>(F+i, F_i);
+        sycomore::simd::load<Aligned>(F_star+i, F_star_i);
+        sycomore::simd::load<Aligned>(Z+i, Z_i);
     
         auto const F_i_new = 
-            T[3*0+0] * F_i + T[3*0+1] * F_star_i + T[3*0+2] * Z_i;
+            sycomore::simd::dot(T.data()+3*0, F_i, F_star_i, Z_i);
         auto const F_i_star_new = 
-            T[3*1+0] * F_i + T[3*1+1] * F_star_i + T[3*1+2] * Z_i;
+            sycomore::simd::dot(T.data()+3*1, F_i, F_star_i, Z_i);
         // NOTE: no need to store Z_i_new, Z_i is not reused later
         
-        sycomore::simd::store_aligned(F_i_new, F+i);
-        sycomore::simd::store_aligned(F_i_star_new, F_star+i);
-        sycomore::simd::store_aligned(
-            T[3*2+0] * F_i + T[3*2+1] * F_star_i + T[3*2+2] * Z_i, Z+i);
+        sycomore::simd::store<Aligned>(F_i_new, F+i);
+        sycomore::simd::store<Aligned>(F_i_star_new, F_star+i);
+        sycomore::simd::store<Aligned>(
+            sycomore::simd::dot(T.data()+3*2, F_i, F_star_i, Z_i), Z+i);
     }
 }
 
@@ -56,19 +102,34 @@ apply_pulse_single_pool_d(
     std::array<Complex, 9> const & T, Model & model, std::size_t states_count)
 {    
     using Batch = simd::Batch<Complex, InstructionSet>;
-    auto const simd_end = states_count - states_count % Batch::size;
     
-    apply_pulse_single_pool_w<Batch>(
-        T,
-        model.F[0].data(), model.F_star[0].data(), model.Z[0].data(),
-        0, simd_end, Batch::size);
-    apply_pulse_single_pool_w<Complex>(
-        T,
-        model.F[0].data(), model.F_star[0].data(), model.Z[0].data(),
-        simd_end, states_count, 1);
+    for_each_segment(
+        model, states_count,
+        [&](
+            std::size_t order, std::size_t F_index, std::size_t F_star_index,
+            std::size_t count)
+        {
+            auto F = model.F[0].data()+F_index;
+            auto F_star = model.F_star[0].data()+F_star_index;
+            auto Z = model.Z[0].data()+order;
+            auto const simd_end = count - count % Batch::size;
+            
+            if(is_aligned<InstructionSet>({F, F_star, Z}))
+            {
+                apply_pulse_single_pool_w<Batch, true>(
+                    T, F, F_star, Z, 0, simd_end, Batch::size);
+            }
+            else
+            {
+                apply_pulse_single_pool_w<Batch, false>(
+                    T, F, F_star, Z, 0, simd_end, Batch::size);
+            }
+            apply_pulse_single_pool_w<Complex>(
+                T, F, F_star, Z, simd_end, count, 1);
+        });
 }
 
-template<typename ValueType>
+template<typename ValueType, bool Aligned>
 void apply_pulse_exchange_w(
     std::array<Complex, 18> const & T,
     Complex * F_a, Complex * F_star_a, Complex * Z_a,
@@ -78,36 +139,36 @@ void apply_pulse_exchange_w(
     for(std::size_t i=start; i<end; i+=step)
     {
         ValueType F_a_i, F_star_a_i, Z_a_i;
-        sycomore::simd::load_aligned(F_a+i, F_a_i);
-        sycomore::simd::load_aligned(F_star_a+i, F_star_a_i);
-        sycomore::simd::load_aligned(Z_a+i, Z_a_i);
+        sycomore::simd::load<Aligned>(F_a+i, F_a_i);
+        sycomore::simd::load<Aligned>(F_star_a+i, F_star_a_i);
+        sycomore::simd::load<Aligned>(Z_a+i, Z_a_i);
     
         auto const F_a_i_new = 
-            T[3*0+0] * F_a_i + T[3*0+1] * F_star_a_i + T[3*0+2] * Z_a_i;
+            sycomore::simd::dot(T.data()+3*0, F_a_i, F_star_a_i, Z_a_i);
         auto const F_star_a_i_new = 
-            T[3*1+0] * F_a_i + T[3*1+1] * F_star_a_i + T[3*1+2] * Z_a_i;
+            sycomore::simd::dot(T.data()+3*1, F_a_i, F_star_a_i, Z_a_i);
         auto const Z_a_i_new =
-            T[3*2+0] * F_a_i + T[3*2+1] * F_star_a_i + T[3*2+2] * Z_a_i;
+            sycomore::simd::dot(T.data()+3*2, F_a_i, F_star_a_i, Z_a_i);
         
-        sycomore::simd::store_aligned(F_a_i_new, F_a+i);
-        sycomore::simd::store_aligned(F_star_a_i_new, F_star_a+i);
-        sycomore::simd::store_aligned(Z_a_i_new, Z_a+i);
+        sycomore::simd::store<Aligned>(F_a_i_new, F_a+i);
+        sycomore::simd::store<Aligned>(F_star_a_i_new, F_star_a+i);
+        sycomore::simd::store<Aligned>(Z_a_i_new, Z_a+i);
         
         ValueType F_b_i, F_star_b_i, Z_b_i;
-        sycomore::simd::load_aligned(F_b+i, F_b_i);
-        sycomore::simd::load_aligned(F_star_b+i, F_star_b_i);
-        sycomore::simd::load_aligned(Z_b+i, Z_b_i);
+        sycomore::simd::load<Aligned>(F_b+i, F_b_i);
+        sycomore::simd::load<Aligned>(F_star_b+i, F_star_b_i);
+        sycomore::simd::load<Aligned>(Z_b+i, Z_b_i);
     
         auto const F_b_i_new = 
-            T[3*3+0] * F_b_i + T[3*3+1] * F_star_b_i + T[3*3+2] * Z_b_i;
+            sycomore::simd::dot(T.data()+3*3, F_b_i, F_star_b_i, Z_b_i);
         auto const F_star_b_i_new = 
-            T[3*4+0] * F_b_i + T[3*4+1] * F_star_b_i + T[3*4+2] * Z_b_i;
+            sycomore::simd::dot(T.data()+3*4, F_b_i, F_star_b_i, Z_b_i);
         auto const Z_b_i_new =
-            T[3*5+0] * F_b_i + T[3*5+1] * F_star_b_i + T[3*5+2] * Z_b_i;
+            sycomore::simd::dot(T.data()+3*5, F_b_i, F_star_b_i, Z_b_i);
         
-        sycomore::simd::store_aligned(F_b_i_new, F_b+i);
-        sycomore::simd::store_aligned(F_star_b_i_new, F_star_b+i);
-        sycomore::simd::store_aligned(Z_b_i_new, Z_b+i);
+        sycomore::simd::store<Aligned>(F_b_i_new, F_b+i);
+        sycomore::simd::store<Aligned>(F_star_b_i_new, F_star_b+i);
+        sycomore::simd::store<Aligned>(Z_b_i_new, Z_b+i);
     }
 }
 
@@ -117,21 +178,42 @@ apply_pulse_exchange_d(
     std::array<Complex, 18> const & T, Model & model, std::size_t states_count)
 {
     using Batch = simd::Batch<Complex, InstructionSet>;
-    auto const simd_end = states_count - states_count % Batch::size;
     
-    apply_pulse_exchange_w<Batch>(
-        T,
-        model.F[0].data(), model.F_star[0].data(), model.Z[0].data(),
-        model.F[1].data(), model.F_star[1].data(), model.Z[1].data(),
-        0, simd_end, Batch::size);
-    apply_pulse_exchange_w<Complex>(
-        T,
-        model.F[0].data(), model.F_star[0].data(), model.Z[0].data(),
-        model.F[1].data(), model.F_star[1].data(), model.Z[1].data(),
-        simd_end, states_count, 1);
+    for_each_segment(
+        model, states_count,
+        [&](
+            std::size_t order, std::size_t F_index, std::size_t F_star_index,
+            std::size_t count)
+        {
+            auto F_a = model.F[0].data()+F_index;
+            auto F_star_a = model.F_star[0].data()+F_star_index;
+            auto Z_a = model.Z[0].data()+order;
+            auto F_b = model.F[1].data()+F_index;
+            auto F_star_b = model.F_star[1].data()+F_star_index;
+            auto Z_b = model.Z[1].data()+order;
+            auto const simd_end = count - count % Batch::size;
+            
+            if(
+                is_aligned<InstructionSet>(
+                    {F_a, F_star_a, Z_a, F_b, F_star_b, Z_b}))
+            {
+                apply_pulse_exchange_w<Batch, true>(
+                    T, F_a, F_star_a, Z_a, F_b, F_star_b, Z_b,
+                    0, simd_end, Batch::size);
+            }
+            else
+            {
+                apply_pulse_exchange_w<Batch, false>(
+                    T, F_a, F_star_a, Z_a, F_b, F_star_b, Z_b,
+                    0, simd_end, Batch::size);
+            }
+            apply_pulse_exchange_w<Complex>(
+                T, F_a, F_star_a, Z_a, F_b, F_star_b, Z_b,
+                simd_end, count, 1);
+        });
 }
 
-template<typename ValueType>
+template<typename ValueType, bool Aligned>
 void apply_pulse_magnetization_transfer_w(
     std::array<Complex, 10> const & T,
     Complex * F, Complex * F_star, Complex * Z_a, Complex * Z_b,
@@ -140,24 +222,24 @@ void apply_pulse_magnetization_transfer_w(
     for(std::size_t i=start; i<end; i+=step)
     {
         ValueType F_i, F_star_i, Z_a_i;
-        sycomore::simd::load_aligned(F+i, F_i);
-        sycomore::simd::load_aligned(F_star+i, F_star_i);
-        sycomore::simd::load_aligned(Z_a+i, Z_a_i);
+        sycomore::simd::load<Aligned>(F+i, F_i);
+        sycomore::simd::load<Aligned>(F_star+i, F_star_i);
+        sycomore::simd::load<Aligned>(Z_a+i, Z_a_i);
     
         auto const F_i_new = 
-            T[3*0+0] * F_i + T[3*0+1] * F_star_i + T[3*0+2] * Z_a_i;
+            sycomore::simd::dot(T.data()+3*0, F_i, F_star_i, Z_a_i);
         auto const F_i_star_new = 
-            T[3*1+0] * F_i + T[3*1+1] * F_star_i + T[3*1+2] * Z_a_i;
+            sycomore::simd::dot(T.data()+3*1, F_i, F_star_i, Z_a_i);
         auto const Z_a_i_new =
-            T[3*2+0] * F_i + T[3*2+1] * F_star_i + T[3*2+2] * Z_a_i;
+            sycomore::simd::dot(T.data()+3*2, F_i, F_star_i, Z_a_i);
         
-        sycomore::simd::store_aligned(F_i_new, F+i);
-        sycomore::simd::store_aligned(F_i_star_new, F_star+i);
-        sycomore::simd::store_aligned(Z_a_i_new, Z_a+i);
+        sycomore::simd::store<Aligned>(F_i_new, F+i);
+        sycomore::simd::store<Aligned>(F_i_star_new, F_star+i);
+        sycomore::simd::store<Aligned>(Z_a_i_new, Z_a+i);
         
         ValueType Z_b_i;
-        sycomore::simd::load_aligned(Z_b+i, Z_b_i);
-        sycomore::simd::store_aligned(Z_b_i*T[9], Z_b+i);
+        sycomore::simd::load<Aligned>(Z_b+i, Z_b_i);
+        sycomore::simd::store<Aligned>(Z_b_i*T[9], Z_b+i);
     }
 }
 
@@ -167,23 +249,39 @@ apply_pulse_magnetization_transfer_d(
     std::array<Complex, 10> const & T, Model & model, std::size_t states_count)
 {    
     using Batch = simd::Batch<Complex, InstructionSet>;
-    auto const simd_end = states_count - states_count % Batch::size;
     
-    apply_pulse_magnetization_transfer_w<Batch>(
-        T,
-        model.F[0].data(), model.F_star[0].data(), model.Z[0].data(),
-        model.Z[1].data(), 0, simd_end, Batch::size);
-    apply_pulse_magnetization_transfer_w<Complex>(
-        T,
-        model.F[0].data(), model.F_star[0].data(), model.Z[0].data(),
-        model.Z[1].data(), simd_end, states_count, 1);
+    for_each_segment(
+        model, states_count,
+        [&](
+            std::size_t order, std::size_t F_index, std::size_t F_star_index,
+            std::size_t count)
+        {
+            auto F = model.F[0].data()+F_index;
+            auto F_star = model.F_star[0].data()+F_star_index;
+            auto Z_a = model.Z[0].data()+order;
+            auto Z_b = model.Z[1].data()+order;
+            auto const simd_end = count - count % Batch::size;
+            
+            if(is_aligned<InstructionSet>({F, F_star, Z_a, Z_b}))
+            {
+                apply_pulse_magnetization_transfer_w<Batch, true>(
+                    T, F, F_star, Z_a, Z_b, 0, simd_end, Batch::size);
+            }
+            else
+            {
+                apply_pulse_magnetization_transfer_w<Batch, false>(
+                    T, F, F_star, Z_a, Z_b, 0, simd_end, Batch::size);
+            }
+            apply_pulse_magnetization_transfer_w<Complex>(
+                T, F, F_star, Z_a, Z_b, simd_end, count, 1);
+        });
 }
 
 /*******************************************************************************
  *                             Relaxation operators                            *
  ******************************************************************************/
 
-template<typename ValueType>
+template<typename ValueType, bool Aligned>
 void relaxation_single_pool_w(
     std::pair<Real, Real> const & E,
     Complex * F, Complex * F_star, Complex * Z,
@@ -192,16 +290,16 @@ void relaxation_single_pool_w(
     for(std::size_t i=start; i<end; i+=step)
     {
         ValueType F_i;
-        sycomore::simd::load_aligned(F+i, F_i);
-        sycomore::simd::store_aligned(F_i*E.second, F+i);
+        sycomore::simd::load<Aligned>(F+i, F_i);
+        sycomore::simd::store<Aligned>(F_i*E.second, F+i);
 
         ValueType F_star_i;
-        sycomore::simd::load_aligned(F_star+i, F_star_i);
-        sycomore::simd::store_aligned(F_star_i*E.second, F_star+i);
+        sycomore::simd::load<Aligned>(F_star+i, F_star_i);
+        sycomore::simd::store<Aligned>(F_star_i*E.second, F_star+i);
 
         ValueType Z_i;
-        sycomore::simd::load_aligned(Z+i, Z_i);
-        sycomore::simd::store_aligned(Z_i*E.first, Z+i);
+        sycomore::simd::load<Aligned>(Z+i, Z_i);
+        sycomore::simd::store<Aligned>(Z_i*E.first, Z+i);
     }
 }
 
@@ -211,19 +309,34 @@ relaxation_single_pool_d(
     std::pair<Real, Real> const & E, Model & model, std::size_t states_count)
 {
     using Batch = simd::Batch<Complex, InstructionSet>;
-    auto const simd_end = states_count - states_count % Batch::size;
     
-    relaxation_single_pool_w<Batch>(
-        E,
-        model.F[0].data(), model.F_star[0].data(), model.Z[0].data(),
-        0, simd_end, Batch::size);
-    relaxation_single_pool_w<Complex>(
-        E,
-        model.F[0].data(), model.F_star[0].data(), model.Z[0].data(),
-        simd_end, states_count, 1);
+    for_each_segment(
+        model, states_count,
+        [&](
+            std::size_t order, std::size_t F_index, std::size_t F_star_index,
+            std::size_t count)
+        {
+            auto F = model.F[0].data()+F_index;
+            auto F_star = model.F_star[0].data()+F_star_index;
+            auto Z = model.Z[0].data()+order;
+            auto const simd_end = count - count % Batch::size;
+            
+            if(is_aligned<InstructionSet>({F, F_star, Z}))
+            {
+                relaxation_single_pool_w<Batch, true>(
+                    E, F, F_star, Z, 0, simd_end, Batch::size);
+            }
+            else
+            {
+                relaxation_single_pool_w<Batch, false>(
+                    E, F, F_star, Z, 0, simd_end, Batch::size);
+            }
+            relaxation_single_pool_w<Complex>(
+                E, F, F_star, Z, simd_end, count, 1);
+        });
 }
 
-template<typename ValueType>
+template<typename ValueType, bool Aligned>
 void
 relaxation_exchange_w(
     std::array<Complex, 8> const & Xi_T, std::array<Real, 4> const & Xi_L,
@@ -234,41 +347,41 @@ relaxation_exchange_w(
     for(std::size_t i=start; i<end; i+=step)
     {
         ValueType F_a_i;
-        sycomore::simd::load_aligned(F_a+i, F_a_i);
+        sycomore::simd::load<Aligned>(F_a+i, F_a_i);
 
         ValueType F_star_a_i;
-        sycomore::simd::load_aligned(F_star_a+i, F_star_a_i);
+        sycomore::simd::load<Aligned>(F_star_a+i, F_star_a_i);
         
         ValueType F_b_i;
-        sycomore::simd::load_aligned(F_b+i, F_b_i);
+        sycomore::simd::load<Aligned>(F_b+i, F_b_i);
 
         ValueType F_star_b_i;
-        sycomore::simd::load_aligned(F_star_b+i, F_star_b_i);
+        sycomore::simd::load<Aligned>(F_star_b+i, F_star_b_i);
         
         auto const F_a_i_new = Xi_T[0]*F_a_i+Xi_T[1]*F_b_i;
         auto const F_star_a_i_new = Xi_T[2]*F_star_a_i+Xi_T[3]*F_star_b_i;
         auto const F_b_i_new = Xi_T[4]*F_a_i+Xi_T[5]*F_b_i;
         auto const F_star_b_i_new = Xi_T[6]*F_star_a_i+Xi_T[7]*F_star_b_i;
         
-        sycomore::simd::store_aligned(F_a_i_new, F_a+i);
-        sycomore::simd::store_aligned(F_star_a_i_new, F_star_a+i);
-        sycomore::simd::store_aligned(F_b_i_new, F_b+i);
-        sycomore::simd::store_aligned(F_star_b_i_new, F_star_b+i);
+        sycomore::simd::store<Aligned>(F_a_i_new, F_a+i);
+        sycomore::simd::store<Aligned>(F_star_a_i_new, F_star_a+i);
+        sycomore::simd::store<Aligned>(F_b_i_new, F_b+i);
+        sycomore::simd::store<Aligned>(F_star_b_i_new, F_star_b+i);
     }
     
     for(std::size_t i=start; i<end; i+=step)
     {
         ValueType Z_a_i;
-        sycomore::simd::load_aligned(Z_a+i, Z_a_i);
+        sycomore::simd::load<Aligned>(Z_a+i, Z_a_i);
         
         ValueType Z_b_i;
-        sycomore::simd::load_aligned(Z_b+i, Z_b_i);
+        sycomore::simd::load<Aligned>(Z_b+i, Z_b_i);
         
         auto const Z_a_i_new = Xi_L[0]*Z_a_i+Xi_L[1]*Z_b_i;
         auto const Z_b_i_new = Xi_L[2]*Z_a_i+Xi_L[3]*Z_b_i;
         
-        sycomore::simd::store_aligned(Z_a_i_new, Z_a+i);
-        sycomore::simd::store_aligned(Z_b_i_new, Z_b+i);
+        sycomore::simd::store<Aligned>(Z_a_i_new, Z_a+i);
+        sycomore::simd::store<Aligned>(Z_b_i_new, Z_b+i);
     }
 }
 
@@ -279,21 +392,42 @@ relaxation_exchange_d(
     Model & model, std::size_t states_count)
 {
     using Batch = simd::Batch<Complex, InstructionSet>;
-    auto const simd_end = states_count - states_count % Batch::size;
     
-    relaxation_exchange_w<Batch>(
-        Xi_T, Xi_L,
-        model.F[0].data(), model.F_star[0].data(), model.Z[0].data(),
-        model.F[1].data(), model.F_star[1].data(), model.Z[1].data(),
-        0, simd_end, Batch::size);
-    relaxation_exchange_w<Complex>(
-        Xi_T, Xi_L,
-        model.F[0].data(), model.F_star[0].data(), model.Z[0].data(),
-        model.F[1].data(), model.F_star[1].data(), model.Z[1].data(),
-        simd_end, states_count, 1);
+    for_each_segment(
+        model, states_count,
+        [&](
+            std::size_t order, std::size_t F_index, std::size_t F_star_index,
+            std::size_t count)
+        {
+            auto F_a = model.F[0].data()+F_index;
+            auto F_star_a = model.F_star[0].data()+F_star_index;
+            auto Z_a = model.Z[0].data()+order;
+            auto F_b = model.F[1].data()+F_index;
+            auto F_star_b = model.F_star[1].data()+F_star_index;
+            auto Z_b = model.Z[1].data()+order;
+            auto const simd_end = count - count % Batch::size;
+            
+            if(
+                is_aligned<InstructionSet>(
+                    {F_a, F_star_a, Z_a, F_b, F_star_b, Z_b}))
+            {
+                relaxation_exchange_w<Batch, true>(
+                    Xi_T, Xi_L, F_a, F_star_a, Z_a, F_b, F_star_b, Z_b,
+                    0, simd_end, Batch::size);
+            }
+            else
+            {
+                relaxation_exchange_w<Batch, false>(
+                    Xi_T, Xi_L, F_a, F_star_a, Z_a, F_b, F_star_b, Z_b,
+                    0, simd_end, Batch::size);
+            }
+            relaxation_exchange_w<Complex>(
+                Xi_T, Xi_L, F_a, F_star_a, Z_a, F_b, F_star_b, Z_b,
+                simd_end, count, 1);
+        });
 }
 
-template<typename ValueType>
+template<typename ValueType, bool Aligned>
 void relaxation_magnetization_transfer_w(
     Real const & Xi_T, std::array<Real, 4> const & Xi_L,
     Complex * F_a, Complex * F_star_a, Complex * Z_a,
@@ -303,27 +437,27 @@ void relaxation_magnetization_transfer_w(
     for(std::size_t i=start; i<end; i+=step)
     {
         ValueType F_a_i;
-        sycomore::simd::load_aligned(F_a+i, F_a_i);
-        sycomore::simd::store_aligned(F_a_i*Xi_T, F_a+i);
+        sycomore::simd::load<Aligned>(F_a+i, F_a_i);
+        sycomore::simd::store<Aligned>(F_a_i*Xi_T, F_a+i);
         
         ValueType F_star_a_i;
-        sycomore::simd::load_aligned(F_star_a+i, F_star_a_i);
-        sycomore::simd::store_aligned(F_star_a_i*Xi_T, F_star_a+i);
+        sycomore::simd::load<Aligned>(F_star_a+i, F_star_a_i);
+        sycomore::simd::store<Aligned>(F_star_a_i*Xi_T, F_star_a+i);
     }
     
     for(std::size_t i=start; i<end; i+=step)
     {
         ValueType Z_a_i;
-        sycomore::simd::load_aligned(Z_a+i, Z_a_i);
+        sycomore::simd::load<Aligned>(Z_a+i, Z_a_i);
         
         ValueType Z_b_i;
-        sycomore::simd::load_aligned(Z_b+i, Z_b_i);
+        sycomore::simd::load<Aligned>(Z_b+i, Z_b_i);
         
         auto const Z_a_i_new = Xi_L[0]*Z_a_i+Xi_L[1]*Z_b_i;
         auto const Z_b_i_new = Xi_L[2]*Z_a_i+Xi_L[3]*Z_b_i;
         
-        sycomore::simd::store_aligned(Z_a_i_new, Z_a+i);
-        sycomore::simd::store_aligned(Z_b_i_new, Z_b+i);
+        sycomore::simd::store<Aligned>(Z_a_i_new, Z_a+i);
+        sycomore::simd::store<Aligned>(Z_b_i_new, Z_b+i);
     }
 }
 
@@ -333,25 +467,46 @@ void relaxation_magnetization_transfer_d(
     Model & model, std::size_t states_count)
 {
     using Batch = simd::Batch<Complex, InstructionSet>;
-    auto const simd_end = states_count - states_count % Batch::size;
     
-    relaxation_magnetization_transfer_w<Batch>(
-        Xi_T, Xi_L,
-        model.F[0].data(), model.F_star[0].data(), model.Z[0].data(),
-        model.F[1].data(), model.F_star[1].data(), model.Z[1].data(),
-        0, simd_end, Batch::size);
-    relaxation_magnetization_transfer_w<Complex>(
-        Xi_T, Xi_L,
-        model.F[0].data(), model.F_star[0].data(), model.Z[0].data(),
-        model.F[1].data(), model.F_star[1].data(), model.Z[1].data(),
-        simd_end, states_count, 1);
+    for_each_segment(
+        model, states_count,
+        [&](
+            std::size_t order, std::size_t F_index, std::size_t F_star_index,
+            std::size_t count)
+        {
+            auto F_a = model.F[0].data()+F_index;
+            auto F_star_a = model.F_star[0].data()+F_star_index;
+            auto Z_a = model.Z[0].data()+order;
+            auto F_b = model.F[1].data()+F_index;
+            auto F_star_b = model.F_star[1].data()+F_star_index;
+            auto Z_b = model.Z[1].data()+order;
+            auto const simd_end = count - count % Batch::size;
+            
+            if(
+                is_aligned<InstructionSet>(
+                    {F_a, F_star_a, Z_a, F_b, F_star_b, Z_b}))
+            {
+                relaxation_magnetization_transfer_w<Batch, true>(
+                    Xi_T, Xi_L, F_a, F_star_a, Z_a, F_b, F_star_b, Z_b,
+                    0, simd_end, Batch::size);
+            }
+            else
+            {
+                relaxation_magnetization_transfer_w<Batch, false>(
+                    Xi_T, Xi_L, F_a, F_star_a, Z_a, F_b, F_star_b, Z_b,
+                    0, simd_end, Batch::size);
+            }
+            relaxation_magnetization_transfer_w<Complex>(
+                Xi_T, Xi_L, F_a, F_star_a, Z_a, F_b, F_star_b, Z_b,
+                simd_end, count, 1);
+        });
 }
 
 /*******************************************************************************
  *                             Diffusion operator                              *
  ******************************************************************************/
 
-template<typename RealType, typename ComplexType>
+template<typename RealType, typename ComplexType, bool Aligned>
 void diffusion_w(
     Real delta_k, Real tau, Real D, Real const * k_array,
     Complex * F, Complex * F_star, Complex * Z,
@@ -360,21 +515,21 @@ void diffusion_w(
     for(std::size_t i=begin; i<end; i+=step)
     {
         RealType k;
-        sycomore::simd::load_aligned(k_array+i, k);
+        sycomore::simd::load<Aligned>(k_array+i, k);
         
         auto const D_ = operators::diffusion(D, tau, k, delta_k);
         
         ComplexType F_i;
-        sycomore::simd::load_aligned(F+i, F_i);
-        sycomore::simd::store_aligned(F_i*std::get<0>(D_), F+i);
+        sycomore::simd::load<Aligned>(F+i, F_i);
+        sycomore::simd::store<Aligned>(F_i*std::get<0>(D_), F+i);
         
         ComplexType F_star_i;
-        sycomore::simd::load_aligned(F_star+i, F_star_i);
-        sycomore::simd::store_aligned(F_star_i*std::get<1>(D_), F_star+i);
+        sycomore::simd::load<Aligned>(F_star+i, F_star_i);
+        sycomore::simd::store<Aligned>(F_star_i*std::get<1>(D_), F_star+i);
         
         ComplexType Z_i;
-        sycomore::simd::load_aligned(Z+i, Z_i);
-        sycomore::simd::store_aligned(Z_i*std::get<2>(D_), Z+i);
+        sycomore::simd::load<Aligned>(Z+i, Z_i);
+        sycomore::simd::store<Aligned>(Z_i*std::get<2>(D_), Z+i);
     }
 }
 
@@ -383,18 +538,39 @@ void
 diffusion_d(
     Real delta_k, Real tau, Real D, Real const * k,
     Model::Population & F, Model::Population & F_star, Model::Population & Z,
+    std::size_t F_offset, std::size_t F_star_offset,
     std::size_t states_count)
-{    
+{
     using RealBatch = simd::Batch<Real, InstructionSet>;
     using ComplexBatch = simd::Batch<Complex, InstructionSet>;
-    auto const simd_end = states_count - states_count % ComplexBatch::size;
     
-    diffusion_w<RealBatch, ComplexBatch>(
-        delta_k, tau, D, k, F.data(), F_star.data(), Z.data(),
-        0, simd_end, ComplexBatch::size);
-    diffusion_w<Real, Complex>(
-        delta_k, tau, D, k, F.data(), F_star.data(), Z.data(),
-        simd_end, states_count, 1);
+    for_each_segment(
+        F.size(), F_offset, F_star_offset, states_count,
+        [&](
+            std::size_t order, std::size_t F_index, std::size_t F_star_index,
+            std::size_t count)
+        {
+            auto F_ = F.data()+F_index;
+            auto F_star_ = F_star.data()+F_star_index;
+            auto Z_ = Z.data()+order;
+            auto k_ = k+order;
+            auto const simd_end = count - count % ComplexBatch::size;
+            
+            if(is_aligned<InstructionSet>({F_, F_star_, Z_, k_}))
+            {
+                diffusion_w<RealBatch, ComplexBatch, true>(
+                    delta_k, tau, D, k_, F_, F_star_, Z_,
+                    0, simd_end, ComplexBatch::size);
+            }
+            else
+            {
+                diffusion_w<RealBatch, ComplexBatch, false>(
+                    delta_k, tau, D, k_, F_, F_star_, Z_,
+                    0, simd_end, ComplexBatch::size);
+            }
+            diffusion_w<Real, Complex>(
+                delta_k, tau, D, k_, F_, F_star_, Z_, simd_end, count, 1);
+        });
 }
 
 /*******************************************************************************
@@ -504,7 +680,7 @@ diffusion_3d_b_d(
  *                           Off-resonance operator                            *
  ******************************************************************************/
 
-template<typename ValueType>
+template<typename ValueType, bool Aligned>
 void off_resonance_w(
     std::pair<Complex, Complex> const & phi,
     Complex * F, Complex * F_star,
@@ -513,11 +689,11 @@ void off_resonance_w(
     for(std::size_t i=begin; i<end; i+=step)
     {
         ValueType F_i, F_star_i;
-        sycomore::simd::load_aligned(F+i, F_i);
-        sycomore::simd::load_aligned(F_star+i, F_star_i);
+        sycomore::simd::load<Aligned>(F+i, F_i);
+        sycomore::simd::load<Aligned>(F_star+i, F_star_i);
         
-        sycomore::simd::store_aligned(F_i*phi.first, F+i);
-        sycomore::simd::store_aligned(F_star_i*phi.second, F_star+i);
+        sycomore::simd::store<Aligned>(F_i*phi.first, F+i);
+        sycomore::simd::store<Aligned>(F_star_i*phi.second, F_star+i);
         
         // Z̃ states are unaffected
     }
@@ -528,22 +704,40 @@ void
 off_resonance_d(
     std::pair<Complex, Complex> const & phi,
     Model::Population & F, Model::Population & F_star,
+    std::size_t F_offset, std::size_t F_star_offset,
     std::size_t states_count)
-{    
+{
     using Batch = simd::Batch<Complex, InstructionSet>;
-    auto const simd_end = states_count - states_count % Batch::size;
     
-    off_resonance_w<Batch>(
-        phi, F.data(), F_star.data(), 0, simd_end, Batch::size);
-    off_resonance_w<Complex>(
-        phi, F.data(), F_star.data(), simd_end, states_count, 1);
+    for_each_segment(
+        F.size(), F_offset, F_star_offset, states_count,
+        [&](
+            std::size_t, std::size_t F_index, std::size_t F_star_index,
+            std::size_t count)
+        {
+            auto F_ = F.data()+F_index;
+            auto F_star_ = F_star.data()+F_star_index;
+            auto const simd_end = count - count % Batch::size;
+            
+            if(is_aligned<InstructionSet>({F_, F_star_}))
+            {
+                off_resonance_w<Batch, true>(
+                    phi, F_, F_star_, 0, simd_end, Batch::size);
+            }
+            else
+            {
+                off_resonance_w<Batch, false>(
+                    phi, F_, F_star_, 0, simd_end, Batch::size);
+            }
+            off_resonance_w<Complex>(phi, F_, F_star_, simd_end, count, 1);
+        });
 }
 
 /*******************************************************************************
  *                            Bulk motion operator                             *
  ******************************************************************************/
 
-template<typename RealType, typename ComplexType>
+template<typename RealType, typename ComplexType, bool Aligned>
 void bulk_motion_w(
     Real delta_k, Real v, Real tau, Real const * k_array,
     Complex * F, Complex * F_star, Complex * Z,
@@ -552,22 +746,22 @@ void bulk_motion_w(
     for(std::size_t i=begin; i<end; i+=step)
     {
         RealType k;
-        sycomore::simd::load_aligned(k_array+i, k);
+        sycomore::simd::load<Aligned>(k_array+i, k);
         
         auto const J = operators::bulk_motion<RealType, ComplexType>(
             v, tau, k, delta_k);
         
         ComplexType F_i;
-        sycomore::simd::load_aligned(F+i, F_i);
-        sycomore::simd::store_aligned(F_i*std::get<0>(J), F+i);
+        sycomore::simd::load<Aligned>(F+i, F_i);
+        sycomore::simd::store<Aligned>(F_i*std::get<0>(J), F+i);
         
         ComplexType F_star_i;
-        sycomore::simd::load_aligned(F_star+i, F_star_i);
-        sycomore::simd::store_aligned(F_star_i*std::get<1>(J), F_star+i);
+        sycomore::simd::load<Aligned>(F_star+i, F_star_i);
+        sycomore::simd::store<Aligned>(F_star_i*std::get<1>(J), F_star+i);
         
         ComplexType Z_i;
-        sycomore::simd::load_aligned(Z+i, Z_i);
-        sycomore::simd::store_aligned(Z_i*std::get<2>(J), Z+i);
+        sycomore::simd::load<Aligned>(Z+i, Z_i);
+        sycomore::simd::store<Aligned>(Z_i*std::get<2>(J), Z+i);
     }
 }
 
@@ -579,20 +773,936 @@ bulk_motion_d(
 {    
     using RealBatch = simd::Batch<Real, InstructionSet>;
     using ComplexBatch = simd::Batch<Complex, InstructionSet>;
-    auto const simd_end = states_count - states_count % ComplexBatch::size;
     
     for(std::size_t pool=0; pool<model.pools; ++pool)
     {
-        auto F = model.F[pool].data();
-        auto F_star = model.F_star[pool].data();
-        auto Z = model.Z[pool].data();
-        bulk_motion_w<RealBatch, ComplexBatch>(
-            delta_k, v, tau, k, F, F_star, Z, 0, simd_end, ComplexBatch::size);
-        bulk_motion_w<Real, Complex>(
-            delta_k, v, tau, k, F, F_star, Z, simd_end, states_count, 1);
+        for_each_segment(
+            model, states_count,
+            [&](
+                std::size_t order, std::size_t F_index,
+                std::size_t F_star_index, std::size_t count)
+            {
+                auto F = model.F[pool].data()+F_index;
+                auto F_star = model.F_star[pool].data()+F_star_index;
+                auto Z = model.Z[pool].data()+order;
+                auto k_ = k+order;
+                auto const simd_end = count - count % ComplexBatch::size;
+                
+                if(is_aligned<InstructionSet>({F, F_star, Z, k_}))
+                {
+                    bulk_motion_w<RealBatch, ComplexBatch, true>(
+                        delta_k, v, tau, k_, F, F_star, Z,
+                        0, simd_end, ComplexBatch::size);
+                }
+                else
+                {
+                    bulk_motion_w<RealBatch, ComplexBatch, false>(
+                        delta_k, v, tau, k_, F, F_star, Z,
+                        0, simd_end, ComplexBatch::size);
+                }
+                bulk_motion_w<Real, Complex>(
+                    delta_k, v, tau, k_, F, F_star, Z, simd_end, count, 1);
+            });
+    }
+}
+
+/*******************************************************************************
+ *                           Time interval operator                            *
+ ******************************************************************************/
+
+template<typename RealType, typename ComplexType, bool Aligned>
+void time_interval_w(
+    std::pair<Real, Real> const & E, Real delta_k, Real tau, Real D, Real v,
+    std::pair<Complex, Complex> const & phi, Real const * k_array,
+    Complex * F, Complex * F_star, Complex * Z,
+    std::size_t begin, std::size_t end, std::size_t step)
+{
+    // Order-independent part of the operator
+    auto const F_factor = E.second*phi.first;
+    auto const F_star_factor = E.second*phi.second;
+    auto const Z_factor = E.first;
+    
+    for(std::size_t i=begin; i<end; i+=step)
+    {
+        ComplexType F_i, F_star_i, Z_i;
+        sycomore::simd::load<Aligned>(F+i, F_i);
+        sycomore::simd::load<Aligned>(F_star+i, F_star_i);
+        sycomore::simd::load<Aligned>(Z+i, Z_i);
+        
+        F_i = F_i*F_factor;
+        F_star_i = F_star_i*F_star_factor;
+        Z_i = Z_i*Z_factor;
+        
+        if(k_array != nullptr)
+        {
+            RealType k;
+            sycomore::simd::load<Aligned>(k_array+i, k);
+            
+            if(D != 0)
+            {
+                auto const D_ = operators::diffusion(D, tau, k, delta_k);
+                F_i = F_i*std::get<0>(D_);
+                F_star_i = F_star_i*std::get<1>(D_);
+                Z_i = Z_i*std::get<2>(D_);
+            }
+            
+            if(v != 0)
+            {
+                auto const J = operators::bulk_motion<RealType, ComplexType>(
+                    v, tau, k, delta_k);
+                F_i = F_i*std::get<0>(J);
+                F_star_i = F_star_i*std::get<1>(J);
+                Z_i = Z_i*std::get<2>(J);
+            }
+        }
+        
+        sycomore::simd::store<Aligned>(F_i, F+i);
+        sycomore::simd::store<Aligned>(F_star_i, F_star+i);
+        sycomore::simd::store<Aligned>(Z_i, Z+i);
     }
 }
 
+template<INSTRUCTION_SET_TYPE InstructionSet>
+void
+time_interval_d(
+    std::pair<Real, Real> const & E, Real delta_k, Real tau, Real D, Real v,
+    std::pair<Complex, Complex> const & phi, Real const * k,
+    Model::Population & F, Model::Population & F_star, Model::Population & Z,
+    std::size_t F_offset, std::size_t F_star_offset,
+    std::size_t states_count)
+{
+    using RealBatch = simd::Batch<Real, InstructionSet>;
+    using ComplexBatch = simd::Batch<Complex, InstructionSet>;
+    
+    for_each_segment(
+        F.size(), F_offset, F_star_offset, states_count,
+        [&](
+            std::size_t order, std::size_t F_index, std::size_t F_star_index,
+            std::size_t count)
+        {
+            auto F_ = F.data()+F_index;
+            auto F_star_ = F_star.data()+F_star_index;
+            auto Z_ = Z.data()+order;
+            auto k_ = (k != nullptr) ? k+order : nullptr;
+            auto const simd_end = count - count % ComplexBatch::size;
+            
+            if(is_aligned<InstructionSet>({F_, F_star_, Z_, k_}))
+            {
+                time_interval_w<RealBatch, ComplexBatch, true>(
+                    E, delta_k, tau, D, v, phi, k_, F_, F_star_, Z_,
+                    0, simd_end, ComplexBatch::size);
+            }
+            else
+            {
+                time_interval_w<RealBatch, ComplexBatch, false>(
+                    E, delta_k, tau, D, v, phi, k_, F_, F_star_, Z_,
+                    0, simd_end, ComplexBatch::size);
+            }
+            time_interval_w<Real, Complex>(
+                E, delta_k, tau, D, v, phi, k_, F_, F_star_, Z_,
+                simd_end, count, 1);
+        });
+}
+
+/*******************************************************************************
+ *                                Accumulation                                 *
+ ******************************************************************************/
+
+template<typename ValueType, bool Aligned>
+void
+add_scaled_single_pool_w(
+    std::array<Real, 3> const & factors,
+    Complex const * F, Complex const * F_star, Complex const * Z,
+    Complex * F_out, Complex * F_star_out, Complex * Z_out,
+    std::size_t start, std::size_t end, std::size_t step)
+{
+    for(std::size_t i=start; i<end; i+=step)
+    {
+        ValueType F_i, F_out_i;
+        sycomore::simd::load<Aligned>(F+i, F_i);
+        sycomore::simd::load<Aligned>(F_out+i, F_out_i);
+        sycomore::simd::store<Aligned>(F_out_i+F_i*factors[0], F_out+i);
+        
+        ValueType F_star_i, F_star_out_i;
+        sycomore::simd::load<Aligned>(F_star+i, F_star_i);
+        sycomore::simd::load<Aligned>(F_star_out+i, F_star_out_i);
+        sycomore::simd::store<Aligned>(
+            F_star_out_i+F_star_i*factors[1], F_star_out+i);
+        
+        ValueType Z_i, Z_out_i;
+        sycomore::simd::load<Aligned>(Z+i, Z_i);
+        sycomore::simd::load<Aligned>(Z_out+i, Z_out_i);
+        sycomore::simd::store<Aligned>(Z_out_i+Z_i*factors[2], Z_out+i);
+    }
+}
+
+template<INSTRUCTION_SET_TYPE InstructionSet>
+void
+add_scaled_single_pool_d(
+    std::array<Real, 3> const & factors, Model const & source,
+    Model & destination, std::size_t states_count)
+{
+    using Batch = simd::Batch<Complex, InstructionSet>;
+    
+    for_each_segment(
+        source, states_count,
+        [&](
+            std::size_t order, std::size_t F_index, std::size_t F_star_index,
+            std::size_t count)
+        {
+            auto F = source.F[0].data()+F_index;
+            auto F_star = source.F_star[0].data()+F_star_index;
+            auto Z = source.Z[0].data()+order;
+            auto F_out = destination.F[0].data()+F_index;
+            auto F_star_out = destination.F_star[0].data()+F_star_index;
+            auto Z_out = destination.Z[0].data()+order;
+            auto const simd_end = count - count % Batch::size;
+            
+            if(is_aligned<InstructionSet>(
+                {F, F_star, Z, F_out, F_star_out, Z_out}))
+            {
+                add_scaled_single_pool_w<Batch, true>(
+                    factors, F, F_star, Z, F_out, F_star_out, Z_out,
+                    0, simd_end, Batch::size);
+            }
+            else
+            {
+                add_scaled_single_pool_w<Batch, false>(
+                    factors, F, F_star, Z, F_out, F_star_out, Z_out,
+                    0, simd_end, Batch::size);
+            }
+            add_scaled_single_pool_w<Complex>(
+                factors, F, F_star, Z, F_out, F_star_out, Z_out,
+                simd_end, count, 1);
+        });
+}
+
+/*******************************************************************************
+ *                               Threshold culling                             *
+ ******************************************************************************/
+
+template<typename RealType, typename ComplexType, bool Aligned>
+void cull_magnitude_w(
+    Complex const * F, Complex const * F_star, Complex const * Z,
+    Real * magnitude, bool first_pool,
+    std::size_t begin, std::size_t end, std::size_t step)
+{
+    // NOTE: |x|^2 is computed from the real and imaginary parts, to avoid the
+    // square root of abs.
+    auto const norm = [](ComplexType const & x) {
+        return RealType(x.real()*x.real() + x.imag()*x.imag()); };
+    
+    for(std::size_t i=begin; i<end; i+=step)
+    {
+        ComplexType F_i, F_star_i, Z_i;
+        sycomore::simd::load<Aligned>(F+i, F_i);
+        sycomore::simd::load<Aligned>(F_star+i, F_star_i);
+        sycomore::simd::load<Aligned>(Z+i, Z_i);
+        
+        RealType magnitude_i = norm(F_i) + norm(F_star_i) + norm(Z_i);
+        if(!first_pool)
+        {
+            RealType previous;
+            sycomore::simd::load<Aligned>(magnitude+i, previous);
+            magnitude_i = sycomore::simd::max(magnitude_i, previous);
+        }
+        
+        sycomore::simd::store<Aligned>(magnitude_i, magnitude+i);
+    }
+}
+
+template<INSTRUCTION_SET_TYPE InstructionSet>
+void
+cull_magnitude_d(
+    Model const & model, std::size_t states_count, Real * magnitude)
+{
+    using RealBatch = simd::Batch<Real, InstructionSet>;
+    using ComplexBatch = simd::Batch<Complex, InstructionSet>;
+    
+    for(std::size_t pool=0; pool<model.pools; ++pool)
+    {
+        auto const & F = model.F[pool];
+        auto const & F_star = model.F_star[pool];
+        auto const & Z = model.Z[pool];
+        
+        for_each_segment(
+            model, states_count,
+            [&](
+                std::size_t order, std::size_t F_index,
+                std::size_t F_star_index, std::size_t count)
+            {
+                auto F_ = F.data()+F_index;
+                auto F_star_ = F_star.data()+F_star_index;
+                auto Z_ = Z.data()+order;
+                auto magnitude_ = magnitude+order;
+                auto const simd_end = count - count % ComplexBatch::size;
+                
+                if(is_aligned<InstructionSet>({F_, F_star_, Z_, magnitude_}))
+                {
+                    cull_magnitude_w<RealBatch, ComplexBatch, true>(
+                        F_, F_star_, Z_, magnitude_, pool==0,
+                        0, simd_end, ComplexBatch::size);
+                }
+                else
+                {
+                    cull_magnitude_w<RealBatch, ComplexBatch, false>(
+                        F_, F_star_, Z_, magnitude_, pool==0,
+                        0, simd_end, ComplexBatch::size);
+                }
+                cull_magnitude_w<Real, Complex>(
+                    F_, F_star_, Z_, magnitude_, pool==0,
+                    simd_end, count, 1);
+            });
+    }
+}
+
+template<typename Order>
+std::size_t cull(
+    Real threshold, Model & model, Order * orders, std::size_t order_width,
+    std::size_t states_count, Real * magnitude)
+{
+    cull_magnitude(model, states_count, magnitude);
+    auto const threshold_squared = threshold*threshold;
+    
+    // Always include the zero order (implicit since we start at 1), include
+    // other orders if their magnitude is above threshold. The source order is
+    // always copied and the destination only advances if the order is kept:
+    // this avoids a data-dependent branch.
+    std::size_t destination=1;
+    for(std::size_t source=1; source<states_count; ++source)
+    {
+        for(std::size_t j=0; j<order_width; ++j)
+        {
+            orders[destination*order_width+j] = orders[source*order_width+j];
+        }
+        for(std::size_t pool=0; pool<model.pools; ++pool)
+        {
+            model.F[pool][destination] = model.F[pool][source];
+            model.F_star[pool][destination] = model.F_star[pool][source];
+            model.Z[pool][destination] = model.Z[pool][source];
+        }
+        destination += (magnitude[source] >= threshold_squared);
+    }
+    
+    for(std::size_t pool=0; pool<model.pools; ++pool)
+    {
+        model.F[pool].resize(destination);
+        model.F_star[pool].resize(destination);
+        model.Z[pool].resize(destination);
+    }
+    
+    return destination;
+}
+
+/*******************************************************************************
+ *                               Batched models                                *
+ ******************************************************************************/
+
+template<typename RealType, typename ComplexType>
+void apply_pulse_batch_w(
+    Real angle, Real phase, Real const * B1,
+    Complex * F, Complex * F_star, Complex * Z,
+    std::size_t states_count, std::size_t stride,
+    std::size_t begin, std::size_t end, std::size_t step)
+{
+    // Phase terms are shared by all models, see operators::pulse_single_pool
+    auto const cos_phase = std::cos(phase);
+    auto const sin_phase = std::sin(phase);
+    auto const cos_2_phase = std::cos(2*phase);
+    auto const sin_2_phase = std::sin(2*phase);
+    
+    for(std::size_t m=begin; m<end; m+=step)
+    {
+        RealType B1_m;
+        sycomore::simd::load_aligned(B1+m, B1_m);
+        
+        auto const a = angle*B1_m;
+        RealType const cos_a = sycomore::simd::cos(a);
+        RealType const sin_a = sycomore::simd::sin(a);
+        RealType const cos_squared = 0.5*(1.+cos_a);
+        RealType const sin_squared = 0.5*(1.-cos_a);
+        
+        // Non-real terms of the pulse matrix; the diagonal terms are real.
+        ComplexType const T_0_1(
+            cos_2_phase*sin_squared, sin_2_phase*sin_squared);
+        ComplexType const T_0_2(sin_phase*sin_a, -cos_phase*sin_a);
+        ComplexType const T_1_0(
+            cos_2_phase*sin_squared, -sin_2_phase*sin_squared);
+        ComplexType const T_1_2(sin_phase*sin_a, cos_phase*sin_a);
+        ComplexType const T_2_0(-0.5*sin_phase*sin_a, -0.5*cos_phase*sin_a);
+        ComplexType const T_2_1(-0.5*sin_phase*sin_a, 0.5*cos_phase*sin_a);
+        
+        for(std::size_t order=0; order<states_count; ++order)
+        {
+            auto const i = order*stride+m;
+            
+            ComplexType F_i, F_star_i, Z_i;
+            sycomore::simd::load_aligned(F+i, F_i);
+            sycomore::simd::load_aligned(F_star+i, F_star_i);
+            sycomore::simd::load_aligned(Z+i, Z_i);
+            
+            sycomore::simd::store_aligned(
+                F_i*cos_squared + T_0_1*F_star_i + T_0_2*Z_i, F+i);
+            sycomore::simd::store_aligned(
+                T_1_0*F_i + F_star_i*cos_squared + T_1_2*Z_i, F_star+i);
+            sycomore::simd::store_aligned(
+                T_2_0*F_i + T_2_1*F_star_i + Z_i*cos_a, Z+i);
+        }
+    }
+}
+
+template<INSTRUCTION_SET_TYPE InstructionSet>
+void
+apply_pulse_batch_d(
+    Real angle, Real phase, Real const * B1,
+    Complex * F, Complex * F_star, Complex * Z,
+    std::size_t states_count, std::size_t stride)
+{
+    using RealBatch = simd::Batch<Real, InstructionSet>;
+    using ComplexBatch = simd::Batch<Complex, InstructionSet>;
+    auto const simd_end = stride - stride % ComplexBatch::size;
+    
+    apply_pulse_batch_w<RealBatch, ComplexBatch>(
+        angle, phase, B1, F, F_star, Z, states_count, stride,
+        0, simd_end, ComplexBatch::size);
+    apply_pulse_batch_w<Real, Complex>(
+        angle, phase, B1, F, F_star, Z, states_count, stride,
+        simd_end, stride, 1);
+}
+
+template<typename RealType, typename ComplexType>
+void relaxation_batch_w(
+    Real const * R1, Real const * R2, Real const * M0, Real duration,
+    Complex * F, Complex * F_star, Complex * Z,
+    std::size_t states_count, std::size_t stride,
+    std::size_t begin, std::size_t end, std::size_t step)
+{
+    for(std::size_t m=begin; m<end; m+=step)
+    {
+        RealType R1_m, R2_m, M0_m;
+        sycomore::simd::load_aligned(R1+m, R1_m);
+        sycomore::simd::load_aligned(R2+m, R2_m);
+        sycomore::simd::load_aligned(M0+m, M0_m);
+        
+        RealType const E_1 = sycomore::simd::exp(-duration*R1_m);
+        RealType const E_2 = sycomore::simd::exp(-duration*R2_m);
+        
+        for(std::size_t order=0; order<states_count; ++order)
+        {
+            auto const i = order*stride+m;
+            
+            ComplexType F_i, F_star_i, Z_i;
+            sycomore::simd::load_aligned(F+i, F_i);
+            sycomore::simd::load_aligned(F_star+i, F_star_i);
+            sycomore::simd::load_aligned(Z+i, Z_i);
+            
+            sycomore::simd::store_aligned(F_i*E_2, F+i);
+            sycomore::simd::store_aligned(F_star_i*E_2, F_star+i);
+            sycomore::simd::store_aligned(Z_i*E_1, Z+i);
+        }
+        
+        // Recovery only affects the Z̃_0 state
+        ComplexType Z_0;
+        sycomore::simd::load_aligned(Z+m, Z_0);
+        sycomore::simd::store_aligned(
+            Z_0+ComplexType(M0_m*(1.-E_1), RealType(0.)), Z+m);
+    }
+}
+
+template<INSTRUCTION_SET_TYPE InstructionSet>
+void
+relaxation_batch_d(
+    Real const * R1, Real const * R2, Real const * M0, Real duration,
+    Complex * F, Complex * F_star, Complex * Z,
+    std::size_t states_count, std::size_t stride)
+{
+    using RealBatch = simd::Batch<Real, InstructionSet>;
+    using ComplexBatch = simd::Batch<Complex, InstructionSet>;
+    auto const simd_end = stride - stride % ComplexBatch::size;
+    
+    relaxation_batch_w<RealBatch, ComplexBatch>(
+        R1, R2, M0, duration, F, F_star, Z, states_count, stride,
+        0, simd_end, ComplexBatch::size);
+    relaxation_batch_w<Real, Complex>(
+        R1, R2, M0, duration, F, F_star, Z, states_count, stride,
+        simd_end, stride, 1);
+}
+
+template<typename RealType, typename ComplexType>
+void diffusion_batch_w(
+    Real delta_k, Real tau, Real const * D, Real const * k_array,
+    Complex * F, Complex * F_star, Complex * Z,
+    std::size_t states_count, std::size_t stride,
+    std::size_t begin, std::size_t end, std::size_t step)
+{
+    auto const b_T_common = std::pow(delta_k, 2) / 12;
+    for(std::size_t order=0; order<states_count; ++order)
+    {
+        // The b-values only depend on the order, the diffusion coefficients
+        // only depend on the model: compute the former once per order, and
+        // sweep the models, which are contiguous in memory.
+        auto const & k = k_array[order];
+        auto const b_T_plus = tau*(std::pow(k+delta_k/2, 2) + b_T_common);
+        auto const b_T_minus = tau*(std::pow(-k+delta_k/2, 2) + b_T_common);
+        auto const b_L = std::pow(k, 2) * tau;
+        
+        for(std::size_t m=begin; m<end; m+=step)
+        {
+            RealType D_m;
+            sycomore::simd::load_aligned(D+m, D_m);
+            
+            auto const i = order*stride+m;
+            
+            ComplexType F_i, F_star_i, Z_i;
+            sycomore::simd::load_aligned(F+i, F_i);
+            sycomore::simd::load_aligned(F_star+i, F_star_i);
+            sycomore::simd::load_aligned(Z+i, Z_i);
+            
+            RealType const D_T_plus = sycomore::simd::exp(-b_T_plus*D_m);
+            RealType const D_T_minus = sycomore::simd::exp(-b_T_minus*D_m);
+            RealType const D_L = sycomore::simd::exp(-b_L*D_m);
+            
+            sycomore::simd::store_aligned(F_i*D_T_plus, F+i);
+            sycomore::simd::store_aligned(F_star_i*D_T_minus, F_star+i);
+            sycomore::simd::store_aligned(Z_i*D_L, Z+i);
+        }
+    }
+}
+
+template<INSTRUCTION_SET_TYPE InstructionSet>
+void
+diffusion_batch_d(
+    Real delta_k, Real tau, Real const * D, Real const * k_array,
+    Complex * F, Complex * F_star, Complex * Z,
+    std::size_t states_count, std::size_t stride)
+{
+    using RealBatch = simd::Batch<Real, InstructionSet>;
+    using ComplexBatch = simd::Batch<Complex, InstructionSet>;
+    auto const simd_end = stride - stride % ComplexBatch::size;
+    
+    diffusion_batch_w<RealBatch, ComplexBatch>(
+        delta_k, tau, D, k_array, F, F_star, Z, states_count, stride,
+        0, simd_end, ComplexBatch::size);
+    diffusion_batch_w<Real, Complex>(
+        delta_k, tau, D, k_array, F, F_star, Z, states_count, stride,
+        simd_end, stride, 1);
+}
+
+template<typename RealType, typename ComplexType>
+void off_resonance_batch_w(
+    Real duration, Real delta_omega, Real const * species_delta_omega,
+    Complex * F, Complex * F_star,
+    std::size_t states_count, std::size_t stride,
+    std::size_t begin, std::size_t end, std::size_t step)
+{
+    for(std::size_t m=begin; m<end; m+=step)
+    {
+        RealType species_delta_omega_m;
+        sycomore::simd::load_aligned(
+            species_delta_omega+m, species_delta_omega_m);
+        
+        auto const angle = 
+            duration*2*M_PI*(delta_omega+species_delta_omega_m);
+        RealType const cos_angle = sycomore::simd::cos(angle);
+        RealType const sin_angle = sycomore::simd::sin(angle);
+        
+        // See operators::phase_accumulation
+        ComplexType const phi_plus(cos_angle, sin_angle);
+        ComplexType const phi_minus(cos_angle, -sin_angle);
+        
+        for(std::size_t order=0; order<states_count; ++order)
+        {
+            auto const i = order*stride+m;
+            
+            ComplexType F_i, F_star_i;
+            sycomore::simd::load_aligned(F+i, F_i);
+            sycomore::simd::load_aligned(F_star+i, F_star_i);
+            
+            sycomore::simd::store_aligned(F_i*phi_plus, F+i);
+            sycomore::simd::store_aligned(F_star_i*phi_minus, F_star+i);
+            
+            // Z̃ states are unaffected
+        }
+    }
+}
+
+template<INSTRUCTION_SET_TYPE InstructionSet>
+void
+off_resonance_batch_d(
+    Real duration, Real delta_omega, Real const * species_delta_omega,
+    Complex * F, Complex * F_star,
+    std::size_t states_count, std::size_t stride)
+{
+    using RealBatch = simd::Batch<Real, InstructionSet>;
+    using ComplexBatch = simd::Batch<Complex, InstructionSet>;
+    auto const simd_end = stride - stride % ComplexBatch::size;
+    
+    off_resonance_batch_w<RealBatch, ComplexBatch>(
+        duration, delta_omega, species_delta_omega, F, F_star,
+        states_count, stride, 0, simd_end, ComplexBatch::size);
+    off_resonance_batch_w<Real, Complex>(
+        duration, delta_omega, species_delta_omega, F, F_star,
+        states_count, stride, simd_end, stride, 1);
+}
+
+template<typename RealType, typename Scalar>
+void apply_pulse_batch_planar_w(
+    Real angle, Real phase, Real const * B1,
+    Scalar * F, Scalar * F_star, Scalar * Z,
+    std::size_t states_count, std::size_t stride,
+    std::size_t begin, std::size_t end, std::size_t step)
+{
+    using sycomore::simd::multiply_add;
+    
+    // Phase terms are shared by all models, see operators::pulse_single_pool
+    Scalar const cos_phase = std::cos(phase);
+    Scalar const sin_phase = std::sin(phase);
+    Scalar const cos_2_phase = std::cos(2*phase);
+    Scalar const sin_2_phase = std::sin(2*phase);
+    Scalar const half = 0.5;
+    
+    for(std::size_t m=begin; m<end; m+=step)
+    {
+        RealType B1_m;
+        sycomore::simd::load_converted(B1+m, B1_m);
+        
+        RealType const a = Scalar(angle)*B1_m;
+        RealType const cos_a = sycomore::simd::cos(a);
+        RealType const sin_a = sycomore::simd::sin(a);
+        RealType const cos_squared = half*(Scalar(1)+cos_a);
+        RealType const sin_squared = half*(Scalar(1)-cos_a);
+        
+        // Real and imaginary parts of the non-real terms of the pulse matrix,
+        // see apply_pulse_batch_w.
+        RealType const T_0_1_r = cos_2_phase*sin_squared;
+        RealType const T_0_1_i = sin_2_phase*sin_squared;
+        RealType const T_0_2_r = sin_phase*sin_a;
+        RealType const T_0_2_i = -cos_phase*sin_a;
+        RealType const T_1_0_r = T_0_1_r;
+        RealType const T_1_0_i = -T_0_1_i;
+        RealType const T_1_2_r = T_0_2_r;
+        RealType const T_1_2_i = -T_0_2_i;
+        RealType const T_2_0_r = -half*T_0_2_r;
+        RealType const T_2_0_i = half*T_0_2_i;
+        RealType const T_2_1_r = T_2_0_r;
+        RealType const T_2_1_i = -T_2_0_i;
+        
+        for(std::size_t order=0; order<states_count; ++order)
+        {
+            auto const r = 2*order*stride+m;
+            auto const i = r+stride;
+            
+            RealType F_r, F_i, F_star_r, F_star_i, Z_r, Z_i;
+            sycomore::simd::load_aligned(F+r, F_r);
+            sycomore::simd::load_aligned(F+i, F_i);
+            sycomore::simd::load_aligned(F_star+r, F_star_r);
+            sycomore::simd::load_aligned(F_star+i, F_star_i);
+            sycomore::simd::load_aligned(Z+r, Z_r);
+            sycomore::simd::load_aligned(Z+i, Z_i);
+            
+            RealType F_r_new = cos_squared*F_r;
+            RealType F_i_new = cos_squared*F_i;
+            multiply_add(
+                T_0_1_r, T_0_1_i, F_star_r, F_star_i, F_r_new, F_i_new);
+            multiply_add(T_0_2_r, T_0_2_i, Z_r, Z_i, F_r_new, F_i_new);
+            
+            RealType F_star_r_new = cos_squared*F_star_r;
+            RealType F_star_i_new = cos_squared*F_star_i;
+            multiply_add(
+                T_1_0_r, T_1_0_i, F_r, F_i, F_star_r_new, F_star_i_new);
+            multiply_add(
+                T_1_2_r, T_1_2_i, Z_r, Z_i, F_star_r_new, F_star_i_new);
+            
+            RealType Z_r_new = cos_a*Z_r;
+            RealType Z_i_new = cos_a*Z_i;
+            multiply_add(T_2_0_r, T_2_0_i, F_r, F_i, Z_r_new, Z_i_new);
+            multiply_add(
+                T_2_1_r, T_2_1_i, F_star_r, F_star_i, Z_r_new, Z_i_new);
+            
+            sycomore::simd::store_aligned(F_r_new, F+r);
+            sycomore::simd::store_aligned(F_i_new, F+i);
+            sycomore::simd::store_aligned(F_star_r_new, F_star+r);
+            sycomore::simd::store_aligned(F_star_i_new, F_star+i);
+            sycomore::simd::store_aligned(Z_r_new, Z+r);
+            sycomore::simd::store_aligned(Z_i_new, Z+i);
+        }
+    }
+}
+
+template<INSTRUCTION_SET_TYPE InstructionSet>
+void
+apply_pulse_batch_planar_d(
+    Real angle, Real phase, Real const * B1,
+    Real * F, Real * F_star, Real * Z,
+    std::size_t states_count, std::size_t stride)
+{
+    using RealBatch = simd::Batch<Real, InstructionSet>;
+    auto const simd_end = stride - stride % RealBatch::size;
+    
+    apply_pulse_batch_planar_w<RealBatch>(
+        angle, phase, B1, F, F_star, Z, states_count, stride,
+        0, simd_end, RealBatch::size);
+    apply_pulse_batch_planar_w<Real>(
+        angle, phase, B1, F, F_star, Z, states_count, stride,
+        simd_end, stride, 1);
+}
+
+template<INSTRUCTION_SET_TYPE InstructionSet>
+void
+apply_pulse_batch_planar_float_d(
+    Real angle, Real phase, Real const * B1,
+    float * F, float * F_star, float * Z,
+    std::size_t states_count, std::size_t stride)
+{
+    using FloatBatch = simd::Batch<float, InstructionSet>;
+    auto const simd_end = stride - stride % FloatBatch::size;
+    
+    apply_pulse_batch_planar_w<FloatBatch>(
+        angle, phase, B1, F, F_star, Z, states_count, stride,
+        0, simd_end, FloatBatch::size);
+    apply_pulse_batch_planar_w<float>(
+        angle, phase, B1, F, F_star, Z, states_count, stride,
+        simd_end, stride, 1);
+}
+
+template<typename RealType, typename Scalar>
+void relaxation_batch_planar_w(
+    Real const * R1, Real const * R2, Real const * M0, Real duration,
+    Scalar * F, Scalar * F_star, Scalar * Z,
+    std::size_t states_count, std::size_t stride,
+    std::size_t begin, std::size_t end, std::size_t step)
+{
+    for(std::size_t m=begin; m<end; m+=step)
+    {
+        RealType R1_m, R2_m, M0_m;
+        sycomore::simd::load_converted(R1+m, R1_m);
+        sycomore::simd::load_converted(R2+m, R2_m);
+        sycomore::simd::load_converted(M0+m, M0_m);
+        
+        RealType const E_1 = sycomore::simd::exp(Scalar(-duration)*R1_m);
+        RealType const E_2 = sycomore::simd::exp(Scalar(-duration)*R2_m);
+        
+        // Real and imaginary parts are scaled by the same real factor.
+        for(std::size_t row=0; row<2*states_count; ++row)
+        {
+            auto const i = row*stride+m;
+            
+            RealType F_i, F_star_i, Z_i;
+            sycomore::simd::load_aligned(F+i, F_i);
+            sycomore::simd::load_aligned(F_star+i, F_star_i);
+            sycomore::simd::load_aligned(Z+i, Z_i);
+            
+            sycomore::simd::store_aligned(F_i*E_2, F+i);
+            sycomore::simd::store_aligned(F_star_i*E_2, F_star+i);
+            sycomore::simd::store_aligned(Z_i*E_1, Z+i);
+        }
+        
+        // Recovery only affects the real part of the Z̃_0 state
+        RealType Z_0;
+        sycomore::simd::load_aligned(Z+m, Z_0);
+        sycomore::simd::store_aligned(Z_0+M0_m*(Scalar(1)-E_1), Z+m);
+    }
+}
+
+template<INSTRUCTION_SET_TYPE InstructionSet>
+void
+relaxation_batch_planar_d(
+    Real const * R1, Real const * R2, Real const * M0, Real duration,
+    Real * F, Real * F_star, Real * Z,
+    std::size_t states_count, std::size_t stride)
+{
+    using RealBatch = simd::Batch<Real, InstructionSet>;
+    auto const simd_end = stride - stride % RealBatch::size;
+    
+    relaxation_batch_planar_w<RealBatch>(
+        R1, R2, M0, duration, F, F_star, Z, states_count, stride,
+        0, simd_end, RealBatch::size);
+    relaxation_batch_planar_w<Real>(
+        R1, R2, M0, duration, F, F_star, Z, states_count, stride,
+        simd_end, stride, 1);
+}
+
+template<INSTRUCTION_SET_TYPE InstructionSet>
+void
+relaxation_batch_planar_float_d(
+    Real const * R1, Real const * R2, Real const * M0, Real duration,
+    float * F, float * F_star, float * Z,
+    std::size_t states_count, std::size_t stride)
+{
+    using FloatBatch = simd::Batch<float, InstructionSet>;
+    auto const simd_end = stride - stride % FloatBatch::size;
+    
+    relaxation_batch_planar_w<FloatBatch>(
+        R1, R2, M0, duration, F, F_star, Z, states_count, stride,
+        0, simd_end, FloatBatch::size);
+    relaxation_batch_planar_w<float>(
+        R1, R2, M0, duration, F, F_star, Z, states_count, stride,
+        simd_end, stride, 1);
+}
+
+template<typename RealType, typename Scalar>
+void diffusion_batch_planar_w(
+    Real delta_k, Real tau, Real const * D, Real const * k_array,
+    Scalar * F, Scalar * F_star, Scalar * Z,
+    std::size_t states_count, std::size_t stride,
+    std::size_t begin, std::size_t end, std::size_t step)
+{
+    auto const b_T_common = std::pow(delta_k, 2) / 12;
+    for(std::size_t order=0; order<states_count; ++order)
+    {
+        // See diffusion_batch_w
+        auto const & k = k_array[order];
+        Scalar const minus_b_T_plus =
+            -tau*(std::pow(k+delta_k/2, 2) + b_T_common);
+        Scalar const minus_b_T_minus =
+            -tau*(std::pow(-k+delta_k/2, 2) + b_T_common);
+        Scalar const minus_b_L = -std::pow(k, 2) * tau;
+        
+        for(std::size_t m=begin; m<end; m+=step)
+        {
+            RealType D_m;
+            sycomore::simd::load_converted(D+m, D_m);
+            
+            RealType const D_T_plus = sycomore::simd::exp(minus_b_T_plus*D_m);
+            RealType const D_T_minus =
+                sycomore::simd::exp(minus_b_T_minus*D_m);
+            RealType const D_L = sycomore::simd::exp(minus_b_L*D_m);
+            
+            for(auto const i: {2*order*stride+m, (2*order+1)*stride+m})
+            {
+                RealType F_i, F_star_i, Z_i;
+                sycomore::simd::load_aligned(F+i, F_i);
+                sycomore::simd::load_aligned(F_star+i, F_star_i);
+                sycomore::simd::load_aligned(Z+i, Z_i);
+                
+                sycomore::simd::store_aligned(F_i*D_T_plus, F+i);
+                sycomore::simd::store_aligned(F_star_i*D_T_minus, F_star+i);
+                sycomore::simd::store_aligned(Z_i*D_L, Z+i);
+            }
+        }
+    }
+}
+
+template<INSTRUCTION_SET_TYPE InstructionSet>
+void
+diffusion_batch_planar_d(
+    Real delta_k, Real tau, Real const * D, Real const * k_array,
+    Real * F, Real * F_star, Real * Z,
+    std::size_t states_count, std::size_t stride)
+{
+    using RealBatch = simd::Batch<Real, InstructionSet>;
+    auto const simd_end = stride - stride % RealBatch::size;
+    
+    diffusion_batch_planar_w<RealBatch>(
+        delta_k, tau, D, k_array, F, F_star, Z, states_count, stride,
+        0, simd_end, RealBatch::size);
+    diffusion_batch_planar_w<Real>(
+        delta_k, tau, D, k_array, F, F_star, Z, states_count, stride,
+        simd_end, stride, 1);
+}
+
+template<INSTRUCTION_SET_TYPE InstructionSet>
+void
+diffusion_batch_planar_float_d(
+    Real delta_k, Real tau, Real const * D, Real const * k_array,
+    float * F, float * F_star, float * Z,
+    std::size_t states_count, std::size_t stride)
+{
+    using FloatBatch = simd::Batch<float, InstructionSet>;
+    auto const simd_end = stride - stride % FloatBatch::size;
+    
+    diffusion_batch_planar_w<FloatBatch>(
+        delta_k, tau, D, k_array, F, F_star, Z, states_count, stride,
+        0, simd_end, FloatBatch::size);
+    diffusion_batch_planar_w<float>(
+        delta_k, tau, D, k_array, F, F_star, Z, states_count, stride,
+        simd_end, stride, 1);
+}
+
+template<typename RealType, typename Scalar>
+void off_resonance_batch_planar_w(
+    Real duration, Real delta_omega, Real const * species_delta_omega,
+    Scalar * F, Scalar * F_star,
+    std::size_t states_count, std::size_t stride,
+    std::size_t begin, std::size_t end, std::size_t step)
+{
+    using sycomore::simd::fma;
+    using sycomore::simd::fnma;
+    
+    for(std::size_t m=begin; m<end; m+=step)
+    {
+        RealType species_delta_omega_m;
+        sycomore::simd::load_converted(
+            species_delta_omega+m, species_delta_omega_m);
+        
+        RealType const angle = Scalar(duration*2*M_PI)*(
+            Scalar(delta_omega)+species_delta_omega_m);
+        RealType const cos_angle = sycomore::simd::cos(angle);
+        RealType const sin_angle = sycomore::simd::sin(angle);
+        
+        for(std::size_t order=0; order<states_count; ++order)
+        {
+            auto const r = 2*order*stride+m;
+            auto const i = r+stride;
+            
+            RealType F_r, F_i, F_star_r, F_star_i;
+            sycomore::simd::load_aligned(F+r, F_r);
+            sycomore::simd::load_aligned(F+i, F_i);
+            sycomore::simd::load_aligned(F_star+r, F_star_r);
+            sycomore::simd::load_aligned(F_star+i, F_star_i);
+            
+            // F̃ is multiplied by exp(i angle), F̃* by exp(-i angle), see
+            // operators::phase_accumulation
+            sycomore::simd::store_aligned(
+                fnma(F_i, sin_angle, F_r*cos_angle), F+r);
+            sycomore::simd::store_aligned(
+                fma(F_r, sin_angle, F_i*cos_angle), F+i);
+            sycomore::simd::store_aligned(
+                fma(F_star_i, sin_angle, F_star_r*cos_angle), F_star+r);
+            sycomore::simd::store_aligned(
+                fnma(F_star_r, sin_angle, F_star_i*cos_angle), F_star+i);
+            
+            // Z̃ states are unaffected
+        }
+    }
+}
+
+template<INSTRUCTION_SET_TYPE InstructionSet>
+void
+off_resonance_batch_planar_d(
+    Real duration, Real delta_omega, Real const * species_delta_omega,
+    Real * F, Real * F_star,
+    std::size_t states_count, std::size_t stride)
+{
+    using RealBatch = simd::Batch<Real, InstructionSet>;
+    auto const simd_end = stride - stride % RealBatch::size;
+    
+    off_resonance_batch_planar_w<RealBatch>(
+        duration, delta_omega, species_delta_omega, F, F_star,
+        states_count, stride, 0, simd_end, RealBatch::size);
+    off_resonance_batch_planar_w<Real>(
+        duration, delta_omega, species_delta_omega, F, F_star,
+        states_count, stride, simd_end, stride, 1);
+}
+
+template<INSTRUCTION_SET_TYPE InstructionSet>
+void
+off_resonance_batch_planar_float_d(
+    Real duration, Real delta_omega, Real const * species_delta_omega,
+    float * F, float * F_star,
+    std::size_t states_count, std::size_t stride)
+{
+    using FloatBatch = simd::Batch<float, InstructionSet>;
+    auto const simd_end = stride - stride % FloatBatch::size;
+    
+    off_resonance_batch_planar_w<FloatBatch>(
+        duration, delta_omega, species_delta_omega, F, F_star,
+        states_count, stride, 0, simd_end, FloatBatch::size);
+    off_resonance_batch_planar_w<float>(
+        duration, delta_omega, species_delta_omega, F, F_star,
+        states_count, stride, simd_end, stride, 1);
+}
+
 }
 
 }
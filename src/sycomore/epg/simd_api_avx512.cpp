@@ -40,6 +40,7 @@ template
 void diffusion_d<XSIMD_X86_AVX512_VERSION>(
     Real delta_k, Real tau, Real D, Real const * k_array,
     Model::Population & F, Model::Population & F_star, Model::Population & Z,
+    std::size_t F_offset, std::size_t F_star_offset,
     std::size_t states_count);
 
 template 
@@ -60,6 +61,7 @@ void
 off_resonance_d<XSIMD_X86_AVX512_VERSION>(
     std::pair<Complex, Complex> const & phi,
     Model::Population & F, Model::Population & F_star,
+    std::size_t F_offset, std::size_t F_star_offset,
     std::size_t states_count);
 
 template
@@ -68,6 +70,110 @@ bulk_motion_d<XSIMD_X86_AVX512_VERSION>(
     Real delta_k, Real v, Real tau, Real const * k, Model & model,
     std::size_t states_count);
 
+template
+void
+time_interval_d<XSIMD_X86_AVX512_VERSION>(
+    std::pair<Real, Real> const & E, Real delta_k, Real tau, Real D, Real v,
+    std::pair<Complex, Complex> const & phi, Real const * k_array,
+    Model::Population & F, Model::Population & F_star, Model::Population & Z,
+    std::size_t F_offset, std::size_t F_star_offset,
+    std::size_t states_count);
+
+template
+void
+add_scaled_single_pool_d<XSIMD_X86_AVX512_VERSION>(
+    std::array<Real, 3> const & factors, Model const & source,
+    Model & destination, std::size_t states_count);
+
+template
+void
+cull_magnitude_d<XSIMD_X86_AVX512_VERSION>(
+    Model const & model, std::size_t states_count, Real * magnitude);
+
+template
+void
+apply_pulse_batch_d<XSIMD_X86_AVX512_VERSION>(
+    Real angle, Real phase, Real const * B1,
+    Complex * F, Complex * F_star, Complex * Z,
+    std::size_t states_count, std::size_t stride);
+
+template
+void
+relaxation_batch_d<XSIMD_X86_AVX512_VERSION>(
+    Real const * R1, Real const * R2, Real const * M0, Real duration,
+    Complex * F, Complex * F_star, Complex * Z,
+    std::size_t states_count, std::size_t stride);
+
+template
+void
+diffusion_batch_d<XSIMD_X86_AVX512_VERSION>(
+    Real delta_k, Real tau, Real const * D, Real const * k_array,
+    Complex * F, Complex * F_star, Complex * Z,
+    std::size_t states_count, std::size_t stride);
+
+template
+void
+off_resonance_batch_d<XSIMD_X86_AVX512_VERSION>(
+    Real duration, Real delta_omega, Real const * species_delta_omega,
+    Complex * F, Complex * F_star,
+    std::size_t states_count, std::size_t stride);
+
+template
+void
+apply_pulse_batch_planar_d<XSIMD_X86_AVX512_VERSION>(
+    Real angle, Real phase, Real const * B1,
+    Real * F, Real * F_star, Real * Z,
+    std::size_t states_count, std::size_t stride);
+
+template
+void
+apply_pulse_batch_planar_float_d<XSIMD_X86_AVX512_VERSION>(
+    Real angle, Real phase, Real const * B1,
+    float * F, float * F_star, float * Z,
+    std::size_t states_count, std::size_t stride);
+
+template
+void
+relaxation_batch_planar_d<XSIMD_X86_AVX512_VERSION>(
+    Real const * R1, Real const * R2, Real const * M0, Real duration,
+    Real * F, Real * F_star, Real * Z,
+    std::size_t states_count, std::size_t stride);
+
+template
+void
+relaxation_batch_planar_float_d<XSIMD_X86_AVX512_VERSION>(
+    Real const * R1, Real const * R2, Real const * M0, Real duration,
+    float * F, float * F_star, float * Z,
+    std::size_t states_count, std::size_t stride);
+
+template
+void
+diffusion_batch_planar_d<XSIMD_X86_AVX512_VERSION>(
+    Real delta_k, Real tau, Real const * D, Real const * k_array,
+    Real * F, Real * F_star, Real * Z,
+    std::size_t states_count, std::size_t stride);
+
+template
+void
+diffusion_batch_planar_float_d<XSIMD_X86_AVX512_VERSION>(
+    Real delta_k, Real tau, Real const * D, Real const * k_array,
+    float * F, float * F_star, float * Z,
+    std::size_t states_count, std::size_t stride);
+
+template
+void
+off_resonance_batch_planar_d<XSIMD_X86_AVX512_VERSION>(
+    Real duration, Real delta_omega, Real const * species_delta_omega,
+    Real * F, Real * F_star,
+    std::size_t states_count, std::size_t stride);
+
+template
+void
+off_resonance_batch_planar_float_d<XSIMD_X86_AVX512_VERSION>(
+    Real duration, Real delta_omega, Real const * species_delta_omega,
+    float * F, float * F_star,
+    std::size_t states_count, std::size_t stride);
+
 }
 
 }
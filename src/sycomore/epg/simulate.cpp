@@ -0,0 +1,55 @@
+#include "simulate.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include "sycomore/Array.h"
+#include "sycomore/epg/Discrete.h"
+#include "sycomore/Quantity.h"
+#include "sycomore/Species.h"
+#include "sycomore/sycomore.h"
+#include "sycomore/ThreadPool.h"
+
+namespace sycomore
+{
+
+namespace epg
+{
+
+TensorC<2> simulate(
+    DiscreteSequence const & sequence, std::vector<Species> const & species,
+    Vector3R const & initial_magnetization, Quantity const & bin_width,
+    unsigned int threads)
+{
+    std::vector<std::vector<Complex>> echoes(species.size());
+    
+    ThreadPool::shared(threads).parallel_for(
+        species.size(), 
+        [&](std::size_t index) {
+            Discrete model(species[index], initial_magnetization, bin_width);
+            echoes[index] = sequence(model);
+        },
+        1);
+    
+    auto const echoes_count = echoes.empty() ? 0 : echoes[0].size();
+    TensorC<2> result(
+        TensorC<2>::shape_type{species.size(), echoes_count});
+    for(std::size_t index=0; index<echoes.size(); ++index)
+    {
+        if(echoes[index].size() != echoes_count)
+        {
+            throw std::runtime_error(
+                "All models must yield the same number of echoes");
+        }
+        std::copy(
+            echoes[index].begin(), echoes[index].end(),
+            result.begin()+index*echoes_count);
+    }
+    
+    return result;
+}
+
+}
+
+}
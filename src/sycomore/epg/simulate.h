@@ -0,0 +1,45 @@
+#ifndef _fc34de90_f29d_49b3_a871_6076a1a62827
+#define _fc34de90_f29d_49b3_a871_6076a1a62827
+
+#include <functional>
+#include <vector>
+
+#include "sycomore/Array.h"
+#include "sycomore/epg/Discrete.h"
+#include "sycomore/Quantity.h"
+#include "sycomore/Species.h"
+#include "sycomore/sycomore.h"
+#include "sycomore/units.h"
+
+namespace sycomore
+{
+
+namespace epg
+{
+
+/**
+ * @brief Sequence applied to a single model, returning the acquired echoes.
+ *
+ * The sequence is called concurrently on independent models: it must not
+ * modify shared state.
+ */
+using DiscreteSequence = std::function<std::vector<Complex>(Discrete &)>;
+
+/**
+ * @brief Simulate a sequence on one single-pool discrete model per species,
+ * in parallel, and return the echoes as a species × echoes matrix.
+ *
+ * All models must yield the same number of echoes. If threads is 0, use the
+ * number of hardware threads.
+ */
+TensorC<2> simulate(
+    DiscreteSequence const & sequence, std::vector<Species> const & species,
+    Vector3R const & initial_magnetization={0,0,1},
+    Quantity const & bin_width=1*units::rad/units::m,
+    unsigned int threads=0);
+
+}
+
+}
+
+#endif // _fc34de90_f29d_49b3_a871_6076a1a62827
@@ -1,6 +1,7 @@
 #ifndef _a26d369d_eae0_467a_98b4_dde5e537b8ec
 #define _a26d369d_eae0_467a_98b4_dde5e537b8ec
 
+#include <array>
 #include <cstddef>
 #include <functional>
 
@@ -10,6 +11,22 @@ namespace sycomore
 /// @brief Combine two hashes, implementation from boost::hash_combine.
 void combine_hashes(std::size_t & seed, std::size_t value);
 
+/// @brief Hash of a fixed-size array, combining the hashes of its elements.
+template<typename T, std::size_t N>
+struct ArrayHash
+{
+    std::size_t operator()(std::array<T, N> const & array) const
+    {
+        std::hash<T> const hasher;
+        std::size_t seed = 0;
+        for(auto && item: array)
+        {
+            combine_hashes(seed, hasher(item));
+        }
+        return seed;
+    }
+};
+
 }
 
 #endif // _a26d369d_eae0_467a_98b4_dde5e537b8ec
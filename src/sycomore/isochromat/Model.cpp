@@ -1,8 +1,13 @@
 #include "Model.h"
 
+#include <algorithm>
 #include <array>
 #include <cmath>
+#include <cstddef>
+#include <functional>
+#include <memory>
 #include <stdexcept>
+#include <vector>
 
 #include <xtensor/xbuilder.hpp>
 #include <xtensor/xmath.hpp>
@@ -10,10 +15,14 @@
 #include <xtensor/xtensor.hpp>
 #include <xtensor/xview.hpp>
 
+#include "sycomore/Buffer.h"
+#include "sycomore/HardPulseApproximation.h"
 #include "sycomore/Quantity.h"
 #include "sycomore/sycomore.h"
+#include "sycomore/ThreadPool.h"
 #include "sycomore/units.h"
 #include "sycomore/isochromat/Operator.h"
+#include "sycomore/isochromat/simd_api.h"
 
 namespace sycomore
 {
@@ -43,8 +52,7 @@ Model
     TensorQ<2> const & positions, TensorQ<1> const & delta_omega)
 : _T1(T1.shape()), _T2(T2.shape()), _M0(xt::view(M0, xt::all(), 2UL)),
     _delta_omega(delta_omega.size() == 0 ? T1.shape() : delta_omega.shape()),
-    _magnetization(TensorR<2>::shape_type{M0.shape()[0], 4}),
-    _positions(positions.shape())
+    _stride(8*((M0.shape()[0]+7)/8)), _positions(positions.shape())
 {
     if(
         T1.size() != T2.size() || T1.size() != M0.shape()[0]
@@ -56,8 +64,17 @@ Model
     this->_T1 = convert_to(T1, units::s);
     this->_T2 = convert_to(T2, units::s);
     
-    xt::view(this->_magnetization, xt::all(), xt::range(0, 3)) = M0;
-    xt::view(this->_magnetization, xt::all(), 3UL) = 1;
+    // The number of isochromats is padded to the widest batch (8 reals for
+    // AVX-512) so that all rows are aligned.
+    this->_magnetization.resize(4*this->_stride, 0);
+    for(std::size_t n=0; n<M0.shape()[0]; ++n)
+    {
+        for(std::size_t i=0; i<3; ++i)
+        {
+            this->_magnetization[i*this->_stride+n] = M0.unchecked(n, i);
+        }
+        this->_magnetization[3*this->_stride+n] = 1;
+    }
     
     this->_delta_omega = 
         delta_omega.size() == 0
@@ -97,19 +114,25 @@ Model
     TensorR<1> const cos_angle = xt::cos(angle), cos_phase = xt::cos(phase_);
     TensorR<1> const sin_angle = xt::sin(angle), sin_phase = xt::sin(phase_);
     
+    // Affine operator: the last row, (0, 0, 0, 1), is not stored. The
+    // matrices are written in place, without per-isochromat temporaries.
     Operator::Array op = xt::zeros<Operator::Array::value_type>(
-        Operator::Array::shape_type{angle.size(), 4, 4});
+        Operator::Array::shape_type{angle.size(), 3, 4});
     for(std::size_t i=0; i<angle.size(); ++i)
     {
         auto const ca=cos_angle.unchecked(i), cp=cos_phase.unchecked(i);
         auto const sa=sin_angle.unchecked(i), sp=sin_phase.unchecked(i);
-        auto const cp2=std::pow(cp, 2), sp2=std::pow(sp, 2);
-        xt::view(op, i) = TensorR<2>{
-            {sp2*ca - sp2 + 1, (1-ca)*sp*cp,  sa*sp, 0},
-            {    (1-ca)*sp*cp,   sp2+ca*cp2, -sa*cp, 0},
-            {          -sa*sp,        sa*cp,     ca, 0},
-            {               0,            0,      0, 1}
-        };
+        auto const cp2=cp*cp, sp2=sp*sp;
+        auto * matrix = op.data()+12*i;
+        matrix[0] = sp2*ca - sp2 + 1;
+        matrix[1] = (1-ca)*sp*cp;
+        matrix[2] = sa*sp;
+        matrix[4] = (1-ca)*sp*cp;
+        matrix[5] = sp2+ca*cp2;
+        matrix[6] = -sa*cp;
+        matrix[8] = -sa*sp;
+        matrix[9] = sa*cp;
+        matrix[10] = ca;
     }
     return {op};
 }
@@ -160,18 +183,18 @@ Operator
 Model
 ::build_relaxation(Quantity const & duration) const
 {
+    // Diagonal affine operator: diagonal of the linear part, then translation.
     Operator::Array op = xt::zeros<Operator::Array::value_type>(
-        Operator::Array::shape_type{this->_positions.shape()[0], 4, 4});
+        Operator::Array::shape_type{this->_positions.shape()[0], 2, 3});
     auto const duration_s = duration.convert_to(units::s);
     auto const E1 = xt::exp(-duration_s/this->_T1);
     auto const E2 = xt::exp(-duration_s/this->_T2);
     xt::view(op, xt::all(), 0UL, 0UL) = E2;
-    xt::view(op, xt::all(), 1UL, 1UL) = E2;
-    xt::view(op, xt::all(), 2UL, 2UL) = E1;
-    xt::view(op, xt::all(), 3UL, 3UL) = 1;
-    xt::view(op, xt::all(), 2UL, 3UL) = this->_M0*(1-E1);
+    xt::view(op, xt::all(), 0UL, 1UL) = E2;
+    xt::view(op, xt::all(), 0UL, 2UL) = E1;
+    xt::view(op, xt::all(), 1UL, 2UL) = this->_M0*(1-E1);
     
-    return {op};
+    return {Operator::DiagonalAffine, op};
 }
 
 Operator
@@ -188,40 +211,215 @@ Model
     TensorR<1> const cos_angle = xt::cos(angle);
     TensorR<1> const sin_angle = xt::sin(angle);
     
-    Operator::Array op = xt::zeros<Operator::Array::value_type>(
-        Operator::Array::shape_type{angle.size(), 4, 4});
-    for(std::size_t i=0; i<angle.size(); ++i)
+    // Rotation around the z axis: cosine and sine of the angle.
+    Operator::Array op(Operator::Array::shape_type{angle.size(), 1, 2});
+    xt::view(op, xt::all(), 0UL, 0UL) = cos_angle;
+    xt::view(op, xt::all(), 0UL, 1UL) = sin_angle;
+    return {Operator::ZRotation, op};
+}
+
+void
+Model
+::apply(Operator const & operator_)
+{
+    auto const & data = operator_.data();
+    auto const size = this->_positions.shape()[0];
+    if(operator_.size() != 1 && operator_.size() != size)
     {
-        auto const ca=cos_angle.unchecked(i), sa=sin_angle.unchecked(i);
-        xt::view(op, i) = TensorR<2>{
-            {ca, -sa, 0, 0},
-            {sa,  ca, 0, 0},
-            { 0,   0, 1, 0},
-            { 0,   0, 0, 1}
-        };
+        throw std::runtime_error("Size mismatch");
     }
-    return {op};
+    
+    // Select the kernel matching the structure of the operator.
+    decltype(simd_api::apply) kernel = nullptr;
+    switch(operator_.kind())
+    {
+        case Operator::Identity:
+            return;
+        case Operator::DiagonalAffine:
+            kernel = simd_api::apply_diagonal_affine;
+            break;
+        case Operator::ZRotation:
+            kernel = simd_api::apply_z_rotation;
+            break;
+        case Operator::Affine:
+            kernel = simd_api::apply_affine;
+            break;
+        case Operator::General:
+            kernel = simd_api::apply;
+            break;
+    }
+    
+    // A single matrix is broadcast to all isochromats, other operators are
+    // read from their rows.
+    Real const * coefficients =
+        (operator_.size() == 1) ? data.data() : operator_.rows().data();
+    std::size_t const operator_stride = operator_.rows_stride();
+    
+    this->_for_each_chunk(
+        [&](std::size_t begin, std::size_t end) {
+            kernel(
+                coefficients, operator_stride, this->_magnetization.data(),
+                this->_stride, begin, end);
+        });
 }
 
 void
 Model
-::apply(Operator const & operator_)
+::apply_pulse(Quantity const & angle, Quantity const & phase)
+{
+    // A single matrix, broadcast to all isochromats.
+    this->apply(this->build_pulse(angle, phase));
+}
+
+void
+Model
+::apply_pulse(TensorQ<1> const & angle, TensorQ<1> const & phase)
 {
-    auto const & array = operator_.array();
-    for(std::size_t n=0; n<this->_magnetization.shape()[0]; ++n)
+    auto const size = this->_positions.shape()[0];
+    if(
+        (phase.size() != 0 && angle.size() != phase.size())
+        || (angle.size() != 1 && angle.size() != size))
     {
-        auto l = xt::view(array, n);
-        auto r = xt::view(this->_magnetization, n);
-        auto temp = xt::empty_like(r);
-        for(std::size_t i=0; i<4; ++i)
-        {
-            temp.unchecked(i) = 
-                l.unchecked(i,0)*r.unchecked(0)
-                + l.unchecked(i,1)*r.unchecked(1)
-                + l.unchecked(i, 2)*r.unchecked(2)
-                + l.unchecked(i,3)*r.unchecked(3);
-        }
-        r = temp;
+        throw std::runtime_error("Size mismatch");
+    }
+    
+    TensorR<1> const angle_rad = convert_to(angle, units::rad);
+    TensorR<1> const phase_rad =
+        phase.size() != 0 ? convert_to(phase, units::rad) : TensorR<1>{0.};
+    std::size_t const angle_stride = (angle.size() == 1) ? 0 : 1;
+    std::size_t const phase_stride = (phase_rad.size() == 1) ? 0 : 1;
+    
+    this->_for_each_chunk(
+        [&](std::size_t begin, std::size_t end) {
+            simd_api::pulse(
+                angle_rad.data(), angle_stride, phase_rad.data(),
+                phase_stride, this->_magnetization.data(), this->_stride,
+                begin, end);
+        });
+}
+
+void
+Model
+::apply_time_interval(
+    Quantity const & duration, Quantity const & delta_omega,
+    TensorQ<1> const & gradient)
+{
+    this->apply_time_interval(
+        duration, TensorQ<1>{delta_omega},
+        gradient.size() != 0 ? xt::atleast_2d(gradient) : TensorQ<2>{});
+}
+
+void
+Model
+::apply_time_interval(
+    Quantity const & duration, TensorQ<1> const & delta_omega,
+    TensorQ<2> const & gradient)
+{
+    auto const size = this->_positions.shape()[0];
+    if(
+        (delta_omega.size() != 1 && delta_omega.size() != size)
+        || (
+            gradient.size() != 0
+            && gradient.shape()[0] != 1 && gradient.shape()[0] != size))
+    {
+        throw std::runtime_error("Size mismatch");
+    }
+    
+    auto const duration_s = duration.convert_to(units::s);
+    TensorR<1> const delta_omega_Hz = convert_to(delta_omega, units::Hz);
+    TensorR<2> const gradient_T_per_m =
+        gradient.size() != 0
+        ? convert_to(gradient, units::T/units::m) : TensorR<2>{{0., 0., 0.}};
+    std::size_t const field_stride = (delta_omega_Hz.size() == 1) ? 0 : 1;
+    std::size_t const gradient_stride =
+        (gradient_T_per_m.shape()[0] == 1) ? 0 : 3;
+    
+    this->_for_each_chunk(
+        [&](std::size_t begin, std::size_t end) {
+            simd_api::time_interval(
+                duration_s, this->_T1.data(), this->_T2.data(),
+                this->_M0.data(), this->_delta_omega.data(),
+                delta_omega_Hz.data(), field_stride, gradient_T_per_m.data(),
+                gradient_stride, this->_positions.data(),
+                this->_magnetization.data(), this->_stride, begin, end);
+        });
+}
+
+void
+Model
+::apply_relaxation(Quantity const & duration)
+{
+    auto const duration_s = duration.convert_to(units::s);
+    this->_for_each_chunk(
+        [&](std::size_t begin, std::size_t end) {
+            simd_api::relaxation(
+                duration_s, this->_T1.data(), this->_T2.data(),
+                this->_M0.data(), this->_magnetization.data(), this->_stride,
+                begin, end);
+        });
+}
+
+void
+Model
+::apply_shaped_pulse(
+    HardPulseApproximation const & pulse, Quantity const & delta_omega,
+    TensorQ<1> const & gradient)
+{
+    if(gradient.size() != 0 && gradient.size() != 3)
+    {
+        throw std::runtime_error("Size mismatch");
+    }
+    
+    // Unit quaternion (w, q_x, q_y) of each hard pulse, as in the pulse
+    // kernel.
+    std::vector<Real> rotations;
+    rotations.reserve(3*pulse.pulses().size());
+    for(auto && hard_pulse: pulse.pulses())
+    {
+        auto const half_angle = 0.5*hard_pulse.angle().convert_to(units::rad);
+        auto const phase = hard_pulse.phase().convert_to(units::rad);
+        rotations.push_back(std::cos(half_angle));
+        rotations.push_back(std::sin(half_angle)*std::cos(phase));
+        rotations.push_back(std::sin(half_angle)*std::sin(phase));
+    }
+    
+    auto const duration_s = pulse.duration().convert_to(units::s);
+    Real const delta_omega_Hz = delta_omega.convert_to(units::Hz);
+    std::array<Real, 3> gradient_T_per_m{0., 0., 0.};
+    for(std::size_t i=0; i<gradient.size(); ++i)
+    {
+        gradient_T_per_m[i] = gradient(i).convert_to(units::T/units::m);
+    }
+    
+    this->_for_each_chunk(
+        [&](std::size_t begin, std::size_t end) {
+            simd_api::shaped_pulse(
+                rotations.data(), pulse.pulses().size(), duration_s,
+                this->_T1.data(), this->_T2.data(), this->_M0.data(),
+                this->_delta_omega.data(), &delta_omega_Hz, 0,
+                gradient_T_per_m.data(), 0, this->_positions.data(),
+                this->_magnetization.data(), this->_stride, begin, end);
+        });
+}
+
+unsigned int
+Model
+::threads() const
+{
+    return this->_pool ? this->_pool->size() : 1;
+}
+
+void
+Model
+::set_threads(unsigned int threads)
+{
+    if(threads == 1)
+    {
+        this->_pool.reset();
+    }
+    else
+    {
+        this->_pool = std::make_shared<ThreadPool>(threads);
     }
 }
 
@@ -257,9 +455,17 @@ TensorR<2>
 Model
 ::magnetization() const
 {
-    return xt::eval(
-        xt::view(this->_magnetization, xt::all(), xt::range(0, 3))
-        / xt::expand_dims(xt::view(this->_magnetization, xt::all(), 3UL), 1));
+    auto const size = this->_positions.shape()[0];
+    TensorR<2> result(TensorR<2>::shape_type{size, 3});
+    for(std::size_t n=0; n<size; ++n)
+    {
+        auto const w = this->_magnetization[3*this->_stride+n];
+        for(std::size_t i=0; i<3; ++i)
+        {
+            result.unchecked(n, i) = this->_magnetization[i*this->_stride+n]/w;
+        }
+    }
+    return result;
 }
 
 TensorQ<2>
@@ -269,6 +475,31 @@ Model
     return this->_positions*units::m;
 }
 
+void
+Model
+::_for_each_chunk(
+    std::function<void(std::size_t, std::size_t)> const & kernel)
+{
+    auto const size = this->_positions.shape()[0];
+    
+    // Chunks are a multiple of the widest batch, so that each one starts on an
+    // aligned boundary.
+    std::size_t const chunk = 16384;
+    if(!this->_pool || size <= chunk)
+    {
+        kernel(0, size);
+    }
+    else
+    {
+        this->_pool->parallel_for(
+            (size+chunk-1)/chunk,
+            [&](std::size_t index) {
+                kernel(index*chunk, std::min(size, (index+1)*chunk));
+            },
+            1);
+    }
+}
+
 }
 
 }
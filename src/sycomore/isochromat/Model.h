@@ -1,10 +1,17 @@
 #ifndef _8db2389d_b425_4fa0_8897_04a4ff117e15
 #define _8db2389d_b425_4fa0_8897_04a4ff117e15
 
+#include <cstddef>
+#include <functional>
+#include <memory>
+
 #include <xtensor/xtensor.hpp>
 
+#include "sycomore/Buffer.h"
+#include "sycomore/HardPulseApproximation.h"
 #include "sycomore/Quantity.h"
 #include "sycomore/sycomore.h"
+#include "sycomore/ThreadPool.h"
 #include "sycomore/units.h"
 #include "sycomore/isochromat/Operator.h"
 
@@ -57,9 +64,65 @@ public:
     /// @brief Create a spatially-varying phase accumulation operator
     Operator build_phase_accumulation(TensorQ<1> const & angle) const;
     
-    /// @brief Apply an operator to the magnetization
+    /**
+     * @brief Apply an operator to the magnetization. The operator must either
+     * contain one matrix per isochromat, or a single matrix which is applied
+     * to all isochromats.
+     */
     void apply(Operator const & operator_);
     
+    /// @brief Apply a spatially constant RF pulse
+    void apply_pulse(
+        Quantity const & angle, Quantity const & phase=0*units::rad);
+    
+    /**
+     * @brief Apply a spatially-varying RF pulse, computing the rotation of
+     * each isochromat on the fly.
+     */
+    void apply_pulse(
+        TensorQ<1> const & angle, TensorQ<1> const & phase=TensorQ<1>{});
+    
+    /**
+     * @brief Apply a spatially constant time interval, computing the
+     * transform of each isochromat on the fly.
+     */
+    void apply_time_interval(
+        Quantity const & duration, Quantity const & delta_omega=0*units::Hz,
+        TensorQ<1> const & gradient={});
+    
+    /**
+     * @brief Apply a spatially-varying time interval, computing the transform
+     * of each isochromat on the fly.
+     */
+    void apply_time_interval(
+        Quantity const & duration, TensorQ<1> const & delta_omega,
+        TensorQ<2> const & gradient={});
+    
+    /**
+     * @brief Apply the relaxation, computing the transform of each isochromat
+     * on the fly.
+     */
+    void apply_relaxation(Quantity const & duration);
+    
+    /**
+     * @brief Apply a shaped pulse: each of its hard pulses is followed by a
+     * spatially constant time interval of the hard pulse duration. The
+     * magnetization of each isochromat is read and written once.
+     */
+    void apply_shaped_pulse(
+        HardPulseApproximation const & pulse,
+        Quantity const & delta_omega=0*units::Hz,
+        TensorQ<1> const & gradient={});
+    
+    /// @brief Return the number of threads used to apply the operators
+    unsigned int threads() const;
+    
+    /**
+     * @brief Set the number of threads used to apply the operators. If 0, use
+     * the number of hardware threads. Copies of the model share its threads.
+     */
+    void set_threads(unsigned int threads);
+    
     /// @brief Return the T1 field
     TensorQ<1> T1() const;
     
@@ -77,15 +140,32 @@ public:
     
     /// @brief Return the positions of the isochromats
     TensorQ<2> positions() const;
-    
+
 private:
     TensorR<1> _T1;
     TensorR<1> _T2;
     TensorR<1> _M0;
     TensorR<1> _delta_omega;
     
-    TensorR<2> _magnetization;
+    /// @brief Number of isochromats, padded to a multiple of the widest batch
+    std::size_t _stride;
+    
+    /**
+     * @brief Magnetization of all isochromats, as four rows of stride
+     * elements (x, y, z, and the homogeneous coordinate)
+     */
+    Buffer<Real> _magnetization;
     TensorR<2> _positions;
+    
+    /// @brief Pool used to apply the operators, null if single-threaded
+    std::shared_ptr<ThreadPool> _pool;
+    
+    /**
+     * @brief Call kernel on consecutive ranges of isochromats, in parallel if
+     * the model is multi-threaded. Each range starts on an aligned boundary.
+     */
+    void _for_each_chunk(
+        std::function<void(std::size_t, std::size_t)> const & kernel);
 };
 
 }
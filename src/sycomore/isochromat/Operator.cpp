@@ -1,12 +1,16 @@
 #include "Operator.h"
 
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
+#include <utility>
+
 #include <xtensor/xbuilder.hpp>
 #include <xtensor/xtensor.hpp>
-#include <xtensor/xfixed.hpp>
 #include <xtensor/xview.hpp>
 
-#include "sycomore/Array.h"
 #include "sycomore/sycomore.h"
 
 namespace sycomore
@@ -17,133 +21,373 @@ namespace isochromat
 
 Operator
 ::Operator()
-: _array(xt::eye<Real>({1,4,4}))
+: _array(Array::shape_type{1, 0, 0}), _kind(Identity)
 {
-    // Nothing else.
+    this->_reset_rows();
 }
 
 Operator
 ::Operator(Array const & data)
-: _array(data)
+: _array(data), _kind(General)
 {
-    if(this->_array.shape()[1] != 4 || this->_array.shape()[2] != 4)
+    if(this->_array.shape()[1] == 3 && this->_array.shape()[2] == 4)
+    {
+        this->_kind = Affine;
+    }
+    else if(this->_array.shape()[1] == 4 && this->_array.shape()[2] == 4)
+    {
+        // Store in compact form if all matrices are affine
+        bool affine = true;
+        for(std::size_t item=0; item<data.shape()[0] && affine; ++item)
+        {
+            affine =
+                data.unchecked(item, 3, 0) == 0
+                && data.unchecked(item, 3, 1) == 0
+                && data.unchecked(item, 3, 2) == 0
+                && data.unchecked(item, 3, 3) == 1;
+        }
+        if(affine)
+        {
+            this->_array =
+                xt::view(data, xt::all(), xt::range(0, 3), xt::all());
+            this->_kind = Affine;
+        }
+    }
+    else
     {
         throw std::runtime_error("Invalid shape");
     }
+    
+    this->_reset_rows();
 }
 
-#define MULT_4_4(l, r, dest) \
-    for(std::size_t i=0; i<4; ++i) \
-    { \
-        for(std::size_t j=0; j<4; ++j) \
-        { \
-            dest.unchecked(i,j) =  \
-                l.unchecked(i,0)*r.unchecked(0,j) \
-                + l.unchecked(i,1)*r.unchecked(1,j) \
-                + l.unchecked(i, 2)*r.unchecked(2,j) \
-                + l.unchecked(i,3)*r.unchecked(3,j); \
-        } \
+Operator
+::Operator(Kind kind, Array const & data)
+: _array(data), _kind(kind)
+{
+    if(data.shape() != Operator::_shape(kind, data.shape()[0]))
+    {
+        throw std::runtime_error("Invalid shape");
+    }
+    if(kind == Identity && data.shape()[0] != 1)
+    {
+        throw std::runtime_error("Identity must have a single matrix");
     }
+    
+    this->_reset_rows();
+}
 
 Operator &
 Operator
 ::operator*=(Operator const & right)
 {
-    static thread_local Matrix4x4<Real> matrix;
+    Operator::_product(*this, right, *this);
+    return *this;
+}
+
+Operator &
+Operator
+::pre_multiply(Operator const & left)
+{
+    Operator::_product(left, *this, *this);
+    return *this;
+}
+
+Operator::Array
+Operator
+::array() const
+{
+    if(this->_kind == General)
+    {
+        return this->_array;
+    }
     
-    if(this->_array.shape()[0] == 1 && right._array.shape()[0] != 1)
+    Array result = xt::zeros<Real>(Array::shape_type{this->size(), 4, 4});
+    xt::view(result, xt::all(), xt::range(0, 3), xt::all()) =
+        this->_promote(Affine);
+    xt::view(result, xt::all(), 3UL, 3UL) = 1;
+    return result;
+}
+
+Operator::Array const &
+Operator
+::data() const
+{
+    return this->_array;
+}
+
+Operator::Kind
+Operator
+::kind() const
+{
+    return this->_kind;
+}
+
+bool
+Operator
+::is_affine() const
+{
+    return this->_kind != General;
+}
+
+std::size_t
+Operator
+::size() const
+{
+    return this->_array.shape()[0];
+}
+
+Buffer<Real> const &
+Operator
+::rows() const
+{
+    auto & rows = *this->_rows;
+    std::call_once(
+        rows.computed,
+        [&]() {
+            auto const size = this->size();
+            if(size == 1)
+            {
+                return;
+            }
+            
+            auto const stride = this->rows_stride();
+            auto const matrix_size =
+                this->_array.shape()[1]*this->_array.shape()[2];
+            rows.data.resize(matrix_size*stride);
+            
+            // Transpose by blocks of matrices, so that the written rows stay
+            // in cache.
+            std::size_t const block = 64;
+            for(std::size_t begin=0; begin<size; begin+=block)
+            {
+                auto const end = std::min(size, begin+block);
+                for(std::size_t k=0; k<matrix_size; ++k)
+                {
+                    Real const * source = this->_array.data()+k;
+                    Real * destination = rows.data.data()+k*stride;
+                    for(std::size_t item=begin; item<end; ++item)
+                    {
+                        destination[item] = source[item*matrix_size];
+                    }
+                }
+            }
+        });
+    return rows.data;
+}
+
+std::size_t
+Operator
+::rows_stride() const
+{
+    // Pad the rows to a multiple of the widest SIMD batch (8 doubles), as the
+    // magnetization of the model, so that all rows are aligned.
+    auto const size = this->size();
+    return (size == 1) ? 0 : 8*((size+7)/8);
+}
+
+void
+Operator
+::_reset_rows()
+{
+    this->_rows = std::make_shared<Rows>();
+}
+
+Operator::Array::shape_type
+Operator
+::_shape(Kind kind, std::size_t size)
+{
+    switch(kind)
     {
-        auto temp = xt::empty_like(right._array);
-        auto l = xt::view(this->_array, 0UL);
-        for(std::size_t item=0, end=right._array.shape()[0]; item<end; ++item)
-        {
-            auto destination = xt::view(temp, item);
-            auto r = xt::view(right._array, item);
-            MULT_4_4(l, r, destination)
-        }
-        this->_array = std::move(temp);
+        case Identity: return {size, 0, 0};
+        case DiagonalAffine: return {size, 2, 3};
+        case ZRotation: return {size, 1, 2};
+        case Affine: return {size, 3, 4};
+        case General: return {size, 4, 4};
     }
-    else if(this->_array.shape()[0] != 1 && right._array.shape()[0] == 1)
+    throw std::runtime_error("Invalid kind");
+}
+
+Operator::Array
+Operator
+::_promote(Kind kind) const
+{
+    if(kind == this->_kind)
     {
-        auto r = xt::view(right._array, 0UL);
-        for(std::size_t item=0, end=this->_array.shape()[0]; item<end; ++item)
-        {
-            auto l = xt::view(this->_array, item);
-            MULT_4_4(l, r, matrix)
-            l = matrix;
-        }
+        return this->_array;
     }
-    else if(this->_array.shape()[0] == right._array.shape()[0])
+    if(kind == General)
     {
-        for(std::size_t item=0, end=right._array.shape()[0]; item<end; ++item)
-        {
-            auto l = xt::view(this->_array, item);
-            auto r = xt::view(right._array, item);
-            MULT_4_4(l, r, matrix)
-            l = matrix;
-        }
+        return this->array();
     }
-    else
+    if(kind != Affine)
     {
-        throw std::runtime_error("Size mismatch");
+        throw std::runtime_error("Invalid promotion");
     }
     
-    return *this;
+    Array result = xt::zeros<Real>(Operator::_shape(Affine, this->size()));
+    for(std::size_t item=0; item<this->size(); ++item)
+    {
+        Real * d = result.data()+12*item;
+        if(this->_kind == Identity)
+        {
+            d[0] = d[5] = d[10] = 1;
+        }
+        else if(this->_kind == DiagonalAffine)
+        {
+            Real const * s = this->_array.data()+6*item;
+            d[0] = s[0]; d[5] = s[1]; d[10] = s[2];
+            d[3] = s[3]; d[7] = s[4]; d[11] = s[5];
+        }
+        else if(this->_kind == ZRotation)
+        {
+            Real const * s = this->_array.data()+2*item;
+            d[0] = s[0]; d[1] = -s[1];
+            d[4] = s[1]; d[5] = s[0];
+            d[10] = 1;
+        }
+    }
+    return result;
 }
 
-Operator &
+void
 Operator
-::pre_multiply(Operator const & left)
+::_product(
+    Operator const & left, Operator const & right, Operator & destination)
 {
-    static thread_local Matrix4x4<Real> matrix;
+    auto const left_size = left.size(), right_size = right.size();
+    if(left_size != 1 && right_size != 1 && left_size != right_size)
+    {
+        throw std::runtime_error("Size mismatch");
+    }
     
-    if(left._array.shape()[0] == 1 && this->_array.shape()[0] != 1)
+    // The identity is neutral: the product is a copy of the other operand.
+    if(left._kind == Identity)
     {
-        auto l = xt::view(left._array, 0UL);
-        for(std::size_t item=0, end=this->_array.shape()[0]; item<end; ++item)
+        if(&destination != &right)
         {
-            auto r = xt::view(this->_array, item);
-            MULT_4_4(l, r, matrix)
-            r = matrix;
+            destination = right;
         }
+        return;
     }
-    else if(left._array.shape()[0] != 1 && this->_array.shape()[0] == 1)
+    if(right._kind == Identity)
     {
-        auto temp = xt::empty_like(left._array);
-        auto r = xt::view(this->_array, 0UL);
-        for(std::size_t item=0, end=left._array.shape()[0]; item<end; ++item)
+        if(&destination != &left)
         {
-            auto destination = xt::view(temp, item);
-            auto l = xt::view(left._array, item);
-            MULT_4_4(l, r, destination)
+            destination = left;
         }
-        std::swap(this->_array, temp);
+        return;
     }
-    else if(left._array.shape()[0] == this->_array.shape()[0])
+    
+    // Operands of different kinds are promoted to the least specific one, or
+    // to Affine for a diagonal and a rotation.
+    Kind kind = std::max(left._kind, right._kind);
+    if(left._kind != right._kind && kind < Affine)
     {
-        for(std::size_t item=0, end=left._array.shape()[0]; item<end; ++item)
-        {
-            auto l = xt::view(left._array, item);
-            auto r = xt::view(this->_array, item);
-            MULT_4_4(l, r, matrix)
-            r = matrix;
-        }
+        kind = Affine;
     }
-    else
+    Array left_promoted, right_promoted;
+    if(left._kind != kind)
     {
-        throw std::runtime_error("Size mismatch");
+        left_promoted = left._promote(kind);
+    }
+    if(right._kind != kind)
+    {
+        right_promoted = right._promote(kind);
     }
+    Real const * l =
+        (left._kind != kind) ? left_promoted.data() : left._array.data();
+    Real const * r =
+        (right._kind != kind) ? right_promoted.data() : right._array.data();
     
-    return *this;
+    std::size_t const size = std::max(left_size, right_size);
+    auto const shape = Operator::_shape(kind, size);
+    std::size_t const matrix_size = shape[1]*shape[2];
+    std::size_t const left_stride = (left_size == 1) ? 0 : matrix_size;
+    std::size_t const right_stride = (right_size == 1) ? 0 : matrix_size;
+    
+    // Compute in place if the destination already has the correct shape,
+    // since each matrix only depends on the matrices of the same index.
+    bool const in_place =
+        destination._kind == kind && destination._array.shape() == shape;
+    Array result;
+    if(!in_place)
+    {
+        result = Array(shape);
+    }
+    Real * d = in_place ? destination._array.data() : result.data();
+    
+    for(std::size_t item=0; item<size; ++item)
+    {
+        Operator::_multiply(
+            l+item*left_stride, r+item*right_stride, d+item*matrix_size,
+            kind);
+    }
+    
+    if(!in_place)
+    {
+        destination._array = std::move(result);
+        destination._kind = kind;
+    }
+    destination._reset_rows();
 }
 
-#undef MULT_4_4
-
-Operator::Array const &
+void
 Operator
-::array() const
+::_multiply(
+    Real const * left, Real const * right, Real * destination, Kind kind)
 {
-    return this->_array;
+    Real result[16];
+    std::size_t size = 0;
+    if(kind == DiagonalAffine)
+    {
+        // L(Rx + t_R) + t_L = LRx + (L t_R + t_L)
+        for(std::size_t i=0; i<3; ++i)
+        {
+            result[i] = left[i]*right[i];
+            result[3+i] = left[i]*right[3+i] + left[3+i];
+        }
+        size = 6;
+    }
+    else if(kind == ZRotation)
+    {
+        // Sum of angles
+        result[0] = left[0]*right[0] - left[1]*right[1];
+        result[1] = left[1]*right[0] + left[0]*right[1];
+        size = 2;
+    }
+    else if(kind == Affine)
+    {
+        // The last row of both matrices is (0, 0, 0, 1): 36 multiplications
+        // instead of 64.
+        for(std::size_t i=0; i<3; ++i)
+        {
+            auto const l = left+4*i;
+            for(std::size_t j=0; j<3; ++j)
+            {
+                result[4*i+j] =
+                    l[0]*right[j] + l[1]*right[4+j] + l[2]*right[8+j];
+            }
+            result[4*i+3] =
+                l[0]*right[3] + l[1]*right[7] + l[2]*right[11] + l[3];
+        }
+        size = 12;
+    }
+    else if(kind == General)
+    {
+        for(std::size_t i=0; i<4; ++i)
+        {
+            auto const l = left+4*i;
+            for(std::size_t j=0; j<4; ++j)
+            {
+                result[4*i+j] =
+                    l[0]*right[j] + l[1]*right[4+j] + l[2]*right[8+j]
+                    + l[3]*right[12+j];
+            }
+        }
+        size = 16;
+    }
+    std::copy(result, result+size, destination);
 }
 
 Operator operator*(Operator left, Operator const & right)
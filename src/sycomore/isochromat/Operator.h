@@ -1,8 +1,13 @@
 #ifndef _e0796018_5e39_4c59_988a_1e882e463fd4
 #define _e0796018_5e39_4c59_988a_1e882e463fd4
 
+#include <cstddef>
+#include <memory>
+#include <mutex>
+
 #include <xtensor/xtensor.hpp>
 
+#include "sycomore/Buffer.h"
 #include "sycomore/sycomore.h"
 
 namespace sycomore
@@ -11,19 +16,45 @@ namespace sycomore
 namespace isochromat
 {
 
-/// @brief Isochromat simulation operator, i.e. an array of 4×4 matrices
+/**
+ * @brief Isochromat simulation operator, i.e. an array of 4×4 matrices
+ *
+ * Operators are tagged with their structure, which determines how they are
+ * stored, chained, and applied:
+ * - Identity: no data, shape 1×0×0
+ * - DiagonalAffine: diagonal of the linear part and translation, shape n×2×3
+ * - ZRotation: cosine and sine of a rotation around the z axis, shape n×1×2
+ * - Affine: linear part and translation, shape n×3×4
+ * - General: full 4×4 matrices, shape n×4×4
+ * Chaining two operators of the same structured kind keeps that kind;
+ * otherwise, the operands are promoted to Affine or General.
+ *
+ * Operators with more than one matrix are applied from their stored
+ * representation transposed to one row per coefficient, so that the SIMD
+ * loads are contiguous. The transposition is computed on first use and
+ * shared by the copies of the operator.
+ */
 class Operator
 {
 public:
     /// @brief Array representation of the operator
     using Array = TensorR<3>;
     
+    /// @brief Structure of the operator, from the most to the least specific
+    enum Kind { Identity, DiagonalAffine, ZRotation, Affine, General };
+    
     /// @brief Build an identity operator.
     Operator();
     
-    /// @brief Build an operator from given array.
+    /**
+     * @brief Build an operator from given array, of shape n×4×4, or n×3×4 for
+     * an affine operator.
+     */
     Operator(Array const & data);
     
+    /// @brief Build an operator of given kind from its stored representation.
+    Operator(Kind kind, Array const & data);
+    
     /// @brief Default copy constructor.
     Operator(Operator const &) = default;
     
@@ -42,23 +73,83 @@ public:
     /**
      * @brief In-place chaining of operators, with right applied first.
      *
-     * If *this and/or right has shape 1×4×4, it is broadcast to match the other
-     * operand. Otherwise, both operand must have shape n×4×4.
+     * If *this and/or right has a single matrix, it is broadcast to match the
+     * other operand. Otherwise, both operand must have n matrices.
      */
     Operator & operator*=(Operator const & right);
     
     /**
      * @brief In-place chaining of operators, with self applied first.
      *
-     * If *this and/or left has shape 1×4×4, it is broadcast to match the other
-     * operand. Otherwise, both operand must have shape n×4×4.
+     * If *this and/or left has a single matrix, it is broadcast to match the
+     * other operand. Otherwise, both operand must have n matrices.
      */
     Operator & pre_multiply(Operator const & left);
     
-    /// @brief Numeric representation of the operator.
-    Array const & array() const;
+    /// @brief Numeric representation of the operator, as n×4×4 matrices.
+    Array array() const;
+    
+    /// @brief Stored representation of the operator, depending on its kind.
+    Array const & data() const;
+    
+    /// @brief Return the structure of the operator.
+    Kind kind() const;
+    
+    /// @brief Test whether the last row of all matrices is (0, 0, 0, 1).
+    bool is_affine() const;
+    
+    /// @brief Return the number of matrices of the operator.
+    std::size_t size() const;
+    
+    /**
+     * @brief Stored representation, with one row per coefficient: coefficient
+     * k of matrix n is at k*rows_stride()+n. Empty if the operator has a
+     * single matrix.
+     *
+     * The rows are computed on the first call after a modification of the
+     * operator; this function may be called concurrently.
+     */
+    Buffer<Real> const & rows() const;
+    
+    /**
+     * @brief Distance between two rows, a multiple of the widest SIMD batch,
+     * or 0 if the operator has a single matrix.
+     */
+    std::size_t rows_stride() const;
 private:
     Array _array;
+    Kind _kind;
+    
+    /// @brief Transposed representation, computed once.
+    struct Rows
+    {
+        std::once_flag computed;
+        Buffer<Real> data;
+    };
+    std::shared_ptr<Rows> _rows;
+    
+    /// @brief Discard the rows after a modification of the operator.
+    void _reset_rows();
+    
+    /// @brief Return the shape of the stored representation.
+    static Array::shape_type _shape(Kind kind, std::size_t size);
+    
+    /// @brief Return the data, promoted to a less specific kind.
+    Array _promote(Kind kind) const;
+    
+    /**
+     * @brief Compute left×right in destination, which may be one of the
+     * operands, broadcasting operands with a single matrix.
+     */
+    static void _product(
+        Operator const & left, Operator const & right, Operator & destination);
+    
+    /**
+     * @brief Product of two matrices of the same kind. Destination may be one
+     * of the operands.
+     */
+    static void _multiply(
+        Real const * left, Real const * right, Real * destination, Kind kind);
 };
 
 /// @brief Operator chaining, representing right followed by left.
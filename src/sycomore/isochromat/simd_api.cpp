@@ -0,0 +1,155 @@
+#include "simd_api.h"
+
+#include <cstddef>
+
+#include "sycomore/simd.h"
+#include "sycomore/sycomore.h"
+
+namespace sycomore
+{
+
+namespace isochromat
+{
+
+namespace simd_api
+{
+
+template<>
+void
+apply_d<unsupported>(
+    Real const * operator_, std::size_t operator_stride,
+    Real * magnetization, std::size_t stride,
+    std::size_t begin, std::size_t end)
+{
+    apply_w<Real>(
+        operator_, operator_stride, magnetization, stride, begin, end, 1);
+}
+
+template<>
+void
+apply_affine_d<unsupported>(
+    Real const * operator_, std::size_t operator_stride,
+    Real * magnetization, std::size_t stride,
+    std::size_t begin, std::size_t end)
+{
+    apply_affine_w<Real>(
+        operator_, operator_stride, magnetization, stride, begin, end, 1);
+}
+
+template<>
+void
+apply_diagonal_affine_d<unsupported>(
+    Real const * operator_, std::size_t operator_stride,
+    Real * magnetization, std::size_t stride,
+    std::size_t begin, std::size_t end)
+{
+    apply_diagonal_affine_w<Real>(
+        operator_, operator_stride, magnetization, stride, begin, end, 1);
+}
+
+template<>
+void
+apply_z_rotation_d<unsupported>(
+    Real const * operator_, std::size_t operator_stride,
+    Real * magnetization, std::size_t stride,
+    std::size_t begin, std::size_t end)
+{
+    apply_z_rotation_w<Real>(
+        operator_, operator_stride, magnetization, stride, begin, end, 1);
+}
+
+template<>
+void
+pulse_d<unsupported>(
+    Real const * angle, std::size_t angle_stride,
+    Real const * phase, std::size_t phase_stride,
+    Real * magnetization, std::size_t stride,
+    std::size_t begin, std::size_t end)
+{
+    pulse_w<Real>(
+        angle, angle_stride, phase, phase_stride, magnetization, stride,
+        begin, end, 1);
+}
+
+template<>
+void
+relaxation_d<unsupported>(
+    Real duration, Real const * T1, Real const * T2, Real const * M0,
+    Real * magnetization, std::size_t stride,
+    std::size_t begin, std::size_t end)
+{
+    relaxation_w<Real>(
+        duration, T1, T2, M0, magnetization, stride, begin, end, 1);
+}
+
+template<>
+void
+time_interval_d<unsupported>(
+    Real duration, Real const * T1, Real const * T2, Real const * M0,
+    Real const * delta_omega, Real const * field_delta_omega,
+    std::size_t field_stride, Real const * gradient,
+    std::size_t gradient_stride, Real const * positions,
+    Real * magnetization, std::size_t stride,
+    std::size_t begin, std::size_t end)
+{
+    time_interval_w<Real>(
+        duration, T1, T2, M0, delta_omega, field_delta_omega, field_stride,
+        gradient, gradient_stride, positions, magnetization, stride,
+        begin, end, 1);
+}
+
+template<>
+void
+shaped_pulse_d<unsupported>(
+    Real const * rotations, std::size_t count, Real duration,
+    Real const * T1, Real const * T2, Real const * M0,
+    Real const * delta_omega, Real const * field_delta_omega,
+    std::size_t field_stride, Real const * gradient,
+    std::size_t gradient_stride, Real const * positions,
+    Real * magnetization, std::size_t stride,
+    std::size_t begin, std::size_t end)
+{
+    shaped_pulse_w<Real>(
+        rotations, count, duration, T1, T2, M0, delta_omega,
+        field_delta_omega, field_stride, gradient, gradient_stride, positions,
+        magnetization, stride, begin, end, 1);
+}
+
+/*******************************************************************************
+ *                          Function table and set-up                          *
+ ******************************************************************************/
+
+decltype(&apply_d<unsupported>) apply = nullptr;
+decltype(&apply_affine_d<unsupported>) apply_affine = nullptr;
+decltype(&apply_diagonal_affine_d<unsupported>) apply_diagonal_affine = nullptr;
+decltype(&apply_z_rotation_d<unsupported>) apply_z_rotation = nullptr;
+decltype(&pulse_d<unsupported>) pulse = nullptr;
+decltype(&relaxation_d<unsupported>) relaxation = nullptr;
+decltype(&time_interval_d<unsupported>) time_interval = nullptr;
+decltype(&shaped_pulse_d<unsupported>) shaped_pulse = nullptr;
+
+void set_api(unsigned instruction_set)
+{
+    SYCOMORE_SET_API_FUNCTION(apply)
+    SYCOMORE_SET_API_FUNCTION(apply_affine)
+    SYCOMORE_SET_API_FUNCTION(apply_diagonal_affine)
+    SYCOMORE_SET_API_FUNCTION(apply_z_rotation)
+    SYCOMORE_SET_API_FUNCTION(pulse)
+    SYCOMORE_SET_API_FUNCTION(relaxation)
+    SYCOMORE_SET_API_FUNCTION(time_interval)
+    SYCOMORE_SET_API_FUNCTION(shaped_pulse)
+}
+
+bool set_default_api()
+{
+    set_api(simd::instruction_set());
+    return true;
+}
+
+bool const api_is_set=set_default_api();
+
+}
+
+}
+
+}
@@ -0,0 +1,219 @@
+#ifndef _1a502e7c_67fe_4580_b6f1_48162dc20bd2
+#define _1a502e7c_67fe_4580_b6f1_48162dc20bd2
+
+#include <cstddef>
+
+#include "sycomore/simd.h"
+#include "sycomore/sycomore.h"
+
+namespace sycomore
+{
+
+namespace isochromat
+{
+
+namespace simd_api
+{
+
+// Functions with a _w suffix are worker functions, functions with a _d suffix
+// are dispatcher functions.
+
+// The magnetization is stored as four rows of stride elements (x, y, z, and
+// the homogeneous coordinate): the magnetization of isochromat n is located at
+// n, stride+n, 2*stride+n, and 3*stride+n. The operator has the same layout,
+// with one row per coefficient of the row-major 4×4 matrices: coefficient k
+// of the matrix of isochromat n is located at k*operator_stride+n, and
+// operator_stride must be a multiple of the widest SIMD batch. An operator
+// stride of 0 broadcasts a single matrix, stored contiguously, to all
+// isochromats. Affine operators are stored as 3×4 matrices, their last row
+// being (0, 0, 0, 1). Diagonal affine operators are stored as the diagonal of
+// their linear part followed by their translation (6 coefficients), and
+// rotations around the z axis as their cosine and sine (2 coefficients).
+
+/// @brief Load coefficient k of the operator for the isochromats at n.
+template<typename RealType>
+void load_coefficient(
+    Real const * operator_, std::size_t operator_stride, std::size_t k,
+    std::size_t n, RealType & destination);
+
+template<typename RealType>
+void apply_w(
+    Real const * operator_, std::size_t operator_stride,
+    Real * magnetization, std::size_t stride,
+    std::size_t begin, std::size_t end, std::size_t step);
+
+/**
+ * @brief Apply the operator to the isochromats in [begin, end). begin must be
+ * a multiple of the widest SIMD batch, so that all loads are aligned.
+ */
+SYCOMORE_DEFINE_SIMD_DISPATCHER_FUNCTION(
+    void, apply_d,
+    (
+        Real const * operator_, std::size_t operator_stride,
+        Real * magnetization, std::size_t stride,
+        std::size_t begin, std::size_t end))
+
+template<typename RealType>
+void apply_affine_w(
+    Real const * operator_, std::size_t operator_stride,
+    Real * magnetization, std::size_t stride,
+    std::size_t begin, std::size_t end, std::size_t step);
+
+/// @brief Apply an affine operator, see apply_d.
+SYCOMORE_DEFINE_SIMD_DISPATCHER_FUNCTION(
+    void, apply_affine_d,
+    (
+        Real const * operator_, std::size_t operator_stride,
+        Real * magnetization, std::size_t stride,
+        std::size_t begin, std::size_t end))
+
+template<typename RealType>
+void apply_diagonal_affine_w(
+    Real const * operator_, std::size_t operator_stride,
+    Real * magnetization, std::size_t stride,
+    std::size_t begin, std::size_t end, std::size_t step);
+
+/// @brief Apply a diagonal affine operator, see apply_d.
+SYCOMORE_DEFINE_SIMD_DISPATCHER_FUNCTION(
+    void, apply_diagonal_affine_d,
+    (
+        Real const * operator_, std::size_t operator_stride,
+        Real * magnetization, std::size_t stride,
+        std::size_t begin, std::size_t end))
+
+template<typename RealType>
+void apply_z_rotation_w(
+    Real const * operator_, std::size_t operator_stride,
+    Real * magnetization, std::size_t stride,
+    std::size_t begin, std::size_t end, std::size_t step);
+
+/// @brief Apply a rotation around the z axis, see apply_d.
+SYCOMORE_DEFINE_SIMD_DISPATCHER_FUNCTION(
+    void, apply_z_rotation_d,
+    (
+        Real const * operator_, std::size_t operator_stride,
+        Real * magnetization, std::size_t stride,
+        std::size_t begin, std::size_t end))
+
+// The following kernels compute the transform of each isochromat from the
+// parameters of the model instead of reading it from an operator. Per-
+// isochromat parameters (T1, T2, M0, off-resonance) are arrays of reals, the
+// positions are n×3 row-major arrays. Parameters which may be either
+// spatially constant or spatially varying have a stride, 0 meaning constant.
+
+template<typename RealType>
+void pulse_w(
+    Real const * angle, std::size_t angle_stride,
+    Real const * phase, std::size_t phase_stride,
+    Real * magnetization, std::size_t stride,
+    std::size_t begin, std::size_t end, std::size_t step);
+
+/**
+ * @brief Apply an RF pulse of given angle and phase (in rad) to the
+ * isochromats in [begin, end).
+ */
+SYCOMORE_DEFINE_SIMD_DISPATCHER_FUNCTION(
+    void, pulse_d,
+    (
+        Real const * angle, std::size_t angle_stride,
+        Real const * phase, std::size_t phase_stride,
+        Real * magnetization, std::size_t stride,
+        std::size_t begin, std::size_t end))
+
+template<typename RealType>
+void relaxation_w(
+    Real duration, Real const * T1, Real const * T2, Real const * M0,
+    Real * magnetization, std::size_t stride,
+    std::size_t begin, std::size_t end, std::size_t step);
+
+/**
+ * @brief Apply the relaxation during given duration (in s) to the isochromats
+ * in [begin, end).
+ */
+SYCOMORE_DEFINE_SIMD_DISPATCHER_FUNCTION(
+    void, relaxation_d,
+    (
+        Real duration, Real const * T1, Real const * T2, Real const * M0,
+        Real * magnetization, std::size_t stride,
+        std::size_t begin, std::size_t end))
+
+template<typename RealType>
+void time_interval_w(
+    Real duration, Real const * T1, Real const * T2, Real const * M0,
+    Real const * delta_omega, Real const * field_delta_omega,
+    std::size_t field_stride, Real const * gradient,
+    std::size_t gradient_stride, Real const * positions,
+    Real * magnetization, std::size_t stride,
+    std::size_t begin, std::size_t end, std::size_t step);
+
+/**
+ * @brief Apply a time interval of given duration (in s) to the isochromats in
+ * [begin, end): relaxation, then dephasing due to the off-resonance of the
+ * species and of the field (in Hz), and to the gradient (in T/m).
+ */
+SYCOMORE_DEFINE_SIMD_DISPATCHER_FUNCTION(
+    void, time_interval_d,
+    (
+        Real duration, Real const * T1, Real const * T2, Real const * M0,
+        Real const * delta_omega, Real const * field_delta_omega,
+        std::size_t field_stride, Real const * gradient,
+        std::size_t gradient_stride, Real const * positions,
+        Real * magnetization, std::size_t stride,
+        std::size_t begin, std::size_t end))
+
+template<typename RealType>
+void shaped_pulse_w(
+    Real const * rotations, std::size_t count, Real duration,
+    Real const * T1, Real const * T2, Real const * M0,
+    Real const * delta_omega, Real const * field_delta_omega,
+    std::size_t field_stride, Real const * gradient,
+    std::size_t gradient_stride, Real const * positions,
+    Real * magnetization, std::size_t stride,
+    std::size_t begin, std::size_t end, std::size_t step);
+
+/**
+ * @brief Apply a shaped pulse to the isochromats in [begin, end): each of
+ * the count rotations, given as unit quaternions (w, q_x, q_y) around an axis
+ * of the transverse plane, is followed by a time interval of given duration
+ * (in s), with the same parameters as time_interval_d. The magnetization is
+ * read and written once for the whole pulse.
+ */
+SYCOMORE_DEFINE_SIMD_DISPATCHER_FUNCTION(
+    void, shaped_pulse_d,
+    (
+        Real const * rotations, std::size_t count, Real duration,
+        Real const * T1, Real const * T2, Real const * M0,
+        Real const * delta_omega, Real const * field_delta_omega,
+        std::size_t field_stride, Real const * gradient,
+        std::size_t gradient_stride, Real const * positions,
+        Real * magnetization, std::size_t stride,
+        std::size_t begin, std::size_t end))
+
+/*******************************************************************************
+ *                          Function table and set-up                          *
+ ******************************************************************************/
+
+extern decltype(&apply_d<unsupported>) apply;
+extern decltype(&apply_affine_d<unsupported>) apply_affine;
+extern decltype(&apply_diagonal_affine_d<unsupported>) apply_diagonal_affine;
+extern decltype(&apply_z_rotation_d<unsupported>) apply_z_rotation;
+extern decltype(&pulse_d<unsupported>) pulse;
+extern decltype(&relaxation_d<unsupported>) relaxation;
+extern decltype(&time_interval_d<unsupported>) time_interval;
+extern decltype(&shaped_pulse_d<unsupported>) shaped_pulse;
+
+void set_api(unsigned instruction_set);
+
+bool set_default_api();
+
+extern bool const api_is_set;
+
+}
+
+}
+
+}
+
+#include "simd_api.txx"
+
+#endif // _1a502e7c_67fe_4580_b6f1_48162dc20bd2
@@ -0,0 +1,538 @@
+#ifndef _7d0c0243_5bb8_45b2_ad3f_d0073ed0d985
+#define _7d0c0243_5bb8_45b2_ad3f_d0073ed0d985
+
+#include "simd_api.h"
+
+#include <cmath>
+#include <cstddef>
+
+#include "sycomore/simd.h"
+#include "sycomore/sycomore.h"
+
+namespace sycomore
+{
+
+namespace isochromat
+{
+
+namespace simd_api
+{
+
+template<typename RealType>
+void load_coefficient(
+    Real const * operator_, std::size_t operator_stride, std::size_t k,
+    std::size_t n, RealType & destination)
+{
+    if(operator_stride == 0)
+    {
+        destination = RealType(operator_[k]);
+    }
+    else
+    {
+        sycomore::simd::load_aligned(
+            operator_+k*operator_stride+n, destination);
+    }
+}
+
+template<typename RealType>
+void apply_w(
+    Real const * operator_, std::size_t operator_stride,
+    Real * magnetization, std::size_t stride,
+    std::size_t begin, std::size_t end, std::size_t step)
+{
+    for(std::size_t n=begin; n<end; n+=step)
+    {
+        RealType M[4];
+        for(std::size_t j=0; j<4; ++j)
+        {
+            sycomore::simd::load_aligned(magnetization+j*stride+n, M[j]);
+        }
+        
+        // All components are loaded before the first store: rows can be
+        // updated in place.
+        for(std::size_t i=0; i<4; ++i)
+        {
+            RealType L[4];
+            for(std::size_t j=0; j<4; ++j)
+            {
+                load_coefficient(operator_, operator_stride, 4*i+j, n, L[j]);
+            }
+            
+            RealType const result = sycomore::simd::fma(
+                L[0], M[0],
+                sycomore::simd::fma(
+                    L[1], M[1], sycomore::simd::fma(L[2], M[2], L[3]*M[3])));
+            sycomore::simd::store_aligned(result, magnetization+i*stride+n);
+        }
+    }
+}
+
+template<INSTRUCTION_SET_TYPE InstructionSet>
+void
+apply_d(
+    Real const * operator_, std::size_t operator_stride,
+    Real * magnetization, std::size_t stride,
+    std::size_t begin, std::size_t end)
+{
+    using RealBatch = simd::Batch<Real, InstructionSet>;
+    auto const simd_end = end - (end-begin) % RealBatch::size;
+    
+    apply_w<RealBatch>(
+        operator_, operator_stride, magnetization, stride,
+        begin, simd_end, RealBatch::size);
+    apply_w<Real>(
+        operator_, operator_stride, magnetization, stride,
+        simd_end, end, 1);
+}
+
+template<typename RealType>
+void apply_affine_w(
+    Real const * operator_, std::size_t operator_stride,
+    Real * magnetization, std::size_t stride,
+    std::size_t begin, std::size_t end, std::size_t step)
+{
+    for(std::size_t n=begin; n<end; n+=step)
+    {
+        RealType M[4];
+        for(std::size_t j=0; j<4; ++j)
+        {
+            sycomore::simd::load_aligned(magnetization+j*stride+n, M[j]);
+        }
+        
+        // The homogeneous coordinate is unchanged.
+        for(std::size_t i=0; i<3; ++i)
+        {
+            RealType L[4];
+            for(std::size_t j=0; j<4; ++j)
+            {
+                load_coefficient(operator_, operator_stride, 4*i+j, n, L[j]);
+            }
+            
+            RealType const result = sycomore::simd::fma(
+                L[0], M[0],
+                sycomore::simd::fma(
+                    L[1], M[1], sycomore::simd::fma(L[2], M[2], L[3]*M[3])));
+            sycomore::simd::store_aligned(result, magnetization+i*stride+n);
+        }
+    }
+}
+
+template<INSTRUCTION_SET_TYPE InstructionSet>
+void
+apply_affine_d(
+    Real const * operator_, std::size_t operator_stride,
+    Real * magnetization, std::size_t stride,
+    std::size_t begin, std::size_t end)
+{
+    using RealBatch = simd::Batch<Real, InstructionSet>;
+    auto const simd_end = end - (end-begin) % RealBatch::size;
+    
+    apply_affine_w<RealBatch>(
+        operator_, operator_stride, magnetization, stride,
+        begin, simd_end, RealBatch::size);
+    apply_affine_w<Real>(
+        operator_, operator_stride, magnetization, stride,
+        simd_end, end, 1);
+}
+
+template<typename RealType>
+void apply_diagonal_affine_w(
+    Real const * operator_, std::size_t operator_stride,
+    Real * magnetization, std::size_t stride,
+    std::size_t begin, std::size_t end, std::size_t step)
+{
+    for(std::size_t n=begin; n<end; n+=step)
+    {
+        RealType w;
+        sycomore::simd::load_aligned(magnetization+3*stride+n, w);
+        
+        // Each component only depends on itself and on the homogeneous
+        // coordinate, which is unchanged.
+        for(std::size_t i=0; i<3; ++i)
+        {
+            RealType M, diagonal, translation;
+            sycomore::simd::load_aligned(magnetization+i*stride+n, M);
+            load_coefficient(operator_, operator_stride, i, n, diagonal);
+            load_coefficient(operator_, operator_stride, 3+i, n, translation);
+            
+            RealType const result =
+                sycomore::simd::fma(diagonal, M, translation*w);
+            sycomore::simd::store_aligned(result, magnetization+i*stride+n);
+        }
+    }
+}
+
+template<INSTRUCTION_SET_TYPE InstructionSet>
+void
+apply_diagonal_affine_d(
+    Real const * operator_, std::size_t operator_stride,
+    Real * magnetization, std::size_t stride,
+    std::size_t begin, std::size_t end)
+{
+    using RealBatch = simd::Batch<Real, InstructionSet>;
+    auto const simd_end = end - (end-begin) % RealBatch::size;
+    
+    apply_diagonal_affine_w<RealBatch>(
+        operator_, operator_stride, magnetization, stride,
+        begin, simd_end, RealBatch::size);
+    apply_diagonal_affine_w<Real>(
+        operator_, operator_stride, magnetization, stride,
+        simd_end, end, 1);
+}
+
+template<typename RealType>
+void apply_z_rotation_w(
+    Real const * operator_, std::size_t operator_stride,
+    Real * magnetization, std::size_t stride,
+    std::size_t begin, std::size_t end, std::size_t step)
+{
+    for(std::size_t n=begin; n<end; n+=step)
+    {
+        RealType x, y, c, s;
+        sycomore::simd::load_aligned(magnetization+n, x);
+        sycomore::simd::load_aligned(magnetization+stride+n, y);
+        load_coefficient(operator_, operator_stride, 0, n, c);
+        load_coefficient(operator_, operator_stride, 1, n, s);
+        
+        // z and the homogeneous coordinate are unchanged.
+        sycomore::simd::store_aligned(
+            sycomore::simd::fnma(s, y, c*x), magnetization+n);
+        sycomore::simd::store_aligned(
+            sycomore::simd::fma(s, x, c*y), magnetization+stride+n);
+    }
+}
+
+template<INSTRUCTION_SET_TYPE InstructionSet>
+void
+apply_z_rotation_d(
+    Real const * operator_, std::size_t operator_stride,
+    Real * magnetization, std::size_t stride,
+    std::size_t begin, std::size_t end)
+{
+    using RealBatch = simd::Batch<Real, InstructionSet>;
+    auto const simd_end = end - (end-begin) % RealBatch::size;
+    
+    apply_z_rotation_w<RealBatch>(
+        operator_, operator_stride, magnetization, stride,
+        begin, simd_end, RealBatch::size);
+    apply_z_rotation_w<Real>(
+        operator_, operator_stride, magnetization, stride,
+        simd_end, end, 1);
+}
+
+template<typename RealType>
+void pulse_w(
+    Real const * angle, std::size_t angle_stride,
+    Real const * phase, std::size_t phase_stride,
+    Real * magnetization, std::size_t stride,
+    std::size_t begin, std::size_t end, std::size_t step)
+{
+    RealType const half(0.5);
+    for(std::size_t n=begin; n<end; n+=step)
+    {
+        RealType alpha, phi;
+        sycomore::simd::load_strided(angle+n*angle_stride, angle_stride, alpha);
+        sycomore::simd::load_strided(phase+n*phase_stride, phase_stride, phi);
+        
+        // Unit quaternion of the rotation of angle alpha around the axis
+        // (cos(phi), sin(phi), 0): scalar part w, vector part (q_x, q_y, 0).
+        RealType w, s, cp, sp;
+        sycomore::simd::sincos(half*alpha, s, w);
+        sycomore::simd::sincos(phi, sp, cp);
+        auto const q_x = s*cp, q_y = s*sp;
+        
+        RealType x, y, z;
+        sycomore::simd::load_aligned(magnetization+n, x);
+        sycomore::simd::load_aligned(magnetization+stride+n, y);
+        sycomore::simd::load_aligned(magnetization+2*stride+n, z);
+        
+        // Rodrigues formula in quaternion form: with t = 2 q × M, the rotated
+        // magnetization is M + w t + q × t.
+        auto const t_x = (q_y+q_y)*z;
+        auto const t_y = -(q_x+q_x)*z;
+        auto const t_z = sycomore::simd::fnma(q_y, x, q_x*y)*RealType(2);
+        
+        sycomore::simd::store_aligned(
+            sycomore::simd::fma(q_y, t_z, sycomore::simd::fma(w, t_x, x)),
+            magnetization+n);
+        sycomore::simd::store_aligned(
+            sycomore::simd::fnma(q_x, t_z, sycomore::simd::fma(w, t_y, y)),
+            magnetization+stride+n);
+        sycomore::simd::store_aligned(
+            sycomore::simd::fnma(
+                q_y, t_x,
+                sycomore::simd::fma(
+                    q_x, t_y, sycomore::simd::fma(w, t_z, z))),
+            magnetization+2*stride+n);
+    }
+}
+
+template<INSTRUCTION_SET_TYPE InstructionSet>
+void
+pulse_d(
+    Real const * angle, std::size_t angle_stride,
+    Real const * phase, std::size_t phase_stride,
+    Real * magnetization, std::size_t stride,
+    std::size_t begin, std::size_t end)
+{
+    using RealBatch = simd::Batch<Real, InstructionSet>;
+    auto const simd_end = end - (end-begin) % RealBatch::size;
+    
+    pulse_w<RealBatch>(
+        angle, angle_stride, phase, phase_stride, magnetization, stride,
+        begin, simd_end, RealBatch::size);
+    pulse_w<Real>(
+        angle, angle_stride, phase, phase_stride, magnetization, stride,
+        simd_end, end, 1);
+}
+
+template<typename RealType>
+void relaxation_w(
+    Real duration, Real const * T1, Real const * T2, Real const * M0,
+    Real * magnetization, std::size_t stride,
+    std::size_t begin, std::size_t end, std::size_t step)
+{
+    RealType const minus_duration(-duration);
+    for(std::size_t n=begin; n<end; n+=step)
+    {
+        RealType T1_n, T2_n, M0_n;
+        sycomore::simd::load_unaligned(T1+n, T1_n);
+        sycomore::simd::load_unaligned(T2+n, T2_n);
+        sycomore::simd::load_unaligned(M0+n, M0_n);
+        auto const E1 = sycomore::simd::exp(minus_duration/T1_n);
+        auto const E2 = sycomore::simd::exp(minus_duration/T2_n);
+        
+        RealType x, y, z, w;
+        sycomore::simd::load_aligned(magnetization+n, x);
+        sycomore::simd::load_aligned(magnetization+stride+n, y);
+        sycomore::simd::load_aligned(magnetization+2*stride+n, z);
+        sycomore::simd::load_aligned(magnetization+3*stride+n, w);
+        
+        sycomore::simd::store_aligned(E2*x, magnetization+n);
+        sycomore::simd::store_aligned(E2*y, magnetization+stride+n);
+        sycomore::simd::store_aligned(
+            sycomore::simd::fma(E1, z, M0_n*(RealType(1)-E1)*w),
+            magnetization+2*stride+n);
+    }
+}
+
+template<INSTRUCTION_SET_TYPE InstructionSet>
+void
+relaxation_d(
+    Real duration, Real const * T1, Real const * T2, Real const * M0,
+    Real * magnetization, std::size_t stride,
+    std::size_t begin, std::size_t end)
+{
+    using RealBatch = simd::Batch<Real, InstructionSet>;
+    auto const simd_end = end - (end-begin) % RealBatch::size;
+    
+    relaxation_w<RealBatch>(
+        duration, T1, T2, M0, magnetization, stride,
+        begin, simd_end, RealBatch::size);
+    relaxation_w<Real>(
+        duration, T1, T2, M0, magnetization, stride,
+        simd_end, end, 1);
+}
+
+template<typename RealType>
+void time_interval_w(
+    Real duration, Real const * T1, Real const * T2, Real const * M0,
+    Real const * delta_omega, Real const * field_delta_omega,
+    std::size_t field_stride, Real const * gradient,
+    std::size_t gradient_stride, Real const * positions,
+    Real * magnetization, std::size_t stride,
+    std::size_t begin, std::size_t end, std::size_t step)
+{
+    RealType const minus_duration(-duration);
+    RealType const off_resonance_scale(2*M_PI*duration);
+    RealType const gradient_scale(gamma.magnitude*duration);
+    for(std::size_t n=begin; n<end; n+=step)
+    {
+        RealType T1_n, T2_n, M0_n;
+        sycomore::simd::load_unaligned(T1+n, T1_n);
+        sycomore::simd::load_unaligned(T2+n, T2_n);
+        sycomore::simd::load_unaligned(M0+n, M0_n);
+        auto const E1 = sycomore::simd::exp(minus_duration/T1_n);
+        auto const E2 = sycomore::simd::exp(minus_duration/T2_n);
+        
+        RealType species_frequency, field_frequency;
+        sycomore::simd::load_unaligned(delta_omega+n, species_frequency);
+        sycomore::simd::load_strided(
+            field_delta_omega+n*field_stride, field_stride, field_frequency);
+        
+        // Dot product of the gradient and of the position.
+        RealType gradient_phase(0);
+        for(std::size_t i=0; i<3; ++i)
+        {
+            RealType G, position;
+            sycomore::simd::load_strided(
+                gradient+n*gradient_stride+i, gradient_stride, G);
+            sycomore::simd::load_strided(positions+3*n+i, 3, position);
+            gradient_phase = sycomore::simd::fma(G, position, gradient_phase);
+        }
+        
+        auto const angle = sycomore::simd::fma(
+            off_resonance_scale, species_frequency+field_frequency,
+            gradient_scale*gradient_phase);
+        auto const c = E2*sycomore::simd::cos(angle);
+        auto const s = E2*sycomore::simd::sin(angle);
+        
+        RealType x, y, z, w;
+        sycomore::simd::load_aligned(magnetization+n, x);
+        sycomore::simd::load_aligned(magnetization+stride+n, y);
+        sycomore::simd::load_aligned(magnetization+2*stride+n, z);
+        sycomore::simd::load_aligned(magnetization+3*stride+n, w);
+        
+        // Relaxation and dephasing commute: the transverse decay is the same
+        // for x and y.
+        sycomore::simd::store_aligned(
+            sycomore::simd::fnma(s, y, c*x), magnetization+n);
+        sycomore::simd::store_aligned(
+            sycomore::simd::fma(s, x, c*y), magnetization+stride+n);
+        sycomore::simd::store_aligned(
+            sycomore::simd::fma(E1, z, M0_n*(RealType(1)-E1)*w),
+            magnetization+2*stride+n);
+    }
+}
+
+template<INSTRUCTION_SET_TYPE InstructionSet>
+void
+time_interval_d(
+    Real duration, Real const * T1, Real const * T2, Real const * M0,
+    Real const * delta_omega, Real const * field_delta_omega,
+    std::size_t field_stride, Real const * gradient,
+    std::size_t gradient_stride, Real const * positions,
+    Real * magnetization, std::size_t stride,
+    std::size_t begin, std::size_t end)
+{
+    using RealBatch = simd::Batch<Real, InstructionSet>;
+    auto const simd_end = end - (end-begin) % RealBatch::size;
+    
+    time_interval_w<RealBatch>(
+        duration, T1, T2, M0, delta_omega, field_delta_omega, field_stride,
+        gradient, gradient_stride, positions, magnetization, stride,
+        begin, simd_end, RealBatch::size);
+    time_interval_w<Real>(
+        duration, T1, T2, M0, delta_omega, field_delta_omega, field_stride,
+        gradient, gradient_stride, positions, magnetization, stride,
+        simd_end, end, 1);
+}
+
+template<typename RealType>
+void shaped_pulse_w(
+    Real const * rotations, std::size_t count, Real duration,
+    Real const * T1, Real const * T2, Real const * M0,
+    Real const * delta_omega, Real const * field_delta_omega,
+    std::size_t field_stride, Real const * gradient,
+    std::size_t gradient_stride, Real const * positions,
+    Real * magnetization, std::size_t stride,
+    std::size_t begin, std::size_t end, std::size_t step)
+{
+    RealType const minus_duration(-duration);
+    RealType const off_resonance_scale(2*M_PI*duration);
+    RealType const gradient_scale(gamma.magnitude*duration);
+    for(std::size_t n=begin; n<end; n+=step)
+    {
+        // The transform of the time interval is the same after each hard
+        // pulse: compute it once per isochromat, as in time_interval_w.
+        RealType T1_n, T2_n, M0_n;
+        sycomore::simd::load_unaligned(T1+n, T1_n);
+        sycomore::simd::load_unaligned(T2+n, T2_n);
+        sycomore::simd::load_unaligned(M0+n, M0_n);
+        auto const E1 = sycomore::simd::exp(minus_duration/T1_n);
+        auto const E2 = sycomore::simd::exp(minus_duration/T2_n);
+        
+        RealType species_frequency, field_frequency;
+        sycomore::simd::load_unaligned(delta_omega+n, species_frequency);
+        sycomore::simd::load_strided(
+            field_delta_omega+n*field_stride, field_stride, field_frequency);
+        
+        RealType gradient_phase(0);
+        for(std::size_t i=0; i<3; ++i)
+        {
+            RealType G, position;
+            sycomore::simd::load_strided(
+                gradient+n*gradient_stride+i, gradient_stride, G);
+            sycomore::simd::load_strided(positions+3*n+i, 3, position);
+            gradient_phase = sycomore::simd::fma(G, position, gradient_phase);
+        }
+        
+        auto const angle = sycomore::simd::fma(
+            off_resonance_scale, species_frequency+field_frequency,
+            gradient_scale*gradient_phase);
+        RealType c, s;
+        sycomore::simd::sincos(angle, s, c);
+        c *= E2;
+        s *= E2;
+        auto const recovery = M0_n*(RealType(1)-E1);
+        
+        RealType x, y, z, w;
+        sycomore::simd::load_aligned(magnetization+n, x);
+        sycomore::simd::load_aligned(magnetization+stride+n, y);
+        sycomore::simd::load_aligned(magnetization+2*stride+n, z);
+        sycomore::simd::load_aligned(magnetization+3*stride+n, w);
+        auto const recovery_w = recovery*w;
+        
+        for(std::size_t p=0; p<count; ++p)
+        {
+            // Rotation, as in pulse_w.
+            RealType const q_w(rotations[3*p]);
+            RealType const q_x(rotations[3*p+1]);
+            RealType const q_y(rotations[3*p+2]);
+            
+            auto const t_x = (q_y+q_y)*z;
+            auto const t_y = -(q_x+q_x)*z;
+            auto const t_z = sycomore::simd::fnma(q_y, x, q_x*y)*RealType(2);
+            
+            auto const x_r = sycomore::simd::fma(
+                q_y, t_z, sycomore::simd::fma(q_w, t_x, x));
+            auto const y_r = sycomore::simd::fnma(
+                q_x, t_z, sycomore::simd::fma(q_w, t_y, y));
+            auto const z_r = sycomore::simd::fnma(
+                q_y, t_x,
+                sycomore::simd::fma(
+                    q_x, t_y, sycomore::simd::fma(q_w, t_z, z)));
+            
+            // Time interval.
+            x = sycomore::simd::fnma(s, y_r, c*x_r);
+            y = sycomore::simd::fma(s, x_r, c*y_r);
+            z = sycomore::simd::fma(E1, z_r, recovery_w);
+        }
+        
+        sycomore::simd::store_aligned(x, magnetization+n);
+        sycomore::simd::store_aligned(y, magnetization+stride+n);
+        sycomore::simd::store_aligned(z, magnetization+2*stride+n);
+    }
+}
+
+template<INSTRUCTION_SET_TYPE InstructionSet>
+void
+shaped_pulse_d(
+    Real const * rotations, std::size_t count, Real duration,
+    Real const * T1, Real const * T2, Real const * M0,
+    Real const * delta_omega, Real const * field_delta_omega,
+    std::size_t field_stride, Real const * gradient,
+    std::size_t gradient_stride, Real const * positions,
+    Real * magnetization, std::size_t stride,
+    std::size_t begin, std::size_t end)
+{
+    using RealBatch = simd::Batch<Real, InstructionSet>;
+    auto const simd_end = end - (end-begin) % RealBatch::size;
+    
+    shaped_pulse_w<RealBatch>(
+        rotations, count, duration, T1, T2, M0, delta_omega,
+        field_delta_omega, field_stride, gradient, gradient_stride, positions,
+        magnetization, stride, begin, simd_end, RealBatch::size);
+    shaped_pulse_w<Real>(
+        rotations, count, duration, T1, T2, M0, delta_omega,
+        field_delta_omega, field_stride, gradient, gradient_stride, positions,
+        magnetization, stride, simd_end, end, 1);
+}
+
+}
+
+}
+
+}
+
+#endif // _7d0c0243_5bb8_45b2_ad3f_d0073ed0d985
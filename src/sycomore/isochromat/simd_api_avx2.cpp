@@ -0,0 +1,80 @@
+#include "simd_api.h"
+
+namespace sycomore
+{
+
+namespace isochromat
+{
+
+namespace simd_api
+{
+
+template
+void
+apply_d<XSIMD_X86_AVX2_VERSION>(
+    Real const * operator_, std::size_t operator_stride,
+    Real * magnetization, std::size_t stride,
+    std::size_t begin, std::size_t end);
+
+template
+void
+apply_affine_d<XSIMD_X86_AVX2_VERSION>(
+    Real const * operator_, std::size_t operator_stride,
+    Real * magnetization, std::size_t stride,
+    std::size_t begin, std::size_t end);
+
+template
+void
+apply_diagonal_affine_d<XSIMD_X86_AVX2_VERSION>(
+    Real const * operator_, std::size_t operator_stride,
+    Real * magnetization, std::size_t stride,
+    std::size_t begin, std::size_t end);
+
+template
+void
+apply_z_rotation_d<XSIMD_X86_AVX2_VERSION>(
+    Real const * operator_, std::size_t operator_stride,
+    Real * magnetization, std::size_t stride,
+    std::size_t begin, std::size_t end);
+
+template
+void
+pulse_d<XSIMD_X86_AVX2_VERSION>(
+    Real const * angle, std::size_t angle_stride,
+    Real const * phase, std::size_t phase_stride,
+    Real * magnetization, std::size_t stride,
+    std::size_t begin, std::size_t end);
+
+template
+void
+relaxation_d<XSIMD_X86_AVX2_VERSION>(
+    Real duration, Real const * T1, Real const * T2, Real const * M0,
+    Real * magnetization, std::size_t stride,
+    std::size_t begin, std::size_t end);
+
+template
+void
+time_interval_d<XSIMD_X86_AVX2_VERSION>(
+    Real duration, Real const * T1, Real const * T2, Real const * M0,
+    Real const * delta_omega, Real const * field_delta_omega,
+    std::size_t field_stride, Real const * gradient,
+    std::size_t gradient_stride, Real const * positions,
+    Real * magnetization, std::size_t stride,
+    std::size_t begin, std::size_t end);
+
+template
+void
+shaped_pulse_d<XSIMD_X86_AVX2_VERSION>(
+    Real const * rotations, std::size_t count, Real duration,
+    Real const * T1, Real const * T2, Real const * M0,
+    Real const * delta_omega, Real const * field_delta_omega,
+    std::size_t field_stride, Real const * gradient,
+    std::size_t gradient_stride, Real const * positions,
+    Real * magnetization, std::size_t stride,
+    std::size_t begin, std::size_t end);
+
+}
+
+}
+
+}
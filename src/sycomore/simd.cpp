@@ -55,7 +55,11 @@ int instruction_set()
     if((ecx & 1<<19) != 0) { instruction_set = XSIMD_X86_SSE4_1_VERSION; }
     if((ecx & 1<<20) != 0) { instruction_set = XSIMD_X86_SSE4_2_VERSION; }
     if((ecx & 1<<28) != 0) { instruction_set = XSIMD_X86_AVX_VERSION; }
-    if((ebx & 1<< 5) != 0) { instruction_set = XSIMD_X86_AVX2_VERSION; }
+    // AVX2 kernels also use FMA
+    if((ebx & 1<< 5) != 0 && (ecx & 1<<12) != 0)
+    {
+        instruction_set = XSIMD_X86_AVX2_VERSION;
+    }
     if((ebx & 1<<16) != 0) { instruction_set = XSIMD_X86_AVX512_VERSION; }
     
     return instruction_set;
@@ -2,6 +2,7 @@
 #define _aec30e56_9250_476a_8b0d_0981a035c57b
 
 // NOTE: include required by one of the trigonometric function in xsimd
+#include <algorithm>
 #include <array>
 #include <vector>
 #include <xsimd/xsimd.hpp>
@@ -15,6 +16,8 @@ namespace sycomore
 
 using XSIMD_X86_SSE2_VERSION = xsimd::sse2;
 using XSIMD_X86_AVX_VERSION = xsimd::avx;
+// NOTE: AVX2 is only used with FMA, as available on all AVX2 CPUs but a few
+using XSIMD_X86_AVX2_VERSION = xsimd::fma3<xsimd::avx2>;
 using XSIMD_X86_AVX512_VERSION = xsimd::avx512f;
 
 template<typename T>
@@ -38,6 +41,12 @@ namespace simd
 
 template<INSTRUCTION_SET_TYPE InstructionSet, typename T> constexpr std::size_t width();
 
+template<> 
+constexpr std::size_t width<XSIMD_X86_SSE2_VERSION, float>()
+{
+    return 4;
+}
+
 template<> 
 constexpr std::size_t width<XSIMD_X86_SSE2_VERSION, double>()
 {
@@ -50,6 +59,12 @@ constexpr std::size_t width<XSIMD_X86_SSE2_VERSION, std::complex<double>>()
     return 2;
 }
 
+template<> 
+constexpr std::size_t width<XSIMD_X86_AVX_VERSION, float>()
+{
+    return 8;
+}
+
 template<> 
 constexpr std::size_t width<XSIMD_X86_AVX_VERSION, double>()
 {
@@ -62,6 +77,30 @@ constexpr std::size_t width<XSIMD_X86_AVX_VERSION, std::complex<double>>()
     return 4;
 }
 
+template<> 
+constexpr std::size_t width<XSIMD_X86_AVX2_VERSION, float>()
+{
+    return 8;
+}
+
+template<> 
+constexpr std::size_t width<XSIMD_X86_AVX2_VERSION, double>()
+{
+    return 4;
+}
+
+template<> 
+constexpr std::size_t width<XSIMD_X86_AVX2_VERSION, std::complex<double>>()
+{
+    return 4;
+}
+
+template<> 
+constexpr std::size_t width<XSIMD_X86_AVX512_VERSION, float>()
+{
+    return 16;
+}
+
 template<> 
 constexpr std::size_t width<XSIMD_X86_AVX512_VERSION, double>()
 {
@@ -120,6 +159,122 @@ store_aligned(T const & source, T * destination)
     *destination = source;
 }
 
+template<typename T1, typename T2>
+typename std::enable_if<is_batch<T2>::value, void>::type
+load_unaligned(T1 const * source, T2 & destination)
+{
+#if XSIMD_VERSION_MAJOR >= 8
+    destination = T2::load_unaligned(source);
+#else
+    destination.load_unaligned(source);
+#endif
+}
+
+template<typename T>
+typename std::enable_if<!is_batch<T>::value, void>::type
+load_unaligned(T const * source, T & destination)
+{
+    destination = *source;
+}
+
+template<typename T1, typename T2>
+typename std::enable_if<is_batch<T1>::value, void>::type
+store_unaligned(T1 const & source, T2 * destination)
+{
+    source.store_unaligned(destination);
+}
+
+template<typename T>
+typename std::enable_if<!is_batch<T>::value, void>::type
+store_unaligned(T const & source, T * destination)
+{
+    *destination = source;
+}
+
+/**
+ * @brief Load from aligned memory, converting the elements to the value type
+ * of the destination.
+ */
+template<typename T1, typename T2>
+typename std::enable_if<is_batch<T2>::value, void>::type
+load_converted(T1 const * source, T2 & destination)
+{
+    alignas(64) typename T2::value_type buffer[T2::size];
+    for(std::size_t i=0; i<T2::size; ++i)
+    {
+        buffer[i] = static_cast<typename T2::value_type>(source[i]);
+    }
+    load_aligned(buffer, destination);
+}
+
+template<typename T1, typename T2>
+typename std::enable_if<!is_batch<T2>::value, void>::type
+load_converted(T1 const * source, T2 & destination)
+{
+    destination = static_cast<T2>(*source);
+}
+
+/**
+ * @brief Load elements located every stride elements from source. A stride
+ * of 0 broadcasts the first element.
+ */
+template<typename T1, typename T2>
+typename std::enable_if<is_batch<T2>::value, void>::type
+load_strided(T1 const * source, std::size_t stride, T2 & destination)
+{
+    if(stride == 0)
+    {
+        destination = T2(*source);
+        return;
+    }
+    
+    alignas(64) typename T2::value_type buffer[T2::size];
+    for(std::size_t i=0; i<T2::size; ++i)
+    {
+        buffer[i] = source[i*stride];
+    }
+    load_aligned(buffer, destination);
+}
+
+template<typename T1, typename T2>
+typename std::enable_if<!is_batch<T2>::value, void>::type
+load_strided(T1 const * source, std::size_t, T2 & destination)
+{
+    destination = *source;
+}
+
+/// @brief Load from aligned or unaligned memory.
+template<bool Aligned, typename T1, typename T2>
+typename std::enable_if<Aligned, void>::type
+load(T1 const * source, T2 & destination)
+{
+    load_aligned(source, destination);
+}
+
+/// @brief Load from aligned or unaligned memory.
+template<bool Aligned, typename T1, typename T2>
+typename std::enable_if<!Aligned, void>::type
+load(T1 const * source, T2 & destination)
+{
+    load_unaligned(source, destination);
+}
+
+/// @brief Store to aligned or unaligned memory.
+template<bool Aligned, typename T1, typename T2>
+typename std::enable_if<Aligned, void>::type
+store(T1 const & source, T2 * destination)
+{
+    store_aligned(source, destination);
+}
+
+/// @brief Store to aligned or unaligned memory.
+template<bool Aligned, typename T1, typename T2>
+typename std::enable_if<!Aligned, void>::type
+store(T1 const & source, T2 * destination)
+{
+    store_unaligned(source, destination);
+}
+
 template<typename T>
 typename std::enable_if<is_batch<T>::value, T>::type
 pow(T const & base, int exp)
@@ -151,6 +306,73 @@ exp(T arg)
     return std::exp(arg);
 }
 
+template<typename T>
+typename std::enable_if<is_batch<T>::value, T>::type
+cos(T const & arg)
+{
+    return xsimd::cos(arg);
+}
+
+template<typename T>
+typename std::enable_if<!is_batch<T>::value, T>::type
+cos(T arg)
+{
+    return std::cos(arg);
+}
+
+template<typename T>
+typename std::enable_if<is_batch<T>::value, T>::type
+sin(T const & arg)
+{
+    return xsimd::sin(arg);
+}
+
+template<typename T>
+typename std::enable_if<!is_batch<T>::value, T>::type
+sin(T arg)
+{
+    return std::sin(arg);
+}
+
+/**
+ * @brief Compute the sine and cosine of a batch, sharing the range reduction.
+ */
+template<typename T>
+typename std::enable_if<is_batch<T>::value, void>::type
+sincos(T const & arg, T & sin, T & cos)
+{
+#if XSIMD_VERSION_MAJOR >= 8
+    auto const result = xsimd::sincos(arg);
+    sin = result.first;
+    cos = result.second;
+#else
+    xsimd::sincos(arg, sin, cos);
+#endif
+}
+
+template<typename T>
+typename std::enable_if<!is_batch<T>::value, void>::type
+sincos(T arg, T & sin, T & cos)
+{
+    sin = std::sin(arg);
+    cos = std::cos(arg);
+}
+
+/// @brief Select a if condition is true, b otherwise, element-wise.
+template<typename C, typename T>
+typename std::enable_if<is_batch<T>::value, T>::type
+select(C const & condition, T const & a, T const & b)
+{
+    return xsimd::select(condition, a, b);
+}
+
+template<typename T>
+typename std::enable_if<!is_batch<T>::value, T>::type
+select(bool condition, T a, T b)
+{
+    return condition ? a : b;
+}
+
 template<typename T>
 typename std::enable_if<is_batch<T>::value, T>::type
 conj(T const & arg)
@@ -165,6 +387,114 @@ conj(T arg)
     return std::conj(arg);
 }
 
+template<typename T>
+typename std::enable_if<is_batch<T>::value, T>::type
+fma(T const & a, T const & b, T const & c)
+{
+    return xsimd::fma(a, b, c);
+}
+
+template<typename T>
+typename std::enable_if<!is_batch<T>::value, T>::type
+fma(T a, T b, T c)
+{
+    // NOTE: std::fma is emulated in software on CPUs without FMA
+    return a*b+c;
+}
+
+template<typename T>
+typename std::enable_if<is_batch<T>::value, T>::type
+fnma(T const & a, T const & b, T const & c)
+{
+    return xsimd::fnma(a, b, c);
+}
+
+template<typename T>
+typename std::enable_if<!is_batch<T>::value, T>::type
+fnma(T a, T b, T c)
+{
+    return c-a*b;
+}
+
+/**
+ * @brief Add the product of two complex numbers, given by their real and
+ * imaginary parts, to the real and imaginary parts of an accumulator.
+ */
+template<typename T>
+void multiply_add(
+    T const & a_real, T const & a_imag, T const & b_real, T const & b_imag,
+    T & real, T & imag)
+{
+    real = fma(a_real, b_real, real);
+    real = fnma(a_imag, b_imag, real);
+    imag = fma(a_real, b_imag, imag);
+    imag = fma(a_imag, b_real, imag);
+}
+
+/**
+ * @brief Add the product of a complex scalar and of a complex batch to the
+ * real and imaginary parts of an accumulator, using fused multiply-adds.
+ */
+template<typename T, typename Scalar>
+void multiply_add(
+    Scalar const & c, T const & x,
+    typename T::real_batch & real, typename T::real_batch & imag)
+{
+    using RealBatch = typename T::real_batch;
+    
+    RealBatch const c_real(c.real()), c_imag(c.imag());
+    auto const x_real = x.real();
+    auto const x_imag = x.imag();
+    
+    real = xsimd::fma(c_real, x_real, real);
+    real = xsimd::fnma(c_imag, x_imag, real);
+    imag = xsimd::fma(c_real, x_imag, imag);
+    imag = xsimd::fma(c_imag, x_real, imag);
+}
+
+/**
+ * @brief Return c[0]*x_0 + c[1]*x_1 + c[2]*x_2 for complex scalar coefficients.
+ *
+ * On batches, the real and imaginary parts are accumulated with fused
+ * multiply-adds, which map to single instructions on FMA instruction sets
+ * instead of the separate multiplications and additions of the complex
+ * product.
+ */
+template<typename T, typename Scalar>
+typename std::enable_if<is_batch<T>::value, T>::type
+dot(Scalar const * c, T const & x_0, T const & x_1, T const & x_2)
+{
+    using RealBatch = typename T::real_batch;
+    
+    RealBatch real(0.), imag(0.);
+    multiply_add(c[0], x_0, real, imag);
+    multiply_add(c[1], x_1, real, imag);
+    multiply_add(c[2], x_2, real, imag);
+    
+    return T(real, imag);
+}
+
+template<typename T, typename Scalar>
+typename std::enable_if<!is_batch<T>::value, T>::type
+dot(Scalar const * c, T const & x_0, T const & x_1, T const & x_2)
+{
+    return c[0]*x_0 + c[1]*x_1 + c[2]*x_2;
+}
+
+template<typename T>
+typename std::enable_if<is_batch<T>::value, T>::type
+max(T const & a, T const & b)
+{
+    return xsimd::max(a, b);
+}
+
+template<typename T>
+typename std::enable_if<!is_batch<T>::value, T>::type
+max(T a, T b)
+{
+    return std::max(a, b);
+}
+
 }
 
 }
@@ -180,6 +510,10 @@ conj(T arg)
     { \
         name = &name##_d<XSIMD_X86_AVX_VERSION>; \
     } \
+    if(instruction_set >= XSIMD_X86_AVX2_VERSION::version()) \
+    { \
+        name = &name##_d<XSIMD_X86_AVX2_VERSION>; \
+    } \
     if(instruction_set >= XSIMD_X86_AVX512_VERSION::version()) \
     { \
         name = &name##_d<XSIMD_X86_AVX512_VERSION>; \
@@ -195,10 +529,27 @@ conj(T arg)
     { \
         name = &name##_d<XSIMD_X86_AVX_VERSION>; \
     } \
+    if(instruction_set >= XSIMD_X86_AVX2_VERSION) \
+    { \
+        name = &name##_d<XSIMD_X86_AVX2_VERSION>; \
+    } \
     if(instruction_set >= XSIMD_X86_AVX512_VERSION) \
     { \
         name = &name##_d<XSIMD_X86_AVX512_VERSION>; \
     }
 #endif
 
+/**
+ * @brief Declare a dispatcher function template, its specialization for
+ * unsupported instruction sets, and its instantiations for the supported
+ * ones, which are defined in separate translation units.
+ */
+#define SYCOMORE_DEFINE_SIMD_DISPATCHER_FUNCTION(return_, name, parameters) \
+    template<INSTRUCTION_SET_TYPE InstructionSet> return_ name parameters; \
+    template<> return_ name<unsupported> parameters; \
+    extern template return_ name<XSIMD_X86_SSE2_VERSION> parameters; \
+    extern template return_ name<XSIMD_X86_AVX_VERSION> parameters; \
+    extern template return_ name<XSIMD_X86_AVX2_VERSION> parameters; \
+    extern template return_ name<XSIMD_X86_AVX512_VERSION> parameters;
+
 #endif // _aec30e56_9250_476a_8b0d_0981a035c57b
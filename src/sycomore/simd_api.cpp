@@ -0,0 +1,44 @@
+#include "simd_api.h"
+
+#include <cstddef>
+
+#include "sycomore/simd.h"
+#include "sycomore/sycomore.h"
+
+namespace sycomore
+{
+
+namespace simd_api
+{
+
+template<>
+void
+apodized_sinc_d<unsupported>(
+    Real t0, Real N, Real alpha, Real const * times, Real * envelope,
+    std::size_t begin, std::size_t end)
+{
+    apodized_sinc_w<Real>(t0, N, alpha, times, envelope, begin, end, 1);
+}
+
+/*******************************************************************************
+ *                          Function table and set-up                          *
+ ******************************************************************************/
+
+decltype(&apodized_sinc_d<unsupported>) apodized_sinc = nullptr;
+
+void set_api(unsigned instruction_set)
+{
+    SYCOMORE_SET_API_FUNCTION(apodized_sinc)
+}
+
+bool set_default_api()
+{
+    set_api(simd::instruction_set());
+    return true;
+}
+
+bool const api_is_set=set_default_api();
+
+}
+
+}
@@ -0,0 +1,51 @@
+#ifndef _373f0116_e8b8_4993_8cda_0c43c433019b
+#define _373f0116_e8b8_4993_8cda_0c43c433019b
+
+#include <cstddef>
+
+#include "sycomore/simd.h"
+#include "sycomore/sycomore.h"
+
+namespace sycomore
+{
+
+namespace simd_api
+{
+
+// Functions with a _w suffix are worker functions, functions with a _d suffix
+// are dispatcher functions.
+
+template<typename RealType>
+void apodized_sinc_w(
+    Real t0, Real N, Real alpha, Real const * times, Real * envelope,
+    std::size_t begin, std::size_t end, std::size_t step);
+
+/**
+ * @brief Sample an apodized sinc envelope at times[begin, end) (in s):
+ * ((1-alpha) + alpha cos(pi t/(N t0))) sinc(pi t/t0), with sinc(0) = 1.
+ */
+SYCOMORE_DEFINE_SIMD_DISPATCHER_FUNCTION(
+    void, apodized_sinc_d,
+    (
+        Real t0, Real N, Real alpha, Real const * times, Real * envelope,
+        std::size_t begin, std::size_t end))
+
+/*******************************************************************************
+ *                          Function table and set-up                          *
+ ******************************************************************************/
+
+extern decltype(&apodized_sinc_d<unsupported>) apodized_sinc;
+
+void set_api(unsigned instruction_set);
+
+bool set_default_api();
+
+extern bool const api_is_set;
+
+}
+
+}
+
+#include "simd_api.txx"
+
+#endif // _373f0116_e8b8_4993_8cda_0c43c433019b
@@ -0,0 +1,61 @@
+#ifndef _594c7316_eb47_4169_a988_6d16d4b3705b
+#define _594c7316_eb47_4169_a988_6d16d4b3705b
+
+#include "simd_api.h"
+
+#include <cmath>
+#include <cstddef>
+
+#include "sycomore/simd.h"
+#include "sycomore/sycomore.h"
+
+namespace sycomore
+{
+
+namespace simd_api
+{
+
+template<typename RealType>
+void apodized_sinc_w(
+    Real t0, Real N, Real alpha, Real const * times, Real * envelope,
+    std::size_t begin, std::size_t end, std::size_t step)
+{
+    RealType const sinc_scale(M_PI/t0);
+    RealType const apodization_scale(M_PI/(N*t0));
+    RealType const constant(1-alpha), amplitude(alpha);
+    RealType const zero(0), one(1);
+    for(std::size_t n=begin; n<end; n+=step)
+    {
+        RealType t;
+        sycomore::simd::load_unaligned(times+n, t);
+        
+        auto const x = sinc_scale*t;
+        auto const sinc = sycomore::simd::select(
+            x == zero, one, sycomore::simd::sin(x)/x);
+        auto const apodization = sycomore::simd::fma(
+            amplitude, sycomore::simd::cos(apodization_scale*t), constant);
+        
+        sycomore::simd::store_unaligned(
+            RealType(apodization*sinc), envelope+n);
+    }
+}
+
+template<INSTRUCTION_SET_TYPE InstructionSet>
+void
+apodized_sinc_d(
+    Real t0, Real N, Real alpha, Real const * times, Real * envelope,
+    std::size_t begin, std::size_t end)
+{
+    using RealBatch = simd::Batch<Real, InstructionSet>;
+    auto const simd_end = end - (end-begin) % RealBatch::size;
+    
+    apodized_sinc_w<RealBatch>(
+        t0, N, alpha, times, envelope, begin, simd_end, RealBatch::size);
+    apodized_sinc_w<Real>(t0, N, alpha, times, envelope, simd_end, end, 1);
+}
+
+}
+
+}
+
+#endif // _594c7316_eb47_4169_a988_6d16d4b3705b
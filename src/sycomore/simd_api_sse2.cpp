@@ -0,0 +1,17 @@
+#include "simd_api.h"
+
+namespace sycomore
+{
+
+namespace simd_api
+{
+
+template
+void
+apodized_sinc_d<XSIMD_X86_SSE2_VERSION>(
+    Real t0, Real N, Real alpha, Real const * times, Real * envelope,
+    std::size_t begin, std::size_t end);
+
+}
+
+}
@@ -1,6 +1,9 @@
 #define BOOST_TEST_MODULE Dimensions
 #include <boost/test/unit_test.hpp>
 
+#include <cmath>
+#include <stdexcept>
+
 #include "sycomore/Dimensions.h"
 
 BOOST_AUTO_TEST_CASE(Comparison)
@@ -51,3 +54,51 @@ BOOST_AUTO_TEST_CASE(Pow)
     sycomore::Dimensions const r{6,0,-4,0,0,0,0};
     BOOST_CHECK(std::pow(d, 2) == r);
 }
+
+BOOST_AUTO_TEST_CASE(FractionalPow)
+{
+    sycomore::Dimensions const d{3,0,-2,0,0,0,0};
+    auto const root = std::pow(d, 0.5);
+    BOOST_CHECK(root.length == 1.5);
+    BOOST_CHECK(root.time == -1);
+    BOOST_CHECK(std::pow(std::pow(d, 1./3.), 3) == d);
+}
+
+BOOST_AUTO_TEST_CASE(ExponentArithmetic)
+{
+    sycomore::Dimensions d{1,0,-2,0,0,0,0};
+    d.length *= 3;
+    d.time /= 4;
+    d.mass = 1./3.;
+    d.mass += 0.5;
+    BOOST_CHECK(d == sycomore::Dimensions(3,5./6.,-0.5,0,0,0,0));
+    BOOST_CHECK(d.mass == 5./6.);
+}
+
+BOOST_AUTO_TEST_CASE(NonSixthExponent)
+{
+    sycomore::Dimensions d{1,0,0,0,0,0,0};
+    BOOST_CHECK_THROW(std::pow(d, 0.1), std::runtime_error);
+    BOOST_CHECK_THROW(sycomore::Dimensions(0.25), std::runtime_error);
+    BOOST_CHECK_THROW(d.length *= 0.1, std::runtime_error);
+    BOOST_CHECK_THROW(d.length = 1./7., std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(OutOfRangeExponent)
+{
+    sycomore::Dimensions d{1,0,0,0,0,0,0};
+    BOOST_CHECK_NO_THROW(sycomore::Dimensions(21, -21));
+    BOOST_CHECK_THROW(std::pow(d, 100), std::runtime_error);
+    BOOST_CHECK_THROW(std::pow(d, -22), std::runtime_error);
+    BOOST_CHECK_THROW(sycomore::Dimensions(22), std::runtime_error);
+    BOOST_CHECK_THROW(d.length *= 30, std::runtime_error);
+    
+    sycomore::Dimensions const big{20,0,0,0,0,0,0};
+    BOOST_CHECK_THROW(big*big, std::runtime_error);
+    BOOST_CHECK_THROW(sycomore::Dimensions(-20)/big, std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(Size)
+{
+    BOOST_CHECK(sizeof(sycomore::Dimensions) == 8);
+}
@@ -0,0 +1,108 @@
+#define BOOST_TEST_MODULE HardPulseApproximation
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "sycomore/HardPulseApproximation.h"
+#include "sycomore/Pulse.h"
+#include "sycomore/sycomore.h"
+#include "sycomore/units.h"
+
+void test_pulses(
+    sycomore::HardPulseApproximation const & left,
+    sycomore::HardPulseApproximation const & right)
+{
+    BOOST_TEST(left.duration() == right.duration());
+    BOOST_TEST(left.pulses().size() == right.pulses().size());
+    for(std::size_t i=0; i<left.pulses().size(); ++i)
+    {
+        auto const & l = left.pulses()[i];
+        auto const & r = right.pulses()[i];
+        BOOST_TEST(l.angle().magnitude == r.angle().magnitude);
+        BOOST_TEST(l.phase().magnitude == r.phase().magnitude);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(Constructor, *boost::unit_test::tolerance(1e-12))
+{
+    using namespace sycomore::units;
+    
+    // Odd support: the envelope is sampled at t=0.
+    auto const support = sycomore::linspace(1*ms, 101);
+    sycomore::HardPulseApproximation const pulse(
+        sycomore::Pulse(40*deg, 10*deg), support,
+        sycomore::hann_sinc_envelope(0.25*ms, 2));
+    
+    BOOST_TEST(pulse.pulses().size() == 101);
+    BOOST_TEST(pulse.duration().magnitude == (10*us).magnitude);
+    
+    sycomore::Real sum = 0;
+    for(auto && hard_pulse: pulse.pulses())
+    {
+        BOOST_TEST(std::isfinite(hard_pulse.angle().magnitude));
+        BOOST_TEST(hard_pulse.phase().magnitude == (10*deg).magnitude);
+        sum += hard_pulse.angle().magnitude;
+    }
+    BOOST_TEST(sum == (40*deg).magnitude);
+}
+
+BOOST_AUTO_TEST_CASE(SampledEnvelope, *boost::unit_test::tolerance(1e-12))
+{
+    using namespace sycomore::units;
+    
+    sycomore::Pulse const model(40*deg, 10*deg);
+    // Avoid the zeros of the sinc, where the relative tolerance is not
+    // meaningful.
+    auto const t0 = 0.317*ms;
+    
+    // Not a multiple of the SIMD width
+    for(std::size_t size: {3, 15, 101})
+    {
+        auto const support = sycomore::linspace(1*ms, size);
+        
+        test_pulses(
+            sycomore::HardPulseApproximation(
+                model, support, sycomore::sinc_sampled_envelope(t0)),
+            sycomore::HardPulseApproximation(
+                model, support, sycomore::sinc_envelope(t0)));
+        test_pulses(
+            sycomore::HardPulseApproximation(
+                model, support, sycomore::hann_sinc_sampled_envelope(t0, 2)),
+            sycomore::HardPulseApproximation(
+                model, support, sycomore::hann_sinc_envelope(t0, 2)));
+        test_pulses(
+            sycomore::HardPulseApproximation(
+                model, support,
+                sycomore::hamming_sinc_sampled_envelope(t0, 3)),
+            sycomore::HardPulseApproximation(
+                model, support, sycomore::hamming_sinc_envelope(t0, 3)));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(
+    CustomSampledEnvelope, *boost::unit_test::tolerance(1e-12))
+{
+    using namespace sycomore::units;
+    
+    sycomore::HardPulseApproximation const pulse(
+        sycomore::Pulse(40*deg), sycomore::linspace(1*ms, 4),
+        [](
+            sycomore::Real const * times, std::size_t size,
+            sycomore::Real * values) {
+            for(std::size_t i=0; i<size; ++i)
+            {
+                values[i] = 1+times[i]*1e3;
+            }
+        });
+    
+    std::vector<sycomore::Real> const expected{
+        0.5/4*40, (1-1./6)/4*40, (1+1./6)/4*40, 1.5/4*40};
+    BOOST_TEST(pulse.pulses().size() == expected.size());
+    for(std::size_t i=0; i<expected.size(); ++i)
+    {
+        BOOST_TEST(
+            pulse.pulses()[i].angle().magnitude == (expected[i]*deg).magnitude);
+    }
+}
@@ -0,0 +1,88 @@
+#define BOOST_TEST_MODULE LRUCache
+#include <boost/test/unit_test.hpp>
+
+#include <stdexcept>
+
+#include "sycomore/LRUCache.h"
+
+BOOST_AUTO_TEST_CASE(Empty)
+{
+    sycomore::LRUCache<int, int> cache(2);
+    BOOST_TEST(cache.capacity() == 2);
+    BOOST_TEST(cache.size() == 0);
+    BOOST_TEST(cache.hits() == 0);
+    BOOST_TEST(cache.misses() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(InvalidCapacity)
+{
+    BOOST_CHECK_THROW(
+        (sycomore::LRUCache<int, int>(0)), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(Get)
+{
+    sycomore::LRUCache<int, int> cache(2);
+    int calls = 0;
+    auto const square = [&](int x) {
+        return [&, x]() { ++calls; return x*x; }; };
+    
+    BOOST_TEST(cache.get(2, square(2)) == 4);
+    BOOST_TEST(cache.get(3, square(3)) == 9);
+    BOOST_TEST(cache.get(2, square(2)) == 4);
+    BOOST_TEST(calls == 2);
+    BOOST_TEST(cache.size() == 2);
+    BOOST_TEST(cache.hits() == 1);
+    BOOST_TEST(cache.misses() == 2);
+}
+
+BOOST_AUTO_TEST_CASE(Eviction)
+{
+    sycomore::LRUCache<int, int> cache(2);
+    int calls = 0;
+    auto const square = [&](int x) {
+        return [&, x]() { ++calls; return x*x; }; };
+    
+    cache.get(2, square(2));
+    cache.get(3, square(3));
+    // 2 is now the most recently used value, 3 is evicted.
+    cache.get(2, square(2));
+    cache.get(4, square(4));
+    BOOST_TEST(cache.size() == 2);
+    BOOST_TEST(calls == 3);
+    
+    cache.get(2, square(2));
+    BOOST_TEST(calls == 3);
+    cache.get(3, square(3));
+    BOOST_TEST(calls == 4);
+    
+    cache.set_capacity(1);
+    BOOST_TEST(cache.size() == 1);
+    cache.get(3, square(3));
+    BOOST_TEST(calls == 4);
+}
+
+BOOST_AUTO_TEST_CASE(Copy)
+{
+    sycomore::LRUCache<int, int> cache(2);
+    cache.get(2, []() { return 4; });
+    
+    auto copy = cache;
+    cache.clear();
+    BOOST_TEST(cache.size() == 0);
+    BOOST_TEST(cache.misses() == 0);
+    
+    BOOST_TEST(copy.size() == 1);
+    BOOST_TEST(copy.get(2, []() { return 0; }) == 4);
+    BOOST_TEST(copy.hits() == 1);
+}
+
+BOOST_AUTO_TEST_CASE(Exception)
+{
+    sycomore::LRUCache<int, int> cache(2);
+    BOOST_CHECK_THROW(
+        cache.get(2, []() -> int { throw std::runtime_error("error"); }),
+        std::runtime_error);
+    BOOST_TEST(cache.size() == 0);
+    BOOST_TEST(cache.get(2, []() { return 4; }) == 4);
+}
@@ -0,0 +1,66 @@
+#define BOOST_TEST_MODULE Sequence
+#include <boost/test/unit_test.hpp>
+
+#include <stdexcept>
+
+#include "sycomore/Sequence.h"
+#include "sycomore/TimeInterval.h"
+#include "sycomore/units.h"
+
+BOOST_AUTO_TEST_CASE(Steps)
+{
+    using namespace sycomore::units;
+    
+    sycomore::Sequence sequence;
+    sequence
+        .pulse(90*deg, 30*deg)
+        .time_interval(10*ms, 2*mT/m)
+        .echo();
+    
+    auto const & steps = sequence.steps();
+    BOOST_TEST(steps.size() == 3);
+    
+    BOOST_TEST(steps[0].kind == sycomore::Sequence::Step::Pulse);
+    BOOST_TEST(steps[0].pulse.angle() == 90*deg);
+    BOOST_TEST(steps[0].pulse.phase() == 30*deg);
+    
+    BOOST_TEST(steps[1].kind == sycomore::Sequence::Step::TimeInterval);
+    BOOST_CHECK(
+        steps[1].interval == sycomore::TimeInterval(10*ms, 2*mT/m));
+    
+    BOOST_TEST(steps[2].kind == sycomore::Sequence::Step::Echo);
+    
+    BOOST_TEST(sequence.size() == 3);
+    BOOST_TEST(sequence.echoes() == 1);
+}
+
+BOOST_AUTO_TEST_CASE(Loop)
+{
+    using namespace sycomore::units;
+    
+    sycomore::Sequence TR;
+    TR.pulse(30*deg).time_interval(5*ms, 1*mT/m).echo();
+    
+    sycomore::Sequence sequence;
+    sequence
+        .pulse(180*deg).loop(10, TR)
+        .loop(2, sycomore::Sequence().loop(3, TR));
+    
+    // Modifying the body does not modify the sequence.
+    TR.echo();
+    
+    BOOST_TEST(sequence.steps().size() == 3);
+    BOOST_TEST(sequence.steps()[1].kind == sycomore::Sequence::Step::Loop);
+    BOOST_TEST(sequence.steps()[1].repetitions == 10);
+    BOOST_TEST(sequence.size() == 1+10*3+2*3*3);
+    BOOST_TEST(sequence.echoes() == 10+2*3);
+}
+
+BOOST_AUTO_TEST_CASE(InvalidPulse)
+{
+    using namespace sycomore::units;
+    
+    sycomore::Sequence sequence;
+    BOOST_CHECK_THROW(sequence.pulse(1*ms), std::runtime_error);
+    BOOST_TEST(sequence.steps().empty());
+}
@@ -0,0 +1,108 @@
+#define BOOST_TEST_MODULE ThreadPool
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include "sycomore/ThreadPool.h"
+
+BOOST_AUTO_TEST_CASE(Size)
+{
+    sycomore::ThreadPool pool(3);
+    BOOST_TEST(pool.size() == 3);
+}
+
+BOOST_AUTO_TEST_CASE(DefaultSize)
+{
+    sycomore::ThreadPool pool;
+    BOOST_TEST(pool.size() >= 1);
+}
+
+BOOST_AUTO_TEST_CASE(ParallelFor)
+{
+    sycomore::ThreadPool pool(4);
+    
+    // Several loops on the same pool, with various grain sizes
+    for(std::size_t grain: {0, 1, 7, 1000})
+    {
+        std::vector<int> calls(1000, 0);
+        pool.parallel_for(
+            calls.size(), [&](std::size_t i) { ++calls[i]; }, grain);
+        for(auto && item: calls)
+        {
+            BOOST_TEST(item == 1);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(Empty)
+{
+    sycomore::ThreadPool pool(2);
+    std::atomic<int> calls(0);
+    pool.parallel_for(0, [&](std::size_t) { ++calls; });
+    BOOST_TEST(calls == 0);
+}
+
+BOOST_AUTO_TEST_CASE(Exception)
+{
+    sycomore::ThreadPool pool(4);
+    std::atomic<int> calls(0);
+    BOOST_CHECK_THROW(
+        pool.parallel_for(
+            100, 
+            [&](std::size_t i) {
+                ++calls;
+                if(i == 50) { throw std::runtime_error("error"); }
+            }, 
+            1),
+        std::runtime_error);
+    
+    // Other tasks are still run.
+    BOOST_TEST(calls == 100);
+    
+    // The pool is still usable.
+    calls = 0;
+    pool.parallel_for(100, [&](std::size_t) { ++calls; });
+    BOOST_TEST(calls == 100);
+}
+
+BOOST_AUTO_TEST_CASE(Nested)
+{
+    sycomore::ThreadPool pool(4);
+    std::vector<std::atomic<int>> calls(100);
+    for(auto && item: calls)
+    {
+        item = 0;
+    }
+    
+    // Nested loops on the same pool run inline instead of deadlocking.
+    pool.parallel_for(
+        10,
+        [&](std::size_t i) {
+            pool.parallel_for(
+                10, [&](std::size_t j) { ++calls[10*i+j]; }, 1);
+        },
+        1);
+    for(auto && item: calls)
+    {
+        BOOST_TEST(item == 1);
+    }
+    
+    // The pool is still usable.
+    std::atomic<int> count(0);
+    pool.parallel_for(100, [&](std::size_t) { ++count; });
+    BOOST_TEST(count == 100);
+}
+
+BOOST_AUTO_TEST_CASE(Shared)
+{
+    auto & pool = sycomore::ThreadPool::shared(3);
+    BOOST_TEST(pool.size() == 3);
+    BOOST_TEST(&sycomore::ThreadPool::shared(3) == &pool);
+    BOOST_TEST(&sycomore::ThreadPool::shared(2) != &pool);
+    BOOST_TEST(
+        &sycomore::ThreadPool::shared()
+        == &sycomore::ThreadPool::shared(
+            sycomore::ThreadPool::shared().size()));
+}
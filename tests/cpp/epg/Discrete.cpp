@@ -4,6 +4,8 @@
 #include <xtensor/xview.hpp>
 
 #include "sycomore/epg/Discrete.h"
+#include "sycomore/epg/Regular.h"
+#include "sycomore/HardPulseApproximation.h"
 #include "sycomore/Species.h"
 #include "sycomore/units.h"
 
@@ -136,6 +138,65 @@ BOOST_AUTO_TEST_CASE(MultipleGradient, *boost::unit_test::tolerance(1e-9))
     TEST_COMPLEX_EQUAL(model.echo(), 0);
 }
 
+BOOST_AUTO_TEST_CASE(ShiftRegular, *boost::unit_test::tolerance(1e-12))
+{
+    using namespace sycomore::units;
+    
+    // With a bin width equal to the unit dephasing, the discrete model must
+    // contain the populated states of the regular model, in order.
+    auto const unit_dephasing = 1*mT/m*ms;
+    sycomore::epg::Discrete discrete(
+        species, {0,0,1}, sycomore::gamma*unit_dephasing);
+    sycomore::epg::Regular regular(species, {0,0,1}, 100, unit_dephasing);
+    
+    for(int multiple: {1, 3, -2, 5, -7, -1, 4, 2, -3})
+    {
+        auto const angle = (20.+5*multiple)*deg;
+        auto const gradient = multiple*1*mT/m;
+        
+        discrete.apply_pulse(angle, 10*deg);
+        discrete.shift(1*ms, gradient);
+        regular.apply_pulse(angle, 10*deg);
+        regular.shift(1*ms, gradient);
+        
+        auto && orders = discrete.orders();
+        auto && discrete_states = discrete.states();
+        auto && regular_states = regular.states();
+        
+        std::size_t populated = 0;
+        for(std::size_t i=0; i<regular.size(); ++i)
+        {
+            if(
+                regular_states(i, 0) != 0. || regular_states(i, 1) != 0.
+                || regular_states(i, 2) != 0.)
+            {
+                ++populated;
+            }
+        }
+        BOOST_TEST(discrete.size() == populated);
+        
+        for(std::size_t i=0; i<discrete.size(); ++i)
+        {
+            if(i > 0)
+            {
+                BOOST_TEST(orders[i-1].magnitude < orders[i].magnitude);
+            }
+            
+            std::size_t const order = std::lround(
+                orders[i]/(sycomore::gamma*unit_dephasing));
+            for(std::size_t j=0; j<3; ++j)
+            {
+                // The models are processed in vectors of different sizes,
+                // hence with different rounding errors: compare with an
+                // absolute tolerance, since some states are rounding errors.
+                BOOST_TEST(
+                    std::abs(discrete_states(i, j)-regular_states(order, j))
+                    <= 1e-15);
+            }
+        }
+    }
+}
+
 BOOST_AUTO_TEST_CASE(Relaxation, *boost::unit_test::tolerance(1e-9))
 {
     using namespace sycomore::units;
@@ -292,6 +353,83 @@ BOOST_AUTO_TEST_CASE(Refocalization, *boost::unit_test::tolerance(1e-9))
         sycomore::Complex(0.30684831950624042, 0.53147687960193668));
 }
 
+BOOST_AUTO_TEST_CASE(
+    TimeIntervalOperators, *boost::unit_test::tolerance(1e-12))
+{
+    using namespace sycomore::units;
+    sycomore::Species const species(1000*ms, 100*ms, 3*um*um/ms, 10*Hz);
+    
+    sycomore::epg::Discrete fused(species);
+    fused.velocity = 4*cm/s;
+    fused.delta_omega = 20*Hz;
+    auto separate = fused;
+    
+    for(std::size_t i=0; i<5; ++i)
+    {
+        auto const duration = 10*ms;
+        auto const gradient = (i%2 == 0 ? 1 : -2.5)*1*mT/m;
+        
+        fused.apply_pulse(30*deg, 10*deg);
+        fused.apply_time_interval(duration, gradient);
+        
+        separate.apply_pulse(30*deg, 10*deg);
+        separate.relaxation(duration);
+        separate.diffusion(duration, gradient);
+        separate.bulk_motion(duration, gradient);
+        separate.shift(duration, gradient);
+        separate.off_resonance(duration);
+        
+        BOOST_TEST(fused.size() == separate.size());
+        auto && states = fused.states();
+        auto && expected_states = separate.states();
+        for(std::size_t j=0; j<states.size(); ++j)
+        {
+            TEST_COMPLEX_EQUAL(states.data()[j], expected_states.data()[j]);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(Threshold, *boost::unit_test::tolerance(1e-12))
+{
+    using namespace sycomore::units;
+    
+    sycomore::epg::Discrete model(species);
+    for(std::size_t i=0; i<12; ++i)
+    {
+        model.apply_pulse((20+10*i)*deg, (7*i)*deg);
+        model.apply_time_interval(10*ms, (i%3+1)*1*mT/m);
+    }
+    
+    // Without gradient, the time interval does not change the orders: both
+    // models only differ by the culled states.
+    auto culled = model;
+    culled.threshold = 1e-2;
+    model.apply_time_interval(1*ms, 0*mT/m);
+    culled.apply_time_interval(1*ms, 0*mT/m);
+    
+    auto && orders = model.orders();
+    auto && states = model.states();
+    std::size_t j=0;
+    for(std::size_t i=0; i<model.size(); ++i)
+    {
+        auto && state = xt::view(states, i);
+        auto const magnitude =
+            std::norm(state(0)) + std::norm(state(1)) + std::norm(state(2));
+        if(i == 0 || magnitude >= std::pow(culled.threshold, 2))
+        {
+            BOOST_REQUIRE(j < culled.size());
+            BOOST_TEST(culled.orders()[j] == orders[i]);
+            for(std::size_t k=0; k<3; ++k)
+            {
+                TEST_COMPLEX_EQUAL(culled.state(j)(k), state(k));
+            }
+            ++j;
+        }
+    }
+    BOOST_TEST(j < model.size());
+    BOOST_TEST(culled.size() == j);
+}
+
 BOOST_AUTO_TEST_CASE(BulkMotion, *boost::unit_test::tolerance(1e-9))
 {
     using namespace sycomore::units;
@@ -324,3 +462,38 @@ BOOST_AUTO_TEST_CASE(Elapsed)
     model.apply_time_interval(10*ms);
     BOOST_TEST(model.elapsed() == 10*ms);
 }
+
+BOOST_AUTO_TEST_CASE(ShapedPulse, *boost::unit_test::tolerance(1e-12))
+{
+    using namespace sycomore::units;
+    
+    auto const duration = 1*ms;
+    sycomore::HardPulseApproximation const pulse(
+        sycomore::Pulse(40*deg, 10*deg), sycomore::linspace(duration, 11),
+        sycomore::sinc_envelope(duration/4));
+    
+    sycomore::epg::Discrete shaped(species);
+    sycomore::epg::Discrete manual(species);
+    
+    shaped.apply_shaped_pulse(pulse, 2*mT/m);
+    for(auto && hard_pulse: pulse.pulses())
+    {
+        manual.apply_pulse(hard_pulse.angle(), hard_pulse.phase());
+        manual.apply_time_interval(pulse.duration(), 2*mT/m);
+    }
+    
+    auto && orders = shaped.orders();
+    auto && expected_orders = manual.orders();
+    BOOST_TEST(orders.shape() == expected_orders.shape());
+    for(std::size_t i=0; i<orders.size(); ++i)
+    {
+        BOOST_TEST(orders[i] == expected_orders[i]);
+    }
+    
+    auto && states = shaped.states();
+    auto && expected_states = manual.states();
+    for(std::size_t i=0; i<states.size(); ++i)
+    {
+        TEST_COMPLEX_EQUAL(states.data()[i], expected_states.data()[i]);
+    }
+}
@@ -417,6 +417,49 @@ BOOST_AUTO_TEST_CASE(Refocalization, *boost::unit_test::tolerance(1e-9))
         sycomore::Complex(0.30684831950624042, 0.53147687960193668));
 }
 
+BOOST_AUTO_TEST_CASE(Threshold, *boost::unit_test::tolerance(1e-12))
+{
+    using namespace sycomore::units;
+    
+    sycomore::epg::Discrete3D model(species);
+    for(std::size_t i=0; i<8; ++i)
+    {
+        model.apply_pulse((20+10*i)*deg, (7*i)*deg);
+        model.apply_time_interval(
+            10*ms, {(i%2+1)*1*mT/m, (i%3)*1*mT/m, 1*mT/m});
+    }
+    
+    // Without gradient, the time interval does not change the orders: both
+    // models only differ by the culled states.
+    auto culled = model;
+    culled.threshold = 1e-2;
+    model.apply_time_interval(1*ms, {0*mT/m, 0*mT/m, 0*mT/m});
+    culled.apply_time_interval(1*ms, {0*mT/m, 0*mT/m, 0*mT/m});
+    
+    auto && orders = model.orders();
+    auto && culled_orders = culled.orders();
+    auto && states = model.states();
+    std::size_t j=0;
+    for(std::size_t i=0; i<model.size(); ++i)
+    {
+        auto && state = xt::view(states, i);
+        auto const magnitude =
+            std::norm(state(0)) + std::norm(state(1)) + std::norm(state(2));
+        if(i == 0 || magnitude >= std::pow(culled.threshold, 2))
+        {
+            BOOST_REQUIRE(j < culled.size());
+            for(std::size_t k=0; k<3; ++k)
+            {
+                BOOST_TEST(culled_orders(j, k) == orders(i, k));
+                TEST_COMPLEX_EQUAL(culled.state(j)(k), state(k));
+            }
+            ++j;
+        }
+    }
+    BOOST_TEST(j < model.size());
+    BOOST_TEST(culled.size() == j);
+}
+
 BOOST_AUTO_TEST_CASE(Elapsed)
 {
     using namespace sycomore::units;
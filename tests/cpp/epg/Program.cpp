@@ -0,0 +1,496 @@
+#define BOOST_TEST_MODULE epg_Program
+#include <boost/test/unit_test.hpp>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "sycomore/epg/Program.h"
+#include "sycomore/epg/Regular.h"
+#include "sycomore/Sequence.h"
+#include "sycomore/Species.h"
+#include "sycomore/units.h"
+
+#define TEST_COMPLEX_EQUAL(v1, v2) \
+    { \
+        sycomore::Complex const c1(v1), c2(v2); \
+        BOOST_TEST(c1.real() == c2.real()); \
+        BOOST_TEST(c1.imag() == c2.imag()); \
+    }
+
+/// @brief Run the sequence with a program and with direct calls to the model.
+void test_program(sycomore::epg::Regular const & model)
+{
+    using namespace sycomore::units;
+    
+    std::vector<int> const multiples{1, 2, -1, 0, 3};
+    
+    sycomore::Sequence TR;
+    TR.pulse(40*deg, 20*deg);
+    for(auto multiple: multiples)
+    {
+        TR.time_interval(2*ms, multiple*5*mT/m);
+    }
+    TR.echo();
+    
+    sycomore::Sequence sequence;
+    sequence.pulse(90*deg).loop(20, TR).time_interval(10*ms);
+    
+    auto compiled = model;
+    sycomore::epg::Program const program(sequence, compiled);
+    BOOST_TEST(program.size() == sequence.size());
+    BOOST_TEST(program.echoes() == 20);
+    auto const echoes = program.run(compiled);
+    
+    auto direct = model;
+    std::vector<sycomore::Complex> expected_echoes;
+    direct.apply_pulse(90*deg);
+    for(std::size_t i=0; i<20; ++i)
+    {
+        direct.apply_pulse(40*deg, 20*deg);
+        for(auto multiple: multiples)
+        {
+            direct.apply_time_interval(2*ms, multiple*5*mT/m);
+        }
+        expected_echoes.push_back(direct.echo());
+    }
+    direct.apply_time_interval(10*ms);
+    
+    BOOST_TEST(echoes.size() == expected_echoes.size());
+    for(std::size_t i=0; i<echoes.size(); ++i)
+    {
+        TEST_COMPLEX_EQUAL(echoes[i], expected_echoes[i]);
+    }
+    
+    BOOST_TEST(compiled.elapsed().magnitude == direct.elapsed().magnitude);
+    BOOST_TEST(compiled.size() == direct.size());
+    auto && states = compiled.states();
+    auto && expected_states = direct.states();
+    for(std::size_t i=0; i<states.size(); ++i)
+    {
+        TEST_COMPLEX_EQUAL(states.data()[i], expected_states.data()[i]);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(SinglePool, *boost::unit_test::tolerance(1e-12))
+{
+    using namespace sycomore::units;
+    sycomore::Species const species(1000*ms, 100*ms, 3*um*um/ms, 10*Hz);
+    
+    sycomore::epg::Regular model(species, {0,0,1}, 100, 2*ms*5*mT/m);
+    model.velocity = 4*cm/s;
+    model.delta_omega = 20*Hz;
+    model.threshold = 1e-6;
+    test_program(model);
+    
+    model.circular_storage = true;
+    test_program(model);
+}
+
+BOOST_AUTO_TEST_CASE(NoUnitDephasing, *boost::unit_test::tolerance(1e-12))
+{
+    using namespace sycomore::units;
+    sycomore::Species const species(1000*ms, 100*ms);
+    
+    sycomore::epg::Regular model(species);
+    test_program(model);
+}
+
+BOOST_AUTO_TEST_CASE(Exchange, *boost::unit_test::tolerance(1e-12))
+{
+    using namespace sycomore::units;
+    sycomore::Species const species_a(1000*ms, 100*ms, 3*um*um/ms);
+    sycomore::Species const species_b(800*ms, 50*ms, 2*um*um/ms);
+    
+    sycomore::epg::Regular model(
+        species_a, species_b, {0,0,0.8}, {0,0,0.2}, 20*Hz, 15*Hz, 100,
+        2*ms*5*mT/m);
+    test_program(model);
+}
+
+BOOST_AUTO_TEST_CASE(Invalid)
+{
+    using namespace sycomore::units;
+    sycomore::Species const species(1000*ms, 100*ms);
+    
+    sycomore::epg::Regular model(species, {0,0,1}, 100, 2*ms*5*mT/m);
+    
+    // Gradient is not a multiple of the unit gradient
+    BOOST_CHECK_THROW(
+        sycomore::epg::Program(
+            sycomore::Sequence().time_interval(2*ms, 7.5*mT/m), model),
+        std::runtime_error);
+    
+    // Program compiled for a different model
+    sycomore::epg::Program const program(
+        sycomore::Sequence().pulse(90*deg).echo(), model);
+    sycomore::epg::Regular other(species, {0,0,1}, 100, 1*rad/m);
+    BOOST_CHECK_THROW(program.run(other), std::runtime_error);
+    
+    // Same kind and unit dephasing, but different parameters of the operators
+    sycomore::epg::Regular other_T2(
+        sycomore::Species(1000*ms, 50*ms), {0,0,1}, 100, 2*ms*5*mT/m);
+    BOOST_CHECK_THROW(program.run(other_T2), std::runtime_error);
+    
+    sycomore::epg::Regular other_D(
+        sycomore::Species(1000*ms, 100*ms, 1*um*um/ms), {0,0,1}, 100,
+        2*ms*5*mT/m);
+    BOOST_CHECK_THROW(program.run(other_D), std::runtime_error);
+    
+    auto other_delta_omega = model;
+    other_delta_omega.delta_omega = 10*Hz;
+    BOOST_CHECK_THROW(program.run(other_delta_omega), std::runtime_error);
+    
+    auto other_velocity = model;
+    other_velocity.velocity = 1*cm/s;
+    BOOST_CHECK_THROW(program.run(other_velocity), std::runtime_error);
+    
+    // Parameters which are not used by the operators may differ.
+    auto same = model;
+    same.threshold = 1e-3;
+    BOOST_CHECK_NO_THROW(program.run(same));
+    
+    // Pulse of MT models have a saturation.
+    sycomore::epg::Regular MT(
+        species, 1.5*s, {0,0,0.8}, {0,0,0.2}, 20*Hz);
+    BOOST_CHECK_THROW(
+        sycomore::epg::Program(sycomore::Sequence().pulse(90*deg), MT),
+        std::runtime_error);
+}
+
+sycomore::Sequence jacobian_sequence(sycomore::Real B1)
+{
+    using namespace sycomore::units;
+    
+    sycomore::Sequence TR;
+    TR
+        .pulse(B1*40*deg, 20*deg).time_interval(2*ms).echo()
+        .time_interval(2*ms, 5*mT/m).time_interval(2*ms, -10*mT/m).echo()
+        .time_interval(4*ms, 10*mT/m);
+    
+    sycomore::Sequence sequence;
+    sequence.pulse(B1*90*deg).loop(10, TR);
+    return sequence;
+}
+
+BOOST_AUTO_TEST_CASE(Jacobian)
+{
+    using namespace sycomore::units;
+    using sycomore::epg::Program;
+    
+    std::vector<sycomore::Real> const theta{2, 15, 1, 2e-9};
+    std::vector<Program::Parameter> const parameters{
+        Program::R1, Program::R2, Program::B1, Program::D};
+    
+    auto const simulate = [&](std::vector<sycomore::Real> const & theta) {
+        sycomore::Species const species(
+            theta[0]*Hz, theta[1]*Hz, theta[3]*m*m/s, 10*Hz);
+        sycomore::epg::Regular model(species, {0,0,1}, 100, 2*ms*5*mT/m);
+        model.delta_omega = 20*Hz;
+        return model;
+    };
+    
+    auto model = simulate(theta);
+    auto const sequence = jacobian_sequence(theta[2]);
+    Program const program(sequence, model);
+    std::vector<sycomore::Complex> jacobian;
+    auto const echoes = program.run(model, parameters, jacobian);
+    BOOST_TEST(jacobian.size() == echoes.size()*parameters.size());
+    
+    // Same echoes as without derivatives.
+    auto expected_model = simulate(theta);
+    auto const expected_echoes = program.run(expected_model);
+    BOOST_TEST(echoes.size() == expected_echoes.size());
+    for(std::size_t i=0; i<echoes.size(); ++i)
+    {
+        TEST_COMPLEX_EQUAL(echoes[i], expected_echoes[i]);
+    }
+    
+    // Central finite differences
+    for(std::size_t p=0; p<parameters.size(); ++p)
+    {
+        auto const h = 1e-4*theta[p];
+        std::vector<std::vector<sycomore::Complex>> perturbed;
+        for(auto sign: {-1, +1})
+        {
+            auto theta_p = theta;
+            theta_p[p] += sign*h;
+            auto model_p = simulate(theta_p);
+            Program const program_p(jacobian_sequence(theta_p[2]), model_p);
+            perturbed.push_back(program_p.run(model_p));
+        }
+        for(std::size_t i=0; i<echoes.size(); ++i)
+        {
+            auto const derivative = (perturbed[1][i]-perturbed[0][i])/(2*h);
+            auto const & value = jacobian[i*parameters.size()+p];
+            BOOST_TEST(
+                std::abs(value-derivative) <= 1e-6*std::abs(derivative)+1e-12);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(JacobianInvalid)
+{
+    using namespace sycomore::units;
+    sycomore::Species const species_a(1000*ms, 100*ms);
+    sycomore::Species const species_b(800*ms, 50*ms);
+    
+    sycomore::epg::Regular model(
+        species_a, species_b, {0,0,0.8}, {0,0,0.2}, 20*Hz, 15*Hz);
+    sycomore::epg::Program const program(
+        sycomore::Sequence().pulse(90*deg).echo(), model);
+    std::vector<sycomore::Complex> jacobian;
+    BOOST_CHECK_THROW(
+        program.run(model, {sycomore::epg::Program::R1}, jacobian),
+        std::runtime_error);
+}
+
+void test_steady_state(
+    sycomore::epg::Regular const & model, sycomore::Sequence const & TR,
+    std::size_t repetitions)
+{
+    auto steady_state = model;
+    sycomore::epg::Program const program(TR, steady_state);
+    auto const echoes = program.steady_state(steady_state, 1e-10);
+    
+    auto repeated = model;
+    std::vector<sycomore::Complex> expected_echoes;
+    for(std::size_t i=0; i<repetitions; ++i)
+    {
+        expected_echoes = program.run(repeated);
+    }
+    
+    // The model is at the end of one repetition.
+    auto single = model;
+    program.run(single);
+    BOOST_TEST(
+        steady_state.elapsed().magnitude == single.elapsed().magnitude);
+    
+    BOOST_TEST(echoes.size() == expected_echoes.size());
+    for(std::size_t i=0; i<echoes.size(); ++i)
+    {
+        BOOST_TEST(std::abs(echoes[i]-expected_echoes[i]) < 1e-8);
+    }
+    
+    // Low-populated states may have been culled in only one of the models.
+    auto && states = steady_state.states();
+    auto && expected_states = repeated.states();
+    auto const size = std::min(states.size(), expected_states.size());
+    for(std::size_t i=0; i<size; ++i)
+    {
+        BOOST_TEST(std::abs(states.data()[i]-expected_states.data()[i]) < 1e-8);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(SteadyStateSSFP)
+{
+    using namespace sycomore::units;
+    sycomore::Species const species(100*ms, 20*ms, 1*um*um/ms);
+    
+    sycomore::epg::Regular model(species, {0,0,1}, 100, 1*ms*5*mT/m);
+    model.threshold = 1e-12;
+    
+    sycomore::Sequence TR;
+    TR
+        .pulse(30*deg)
+        .time_interval(1*ms, -5*mT/m).echo().time_interval(2*ms, 10*mT/m);
+    test_steady_state(model, TR, 1000);
+}
+
+BOOST_AUTO_TEST_CASE(SteadyStateBalanced)
+{
+    using namespace sycomore::units;
+    sycomore::Species const species(100*ms, 50*ms);
+    
+    sycomore::epg::Regular model(species);
+    model.delta_omega = 10*Hz;
+    
+    sycomore::Sequence TR;
+    TR.pulse(40*deg, 180*deg).time_interval(2*ms).echo().time_interval(2*ms);
+    test_steady_state(model, TR, 1000);
+}
+
+BOOST_AUTO_TEST_CASE(SteadyStateExchange)
+{
+    using namespace sycomore::units;
+    sycomore::Species const species_a(100*ms, 20*ms);
+    sycomore::Species const species_b(80*ms, 10*ms);
+    
+    sycomore::epg::Regular model(
+        species_a, species_b, {0,0,0.8}, {0,0,0.2}, 20*Hz, 15*Hz, 100,
+        1*ms*5*mT/m);
+    model.threshold = 1e-12;
+    
+    sycomore::Sequence TR;
+    TR.pulse(20*deg).time_interval(2*ms).echo().time_interval(1*ms, 5*mT/m);
+    test_steady_state(model, TR, 1000);
+}
+
+BOOST_AUTO_TEST_CASE(SteadyStateNotReached)
+{
+    using namespace sycomore::units;
+    sycomore::Species const species(100*ms, 20*ms);
+    sycomore::epg::Regular model(species);
+    
+    sycomore::Sequence TR;
+    TR.pulse(30*deg).time_interval(1*ms).echo();
+    sycomore::epg::Program const program(TR, model);
+    BOOST_CHECK_THROW(
+        program.steady_state(model, 1e-10, 0), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(SteadyStateNotUnique)
+{
+    using namespace sycomore::units;
+    
+    // Without relaxation nor pulse, all states are fixed points of the block.
+    sycomore::Species const species(0*Hz, 0*Hz);
+    sycomore::epg::Regular model(species, {0,0,1}, 100, 1*ms*5*mT/m);
+    model.apply_pulse(30*deg);
+    model.apply_time_interval(1*ms, 5*mT/m);
+    model.apply_pulse(30*deg);
+    model.threshold = 1e-4;
+    auto const original = model;
+    
+    sycomore::Sequence TR;
+    TR.time_interval(1*ms).echo();
+    sycomore::epg::Program const program(TR, model);
+    BOOST_CHECK_EXCEPTION(
+        program.steady_state(model), std::runtime_error,
+        [](std::runtime_error const & e) {
+            return std::string(e.what()) == "Steady state is not unique"; });
+    
+    // The model is not modified by the failed solver.
+    BOOST_TEST(model.threshold == original.threshold);
+    BOOST_TEST(model.elapsed().magnitude == original.elapsed().magnitude);
+    BOOST_TEST(model.size() == original.size());
+    auto && states = model.states();
+    auto && expected_states = original.states();
+    BOOST_TEST(states.shape() == expected_states.shape());
+    for(std::size_t i=0; i<states.size(); ++i)
+    {
+        TEST_COMPLEX_EQUAL(states.data()[i], expected_states.data()[i]);
+    }
+}
+
+sycomore::Sequence gradient_sequence(
+    std::vector<sycomore::Real> const & angles,
+    std::vector<sycomore::Real> const & phases)
+{
+    using namespace sycomore::units;
+    
+    sycomore::Sequence sequence;
+    for(std::size_t i=0; i<angles.size(); ++i)
+    {
+        sequence
+            .pulse(angles[i]*rad, phases[i]*rad).time_interval(2*ms).echo()
+            .time_interval(2*ms, (i%3 == 0 ? -5 : 10)*mT/m);
+    }
+    return sequence;
+}
+
+void test_gradient(sycomore::epg::Regular const & model)
+{
+    using namespace sycomore::units;
+    using sycomore::Complex;
+    using sycomore::Real;
+    
+    std::vector<Real> angles, phases;
+    for(std::size_t i=0; i<20; ++i)
+    {
+        angles.push_back(0.2+0.05*i);
+        phases.push_back(0.1*i*i);
+    }
+    
+    // Squared distance to a target signal
+    auto const target = [](std::size_t i) { return Complex(0.1, 0.01*i); };
+    auto const loss = [&](std::vector<Complex> const & echoes) {
+        Real result = 0;
+        for(std::size_t i=0; i<echoes.size(); ++i)
+        {
+            result += std::norm(echoes[i]-target(i));
+        }
+        return result;
+    };
+    auto const loss_gradient = [&](std::vector<Complex> const & echoes) {
+        std::vector<Complex> result(echoes.size());
+        for(std::size_t i=0; i<echoes.size(); ++i)
+        {
+            result[i] = 2.*(echoes[i]-target(i));
+        }
+        return result;
+    };
+    auto const simulate = [&](
+        std::vector<Real> const & angles, std::vector<Real> const & phases) {
+        auto copy = model;
+        sycomore::epg::Program const program(
+            gradient_sequence(angles, phases), copy);
+        return loss(program.run(copy));
+    };
+    
+    for(std::size_t interval: {0, 1, 7, 1000})
+    {
+        auto copy = model;
+        sycomore::epg::Program const program(
+            gradient_sequence(angles, phases), copy);
+        std::vector<Real> angles_gradient, phases_gradient;
+        auto const echoes = program.gradient(
+            copy, loss_gradient, angles_gradient, phases_gradient, interval);
+        BOOST_TEST(loss(echoes) == simulate(angles, phases));
+        BOOST_TEST(angles_gradient.size() == angles.size());
+        BOOST_TEST(phases_gradient.size() == phases.size());
+        
+        Real const h = 1e-6;
+        for(std::size_t i=0; i<angles.size(); ++i)
+        {
+            for(auto * parameters: {&angles, &phases})
+            {
+                auto const & gradient =
+                    (parameters == &angles) ? angles_gradient : phases_gradient;
+                auto const value = (*parameters)[i];
+                (*parameters)[i] = value+h;
+                auto const plus = simulate(angles, phases);
+                (*parameters)[i] = value-h;
+                auto const minus = simulate(angles, phases);
+                (*parameters)[i] = value;
+                
+                auto const derivative = (plus-minus)/(2*h);
+                BOOST_TEST(
+                    std::abs(gradient[i]-derivative)
+                    <= 1e-6*std::abs(derivative)+1e-8);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(Gradient)
+{
+    using namespace sycomore::units;
+    sycomore::Species const species(100*ms, 20*ms, 3*um*um/ms, 10*Hz);
+    
+    sycomore::epg::Regular model(species, {0,0,1}, 100, 2*ms*5*mT/m);
+    model.velocity = 4*cm/s;
+    model.delta_omega = 20*Hz;
+    test_gradient(model);
+    
+    model.circular_storage = true;
+    test_gradient(model);
+}
+
+BOOST_AUTO_TEST_CASE(GradientInvalid)
+{
+    using namespace sycomore::units;
+    sycomore::Species const species(100*ms, 20*ms);
+    sycomore::epg::Regular model(species);
+    sycomore::epg::Program const program(
+        sycomore::Sequence().pulse(90*deg).echo(), model);
+    
+    std::vector<sycomore::Real> angles, phases;
+    BOOST_CHECK_THROW(
+        program.gradient(
+            model,
+            [](std::vector<sycomore::Complex> const &) {
+                return std::vector<sycomore::Complex>(2); },
+            angles, phases),
+        std::runtime_error);
+}
@@ -1,9 +1,12 @@
 #define BOOST_TEST_MODULE epg_Regular
 #include <boost/test/unit_test.hpp>
 
+#include <vector>
+
 #include <xtensor/xview.hpp>
 
 #include "sycomore/epg/Regular.h"
+#include "sycomore/HardPulseApproximation.h"
 #include "sycomore/Species.h"
 #include "sycomore/units.h"
 
@@ -269,6 +272,259 @@ BOOST_AUTO_TEST_CASE(UnitGradient, *boost::unit_test::tolerance(1e-9))
         model.apply_time_interval(12*ms, 2*mT/m), std::runtime_error);
 }
 
+BOOST_AUTO_TEST_CASE(MultipleShift, *boost::unit_test::tolerance(1e-12))
+{
+    using namespace sycomore::units;
+    sycomore::Species const species(1000*ms, 100*ms);
+    
+    // Small initial size to force re-allocations.
+    sycomore::epg::Regular model(species, {0,0,1}, 2, 10*mT/m*ms);
+    sycomore::epg::Regular expected(species, {0,0,1}, 2, 10*mT/m*ms);
+    
+    for(int n: {3, -1, 5, -7, 2, -12, 1})
+    {
+        model.apply_pulse(47*deg, 23*deg);
+        expected.apply_pulse(47*deg, 23*deg);
+        
+        model.shift(10*ms, n*1*mT/m);
+        for(int i=0; i<std::abs(n); ++i)
+        {
+            if(n > 0)
+            {
+                expected.shift();
+            }
+            else
+            {
+                expected.shift(10*ms, -1*mT/m);
+            }
+        }
+        
+        BOOST_TEST(model.size() == expected.size());
+        auto && states = model.states();
+        auto && expected_states = expected.states();
+        for(std::size_t i=0; i<states.size(); ++i)
+        {
+            TEST_COMPLEX_EQUAL(states.data()[i], expected_states.data()[i]);
+        }
+    }
+}
+
+void test_circular_storage(
+    sycomore::epg::Regular linear, sycomore::epg::Regular circular,
+    bool magnetization_transfer=false)
+{
+    using namespace sycomore::units;
+    
+    circular.circular_storage = true;
+    
+    std::vector<int> const multiples{1, 1, 3, -2, 0, 1, -5, 7, 1, 1, -1, 2};
+    for(std::size_t i=0; i<multiples.size(); ++i)
+    {
+        // Go back to linear storage for some time intervals
+        circular.circular_storage = (i<8 || i>9);
+        
+        auto const angle = (30.+10*i)*deg;
+        auto const phase = (5.*i)*deg;
+        auto const duration = 10*ms;
+        auto const gradient = multiples[i]*1*mT/m;
+        
+        for(auto * model: {&linear, &circular})
+        {
+            if(magnetization_transfer)
+            {
+                model->apply_pulse(angle, phase, 0.1);
+            }
+            else
+            {
+                model->apply_pulse(angle, phase);
+            }
+            model->apply_time_interval(duration, gradient);
+        }
+        
+        BOOST_TEST(circular.size() == linear.size());
+        auto && states = circular.states();
+        auto && expected_states = linear.states();
+        BOOST_TEST(states.shape() == expected_states.shape());
+        for(std::size_t j=0; j<states.size(); ++j)
+        {
+            TEST_COMPLEX_EQUAL(states.data()[j], expected_states.data()[j]);
+        }
+        for(std::size_t pool=0; pool<linear.pools(); ++pool)
+        {
+            TEST_COMPLEX_EQUAL(circular.echo(pool), linear.echo(pool));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(CircularStorage, *boost::unit_test::tolerance(1e-12))
+{
+    using namespace sycomore::units;
+    sycomore::Species const species(1000*ms, 100*ms, 3*um*um/ms, 10*Hz);
+    
+    // Small initial size to force re-allocations.
+    sycomore::epg::Regular model(species, {0,0,1}, 3, 10*mT/m*ms);
+    model.velocity = 4*cm/s;
+    model.delta_omega = 20*Hz;
+    model.threshold = 1e-4;
+    
+    test_circular_storage(model, model);
+}
+
+BOOST_AUTO_TEST_CASE(
+    CircularStorageExchange, *boost::unit_test::tolerance(1e-12))
+{
+    using namespace sycomore::units;
+    sycomore::Species const species_a(1000*ms, 100*ms, 3*um*um/ms);
+    sycomore::Species const species_b(800*ms, 50*ms, 2*um*um/ms);
+    
+    sycomore::epg::Regular model(
+        species_a, species_b, {0,0,0.8}, {0,0,0.2}, 20*Hz, 15*Hz, 3, 
+        10*mT/m*ms);
+    
+    test_circular_storage(model, model);
+}
+
+BOOST_AUTO_TEST_CASE(
+    CircularStorageMagnetizationTransfer, *boost::unit_test::tolerance(1e-12))
+{
+    using namespace sycomore::units;
+    sycomore::Species const species_a(1000*ms, 100*ms, 3*um*um/ms);
+    
+    sycomore::epg::Regular model(
+        species_a, 1.5*s, {0,0,0.8}, {0,0,0.2}, 20*Hz, 3, 10*mT/m*ms);
+    
+    test_circular_storage(model, model, true);
+}
+
+BOOST_AUTO_TEST_CASE(StatesViews, *boost::unit_test::tolerance(1e-12))
+{
+    using namespace sycomore::units;
+    sycomore::Species const species_a(1000*ms, 100*ms, 3*um*um/ms);
+    sycomore::Species const species_b(800*ms, 50*ms, 2*um*um/ms);
+    
+    sycomore::epg::Regular model(
+        species_a, species_b, {0,0,0.8}, {0,0,0.2}, 20*Hz, 15*Hz, 3,
+        10*mT/m*ms);
+    model.circular_storage = true;
+    
+    // Shifts in both directions yield both wrapping and contiguous states in
+    // the circular storage.
+    for(int multiple: {1, 2, -1, 3, -2, -2, 1})
+    {
+        model.apply_pulse(40*deg, 10*deg, 30*deg, 20*deg);
+        model.apply_time_interval(10*ms, multiple*1*mT/m);
+        
+        auto const expected = model.states();
+        for(std::size_t pool=0; pool<model.pools(); ++pool)
+        {
+            auto && F = model.F_view(pool);
+            auto && F_star = model.F_star_view(pool);
+            auto && Z = model.Z_view(pool);
+            BOOST_TEST(F.size() == model.size());
+            BOOST_TEST(F_star.size() == model.size());
+            BOOST_TEST(Z.size() == model.size());
+            for(std::size_t order=0; order<model.size(); ++order)
+            {
+                TEST_COMPLEX_EQUAL(F(order), expected(order, pool, 0));
+                TEST_COMPLEX_EQUAL(F_star(order), expected(order, pool, 1));
+                TEST_COMPLEX_EQUAL(Z(order), expected(order, pool, 2));
+            }
+        }
+        
+        // Creating the views does not change the states.
+        auto const states = model.states();
+        for(std::size_t i=0; i<states.size(); ++i)
+        {
+            TEST_COMPLEX_EQUAL(states.data()[i], expected.data()[i]);
+        }
+    }
+    
+    BOOST_CHECK_THROW(model.F_view(2), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(
+    TimeIntervalOperators, *boost::unit_test::tolerance(1e-12))
+{
+    using namespace sycomore::units;
+    sycomore::Species const species_a(1000*ms, 100*ms, 3*um*um/ms, 10*Hz);
+    sycomore::Species const species_b(800*ms, 50*ms, 2*um*um/ms);
+    
+    std::vector<sycomore::epg::Regular> models{
+        {species_a, {0,0,1}, 100, 10*mT/m*ms},
+        {species_a, species_b, {0,0,0.8}, {0,0,0.2}, 20*Hz, 15*Hz, 100, 
+            10*mT/m*ms}};
+    for(auto && fused: models)
+    {
+        fused.velocity = 4*cm/s;
+        fused.delta_omega = 20*Hz;
+        auto separate = fused;
+        
+        for(std::size_t i=0; i<5; ++i)
+        {
+            auto const duration = 10*ms;
+            auto const gradient = (i%2 == 0 ? 1 : -2)*1*mT/m;
+            
+            fused.apply_pulse(30*deg, 10*deg);
+            fused.apply_time_interval(duration, gradient);
+            
+            separate.apply_pulse(30*deg, 10*deg);
+            separate.relaxation(duration);
+            separate.diffusion(duration, gradient);
+            separate.bulk_motion(duration, gradient);
+            separate.shift(duration, gradient);
+            separate.off_resonance(duration);
+            
+            BOOST_TEST(fused.size() == separate.size());
+            auto && states = fused.states();
+            auto && expected_states = separate.states();
+            for(std::size_t j=0; j<states.size(); ++j)
+            {
+                TEST_COMPLEX_EQUAL(
+                    states.data()[j], expected_states.data()[j]);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(OperatorCache, *boost::unit_test::tolerance(1e-12))
+{
+    using namespace sycomore::units;
+    sycomore::Species const species(1000*ms, 100*ms, 0*um*um/ms, 10*Hz);
+    
+    sycomore::epg::Regular cached(species);
+    sycomore::epg::Regular small(species);
+    small.set_operator_cache_capacity(1);
+    
+    // Alternating pulses defeat a single-item cache.
+    for(std::size_t i=0; i<10; ++i)
+    {
+        for(auto * model: {&cached, &small})
+        {
+            model->apply_pulse((i%2 == 0 ? 30 : 60)*deg, 10*deg);
+            model->apply_time_interval(10*ms);
+        }
+    }
+    
+    // Two pulses, one relaxation, and one phase accumulation
+    BOOST_TEST(cached.operator_cache_misses() == 4);
+    BOOST_TEST(cached.operator_cache_hits() == 26);
+    BOOST_TEST(small.operator_cache_misses() == 12);
+    BOOST_TEST(small.operator_cache_hits() == 18);
+    
+    auto && states = cached.states();
+    auto && expected_states = small.states();
+    for(std::size_t i=0; i<states.size(); ++i)
+    {
+        TEST_COMPLEX_EQUAL(states.data()[i], expected_states.data()[i]);
+    }
+    
+    // Changing the species invalidates its operators.
+    cached.set_species(
+        sycomore::Species(500*ms, 50*ms, 0*um*um/ms, 10*Hz));
+    cached.apply_time_interval(10*ms);
+    BOOST_TEST(cached.operator_cache_misses() == 5);
+}
+
 BOOST_AUTO_TEST_CASE(BulkMotion, *boost::unit_test::tolerance(1e-9))
 {
     using namespace sycomore::units;
@@ -299,3 +555,74 @@ BOOST_AUTO_TEST_CASE(Elapsed)
     model.apply_time_interval(10*ms);
     BOOST_TEST(model.elapsed() == 10*ms);
 }
+
+BOOST_AUTO_TEST_CASE(ShapedPulse, *boost::unit_test::tolerance(1e-12))
+{
+    using namespace sycomore::units;
+    sycomore::Species const species(1000*ms, 100*ms, 1*um*um/ms, 10*Hz);
+    
+    auto const duration = 1*ms;
+    sycomore::HardPulseApproximation const pulse(
+        sycomore::Pulse(40*deg, 10*deg), sycomore::linspace(duration, 11),
+        sycomore::sinc_envelope(duration/4));
+    
+    sycomore::epg::Regular shaped(species, {0,0,1}, 100, 0.2*mT/m*ms);
+    sycomore::epg::Regular manual(species, {0,0,1}, 100, 0.2*mT/m*ms);
+    
+    shaped.apply_shaped_pulse(pulse, 2*mT/m);
+    for(auto && hard_pulse: pulse.pulses())
+    {
+        manual.apply_pulse(hard_pulse.angle(), hard_pulse.phase());
+        manual.apply_time_interval(pulse.duration(), 2*mT/m);
+    }
+    
+    // The shaped pulse shifts the states in circular storage, but does not
+    // change the setting of the model.
+    BOOST_TEST(!shaped.circular_storage);
+    
+    BOOST_TEST(shaped.size() == manual.size());
+    BOOST_TEST(shaped.elapsed().magnitude == manual.elapsed().magnitude);
+    auto && states = shaped.states();
+    auto && expected_states = manual.states();
+    for(std::size_t i=0; i<states.size(); ++i)
+    {
+        TEST_COMPLEX_EQUAL(states.data()[i], expected_states.data()[i]);
+    }
+    
+    // Subsequent linear shifts are not affected.
+    shaped.apply_time_interval(10*ms, -3*mT/m);
+    manual.apply_time_interval(10*ms, -3*mT/m);
+    BOOST_TEST(shaped.size() == manual.size());
+    auto && shifted_states = shaped.states();
+    auto && expected_shifted_states = manual.states();
+    for(std::size_t i=0; i<shifted_states.size(); ++i)
+    {
+        TEST_COMPLEX_EQUAL(
+            shifted_states.data()[i], expected_shifted_states.data()[i]);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ShapedPulseMagnetizationTransfer)
+{
+    using namespace sycomore::units;
+    sycomore::Species const species(1000*ms, 100*ms);
+    
+    sycomore::HardPulseApproximation const pulse(
+        sycomore::Pulse(40*deg, 10*deg), sycomore::linspace(1*ms, 11),
+        sycomore::sinc_envelope(0.25*ms));
+    
+    sycomore::epg::Regular model(
+        species, 1*Hz, {0,0,0.8}, {0,0,0.2}, 4.45*Hz, 100, 0.2*mT/m*ms);
+    auto const initial_states = model.states();
+    
+    // The model is rejected before any modification.
+    BOOST_CHECK_THROW(
+        model.apply_shaped_pulse(pulse, 2*mT/m), std::runtime_error);
+    BOOST_TEST(model.elapsed().magnitude == 0);
+    BOOST_TEST(model.size() == 1);
+    auto const states = model.states();
+    for(std::size_t i=0; i<states.size(); ++i)
+    {
+        TEST_COMPLEX_EQUAL(states.data()[i], initial_states.data()[i]);
+    }
+}
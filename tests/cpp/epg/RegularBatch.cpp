@@ -0,0 +1,535 @@
+#define BOOST_TEST_MODULE epg_RegularBatch
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <complex>
+#include <stdexcept>
+#include <vector>
+
+#include "sycomore/epg/Regular.h"
+#include "sycomore/epg/RegularBatch.h"
+#include "sycomore/Species.h"
+#include "sycomore/units.h"
+
+#define TEST_COMPLEX_EQUAL(v1, v2) \
+    { \
+        sycomore::Complex const c1(v1), c2(v2); \
+        BOOST_TEST(c1.real() == c2.real()); \
+        BOOST_TEST(c1.imag() == c2.imag()); \
+    }
+
+// Compare a batch with reference models. A null tolerance uses the tolerance
+// of the test case on each real and imaginary part, a positive tolerance is an
+// absolute tolerance on the complex values.
+void test_batch(
+    sycomore::epg::RegularBatch const & batch,
+    std::vector<sycomore::epg::Regular> const & models,
+    sycomore::Real tolerance=0)
+{
+    BOOST_TEST(batch.models() == models.size());
+    
+    auto && echo = batch.echo();
+    for(std::size_t m=0; m<models.size(); ++m)
+    {
+        auto && model = models[m];
+        
+        BOOST_TEST(batch.size() == model.size());
+        auto && states = batch.states(m);
+        auto && expected_states = model.states();
+        BOOST_TEST(states.shape() == expected_states.shape());
+        for(std::size_t i=0; i<states.size(); ++i)
+        {
+            if(tolerance == 0)
+            {
+                TEST_COMPLEX_EQUAL(
+                    states.data()[i], expected_states.data()[i]);
+            }
+            else
+            {
+                BOOST_TEST(
+                    std::abs(states.data()[i]-expected_states.data()[i])
+                    <= tolerance);
+            }
+        }
+        
+        if(tolerance == 0)
+        {
+            TEST_COMPLEX_EQUAL(echo[m], model.echo());
+        }
+        else
+        {
+            BOOST_TEST(std::abs(echo[m]-model.echo()) <= tolerance);
+        }
+    }
+}
+
+std::vector<sycomore::Species> get_species()
+{
+    using namespace sycomore::units;
+    
+    // Enough models to use both the SIMD and the padding parts of the batch
+    std::vector<sycomore::Species> species;
+    for(std::size_t i=0; i<11; ++i)
+    {
+        species.emplace_back(
+            (500+100*i)*ms, (50+10*i)*ms, (1+0.25*i)*um*um/ms,
+            (10.*i)*Hz);
+    }
+    return species;
+}
+
+BOOST_AUTO_TEST_CASE(Empty)
+{
+    auto const species = get_species();
+    
+    sycomore::epg::RegularBatch batch(species);
+    std::vector<sycomore::epg::Regular> models;
+    for(auto && item: species)
+    {
+        models.emplace_back(item);
+    }
+    
+    test_batch(batch, models);
+}
+
+BOOST_AUTO_TEST_CASE(Pulse, *boost::unit_test::tolerance(1e-9))
+{
+    using namespace sycomore::units;
+    
+    auto const species = get_species();
+    std::vector<sycomore::Real> B1;
+    for(std::size_t i=0; i<species.size(); ++i)
+    {
+        B1.push_back(0.8+0.04*i);
+    }
+    
+    sycomore::epg::RegularBatch batch(species);
+    batch.set_B1(B1);
+    batch.apply_pulse(47*deg, 23*deg);
+    
+    std::vector<sycomore::epg::Regular> models;
+    for(std::size_t i=0; i<species.size(); ++i)
+    {
+        models.emplace_back(species[i]);
+        models.back().apply_pulse(B1[i]*47*deg, 23*deg);
+    }
+    
+    test_batch(batch, models);
+}
+
+BOOST_AUTO_TEST_CASE(TimeInterval, *boost::unit_test::tolerance(1e-9))
+{
+    using namespace sycomore::units;
+    
+    auto const species = get_species();
+    
+    sycomore::epg::RegularBatch batch(
+        species, {0,0,1}, 100, 1*rad/(1*mm));
+    batch.delta_omega = 5*Hz;
+    
+    std::vector<sycomore::epg::Regular> models;
+    for(auto && item: species)
+    {
+        models.emplace_back(
+            item, sycomore::Vector3R{0,0,1}, 100, 1*rad/(1*mm));
+        models.back().delta_omega = 5*Hz;
+    }
+    
+    // Unit, multiple, and negative gradients, and gradient-free interval.
+    std::vector<int> const multiples{1, 1, 3, -2, 0, 1};
+    for(std::size_t i=0; i<multiples.size(); ++i)
+    {
+        auto const angle = (30.+10*i)*deg;
+        auto const phase = (5.*i)*deg;
+        auto const duration = 10*ms;
+        auto const gradient =
+            multiples[i]*1*rad/(1*mm)/(sycomore::gamma*duration);
+        
+        batch.apply_pulse(angle, phase);
+        batch.apply_time_interval(duration, gradient);
+        for(auto && model: models)
+        {
+            model.apply_pulse(angle, phase);
+            model.apply_time_interval(duration, gradient);
+        }
+        
+        test_batch(batch, models);
+    }
+    
+    BOOST_TEST(batch.elapsed().magnitude == models[0].elapsed().magnitude);
+}
+
+BOOST_AUTO_TEST_CASE(Threshold)
+{
+    using namespace sycomore::units;
+    
+    auto const species = get_species();
+    
+    sycomore::epg::RegularBatch batch(species, {0,0,1}, 100, 1*rad/(1*mm));
+    batch.threshold = 1e-3;
+    
+    // Reference models without threshold, to check that only low-populated
+    // states are culled and that the other states are not modified.
+    std::vector<sycomore::epg::Regular> models;
+    for(auto && item: species)
+    {
+        models.emplace_back(
+            item, sycomore::Vector3R{0,0,1}, 100, 1*rad/(1*mm));
+    }
+    
+    auto const duration = 100*ms;
+    auto const gradient = 1*rad/(1*mm)/(sycomore::gamma*duration);
+    for(std::size_t i=0; i<20; ++i)
+    {
+        batch.apply_pulse(20*deg);
+        batch.apply_time_interval(duration, gradient);
+        for(auto && model: models)
+        {
+            model.apply_pulse(20*deg);
+            model.apply_time_interval(duration, gradient);
+        }
+        
+        // Without threshold, the batch would have i+2 states
+        BOOST_TEST(batch.size() <= models[0].size());
+        
+        for(std::size_t m=0; m<models.size(); ++m)
+        {
+            auto const states = batch.states(m);
+            auto const expected = models[m].states();
+            
+            // Kept states match the reference, up to the effect of the
+            // culled states, which are below the threshold.
+            for(std::size_t order=0; order<batch.size(); ++order)
+            {
+                for(std::size_t j=0; j<3; ++j)
+                {
+                    BOOST_TEST(
+                        std::abs(states(order, j)-expected(order, j))
+                        < batch.threshold);
+                }
+            }
+            
+            // Culled states are low-populated in the reference.
+            for(
+                std::size_t order=batch.size(); order<models[m].size();
+                ++order)
+            {
+                sycomore::Real magnitude_squared = 0;
+                for(std::size_t j=0; j<3; ++j)
+                {
+                    magnitude_squared += std::norm(expected(order, j));
+                }
+                BOOST_TEST(std::sqrt(magnitude_squared) < batch.threshold);
+            }
+        }
+    }
+    
+    BOOST_TEST(batch.size() < models[0].size());
+    BOOST_TEST(batch.size() > 1);
+}
+
+BOOST_AUTO_TEST_CASE(Planar, *boost::unit_test::tolerance(1e-9))
+{
+    using namespace sycomore::units;
+    using Batch = sycomore::epg::RegularBatch;
+    
+    auto const species = get_species();
+    std::vector<sycomore::Real> B1;
+    for(std::size_t i=0; i<species.size(); ++i)
+    {
+        B1.push_back(0.8+0.04*i);
+    }
+    
+    Batch batch(
+        species, {0.1,0.2,0.9}, 100, 1*rad/(1*mm), 1e-5, Batch::Planar);
+    BOOST_TEST(batch.layout() == Batch::Planar);
+    batch.set_B1(B1);
+    batch.delta_omega = 5*Hz;
+    batch.threshold = 1e-4;
+    
+    std::vector<sycomore::epg::Regular> models;
+    for(std::size_t i=0; i<species.size(); ++i)
+    {
+        models.emplace_back(
+            species[i], sycomore::Vector3R{0.1,0.2,0.9}, 100, 1*rad/(1*mm));
+        models.back().delta_omega = 5*Hz;
+    }
+    test_batch(batch, models);
+    
+    // Culling depends on all models: compare with an interleaved batch.
+    Batch interleaved(species, {0.1,0.2,0.9}, 100, 1*rad/(1*mm));
+    interleaved.set_B1(B1);
+    interleaved.delta_omega = 5*Hz;
+    interleaved.threshold = 1e-4;
+    
+    std::vector<int> const multiples{1, 1, 3, -2, 0, 1, -4};
+    for(std::size_t i=0; i<multiples.size(); ++i)
+    {
+        auto const angle = (30.+10*i)*deg;
+        auto const phase = (5.*i)*deg;
+        auto const duration = 10*ms;
+        auto const gradient =
+            multiples[i]*1*rad/(1*mm)/(sycomore::gamma*duration);
+        
+        for(auto * item: {&batch, &interleaved})
+        {
+            item->apply_pulse(angle, phase);
+            item->apply_time_interval(duration, gradient);
+        }
+        
+        BOOST_TEST(batch.size() == interleaved.size());
+        auto && echo = batch.echo();
+        auto && expected_echo = interleaved.echo();
+        for(std::size_t m=0; m<species.size(); ++m)
+        {
+            TEST_COMPLEX_EQUAL(echo[m], expected_echo[m]);
+            
+            auto && states = batch.states(m);
+            auto && expected_states = interleaved.states(m);
+            BOOST_TEST(states.shape() == expected_states.shape());
+            for(std::size_t j=0; j<states.size(); ++j)
+            {
+                TEST_COMPLEX_EQUAL(
+                    states.data()[j], expected_states.data()[j]);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(SinglePrecision)
+{
+    using namespace sycomore::units;
+    using Batch = sycomore::epg::RegularBatch;
+    
+    auto const species = get_species();
+    std::vector<sycomore::Real> B1;
+    for(std::size_t i=0; i<species.size(); ++i)
+    {
+        B1.push_back(0.8+0.04*i);
+    }
+    
+    BOOST_CHECK_THROW(
+        Batch(
+            species, {0,0,1}, 100, 1*rad/(1*mm), 1e-5, Batch::Interleaved,
+            Batch::Single),
+        std::runtime_error);
+    
+    Batch single(
+        species, {0.1,0.2,0.9}, 100, 1*rad/(1*mm), 1e-5, Batch::Planar,
+        Batch::Single);
+    BOOST_TEST(single.precision() == Batch::Single);
+    Batch double_(
+        species, {0.1,0.2,0.9}, 100, 1*rad/(1*mm), 1e-5, Batch::Planar);
+    BOOST_TEST(double_.precision() == Batch::Double);
+    for(auto * item: {&single, &double_})
+    {
+        item->set_B1(B1);
+        item->delta_omega = 5*Hz;
+    }
+    
+    // Without culling, both batches have the same number of states, and the
+    // single-precision states have an absolute error close to the float
+    // epsilon (the magnetization is at most 1).
+    std::vector<int> const multiples{1, 1, 3, -2, 0, 1, -4};
+    for(std::size_t i=0; i<multiples.size(); ++i)
+    {
+        auto const angle = (30.+10*i)*deg;
+        auto const phase = (5.*i)*deg;
+        auto const duration = 10*ms;
+        auto const gradient =
+            multiples[i]*1*rad/(1*mm)/(sycomore::gamma*duration);
+        
+        for(auto * item: {&single, &double_})
+        {
+            item->apply_pulse(angle, phase);
+            item->apply_time_interval(duration, gradient);
+        }
+        
+        BOOST_TEST(single.size() == double_.size());
+        auto && echo = single.echo();
+        auto && expected_echo = double_.echo();
+        for(std::size_t m=0; m<species.size(); ++m)
+        {
+            BOOST_TEST(std::abs(echo[m]-expected_echo[m]) <= 1e-5);
+            
+            auto && states = single.states(m);
+            auto && expected_states = double_.states(m);
+            BOOST_TEST(states.shape() == expected_states.shape());
+            for(std::size_t j=0; j<states.size(); ++j)
+            {
+                BOOST_TEST(
+                    std::abs(states.data()[j]-expected_states.data()[j])
+                    <= 1e-5);
+            }
+        }
+    }
+}
+
+// Absolute tolerance of the single-precision batches: the magnetization is at
+// most 1, and the errors of a few operators accumulate above the float
+// epsilon.
+sycomore::Real const single_tolerance = 1e-5;
+
+BOOST_AUTO_TEST_CASE(SinglePrecisionPulse)
+{
+    using namespace sycomore::units;
+    using Batch = sycomore::epg::RegularBatch;
+    
+    auto const species = get_species();
+    std::vector<sycomore::Real> B1;
+    for(std::size_t i=0; i<species.size(); ++i)
+    {
+        B1.push_back(0.8+0.04*i);
+    }
+    
+    Batch batch(
+        species, {0,0,1}, 100, 0*rad/m, 1e-5, Batch::Planar, Batch::Single);
+    batch.set_B1(B1);
+    batch.apply_pulse(47*deg, 23*deg);
+    
+    std::vector<sycomore::epg::Regular> models;
+    for(std::size_t i=0; i<species.size(); ++i)
+    {
+        models.emplace_back(species[i]);
+        models.back().apply_pulse(B1[i]*47*deg, 23*deg);
+    }
+    
+    test_batch(batch, models, single_tolerance);
+}
+
+BOOST_AUTO_TEST_CASE(SinglePrecisionTimeInterval)
+{
+    using namespace sycomore::units;
+    using Batch = sycomore::epg::RegularBatch;
+    
+    auto const species = get_species();
+    std::vector<sycomore::Real> B1;
+    for(std::size_t i=0; i<species.size(); ++i)
+    {
+        B1.push_back(0.8+0.04*i);
+    }
+    
+    Batch batch(
+        species, {0,0,1}, 100, 1*rad/(1*mm), 1e-5, Batch::Planar,
+        Batch::Single);
+    batch.set_B1(B1);
+    batch.delta_omega = 5*Hz;
+    
+    std::vector<sycomore::epg::Regular> models;
+    for(auto && item: species)
+    {
+        models.emplace_back(
+            item, sycomore::Vector3R{0,0,1}, 100, 1*rad/(1*mm));
+        models.back().delta_omega = 5*Hz;
+    }
+    
+    // Unit, multiple, and negative gradients, and gradient-free interval:
+    // relaxation, diffusion and off-resonance are applied by the combined
+    // time interval operator.
+    std::vector<int> const multiples{1, 1, 3, -2, 0, 1};
+    for(std::size_t i=0; i<multiples.size(); ++i)
+    {
+        auto const angle = (30.+10*i)*deg;
+        auto const phase = (5.*i)*deg;
+        auto const duration = 10*ms;
+        auto const gradient =
+            multiples[i]*1*rad/(1*mm)/(sycomore::gamma*duration);
+        
+        batch.apply_pulse(angle, phase);
+        batch.apply_time_interval(duration, gradient);
+        for(std::size_t m=0; m<models.size(); ++m)
+        {
+            models[m].apply_pulse(B1[m]*angle, phase);
+            models[m].apply_time_interval(duration, gradient);
+        }
+        
+        test_batch(batch, models, single_tolerance);
+    }
+    
+    // Separate operators
+    auto const duration = 5*ms;
+    auto const gradient = 2*rad/(1*mm)/(sycomore::gamma*duration);
+    batch.apply_pulse(60*deg, 10*deg);
+    batch.relaxation(duration);
+    batch.diffusion(duration, gradient);
+    batch.off_resonance(duration);
+    batch.shift(duration, gradient);
+    for(std::size_t m=0; m<models.size(); ++m)
+    {
+        models[m].apply_pulse(B1[m]*60*deg, 10*deg);
+        models[m].relaxation(duration);
+        models[m].diffusion(duration, gradient);
+        models[m].off_resonance(duration);
+        models[m].shift(duration, gradient);
+    }
+    test_batch(batch, models, single_tolerance);
+}
+
+BOOST_AUTO_TEST_CASE(SinglePrecisionThreshold)
+{
+    using namespace sycomore::units;
+    using Batch = sycomore::epg::RegularBatch;
+    
+    auto const species = get_species();
+    
+    Batch batch(
+        species, {0,0,1}, 100, 1*rad/(1*mm), 1e-5, Batch::Planar,
+        Batch::Single);
+    batch.threshold = 1e-3;
+    
+    // Reference models without threshold, see the Threshold test case.
+    std::vector<sycomore::epg::Regular> models;
+    for(auto && item: species)
+    {
+        models.emplace_back(
+            item, sycomore::Vector3R{0,0,1}, 100, 1*rad/(1*mm));
+    }
+    
+    auto const duration = 100*ms;
+    auto const gradient = 1*rad/(1*mm)/(sycomore::gamma*duration);
+    for(std::size_t i=0; i<20; ++i)
+    {
+        batch.apply_pulse(20*deg);
+        batch.apply_time_interval(duration, gradient);
+        for(auto && model: models)
+        {
+            model.apply_pulse(20*deg);
+            model.apply_time_interval(duration, gradient);
+        }
+        
+        BOOST_TEST(batch.size() <= models[0].size());
+        
+        for(std::size_t m=0; m<models.size(); ++m)
+        {
+            auto const states = batch.states(m);
+            auto const expected = models[m].states();
+            
+            for(std::size_t order=0; order<batch.size(); ++order)
+            {
+                for(std::size_t j=0; j<3; ++j)
+                {
+                    BOOST_TEST(
+                        std::abs(states(order, j)-expected(order, j))
+                        < batch.threshold+single_tolerance);
+                }
+            }
+            
+            for(
+                std::size_t order=batch.size(); order<models[m].size();
+                ++order)
+            {
+                sycomore::Real magnitude_squared = 0;
+                for(std::size_t j=0; j<3; ++j)
+                {
+                    magnitude_squared += std::norm(expected(order, j));
+                }
+                BOOST_TEST(
+                    std::sqrt(magnitude_squared)
+                    < batch.threshold+single_tolerance);
+            }
+        }
+    }
+    
+    BOOST_TEST(batch.size() < models[0].size());
+    BOOST_TEST(batch.size() > 1);
+}
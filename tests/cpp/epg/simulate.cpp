@@ -0,0 +1,101 @@
+#define BOOST_TEST_MODULE epg_simulate
+#include <boost/test/unit_test.hpp>
+
+#include <stdexcept>
+#include <vector>
+
+#include "sycomore/epg/Discrete.h"
+#include "sycomore/epg/simulate.h"
+#include "sycomore/Species.h"
+#include "sycomore/units.h"
+
+std::vector<sycomore::Complex> sequence(sycomore::epg::Discrete & model)
+{
+    using namespace sycomore::units;
+    
+    model.threshold = 1e-4;
+    
+    std::vector<sycomore::Complex> echoes;
+    for(std::size_t i=0; i<20; ++i)
+    {
+        model.apply_pulse(30*deg, (5.*i*(i+1)/2)*deg);
+        model.apply_time_interval(5*ms, 10*mT/m);
+        echoes.push_back(model.echo());
+        model.apply_time_interval(5*ms, 10*mT/m);
+    }
+    return echoes;
+}
+
+BOOST_AUTO_TEST_CASE(Simulate, *boost::unit_test::tolerance(1e-12))
+{
+    using namespace sycomore::units;
+    
+    std::vector<sycomore::Species> species;
+    for(std::size_t i=0; i<37; ++i)
+    {
+        species.emplace_back(
+            (500.+20*i)*ms, (20.+5*i)*ms, (0.5+0.1*i)*um*um/ms);
+    }
+    
+    auto const echoes = sycomore::epg::simulate(
+        sequence, species, {0,0,1}, 1*rad/m, 4);
+    BOOST_TEST(echoes.shape()[0] == species.size());
+    BOOST_TEST(echoes.shape()[1] == 20);
+    
+    for(std::size_t i=0; i<species.size(); ++i)
+    {
+        sycomore::epg::Discrete model(species[i]);
+        auto const expected = sequence(model);
+        for(std::size_t j=0; j<expected.size(); ++j)
+        {
+            sycomore::Complex const echo = echoes.unchecked(i, j);
+            BOOST_TEST(echo.real() == expected[j].real());
+            BOOST_TEST(echo.imag() == expected[j].imag());
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(DifferentEchoes)
+{
+    using namespace sycomore::units;
+    
+    std::vector<sycomore::Species> const species{
+        {1000*ms, 100*ms}, {800*ms, 80*ms}};
+    auto const sequence = [](sycomore::epg::Discrete & model) {
+        return std::vector<sycomore::Complex>(
+            model.species().T1().magnitude > 0.9 ? 1 : 2);
+    };
+    BOOST_CHECK_THROW(
+        sycomore::epg::simulate(sequence, species), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(Nested, *boost::unit_test::tolerance(1e-12))
+{
+    using namespace sycomore::units;
+    
+    std::vector<sycomore::Species> const species{
+        {1000*ms, 100*ms}, {800*ms, 80*ms}, {600*ms, 60*ms}};
+    
+    // Simulations run from a simulated sequence use the same pool, and must
+    // not deadlock.
+    auto const outer = [&](sycomore::epg::Discrete & model) {
+        auto const inner = sycomore::epg::simulate(
+            sequence, species, {0,0,1}, 1*rad/m, 2);
+        auto echoes = sequence(model);
+        echoes.push_back(inner.unchecked(0, 0));
+        return echoes;
+    };
+    auto const echoes = sycomore::epg::simulate(
+        outer, species, {0,0,1}, 1*rad/m, 2);
+    BOOST_TEST(echoes.shape()[0] == species.size());
+    BOOST_TEST(echoes.shape()[1] == 21);
+    
+    sycomore::epg::Discrete model(species[0]);
+    sycomore::Complex const expected = sequence(model)[0];
+    for(std::size_t i=0; i<species.size(); ++i)
+    {
+        sycomore::Complex const echo = echoes.unchecked(i, 20);
+        BOOST_TEST(echo.real() == expected.real());
+        BOOST_TEST(echo.imag() == expected.imag());
+    }
+}
@@ -1,8 +1,14 @@
 #define BOOST_TEST_MODULE isochromat_Model
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include <xtensor/xbuilder.hpp>
 #include <xtensor/xmath.hpp>
 #include <xtensor/xview.hpp>
+#include "sycomore/HardPulseApproximation.h"
 #include "sycomore/isochromat/Model.h"
 #include "sycomore/units.h"
 
@@ -259,3 +265,194 @@ BOOST_AUTO_TEST_CASE(Apply)
     
     BOOST_TEST(xt::allclose(model.magnetization(), magnetization));
 }
+
+BOOST_AUTO_TEST_CASE(ApplyUniform)
+{
+    using namespace sycomore::units;
+    
+    // Single matrix, broadcast to all isochromats
+    sycomore::isochromat::Operator operator_({
+        {
+            {1, 2, 3, 10},
+            {4, 5, 6, 20},
+            {7, 8, 9, 30},
+            {0, 0, 0, 1},
+        }
+    });
+    
+    sycomore::isochromat::Model model(
+        {1*s, 1*s}, {1*s, 1*s},
+        {{19., 20., 21.}, {22., 23., 24.}}, {{0*m, 0*m, 0*m}, {0*m, 0*m, 1*m}});
+    model.apply(operator_);
+    
+    decltype(model.magnetization()) magnetization{
+        {132, 322, 512}, {150, 367, 584}};
+    
+    BOOST_TEST(xt::allclose(model.magnetization(), magnetization));
+}
+
+BOOST_AUTO_TEST_CASE(ApplySizeMismatch)
+{
+    using namespace sycomore::units;
+    
+    sycomore::isochromat::Model model(
+        1*s, 1*s, {0., 0., 1.},
+        {{0*m, 0*m, 0*m}, {0*m, 0*m, 1*m}, {0*m, 0*m, 2*m}});
+    sycomore::isochromat::Operator::Array array = xt::zeros<sycomore::Real>(
+        sycomore::isochromat::Operator::Array::shape_type{2, 4, 4});
+    BOOST_CHECK_THROW(
+        model.apply(sycomore::isochromat::Operator(array)),
+        std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(ApplyThreads)
+{
+    using namespace sycomore::units;
+    
+    // More isochromats than a single chunk, not a multiple of the SIMD width.
+    std::size_t const size = 50003;
+    sycomore::TensorQ<2> positions(sycomore::TensorQ<2>::shape_type{size, 3});
+    std::fill(positions.begin(), positions.end(), 0*m);
+    sycomore::TensorQ<1> angles(sycomore::TensorQ<1>::shape_type{size});
+    for(std::size_t n=0; n<size; ++n)
+    {
+        angles[n] = (1e-3*n)*rad;
+    }
+    
+    sycomore::isochromat::Model model(1*s, 0.1*s, {0., 0., 1.}, positions);
+    auto threaded = model;
+    BOOST_TEST(model.threads() == 1);
+    threaded.set_threads(4);
+    BOOST_TEST(threaded.threads() == 4);
+    BOOST_TEST(model.threads() == 1);
+    
+    auto const pulse = model.build_pulse(30*deg, 10*deg);
+    auto const phase = model.build_phase_accumulation(angles);
+    for(auto * item: {&model, &threaded})
+    {
+        item->apply(pulse);
+        item->apply(phase);
+    }
+    
+    // Explicit rotation of the magnetization after the pulse.
+    auto const & P = pulse.array();
+    auto const x = P.unchecked(0, 0, 2), y = P.unchecked(0, 1, 2);
+    auto const z = P.unchecked(0, 2, 2);
+    auto const magnetization = model.magnetization();
+    sycomore::Real error = 0;
+    for(std::size_t n=0; n<size; ++n)
+    {
+        auto const c = std::cos(1e-3*n), s = std::sin(1e-3*n);
+        error = std::max({
+            error,
+            std::abs(magnetization.unchecked(n, 0) - (c*x-s*y)),
+            std::abs(magnetization.unchecked(n, 1) - (s*x+c*y)),
+            std::abs(magnetization.unchecked(n, 2) - z)});
+    }
+    BOOST_TEST(error < 1e-12);
+    
+    BOOST_TEST((threaded.magnetization() == magnetization));
+}
+
+BOOST_AUTO_TEST_CASE(ApplyLazy)
+{
+    using namespace sycomore::units;
+    
+    // Not a multiple of the SIMD width, with spatially-varying parameters.
+    std::size_t const size = 13;
+    sycomore::TensorQ<1> T1(sycomore::TensorQ<1>::shape_type{size});
+    sycomore::TensorQ<1> T2(sycomore::TensorQ<1>::shape_type{size});
+    sycomore::TensorR<2> M0(sycomore::TensorR<2>::shape_type{size, 3});
+    sycomore::TensorQ<2> positions(sycomore::TensorQ<2>::shape_type{size, 3});
+    sycomore::TensorQ<1> delta_omega(sycomore::TensorQ<1>::shape_type{size});
+    sycomore::TensorQ<1> angles(sycomore::TensorQ<1>::shape_type{size});
+    sycomore::TensorQ<1> phases(sycomore::TensorQ<1>::shape_type{size});
+    sycomore::TensorQ<1> frequencies(sycomore::TensorQ<1>::shape_type{size});
+    sycomore::TensorQ<2> gradients(sycomore::TensorQ<2>::shape_type{size, 3});
+    for(std::size_t n=0; n<size; ++n)
+    {
+        T1[n] = (500+10*n)*ms;
+        T2[n] = (50+5*n)*ms;
+        delta_omega[n] = (10.*n)*Hz;
+        angles[n] = (5.*n)*deg;
+        phases[n] = (20.*n)*deg;
+        frequencies[n] = (3.*n)*Hz;
+        for(std::size_t i=0; i<3; ++i)
+        {
+            M0.unchecked(n, i) = (i == 2) ? 1+0.1*n : 0;
+            positions.unchecked(n, i) = ((i+1)*n*1.)*mm;
+            gradients.unchecked(n, i) = ((3.-i)*n)*mT/m;
+        }
+    }
+    
+    sycomore::isochromat::Model lazy(T1, T2, M0, positions, delta_omega);
+    auto eager = lazy;
+    
+    lazy.apply_pulse(40*deg, 30*deg);
+    eager.apply(eager.build_pulse(40*deg, 30*deg));
+    lazy.apply_time_interval(
+        10*ms, 20*Hz, {1*mT/m, 2*mT/m, 3*mT/m});
+    eager.apply(
+        eager.build_time_interval(10*ms, 20*Hz, {1*mT/m, 2*mT/m, 3*mT/m}));
+    lazy.apply_pulse(angles, phases);
+    eager.apply(eager.build_pulse(angles, phases));
+    lazy.apply_time_interval(5*ms, frequencies, gradients);
+    eager.apply(eager.build_time_interval(5*ms, frequencies, gradients));
+    lazy.apply_pulse(angles);
+    eager.apply(eager.build_pulse(angles));
+    lazy.apply_relaxation(20*ms);
+    eager.apply(eager.build_relaxation(20*ms));
+    lazy.apply_time_interval(1*ms);
+    eager.apply(eager.build_time_interval(1*ms));
+    
+    BOOST_TEST(xt::allclose(lazy.magnetization(), eager.magnetization()));
+    
+    BOOST_CHECK_THROW(
+        lazy.apply_pulse({10*deg, 20*deg}), std::runtime_error);
+    BOOST_CHECK_THROW(
+        lazy.apply_time_interval(1*ms, {10*Hz, 20*Hz}), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(ApplyShapedPulse)
+{
+    using namespace sycomore::units;
+    
+    std::size_t const size = 13;
+    sycomore::TensorQ<1> T1(sycomore::TensorQ<1>::shape_type{size});
+    sycomore::TensorQ<1> T2(sycomore::TensorQ<1>::shape_type{size});
+    sycomore::TensorR<2> M0(sycomore::TensorR<2>::shape_type{size, 3});
+    sycomore::TensorQ<2> positions(sycomore::TensorQ<2>::shape_type{size, 3});
+    sycomore::TensorQ<1> delta_omega(sycomore::TensorQ<1>::shape_type{size});
+    for(std::size_t n=0; n<size; ++n)
+    {
+        T1[n] = (500+10*n)*ms;
+        T2[n] = (50+5*n)*ms;
+        delta_omega[n] = (10.*n)*Hz;
+        for(std::size_t i=0; i<3; ++i)
+        {
+            M0.unchecked(n, i) = (i == 2) ? 1+0.1*n : 0;
+            positions.unchecked(n, i) = ((i+1)*n*1.)*mm;
+        }
+    }
+    
+    sycomore::isochromat::Model shaped(T1, T2, M0, positions, delta_omega);
+    auto manual = shaped;
+    
+    sycomore::HardPulseApproximation const pulse(
+        sycomore::Pulse(40*deg, 10*deg), sycomore::linspace(1*ms, 11),
+        sycomore::sinc_envelope(0.25*ms));
+    sycomore::TensorQ<1> const gradient{1*mT/m, 2*mT/m, 3*mT/m};
+    
+    shaped.apply_shaped_pulse(pulse, 20*Hz, gradient);
+    for(auto && hard_pulse: pulse.pulses())
+    {
+        manual.apply_pulse(hard_pulse.angle(), hard_pulse.phase());
+        manual.apply_time_interval(pulse.duration(), 20*Hz, gradient);
+    }
+    
+    BOOST_TEST(xt::allclose(shaped.magnetization(), manual.magnetization()));
+    
+    BOOST_CHECK_THROW(
+        shaped.apply_shaped_pulse(pulse, 0*Hz, {1*mT/m, 2*mT/m}),
+        std::runtime_error);
+}
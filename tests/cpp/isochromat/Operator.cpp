@@ -1,6 +1,10 @@
 #define BOOST_TEST_MODULE isochromat_Operator
 #include <boost/test/unit_test.hpp>
 
+#include <cmath>
+#include <stdexcept>
+
+#include <xtensor/xbuilder.hpp>
 #include <xtensor/xmath.hpp>
 #include <xtensor/xview.hpp>
 #include "sycomore/isochromat/Operator.h"
@@ -148,3 +152,197 @@ BOOST_AUTO_TEST_CASE(Multiply)
     };
     BOOST_TEST(xt::allclose(combined.array(), expected));
 }
+
+BOOST_AUTO_TEST_CASE(Affine)
+{
+    sycomore::isochromat::Operator const identity;
+    BOOST_TEST(identity.is_affine());
+    BOOST_TEST(identity.size() == 1);
+    BOOST_TEST(
+        xt::allclose(identity.array(), xt::eye<sycomore::Real>({1,4,4})));
+    
+    // Full 4×4 affine matrices are stored in compact form.
+    sycomore::isochromat::Operator const left({
+        {
+            {1, 2, 3, 4},
+            {5, 6, 7, 8},
+            {9, 10, 11, 12},
+            {0, 0, 0, 1}
+        },
+        {
+            {13, 9, 5, 1},
+            {14, 10, 6, 2},
+            {15, 11, 7, 3},
+            {0, 0, 0, 1}
+        }
+    });
+    BOOST_TEST(left.is_affine());
+    BOOST_TEST(left.size() == 2);
+    BOOST_TEST((
+        left.data().shape()
+        == sycomore::isochromat::Operator::Array::shape_type{2, 3, 4}));
+    
+    sycomore::isochromat::Operator const right({
+        {
+            {16, 15, 14, 13},
+            {12, 11, 10, 9},
+            {8, 7, 6, 5}
+        }
+    });
+    BOOST_TEST(right.is_affine());
+    
+    sycomore::isochromat::Operator::Array const expected{
+        {{64, 58, 52, 50},
+         {208, 190, 172, 162},
+         {352, 322, 292, 274},
+         {0, 0, 0, 1}},
+        {{356, 329, 302, 276},
+         {392, 362, 332, 304},
+         {428, 395, 362, 332},
+         {0, 0, 0, 1}}
+    };
+    
+    auto const product = left * right;
+    BOOST_TEST(product.is_affine());
+    BOOST_TEST(xt::allclose(product.array(), expected));
+    
+    auto pre_multiplied = right;
+    pre_multiplied.pre_multiply(left);
+    BOOST_TEST(pre_multiplied.is_affine());
+    BOOST_TEST(xt::allclose(pre_multiplied.array(), expected));
+    
+    // Chaining with a general operator yields a general operator.
+    sycomore::isochromat::Operator const general({
+        {
+            {1, 0, 0, 0},
+            {0, 1, 0, 0},
+            {0, 0, 1, 0},
+            {0, 0, 1, 1}
+        }
+    });
+    BOOST_TEST(!general.is_affine());
+    auto const mixed = general * left;
+    BOOST_TEST(!mixed.is_affine());
+    BOOST_TEST(
+        xt::allclose(
+            mixed.array(),
+            sycomore::isochromat::Operator::Array{
+                {{1, 2, 3, 4},
+                 {5, 6, 7, 8},
+                 {9, 10, 11, 12},
+                 {9, 10, 11, 13}},
+                {{13, 9, 5, 1},
+                 {14, 10, 6, 2},
+                 {15, 11, 7, 3},
+                 {15, 11, 7, 4}}}));
+}
+
+BOOST_AUTO_TEST_CASE(Kinds)
+{
+    using sycomore::isochromat::Operator;
+    
+    Operator const identity;
+    BOOST_TEST(identity.kind() == Operator::Identity);
+    
+    Operator const diagonal(
+        Operator::DiagonalAffine, Operator::Array{{{2, 3, 4}, {1, 2, 3}}});
+    BOOST_TEST(diagonal.is_affine());
+    BOOST_TEST(
+        xt::allclose(
+            diagonal.array(),
+            Operator::Array{
+                {{2, 0, 0, 1},
+                 {0, 3, 0, 2},
+                 {0, 0, 4, 3},
+                 {0, 0, 0, 1}}}));
+    
+    // Chaining with the identity does not change the kind.
+    auto const diagonal_identity = identity * diagonal * identity;
+    BOOST_TEST(diagonal_identity.kind() == Operator::DiagonalAffine);
+    BOOST_TEST(xt::allclose(diagonal_identity.data(), diagonal.data()));
+    
+    auto const diagonal_product = diagonal * Operator(
+        Operator::DiagonalAffine, Operator::Array{{{5, 6, 7}, {-1, 0, 1}}});
+    BOOST_TEST(diagonal_product.kind() == Operator::DiagonalAffine);
+    BOOST_TEST(
+        xt::allclose(
+            diagonal_product.data(),
+            Operator::Array{{{10, 18, 28}, {-1, 2, 7}}}));
+    
+    Operator const rotation(
+        Operator::ZRotation,
+        Operator::Array{{{std::cos(0.5), std::sin(0.5)}}});
+    auto const rotation_product = rotation * Operator(
+        Operator::ZRotation,
+        Operator::Array{{{std::cos(0.25), std::sin(0.25)}}});
+    BOOST_TEST(rotation_product.kind() == Operator::ZRotation);
+    BOOST_TEST(
+        xt::allclose(
+            rotation_product.data(),
+            Operator::Array{{{std::cos(0.75), std::sin(0.75)}}}));
+    
+    // Different structured kinds are promoted to Affine.
+    auto const mixed = diagonal * Operator(
+        Operator::ZRotation, Operator::Array{{{0, 1}}});
+    BOOST_TEST(mixed.kind() == Operator::Affine);
+    BOOST_TEST(
+        xt::allclose(
+            mixed.array(),
+            Operator::Array{
+                {{0, -2, 0, 1},
+                 {3, 0, 0, 2},
+                 {0, 0, 4, 3},
+                 {0, 0, 0, 1}}}));
+    
+    BOOST_CHECK_THROW(
+        Operator(Operator::ZRotation, Operator::Array{{{1, 2, 3}}}),
+        std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(Rows)
+{
+    using sycomore::isochromat::Operator;
+    
+    // A single matrix is broadcast: no rows.
+    Operator const single(
+        Operator::ZRotation, Operator::Array{{{std::cos(0.5), std::sin(0.5)}}});
+    BOOST_TEST(single.rows_stride() == 0);
+    BOOST_TEST(single.rows().size() == 0);
+    
+    Operator diagonal(
+        Operator::DiagonalAffine,
+        Operator::Array{{{2, 3, 4}, {1, 2, 3}}, {{5, 6, 7}, {-1, 0, 1}}});
+    BOOST_TEST(diagonal.rows_stride() == 8);
+    BOOST_TEST(diagonal.rows().size() == 6*8);
+    for(std::size_t n=0; n<diagonal.size(); ++n)
+    {
+        for(std::size_t k=0; k<6; ++k)
+        {
+            BOOST_TEST(
+                diagonal.rows()[k*diagonal.rows_stride()+n]
+                == diagonal.data().data()[6*n+k]);
+        }
+    }
+    
+    // Rows follow the promotion of the chained operator.
+    diagonal *= single;
+    BOOST_TEST(diagonal.kind() == Operator::Affine);
+    BOOST_TEST(diagonal.rows().size() == 12*8);
+    for(std::size_t n=0; n<diagonal.size(); ++n)
+    {
+        for(std::size_t k=0; k<12; ++k)
+        {
+            BOOST_TEST(
+                diagonal.rows()[k*diagonal.rows_stride()+n]
+                == diagonal.data().data()[12*n+k]);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(InvalidShape)
+{
+    BOOST_CHECK_THROW(
+        sycomore::isochromat::Operator(
+            sycomore::isochromat::Operator::Array{{{1, 2, 3}, {4, 5, 6}}}),
+        std::runtime_error);
+}
@@ -0,0 +1,116 @@
+import unittest
+
+import numpy
+import sycomore
+from sycomore.units import *
+
+class TestProgram(unittest.TestCase):
+    def test_run(self):
+        species = sycomore.Species(1000*ms, 100*ms, 3*um**2/ms)
+        model = sycomore.epg.Regular(species, unit_dephasing=10*rad/m)
+        
+        TR = sycomore.Sequence()
+        TR.pulse(40*deg, 20*deg).time_interval(2*ms, 10*rad/m).echo()
+        sequence = sycomore.Sequence()
+        sequence.pulse(90*deg).loop(20, TR)
+        self.assertEqual(len(sequence), 61)
+        self.assertEqual(sequence.echoes, 20)
+        
+        compiled = sycomore.epg.Regular(species, unit_dephasing=10*rad/m)
+        program = sycomore.epg.Program(sequence, compiled)
+        self.assertEqual(len(program), 61)
+        self.assertEqual(program.echoes, 20)
+        echoes = program.run(compiled)
+        
+        expected = []
+        model.apply_pulse(90*deg)
+        for _ in range(20):
+            model.apply_pulse(40*deg, 20*deg)
+            model.apply_time_interval(sycomore.TimeInterval(2*ms, 10*rad/m))
+            expected.append(model.echo)
+        
+        numpy.testing.assert_allclose(echoes, expected)
+        numpy.testing.assert_allclose(compiled.states, model.states)
+    
+    def test_other_model(self):
+        species = sycomore.Species(1000*ms, 100*ms)
+        model = sycomore.epg.Regular(species, unit_dephasing=10*rad/m)
+        program = sycomore.epg.Program(
+            sycomore.Sequence().pulse(90*deg).echo(), model)
+        
+        other = sycomore.epg.Regular(
+            sycomore.Species(1000*ms, 50*ms), unit_dephasing=10*rad/m)
+        with self.assertRaises(RuntimeError):
+            program.run(other)
+    
+    def test_steady_state(self):
+        species = sycomore.Species(100*ms, 20*ms)
+        model = sycomore.epg.Regular(species, unit_dephasing=10*rad/m)
+        model.threshold = 1e-12
+        
+        TR = sycomore.Sequence()
+        TR.pulse(30*deg).time_interval(2*ms).echo()
+        TR.time_interval(3*ms, 10*rad/m)
+        program = sycomore.epg.Program(TR, model)
+        
+        repeated = sycomore.epg.Regular(species, unit_dephasing=10*rad/m)
+        repeated.threshold = 1e-12
+        for _ in range(1000):
+            expected = program.run(repeated)
+        
+        echoes = program.steady_state(model)
+        numpy.testing.assert_allclose(echoes, expected)
+    
+    def test_jacobian(self):
+        def simulate(R2, parameters=None):
+            species = sycomore.Species(1*Hz, R2*Hz)
+            model = sycomore.epg.Regular(species, unit_dephasing=10*rad/m)
+            TR = sycomore.Sequence()
+            TR.pulse(40*deg).time_interval(2*ms).echo()
+            TR.time_interval(3*ms, 10*rad/m)
+            program = sycomore.epg.Program(
+                sycomore.Sequence().loop(10, TR), model)
+            if parameters is None:
+                return program.run(model)
+            else:
+                return program.run(model, parameters)
+        
+        echoes, jacobian = simulate(10, [sycomore.epg.Program.R2])
+        numpy.testing.assert_allclose(echoes, simulate(10))
+        self.assertEqual(jacobian.shape, (10, 1))
+        
+        h = 1e-4
+        derivative = (simulate(10+h)-simulate(10-h))/(2*h)
+        numpy.testing.assert_allclose(jacobian[:,0], derivative, rtol=1e-6)
+    
+    def test_gradient(self):
+        def simulate(angles, gradient=False):
+            species = sycomore.Species(100*ms, 20*ms)
+            model = sycomore.epg.Regular(species, unit_dephasing=10*rad/m)
+            sequence = sycomore.Sequence()
+            for angle in angles:
+                sequence.pulse(angle*rad).time_interval(2*ms).echo()
+                sequence.time_interval(3*ms, 10*rad/m)
+            program = sycomore.epg.Program(sequence, model)
+            if gradient:
+                return program.gradient(model, lambda echoes: 2*echoes)
+            else:
+                return numpy.sum(numpy.abs(program.run(model))**2)
+        
+        angles = numpy.linspace(0.2, 1, 10)
+        echoes, angles_gradient, phases_gradient = simulate(angles, True)
+        self.assertEqual(len(echoes), 10)
+        self.assertEqual(len(angles_gradient), 10)
+        self.assertEqual(len(phases_gradient), 10)
+        
+        h = 1e-6
+        for i in range(len(angles)):
+            plus, minus = angles.copy(), angles.copy()
+            plus[i] += h
+            minus[i] -= h
+            derivative = (simulate(plus)-simulate(minus))/(2*h)
+            numpy.testing.assert_allclose(
+                angles_gradient[i], derivative, rtol=1e-5)
+
+if __name__ == "__main__":
+    unittest.main()
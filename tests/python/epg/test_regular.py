@@ -1,3 +1,4 @@
+import concurrent.futures
 import unittest
 
 import numpy
@@ -210,6 +211,68 @@ class TestRegular(unittest.TestCase):
         model.apply_time_interval(10*ms)
         self.assertEqual(model.elapsed, 10*ms)
     
+    def test_states_views(self):
+        species = sycomore.Species(1000*ms, 100*ms, 3*um**2/ms)
+        model = sycomore.epg.Regular(species, unit_dephasing=10*mT/m*ms)
+        model.circular_storage = True
+        for multiple in [1, 2, -1, 3]:
+            model.apply_pulse(40*deg, 10*deg)
+            model.apply_time_interval(10*ms, multiple*mT/m)
+        
+        states = model.states
+        F = model.F_view()
+        F_star = model.F_star_view()
+        Z = model.Z_view()
+        for view in [F, F_star, Z]:
+            self.assertEqual(view.shape, (len(model),))
+        numpy.testing.assert_equal(F, states[:, 0])
+        numpy.testing.assert_equal(F_star, states[:, 1])
+        numpy.testing.assert_equal(Z, states[:, 2])
+        
+        # The arrays are copies: they are not affected by modifications of
+        # the model, including a re-allocation or a linearization of its
+        # storage.
+        model.circular_storage = False
+        for _ in range(50):
+            model.apply_pulse(40*deg, 10*deg)
+            model.apply_time_interval(10*ms, 3*mT/m)
+        self.assertGreater(len(model), len(states))
+        numpy.testing.assert_equal(F, states[:, 0])
+        numpy.testing.assert_equal(F_star, states[:, 1])
+        numpy.testing.assert_equal(Z, states[:, 2])
+    
+    def test_threads(self):
+        def simulate(T2):
+            species = sycomore.Species(1000*ms, T2, 3*um**2/ms)
+            model = sycomore.epg.Regular(species, unit_dephasing=10*mT/m*ms)
+            for _ in range(100):
+                model.apply_pulse(60*deg, 20*deg)
+                model.apply_time_interval(10*ms, 1*mT/m)
+            return model.states
+        
+        T2 = [(10+10*i)*ms for i in range(8)]
+        expected = [simulate(x) for x in T2]
+        with concurrent.futures.ThreadPoolExecutor(4) as executor:
+            states = list(executor.map(simulate, T2))
+        for left, right in zip(states, expected):
+            numpy.testing.assert_equal(left, right)
+    
+    def test_shaped_pulse(self):
+        species = sycomore.Species(1000*ms, 100*ms, 1*um**2/ms, 10*Hz)
+        pulse = sycomore.HardPulseApproximation(
+            sycomore.Pulse(40*deg, 10*deg), sycomore.linspace(1*ms, 11),
+            sycomore.sinc_envelope(0.25*ms))
+        
+        shaped = sycomore.epg.Regular(species, unit_dephasing=0.2*mT/m*ms)
+        manual = sycomore.epg.Regular(species, unit_dephasing=0.2*mT/m*ms)
+        
+        shaped.apply_shaped_pulse(pulse, 2*mT/m)
+        for hard_pulse in pulse.pulses:
+            manual.apply_pulse(hard_pulse.angle, hard_pulse.phase)
+            manual.apply_time_interval(pulse.duration, 2*mT/m)
+        
+        numpy.testing.assert_almost_equal(shaped.states, manual.states)
+    
     def _test_model(self, model, orders, states):
         self._test_quantity_array(orders, model.orders)
         numpy.testing.assert_allclose(states, model.states)
@@ -0,0 +1,139 @@
+import unittest
+
+import numpy
+import sycomore
+from sycomore.units import *
+
+class TestRegularBatch(unittest.TestCase):
+    def setUp(self):
+        # Enough models to use both the SIMD and the padding parts of the batch
+        self.species = [
+            sycomore.Species(
+                (500+100*i)*ms, (50+10*i)*ms, (1+0.25*i)*um**2/ms, (10*i)*Hz)
+            for i in range(11)]
+        self.B1 = [0.8+0.04*i for i in range(len(self.species))]
+    
+    def test_empty(self):
+        batch = sycomore.epg.RegularBatch(self.species)
+        self.assertEqual(batch.models, len(self.species))
+        self.assertEqual(batch.size, 1)
+        for m in range(batch.models):
+            numpy.testing.assert_equal(batch.states(m), [[0,0,1]])
+        numpy.testing.assert_equal(batch.echo, numpy.zeros(batch.models))
+    
+    def test_time_interval(self):
+        batch = sycomore.epg.RegularBatch(
+            self.species, [0,0,1], 100, 1*rad/mm)
+        batch.set_B1(self.B1)
+        batch.delta_omega = 5*Hz
+        
+        models = [
+            sycomore.epg.Regular(species, [0,0,1], 100, 1*rad/mm)
+            for species in self.species]
+        for model in models:
+            model.delta_omega = 5*Hz
+        
+        duration = 10*ms
+        for i, multiple in enumerate([1, 1, 3, -2, 0, 1]):
+            angle = (30+10*i)*deg
+            phase = (5*i)*deg
+            gradient = multiple*1*rad/mm/(sycomore.gamma*duration)
+            
+            batch.apply_pulse(angle, phase)
+            batch.apply_time_interval(duration, gradient)
+            for B1, model in zip(self.B1, models):
+                model.apply_pulse(B1*angle, phase)
+                model.apply_time_interval(duration, gradient)
+            
+            self._test_batch(batch, models)
+    
+    def test_threshold(self):
+        batch = sycomore.epg.RegularBatch(
+            self.species, [0,0,1], 100, 1*rad/mm)
+        batch.threshold = 1e-3
+        
+        models = [
+            sycomore.epg.Regular(species, [0,0,1], 100, 1*rad/mm)
+            for species in self.species]
+        
+        duration = 100*ms
+        gradient = 1*rad/mm/(sycomore.gamma*duration)
+        for _ in range(20):
+            batch.apply_pulse(20*deg)
+            batch.apply_time_interval(duration, gradient)
+            for model in models:
+                model.apply_pulse(20*deg)
+                model.apply_time_interval(duration, gradient)
+        
+        self.assertLess(batch.size, len(models[0]))
+        self.assertGreater(batch.size, 1)
+        for m, model in enumerate(models):
+            # Kept states match the reference, culled states are
+            # low-populated in the reference.
+            numpy.testing.assert_allclose(
+                batch.states(m), model.states[:batch.size],
+                atol=batch.threshold)
+            self.assertTrue(
+                numpy.all(
+                    numpy.linalg.norm(model.states[batch.size:], axis=1)
+                    < batch.threshold))
+    
+    def test_precision(self):
+        Batch = sycomore.epg.RegularBatch
+        
+        batch = Batch(self.species)
+        self.assertEqual(batch.precision, Batch.Double)
+        
+        # Single precision requires the planar layout
+        with self.assertRaises(RuntimeError):
+            Batch(self.species, precision=Batch.Single)
+        
+        batch = Batch(
+            self.species, [0,0,1], 100, 1*rad/mm,
+            layout=Batch.Planar, precision=Batch.Single)
+        self.assertEqual(batch.layout, Batch.Planar)
+        self.assertEqual(batch.precision, Batch.Single)
+        batch.set_B1(self.B1)
+        batch.delta_omega = 5*Hz
+        
+        models = [
+            sycomore.epg.Regular(species, [0,0,1], 100, 1*rad/mm)
+            for species in self.species]
+        for model in models:
+            model.delta_omega = 5*Hz
+        
+        duration = 10*ms
+        for i, multiple in enumerate([1, 1, 3, -2, 0, 1]):
+            angle = (30+10*i)*deg
+            phase = (5*i)*deg
+            gradient = multiple*1*rad/mm/(sycomore.gamma*duration)
+            
+            batch.apply_pulse(angle, phase)
+            batch.apply_time_interval(duration, gradient)
+            for B1, model in zip(self.B1, models):
+                model.apply_pulse(B1*angle, phase)
+                model.apply_time_interval(duration, gradient)
+            
+            # The magnetization is at most 1: use an absolute tolerance
+            # above the float epsilon.
+            self._test_batch(batch, models, atol=1e-5)
+    
+    def _test_batch(self, batch, models, atol=None):
+        self.assertEqual(batch.models, len(models))
+        for m, model in enumerate(models):
+            self.assertEqual(batch.size, len(model))
+            if atol is None:
+                numpy.testing.assert_almost_equal(
+                    batch.states(m), model.states)
+            else:
+                numpy.testing.assert_allclose(
+                    batch.states(m), model.states, atol=atol)
+        if atol is None:
+            numpy.testing.assert_almost_equal(
+                batch.echo, [model.echo for model in models])
+        else:
+            numpy.testing.assert_allclose(
+                batch.echo, [model.echo for model in models], atol=atol)
+
+if __name__ == "__main__":
+    unittest.main()
@@ -210,6 +210,66 @@ class TestModel(unittest.TestCase):
         
         numpy.testing.assert_almost_equal(model.magnetization, magnetization)
     
+    def test_threads(self):
+        positions = [[0*m, 0*m, i*m] for i in range(20000)]
+        model = sycomore.isochromat.Model(1*s, 0.1*s, [0, 0, 1], positions)
+        self.assertEqual(model.threads, 1)
+        
+        threaded = sycomore.isochromat.Model(1*s, 0.1*s, [0, 0, 1], positions)
+        threaded.threads = 2
+        self.assertEqual(threaded.threads, 2)
+        
+        pulse = model.build_pulse(30*deg, 10*deg)
+        time_interval = model.build_time_interval(
+            10*ms, 0*Hz, [0*mT/m, 0*mT/m, 1*mT/m])
+        for item in [model, threaded]:
+            item.apply(pulse)
+            item.apply(time_interval)
+        
+        numpy.testing.assert_equal(
+            threaded.magnetization, model.magnetization)
+    
+    def test_apply_lazy(self):
+        T1 = [(500+10*i)*ms for i in range(13)]
+        T2 = [(50+5*i)*ms for i in range(13)]
+        M0 = [[0, 0, 1+0.1*i] for i in range(13)]
+        positions = [[0*m, 0*m, i*mm] for i in range(13)]
+        lazy = sycomore.isochromat.Model(T1, T2, M0, positions)
+        eager = sycomore.isochromat.Model(T1, T2, M0, positions)
+        
+        angles = [(5*i)*deg for i in range(13)]
+        phases = [(20*i)*deg for i in range(13)]
+        lazy.apply_pulse(angles, phases)
+        eager.apply(eager.build_pulse(angles, phases))
+        lazy.apply_time_interval(10*ms, 20*Hz, [0*mT/m, 0*mT/m, 1*mT/m])
+        eager.apply(
+            eager.build_time_interval(10*ms, 20*Hz, [0*mT/m, 0*mT/m, 1*mT/m]))
+        lazy.apply_relaxation(5*ms)
+        eager.apply(eager.build_relaxation(5*ms))
+        
+        numpy.testing.assert_almost_equal(
+            lazy.magnetization, eager.magnetization)
+    
+    def test_apply_shaped_pulse(self):
+        T1 = [(500+10*i)*ms for i in range(13)]
+        T2 = [(50+5*i)*ms for i in range(13)]
+        M0 = [[0, 0, 1+0.1*i] for i in range(13)]
+        positions = [[0*m, 0*m, i*mm] for i in range(13)]
+        shaped = sycomore.isochromat.Model(T1, T2, M0, positions)
+        manual = sycomore.isochromat.Model(T1, T2, M0, positions)
+        
+        pulse = sycomore.HardPulseApproximation(
+            sycomore.Pulse(40*deg, 10*deg), sycomore.linspace(1*ms, 11),
+            sycomore.sinc_envelope(0.25*ms))
+        gradient = [0*mT/m, 0*mT/m, 1*mT/m]
+        shaped.apply_shaped_pulse(pulse, 20*Hz, gradient)
+        for hard_pulse in pulse.pulses:
+            manual.apply_pulse(hard_pulse.angle, hard_pulse.phase)
+            manual.apply_time_interval(pulse.duration, 20*Hz, gradient)
+        
+        numpy.testing.assert_almost_equal(
+            shaped.magnetization, manual.magnetization)
+    
     def _test_quantity_array(self, left, right):
         self.assertEqual(numpy.shape(left), numpy.shape(right))
         self.assertSequenceEqual(
@@ -64,5 +64,43 @@ class TestOperator(unittest.TestCase):
     
         numpy.testing.assert_almost_equal(
             combined.array, self.left @ self.right)
+    
+    def test_affine(self):
+        left = numpy.array(self.left, dtype=float)
+        left[:, 3] = [0, 0, 0, 1]
+        right = numpy.array(self.right, dtype=float)
+        right[:, 3] = [0, 0, 0, 1]
+        
+        operator = sycomore.isochromat.Operator(left)
+        self.assertTrue(operator.is_affine)
+        self.assertEqual(operator.size, 2)
+        numpy.testing.assert_almost_equal(operator.data, left[:, :3])
+        numpy.testing.assert_almost_equal(operator.array, left)
+        
+        combined = operator * sycomore.isochromat.Operator(right[:, :3])
+        self.assertTrue(combined.is_affine)
+        numpy.testing.assert_almost_equal(combined.array, left @ right)
+        
+        self.assertFalse(sycomore.isochromat.Operator(self.left).is_affine)
+    
+    def test_kinds(self):
+        Operator = sycomore.isochromat.Operator
+        self.assertEqual(Operator().kind, Operator.Kind.Identity)
+        
+        diagonal = Operator(
+            Operator.Kind.DiagonalAffine, [[[2, 3, 4], [1, 2, 3]]])
+        numpy.testing.assert_almost_equal(
+            diagonal.array,
+            [[[2, 0, 0, 1], [0, 3, 0, 2], [0, 0, 4, 3], [0, 0, 0, 1]]])
+        
+        rotation = Operator(Operator.Kind.ZRotation, [[[0, 1]]])
+        self.assertEqual(
+            (rotation*rotation).kind, Operator.Kind.ZRotation)
+        numpy.testing.assert_almost_equal((rotation*rotation).data, [[[-1, 0]]])
+        
+        mixed = diagonal * rotation
+        self.assertEqual(mixed.kind, Operator.Kind.Affine)
+        numpy.testing.assert_almost_equal(
+            mixed.array, diagonal.array @ rotation.array)
 if __name__ == "__main__":
     unittest.main()
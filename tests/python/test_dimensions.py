@@ -46,5 +46,25 @@ class TestDimensions(unittest.TestCase):
         r = sycomore.Dimensions(6,0,-4,0,0,0,0)
         self.assertEqual(d**2, r)
 
+    def test_fractional_exponent(self):
+        d = sycomore.Dimensions(length=0.5)
+        self.assertEqual(d.length, 0.5)
+        d.time = -1/3
+        self.assertAlmostEqual(d.time, -1/3)
+        with self.assertRaises(RuntimeError):
+            d.mass = 0.1
+        with self.assertRaises(RuntimeError):
+            sycomore.Dimensions(length=0.25)
+
+    def test_out_of_range_exponent(self):
+        sycomore.Dimensions(21, -21)
+        with self.assertRaises(RuntimeError):
+            sycomore.Dimensions(22)
+        d = sycomore.Dimensions(length=1)
+        with self.assertRaises(RuntimeError):
+            d**100
+        with self.assertRaises(RuntimeError):
+            d.length = -22
+
 if __name__ == "__main__":
     unittest.main()
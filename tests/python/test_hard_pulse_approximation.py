@@ -0,0 +1,35 @@
+import unittest
+
+import numpy
+import sycomore
+from sycomore.units import *
+
+class TestHardPulseApproximation(unittest.TestCase):
+    def test_sampled_envelope(self):
+        model = sycomore.Pulse(40*deg, 10*deg)
+        support = sycomore.linspace(1*ms, 101)
+        t0 = 0.317*ms
+        
+        envelopes = [
+            (sycomore.sinc_sampled_envelope(t0), sycomore.sinc_envelope(t0)),
+            (
+                sycomore.hann_sinc_sampled_envelope(t0, 2),
+                sycomore.hann_sinc_envelope(t0, 2)),
+            (
+                sycomore.hamming_sinc_sampled_envelope(t0, 3),
+                sycomore.hamming_sinc_envelope(t0, 3))]
+        for sampled, callback in envelopes:
+            left = sycomore.HardPulseApproximation(model, support, sampled)
+            right = sycomore.HardPulseApproximation(model, support, callback)
+            
+            self.assertEqual(left.duration, right.duration)
+            self.assertEqual(len(left.pulses), len(right.pulses))
+            numpy.testing.assert_almost_equal(
+                [x.angle.magnitude for x in left.pulses],
+                [x.angle.magnitude for x in right.pulses])
+            self.assertAlmostEqual(
+                sum(x.angle.magnitude for x in left.pulses),
+                model.angle.magnitude)
+
+if __name__ == "__main__":
+    unittest.main()
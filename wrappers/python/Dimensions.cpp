@@ -19,14 +19,37 @@ void wrap_Dimensions(pybind11::module & m)
             arg("electric_current")=0, arg("thermodynamic_temperature")=0,
             arg("amount_of_substance")=0, arg("luminous_intensity")=0
         )
-        .def_readwrite("length", &Dimensions::length)
-        .def_readwrite("mass", &Dimensions::mass)
-        .def_readwrite("time", &Dimensions::time)
-        .def_readwrite("electric_current", &Dimensions::electric_current)
-        .def_readwrite(
-            "thermodynamic_temperature", &Dimensions::thermodynamic_temperature)
-        .def_readwrite("amount_of_substance", &Dimensions::amount_of_substance)
-        .def_readwrite("luminous_intensity", &Dimensions::luminous_intensity)
+        .def_property(
+            "length",
+            [](Dimensions const & d) -> double { return d.length; },
+            [](Dimensions & d, double x) { d.length = x; })
+        .def_property(
+            "mass",
+            [](Dimensions const & d) -> double { return d.mass; },
+            [](Dimensions & d, double x) { d.mass = x; })
+        .def_property(
+            "time",
+            [](Dimensions const & d) -> double { return d.time; },
+            [](Dimensions & d, double x) { d.time = x; })
+        .def_property(
+            "electric_current",
+            [](Dimensions const & d) -> double { return d.electric_current; },
+            [](Dimensions & d, double x) { d.electric_current = x; })
+        .def_property(
+            "thermodynamic_temperature",
+            [](Dimensions const & d) -> double {
+                return d.thermodynamic_temperature; },
+            [](Dimensions & d, double x) { d.thermodynamic_temperature = x; })
+        .def_property(
+            "amount_of_substance",
+            [](Dimensions const & d) -> double {
+                return d.amount_of_substance; },
+            [](Dimensions & d, double x) { d.amount_of_substance = x; })
+        .def_property(
+            "luminous_intensity",
+            [](Dimensions const & d) -> double {
+                return d.luminous_intensity; },
+            [](Dimensions & d, double x) { d.luminous_intensity = x; })
         .def(self == self)
         .def(self != self)
         .def(self *= self)
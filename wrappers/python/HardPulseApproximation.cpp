@@ -6,15 +6,39 @@
 
 #include "type_casters.h"
 
+/**
+ * @brief Opaque wrapper of a sampled envelope: a std::function taking arrays
+ * cannot be converted to a Python callable.
+ */
+struct SampledEnvelope
+{
+    sycomore::HardPulseApproximation::SampledEnvelope envelope;
+};
+
 void wrap_HardPulseApproximation(pybind11::module & m)
 {
     using namespace pybind11;
     using namespace pybind11::literals;
     using namespace sycomore;
 
+    class_<SampledEnvelope>(
+        m, "SampledEnvelope",
+        "Envelope of a shaped pulse, sampled on the whole support at once");
+
     class_<HardPulseApproximation>(
             m, "HardPulseApproximation",
             "Small tip angle approximation of a shaped pulse")
+        .def(
+            init(
+                [](
+                    Pulse const & model, std::vector<Quantity> const & support,
+                    SampledEnvelope const & envelope) {
+                    return HardPulseApproximation(
+                        model, support, envelope.envelope); }),
+            "model"_a, "support"_a, "envelope"_a,
+            "Create a shaped pulse with a flip angle equivalent to given "
+                "hard pulse, sampling the envelope on the whole support at "
+                "once")
         .def(
             init<
                 Pulse, std::vector<Quantity>,
@@ -44,4 +68,29 @@ void wrap_HardPulseApproximation(pybind11::module & m)
         "hamming_sinc_envelope", hamming_sinc_envelope,
         "Create an Hamming-apodized sinc envelope");
     m.def("sinc_envelope", sinc_envelope, "Create a sinc envelope");
+
+    m.def(
+        "apodized_sinc_sampled_envelope",
+        [](Quantity const & t0, unsigned int N, Real alpha) {
+            return SampledEnvelope{
+                apodized_sinc_sampled_envelope(t0, N, alpha)}; },
+        "t0"_a, "N"_a, "alpha"_a,
+        "Create an apodized sinc envelope, sampled with SIMD");
+    m.def(
+        "hann_sinc_sampled_envelope",
+        [](Quantity const & t0, unsigned int N) {
+            return SampledEnvelope{hann_sinc_sampled_envelope(t0, N)}; },
+        "t0"_a, "N"_a,
+        "Create an Hann-apodized sinc envelope, sampled with SIMD");
+    m.def(
+        "hamming_sinc_sampled_envelope",
+        [](Quantity const & t0, unsigned int N) {
+            return SampledEnvelope{hamming_sinc_sampled_envelope(t0, N)}; },
+        "t0"_a, "N"_a,
+        "Create an Hamming-apodized sinc envelope, sampled with SIMD");
+    m.def(
+        "sinc_sampled_envelope",
+        [](Quantity const & t0) {
+            return SampledEnvelope{sinc_sampled_envelope(t0)}; },
+        "t0"_a, "Create a sinc envelope, sampled with SIMD");
 }
@@ -182,13 +182,14 @@ void wrap_Quantity(pybind11::module & m)
         .def(hash(self))
         .def(pickle(
             [](Quantity const & q) {
+                auto const & d = q.dimensions;
                 return make_tuple(
                     q.magnitude, 
-                    q.dimensions.length, q.dimensions.mass, q.dimensions.time,
-                    q.dimensions.electric_current, 
-                    q.dimensions.thermodynamic_temperature,
-                    q.dimensions.amount_of_substance, 
-                    q.dimensions.luminous_intensity);
+                    double(d.length), double(d.mass), double(d.time),
+                    double(d.electric_current), 
+                    double(d.thermodynamic_temperature),
+                    double(d.amount_of_substance), 
+                    double(d.luminous_intensity));
             },
             [](tuple t) {
                 if(t.size() != 8)
@@ -0,0 +1,53 @@
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include "sycomore/Quantity.h"
+#include "sycomore/Sequence.h"
+#include "sycomore/TimeInterval.h"
+#include "sycomore/units.h"
+
+#include "type_casters.h"
+
+void wrap_Sequence(pybind11::module & m)
+{
+    using namespace pybind11;
+    using namespace pybind11::literals;
+    using namespace sycomore;
+    
+    class_<Sequence>(
+            m, "Sequence",
+            "Sequence of RF pulses, time intervals and echo readouts, which "
+            "may be repeated in loops.")
+        .def(init<>())
+        .def(
+            "pulse", &Sequence::pulse, "angle"_a, "phase"_a=0*units::rad,
+            return_value_policy::reference_internal,
+            "Append an RF hard pulse, return the sequence.")
+        .def(
+            "time_interval",
+            static_cast<Sequence & (Sequence::*)(TimeInterval const &)>(
+                &Sequence::time_interval),
+            "interval"_a, return_value_policy::reference_internal,
+            "Append a time interval, return the sequence.")
+        .def(
+            "time_interval",
+            static_cast<
+                    Sequence & (Sequence::*)(Quantity const &, Quantity const &)
+                >(&Sequence::time_interval),
+            "duration"_a, "gradient"_a=0*units::T/units::m,
+            return_value_policy::reference_internal,
+            "Append a time interval, return the sequence.")
+        .def(
+            "echo", &Sequence::echo, return_value_policy::reference_internal,
+            "Append the readout of the echo signal, return the sequence.")
+        .def(
+            "loop", &Sequence::loop, "repetitions"_a, "body"_a,
+            return_value_policy::reference_internal,
+            "Append a repeated sequence, return the sequence.")
+        .def(
+            "__len__", &Sequence::size,
+            "Number of steps, loops being unrolled.")
+        .def_property_readonly(
+            "echoes", &Sequence::echoes,
+            "Number of echo readouts, loops being unrolled.");
+}
@@ -7,6 +7,18 @@
 
 #include "../type_casters.h"
 
+/**
+ * @brief Return a copy of a view of the states: the memory of the view is
+ * freed or moved by the next modification of the model, which Python code
+ * cannot track.
+ */
+pybind11::array_t<sycomore::Complex>
+states_view(sycomore::epg::Base::StatesView const & view)
+{
+    return pybind11::array_t<sycomore::Complex>(
+        {view.size()}, {sizeof(sycomore::Complex)}, view.data());
+}
+
 void wrap_epg_Base(pybind11::module & m)
 {
     using namespace pybind11;
@@ -58,6 +70,25 @@ void wrap_epg_Base(pybind11::module & m)
             R"(Return all states in the model, as :math:`\tilde{F}`, )"
                 R"(:math:`\tilde{F}^*`, and :math:`\tilde{Z}` for each order )"
                 "and each pool.")
+        .def(
+            "F_view",
+            [](Base & model, std::size_t pool) {
+                return states_view(model.F_view(pool)); },
+            "pool"_a=0,
+            "Copy of the F states of a pool, ordered as the orders of the "
+            "model. Unlike states, the other populations are not copied.")
+        .def(
+            "F_star_view",
+            [](Base & model, std::size_t pool) {
+                return states_view(model.F_star_view(pool)); },
+            "pool"_a=0,
+            "Copy of the F* states of a pool, see F_view.")
+        .def(
+            "Z_view",
+            [](Base & model, std::size_t pool) {
+                return states_view(model.Z_view(pool)); },
+            "pool"_a=0,
+            "Copy of the Z states of a pool, see F_view.")
         .def_property_readonly(
             "elapsed", &Base::elapsed, "Return the elapsed time")
         .def_property_readonly(
@@ -68,6 +99,7 @@ void wrap_epg_Base(pybind11::module & m)
             static_cast<void(Base::*)(Quantity const &, Quantity const &)>(
                 &Base::apply_pulse),
             "angle"_a, "phase"_a=0*units::rad,
+            call_guard<gil_scoped_release>(),
             "Apply an RF hard pulse to a single-pool model")
         .def(
             "apply_pulse", 
@@ -77,6 +109,7 @@ void wrap_epg_Base(pybind11::module & m)
                         Quantity const &, Quantity const &)
                 >(&Base::apply_pulse),
             "angle_a"_a, "phase_a"_a, "angle_B"_a, "phase_b"_a,
+            call_guard<gil_scoped_release>(),
             "Apply an RF hard pulse to an two-pools exchange model")
         .def(
             "apply_pulse", 
@@ -84,15 +117,28 @@ void wrap_epg_Base(pybind11::module & m)
                     void(Base::*)(Quantity const &, Quantity const &, Real)
                 >(&Base::apply_pulse),
             "angle_a"_a, "phase_a"_a, "saturation"_a,
+            call_guard<gil_scoped_release>(),
             "Apply an RF pulse to an two-pools magnetization transfer model")
         .def(
             "relaxation", &Base::relaxation, "duration"_a,
+            call_guard<gil_scoped_release>(),
             "Simulate the relaxation during given duration")
         .def(
             "off_resonance", &Base::off_resonance, 
             "duration"_a,
+            call_guard<gil_scoped_release>(),
             "Simulate field- and species-related off-resonance effects during "
                 "given duration with given frequency offset")
+        .def_property_readonly(
+            "operator_cache_hits", &Base::operator_cache_hits,
+            "Number of operators found in the operator cache")
+        .def_property_readonly(
+            "operator_cache_misses", &Base::operator_cache_misses,
+            "Number of operators computed by the operator cache")
+        .def_property(
+            "operator_cache_capacity", &Base::operator_cache_capacity,
+            &Base::set_operator_cache_capacity,
+            "Number of operators of each kind kept in the cache")
         .def("__len__", &Base::size, "Number of states of the model")
     ;
 }
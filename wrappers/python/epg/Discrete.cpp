@@ -58,6 +58,7 @@ void wrap_epg_Discrete(pybind11::module & m)
             static_cast<void(Discrete::*)(Quantity const &, Quantity const &)>(
                 &Discrete::apply_time_interval),
             "duration"_a, "gradient"_a=0*units::T/units::m,
+            call_guard<gil_scoped_release>(),
             "Apply a time interval, i.e. relaxation, diffusion, gradient, and "
             "off-resonance effects. States with a population lower than "
             "*threshold* will be removed.")
@@ -66,15 +67,24 @@ void wrap_epg_Discrete(pybind11::module & m)
             static_cast<void(Discrete::*)(TimeInterval const &)>(
                 &Discrete::apply_time_interval),
             "interval"_a,
+            call_guard<gil_scoped_release>(),
             "Apply a time interval, i.e. relaxation, diffusion, gradient, and "
             "off-resonance effects. States with a population lower than "
             "*threshold* will be removed.")
+        .def(
+            "apply_shaped_pulse", &Discrete::apply_shaped_pulse,
+            "pulse"_a, "gradient"_a=0*units::T/units::m,
+            call_guard<gil_scoped_release>(),
+            "Apply a shaped pulse: each of its hard pulses is followed by a "
+            "time interval of the hard pulse duration, with given gradient.")
         .def(
             "shift", &Discrete::shift, "duration"_a, "gradient"_a,
+            call_guard<gil_scoped_release>(),
             "Apply a gradient; in discrete EPG, this shifts all orders by" 
             "specified value.")
         .def(
             "diffusion", &Discrete::diffusion, "duration"_a, "gradient"_a,
+            call_guard<gil_scoped_release>(),
             "Simulate diffusion during given duration with given gradient ",
             "amplitude.")
     ;
@@ -57,6 +57,7 @@ void wrap_epg_Discrete3D(pybind11::module & m)
                 &Discrete3D::apply_time_interval),
             "duration"_a, "gradient"_a=Vector3Q{
                 0*units::T/units::m, 0*units::T/units::m, 0*units::T/units::m},
+            call_guard<gil_scoped_release>(),
             "Apply a time interval, i.e. relaxation, diffusion, gradient, and "
             "off-resonance effects. States with a population lower than "
             "*threshold* will be removed.")
@@ -65,17 +66,27 @@ void wrap_epg_Discrete3D(pybind11::module & m)
             overload_cast<TimeInterval const &>(
                 &Discrete3D::apply_time_interval),
             "interval"_a,
+            call_guard<gil_scoped_release>(),
             "Apply a time interval, i.e. relaxation, diffusion, gradient, and "
             "off-resonance effects. States with a population lower than "
             "*threshold* will be removed.")
+        .def(
+            "apply_shaped_pulse", &Discrete3D::apply_shaped_pulse,
+            "pulse"_a, "gradient"_a=Vector3Q{
+                0*units::T/units::m, 0*units::T/units::m, 0*units::T/units::m},
+            call_guard<gil_scoped_release>(),
+            "Apply a shaped pulse: each of its hard pulses is followed by a "
+            "time interval of the hard pulse duration, with given gradient.")
         .def(
             "shift", &Discrete3D::shift,
             "duration"_a, "gradient"_a,
+            call_guard<gil_scoped_release>(),
             "Apply a gradient; in discrete EPG, this shifts all orders by "
             "specified value.")
         .def(
             "diffusion", &Discrete3D::diffusion,
             "duration"_a, "gradient"_a,
+            call_guard<gil_scoped_release>(),
             "Simulate diffusion during given duration with given gradient "
             "amplitude.")
     ;
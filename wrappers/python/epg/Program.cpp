@@ -0,0 +1,132 @@
+#include <algorithm>
+#include <vector>
+
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include <xtensor-python/pytensor.hpp>
+
+#include "sycomore/epg/Program.h"
+#include "sycomore/epg/Regular.h"
+#include "sycomore/Sequence.h"
+
+#include "../type_casters.h"
+
+void wrap_epg_Program(pybind11::module & m)
+{
+    using namespace pybind11;
+    using namespace pybind11::literals;
+    using namespace sycomore;
+    using namespace sycomore::epg;
+    
+    auto program = class_<Program>(
+            m, "Program",
+            "Sequence compiled for a regular EPG model: the operators and the "
+            "shifts are computed once, and the program may be run on any "
+            "model with the same parameters.")
+        .def(
+            init<Sequence const &, Regular &>(), "sequence"_a, "model"_a,
+            call_guard<gil_scoped_release>())
+        .def(
+            "__len__", &Program::size,
+            "Number of instructions, loops being unrolled.")
+        .def_property_readonly(
+            "echoes", &Program::echoes,
+            "Number of echoes read by the program.")
+        .def(
+            "run",
+            [](Program const & program, Regular & model) {
+                TensorC<1> echoes(TensorC<1>::shape_type{program.echoes()});
+                {
+                    gil_scoped_release release;
+                    program.run(model, echoes.data());
+                }
+                return echoes;
+            },
+            "model"_a,
+            "Run the program on a model, return the echo of the first pool "
+            "at each readout.")
+        .def(
+            "run",
+            [](
+                Program const & program, Regular & model,
+                std::vector<Program::Parameter> const & parameters) {
+                std::vector<Complex> echoes, jacobian;
+                {
+                    gil_scoped_release release;
+                    echoes = program.run(model, parameters, jacobian);
+                }
+                TensorC<1> echoes_array(TensorC<1>::shape_type{echoes.size()});
+                std::copy(echoes.begin(), echoes.end(), echoes_array.begin());
+                TensorC<2> jacobian_array(
+                    TensorC<2>::shape_type{echoes.size(), parameters.size()});
+                std::copy(
+                    jacobian.begin(), jacobian.end(), jacobian_array.begin());
+                return std::make_pair(echoes_array, jacobian_array);
+            },
+            "model"_a, "parameters"_a,
+            "Run the program on a single-pool model, return the echoes and "
+            "their derivatives with respect to the parameters.")
+        .def(
+            "gradient",
+            [](
+                Program const & program, Regular & model,
+                function echoes_gradient, std::size_t checkpoint_interval) {
+                // The callback is called without the GIL: re-acquire it and
+                // convert the echoes to and from arrays.
+                auto const wrapper = [&](std::vector<Complex> const & echoes) {
+                    gil_scoped_acquire acquire;
+                    TensorC<1> array(TensorC<1>::shape_type{echoes.size()});
+                    std::copy(echoes.begin(), echoes.end(), array.begin());
+                    auto const gradient =
+                        echoes_gradient(array).cast<TensorC<1>>();
+                    return std::vector<Complex>(
+                        gradient.begin(), gradient.end());
+                };
+                
+                std::vector<Complex> echoes;
+                std::vector<Real> angles, phases;
+                {
+                    gil_scoped_release release;
+                    echoes = program.gradient(
+                        model, wrapper, angles, phases, checkpoint_interval);
+                }
+                TensorC<1> echoes_array(TensorC<1>::shape_type{echoes.size()});
+                std::copy(echoes.begin(), echoes.end(), echoes_array.begin());
+                TensorR<1> angles_array(TensorR<1>::shape_type{angles.size()});
+                std::copy(angles.begin(), angles.end(), angles_array.begin());
+                TensorR<1> phases_array(TensorR<1>::shape_type{phases.size()});
+                std::copy(phases.begin(), phases.end(), phases_array.begin());
+                return make_tuple(echoes_array, angles_array, phases_array);
+            },
+            "model"_a, "echoes_gradient"_a, "checkpoint_interval"_a=0,
+            "Run the program on a single-pool model and back-propagate the "
+            "gradient of a real loss with respect to the echoes, given by "
+            "echoes_gradient(echoes) as dL/dRe + i dL/dIm. Return the echoes "
+            "and the gradient of the loss with respect to the angle and to "
+            "the phase of each pulse.")
+        .def(
+            "steady_state",
+            [](
+                Program const & program, Regular & model, Real tolerance,
+                std::size_t max_size) {
+                TensorC<1> echoes(TensorC<1>::shape_type{program.echoes()});
+                {
+                    gil_scoped_release release;
+                    auto const result = program.steady_state(
+                        model, tolerance, max_size);
+                    std::copy(result.begin(), result.end(), echoes.begin());
+                }
+                return echoes;
+            },
+            "model"_a, "tolerance"_a=1e-9, "max_size"_a=10000,
+            "Run the program as a repeated block until the model reaches its "
+            "steady state, return the echoes of the last repetition.");
+    
+    enum_<Program::Parameter>(program, "Parameter")
+        .value("R1", Program::R1)
+        .value("R2", Program::R2)
+        .value("B1", Program::B1)
+        .value("D", Program::D)
+        .export_values();
+}
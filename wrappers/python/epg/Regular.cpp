@@ -49,6 +49,10 @@ void wrap_epg_Regular(pybind11::module & m)
             "initial_size"_a=100, "unit_dephasing"_a=0*units::rad/units::m,
             "gradient_tolerance"_a=1e-5)
         .def_readwrite("velocity", &Regular::velocity, "Bulk velocity")
+        .def_readwrite(
+            "circular_storage", &Regular::circular_storage,
+            "Store the states in ring buffers, so that shifts only update the "
+            "folded and cleared states.")
         .def_property_readonly(
             "unit_dephasing", &Regular::unit_dephasing,
             "Unit gradient dephasing of the model.")
@@ -69,6 +73,7 @@ void wrap_epg_Regular(pybind11::module & m)
             static_cast<void(Regular::*)(Quantity const &, Quantity const &)>(
                 &Regular::apply_time_interval),
             "duration"_a, "gradient"_a=0*units::T/units::m,
+            call_guard<gil_scoped_release>(),
             "Apply a time interval, i.e. relaxation, diffusion, gradient, and "
             "off-resonance effects.")
         .def(
@@ -76,10 +81,18 @@ void wrap_epg_Regular(pybind11::module & m)
             static_cast<void(Regular::*)(TimeInterval const &)>(
                 &Regular::apply_time_interval),
             "time_interval"_a,
+            call_guard<gil_scoped_release>(),
             "Apply a time interval, i.e. relaxation, diffusion, gradient, and "
             "off-resonance effects.")
+        .def(
+            "apply_shaped_pulse", &Regular::apply_shaped_pulse,
+            "pulse"_a, "gradient"_a=0*units::T/units::m,
+            call_guard<gil_scoped_release>(),
+            "Apply a shaped pulse: each of its hard pulses is followed by a "
+            "time interval of the hard pulse duration, with given gradient.")
         .def(
             "shift", static_cast<void (Regular::*)()>(&Regular::shift), 
+            call_guard<gil_scoped_release>(),
             "Apply a unit gradient; in regular EPG, this shifts all orders by 1.")
         .def(
             "shift", 
@@ -87,11 +100,13 @@ void wrap_epg_Regular(pybind11::module & m)
                     void (Regular::*)(Quantity const &, Quantity const &)
                 >(&Regular::shift), 
             "duration"_a, "gradient"_a,
+            call_guard<gil_scoped_release>(),
             "Apply an arbitrary gradient; in regular EPG, this shifts all "
             "orders by an integer number corresponding to a multiple of the "
             "unit gradient.")
         .def(
             "diffusion", &Regular::diffusion, "duration"_a, "gradient"_a,
+            call_guard<gil_scoped_release>(),
             "Simulate diffusion during given duration with given gradient "
             "amplitude.")
     ;
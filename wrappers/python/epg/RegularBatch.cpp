@@ -0,0 +1,130 @@
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+
+#include <xtensor-python/pytensor.hpp>
+
+#include "sycomore/epg/RegularBatch.h"
+#include "sycomore/Species.h"
+
+#include "../type_casters.h"
+
+void wrap_epg_RegularBatch(pybind11::module & m)
+{
+    using namespace pybind11;
+    using namespace sycomore;
+    using namespace sycomore::epg;
+    
+    auto batch = class_<RegularBatch>(
+            m, "RegularBatch",
+            "Batch of single-pool regular EPG models, sharing the same "
+            "sequence but with different species and B1 scaling."
+            "\n"
+            "The states of all models are stored order-major, so that the "
+            "operators are vectorized across models.");
+    
+    // NOTE: the enums must be registered before their use as default
+    // argument.
+    enum_<RegularBatch::Layout>(batch, "Layout")
+        .value("Interleaved", RegularBatch::Interleaved)
+        .value("Planar", RegularBatch::Planar)
+        .export_values();
+    enum_<RegularBatch::Precision>(batch, "Precision")
+        .value("Double", RegularBatch::Double)
+        .value("Single", RegularBatch::Single)
+        .export_values();
+    
+    batch
+        .def(
+            init<
+                std::vector<Species> const &, Vector3R const &, unsigned int,
+                Quantity const &, double, RegularBatch::Layout,
+                RegularBatch::Precision>(),
+            "species"_a, "initial_magnetization"_a=Vector3R{0,0,1},
+            "initial_size"_a=100, "unit_dephasing"_a=0*units::rad/units::m,
+            "gradient_tolerance"_a=1e-5,
+            "layout"_a=RegularBatch::Interleaved,
+            "precision"_a=RegularBatch::Double)
+        .def_readwrite(
+            "delta_omega", &RegularBatch::delta_omega, "Frequency offset")
+        .def_readwrite(
+            "threshold", &RegularBatch::threshold,
+            "Threshold used to cull states with low population in all models")
+        .def_property_readonly(
+            "models", &RegularBatch::models, "Number of models in the batch.")
+        .def_property_readonly(
+            "size", &RegularBatch::size, "Number of states of each model.")
+        .def_property_readonly(
+            "layout", &RegularBatch::layout,
+            "Memory layout of the states.")
+        .def_property_readonly(
+            "precision", &RegularBatch::precision, "Precision of the states.")
+        .def("species", &RegularBatch::species, "model"_a)
+        .def("B1", &RegularBatch::B1, "model"_a)
+        .def(
+            "set_B1", &RegularBatch::set_B1, "B1"_a,
+            "Set the relative B1 of all models")
+        .def_property_readonly(
+            "orders", &RegularBatch::orders,
+            "The sequence of orders currently stored by the models.")
+        .def(
+            "states", &RegularBatch::states, "model"_a,
+            "Return all states of a model.")
+        .def_property_readonly(
+            "echo", &RegularBatch::echo, "Echo signal of each model.")
+        .def_property_readonly("elapsed", &RegularBatch::elapsed)
+        .def_property_readonly(
+            "unit_dephasing", &RegularBatch::unit_dephasing,
+            "Unit gradient dephasing of the models.")
+        .def_property_readonly(
+            "gradient_tolerance", &RegularBatch::gradient_tolerance)
+        .def(
+            "apply_pulse", &RegularBatch::apply_pulse,
+            "angle"_a, "phase"_a=0*units::rad,
+            call_guard<gil_scoped_release>(),
+            "Apply an RF hard pulse, scaled by the B1 of each model.")
+        .def(
+            "apply_time_interval", 
+            static_cast<
+                    void(RegularBatch::*)(Quantity const &, Quantity const &)
+                >(&RegularBatch::apply_time_interval),
+            "duration"_a, "gradient"_a=0*units::T/units::m,
+            call_guard<gil_scoped_release>(),
+            "Apply a time interval, i.e. relaxation, diffusion, gradient, and "
+            "off-resonance effects.")
+        .def(
+            "apply_time_interval", 
+            static_cast<void(RegularBatch::*)(TimeInterval const &)>(
+                &RegularBatch::apply_time_interval),
+            "time_interval"_a,
+            call_guard<gil_scoped_release>(),
+            "Apply a time interval, i.e. relaxation, diffusion, gradient, and "
+            "off-resonance effects.")
+        .def(
+            "shift", static_cast<void (RegularBatch::*)()>(&RegularBatch::shift),
+            call_guard<gil_scoped_release>(),
+            "Apply a unit gradient; in regular EPG, this shifts all orders by 1.")
+        .def(
+            "shift", 
+            static_cast<
+                    void (RegularBatch::*)(Quantity const &, Quantity const &)
+                >(&RegularBatch::shift), 
+            "duration"_a, "gradient"_a,
+            call_guard<gil_scoped_release>(),
+            "Apply an arbitrary gradient, as a multiple of the unit gradient.")
+        .def(
+            "relaxation", &RegularBatch::relaxation, "duration"_a,
+            call_guard<gil_scoped_release>(),
+            "Simulate the relaxation during given duration.")
+        .def(
+            "diffusion", &RegularBatch::diffusion, "duration"_a, "gradient"_a,
+            call_guard<gil_scoped_release>(),
+            "Simulate diffusion during given duration with given gradient "
+            "amplitude.")
+        .def(
+            "off_resonance", &RegularBatch::off_resonance, "duration"_a,
+            call_guard<gil_scoped_release>(),
+            "Simulate field- and species-related off-resonance effects during "
+            "given duration.")
+    ;
+}
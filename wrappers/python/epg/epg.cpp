@@ -7,7 +7,9 @@ void wrap_epg_Discrete(pybind11::module &);
 void wrap_epg_Discrete3D(pybind11::module &);
 void wrap_epg_Model(pybind11::module &);
 void wrap_epg_operators(pybind11::module &);
+void wrap_epg_Program(pybind11::module &);
 void wrap_epg_Regular(pybind11::module &);
+void wrap_epg_RegularBatch(pybind11::module &);
 
 void wrap_epg(pybind11::module & m)
 {
@@ -19,4 +21,6 @@ void wrap_epg(pybind11::module & m)
     wrap_epg_Discrete3D(epg);
     wrap_epg_operators(epg);
     wrap_epg_Regular(epg);
+    wrap_epg_Program(epg);
+    wrap_epg_RegularBatch(epg);
 }
@@ -33,6 +33,28 @@ void wrap_epg_operators(pybind11::module & m)
         "Return the row-wise matrix corresponding to the single-pool EPG pulse "
             "operator");
     
+    operators.def(
+        "pulse_single_pool_derivative",
+        [](Real angle, Real phase) {
+            return as_xtensor_fixed(
+                pulse_single_pool_derivative(angle, phase),
+                xt::xshape<3, 3>{});
+        },
+        "angle"_a, "phase"_a,
+        "Return the row-wise derivative of the single-pool EPG pulse operator "
+            "with respect to the flip angle");
+    
+    operators.def(
+        "pulse_single_pool_phase_derivative",
+        [](Real angle, Real phase) {
+            return as_xtensor_fixed(
+                pulse_single_pool_phase_derivative(angle, phase),
+                xt::xshape<3, 3>{});
+        },
+        "angle"_a, "phase"_a,
+        "Return the row-wise derivative of the single-pool EPG pulse operator "
+            "with respect to the phase");
+    
     operators.def(
         "pulse_exchange",
         [](Real angle_a, Real phase_a, Real angle_b, Real phase_b) {
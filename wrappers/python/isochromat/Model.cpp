@@ -31,12 +31,14 @@ void wrap_isochromat_Model(pybind11::module & m)
             overload_cast<Quantity const &, Quantity const &>(
                 &Model::build_pulse, const_),
             "angle"_a, "phase"_a=0*units::rad,
+            call_guard<gil_scoped_release>(),
             "Create a spatially constant RF pulse operator")
         .def(
             "build_pulse",
             overload_cast<TensorQ<1> const &, TensorQ<1> const &>(
                 &Model::build_pulse, const_),
             "angle"_a, "phase"_a=TensorQ<1>{},
+            call_guard<gil_scoped_release>(),
             "Create a spatially-varying RF pulse operator")
         .def(
             "build_time_interval",
@@ -44,6 +46,7 @@ void wrap_isochromat_Model(pybind11::module & m)
                     Quantity const &, Quantity const &, TensorQ<1> const &>(
                 &Model::build_time_interval, const_),
             "duration"_a, "delta_omega"_a=0*units::Hz, "gradient"_a=TensorQ<1>{},
+            call_guard<gil_scoped_release>(),
             "Create a spatially constant time interval operator")
         .def(
             "build_time_interval",
@@ -51,24 +54,72 @@ void wrap_isochromat_Model(pybind11::module & m)
                     Quantity const &, TensorQ<1> const &, TensorQ<2> const &>(
                 &Model::build_time_interval, const_),
             "duration"_a, "delta_omega"_a, "gradient"_a=TensorQ<2>{},
+            call_guard<gil_scoped_release>(),
             "Create a spatially-varying time interval operator")
         .def(
             "build_relaxation", &Model::build_relaxation, "duration"_a,
+            call_guard<gil_scoped_release>(),
             "Create a relaxation operator")
         .def(
             "build_phase_accumulation",
             overload_cast<Quantity const &>(
                 &Model::build_phase_accumulation, const_),
             "angle"_a,
+            call_guard<gil_scoped_release>(),
             "Create a spatially constant phase accumulation operator")
         .def(
             "build_phase_accumulation",
             overload_cast<TensorQ<1> const &>(
                 &Model::build_phase_accumulation, const_),
-            "angle"_a, "Create a spatially-varying phase accumulation operator")
+            "angle"_a, call_guard<gil_scoped_release>(),
+            "Create a spatially-varying phase accumulation operator")
         .def(
             "apply", &Model::apply, "operator"_a,
+            call_guard<gil_scoped_release>(),
             "Apply an operator to the magnetization")
+        .def(
+            "apply_pulse",
+            overload_cast<Quantity const &, Quantity const &>(
+                &Model::apply_pulse),
+            "angle"_a, "phase"_a=0*units::rad,
+            call_guard<gil_scoped_release>(),
+            "Apply a spatially constant RF pulse")
+        .def(
+            "apply_pulse",
+            overload_cast<TensorQ<1> const &, TensorQ<1> const &>(
+                &Model::apply_pulse),
+            "angle"_a, "phase"_a=TensorQ<1>{},
+            call_guard<gil_scoped_release>(),
+            "Apply a spatially-varying RF pulse")
+        .def(
+            "apply_time_interval",
+            overload_cast<
+                    Quantity const &, Quantity const &, TensorQ<1> const &>(
+                &Model::apply_time_interval),
+            "duration"_a, "delta_omega"_a=0*units::Hz, "gradient"_a=TensorQ<1>{},
+            call_guard<gil_scoped_release>(),
+            "Apply a spatially constant time interval")
+        .def(
+            "apply_time_interval",
+            overload_cast<
+                    Quantity const &, TensorQ<1> const &, TensorQ<2> const &>(
+                &Model::apply_time_interval),
+            "duration"_a, "delta_omega"_a, "gradient"_a=TensorQ<2>{},
+            call_guard<gil_scoped_release>(),
+            "Apply a spatially-varying time interval")
+        .def(
+            "apply_relaxation", &Model::apply_relaxation, "duration"_a,
+            call_guard<gil_scoped_release>(),
+            "Apply the relaxation")
+        .def(
+            "apply_shaped_pulse", &Model::apply_shaped_pulse,
+            "pulse"_a, "delta_omega"_a=0*units::Hz, "gradient"_a=TensorQ<1>{},
+            call_guard<gil_scoped_release>(),
+            "Apply a shaped pulse: each of its hard pulses is followed by a "
+            "spatially constant time interval of the hard pulse duration")
+        .def_property(
+            "threads", &Model::threads, &Model::set_threads,
+            "Number of threads used to apply the operators")
         .def_property_readonly("T1", &Model::T1, "T1 field")
         .def_property_readonly("T2", &Model::T2, "T2 field")
         .def_property_readonly("M0", &Model::M0, "M0 field")
@@ -13,26 +13,56 @@ void wrap_isochromat_Operator(pybind11::module & m)
     using namespace sycomore;
     using namespace sycomore::isochromat;
 
-    class_<Operator>(
-            m, "Operator", 
-            "Isochromat simulation operator, i.e. an array of 4×4 matrices")
+    auto operator_ = class_<Operator>(
+        m, "Operator", 
+        "Isochromat simulation operator, i.e. an array of 4×4 matrices");
+
+    // NOTE: the enum must be registered before its use in the constructor.
+    enum_<Operator::Kind>(operator_, "Kind")
+        .value("Identity", Operator::Identity)
+        .value("DiagonalAffine", Operator::DiagonalAffine)
+        .value("ZRotation", Operator::ZRotation)
+        .value("Affine", Operator::Affine)
+        .value("General", Operator::General);
+
+    operator_
         .def(init<>())
         .def(init<TensorR<3> const &>(), "data"_a)
+        .def(
+            init<Operator::Kind, TensorR<3> const &>(), "kind"_a, "data"_a)
         .def(
             self *= self,
             "In-place chaining of operators: with right applied first.\n"
-            "If self and/or right has shape 1×4×4, it is broadcast to match "
-            "the other operand. Otherwise, both operand must have shape n×4×4.")
+            "If self and/or right has a single matrix, it is broadcast to "
+            "match the other operand. Otherwise, both operand must have n "
+            "matrices. Operands of different kinds are promoted to Affine or "
+            "General.")
         .def(
             "pre_multiply", &Operator::pre_multiply, "left"_a,
             "In-place chaining of operators, with self applied first.\n"
-            "If self and/or left has shape 1×4×4, it is broadcast to match "
-            "the other operand. Otherwise, both operand must have shape n×4×4.")
+            "If self and/or left has a single matrix, it is broadcast to match "
+            "the other operand. Otherwise, both operand must have n matrices. "
+            "Operands of different kinds are promoted to Affine or General.")
         .def_property_readonly(
             "array", [](Operator const & o){
                 return xt::pytensor<Real,3>(o.array());
             },
-            "Numeric representation of the operator")
+            "Numeric representation of the operator, as a copy of n×4×4 "
+            "matrices expanded from the stored data")
+        .def_property_readonly(
+            "data", [](Operator const & o){
+                return xt::pytensor<Real,3>(o.data());
+            },
+            "Stored representation of the operator, depending on its kind: "
+            "1×0×0 (Identity), n×2×3 (DiagonalAffine), n×1×2 (ZRotation), "
+            "n×3×4 (Affine) or n×4×4 (General)")
+        .def_property_readonly(
+            "kind", &Operator::kind, "Structure of the operator")
+        .def_property_readonly(
+            "is_affine", &Operator::is_affine,
+            "Whether the last row of all matrices is (0, 0, 0, 1)")
+        .def_property_readonly(
+            "size", &Operator::size, "Number of matrices of the operator")
         .def(
             self * self,
             "Operator chaining, representing right followed by left");
@@ -13,6 +13,7 @@ void wrap_units(pybind11::module &);
 
 void wrap_Pulse(pybind11::module &);
 void wrap_HardPulseApproximation(pybind11::module &);
+void wrap_Sequence(pybind11::module &);
 void wrap_Species(pybind11::module &);
 void wrap_TimeInterval(pybind11::module &);
 
@@ -29,6 +30,7 @@ PYBIND11_MODULE(_sycomore, _sycomore)
 
     wrap_Pulse(_sycomore);
     wrap_HardPulseApproximation(_sycomore);
+    wrap_Sequence(_sycomore);
     wrap_Species(_sycomore);
     wrap_TimeInterval(_sycomore);
 